@@ -36,4 +36,12 @@ namespace annileen
 			m_EditorGui->render(getEngine()->getScene(), deltaTime);
 		}
 	}
+
+	void ApplicationEditor::editorFixedUpdate(float fixedDeltaTime)
+	{
+		if (m_EditorGui->m_Mode == EditorGui::Mode::Game)
+		{
+			fixedUpdate(fixedDeltaTime);
+		}
+	}
 }
\ No newline at end of file
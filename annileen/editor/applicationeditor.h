@@ -12,6 +12,7 @@ namespace annileen
 
 		virtual void initializeEditorGui();
 		virtual void editorUpdate(float deltaTime);
+		virtual void editorFixedUpdate(float fixedDeltaTime);
 	public:
 
 		bool showEditorGui;
@@ -1,17 +1,23 @@
 #include <editor/editorgui.h>
 #include <engine/engine.h>
+#include <engine/renderer.h>
 #include <imgui-utils/imgui.h>
 #include <glm.hpp>
 #include <engine/core/logger.h>
+#include <engine/core/profiler.h>
 
 #include <engine/model.h>
 #include <engine/camera.h>
 #include <engine/light.h>
 #include <engine/text/text.h>
 #include <engine/material.h>
+#include <engine/scene/sceneserializer.h>
 
 #include <imgui-utils/imgui_stdlib.h>
 
+#include <algorithm>
+#include <functional>
+
 namespace annileen
 {
 	EditorGui::EditorGui()
@@ -21,7 +27,12 @@ namespace annileen
 		m_ShowSceneNodePropertiesWindow = true;
 		m_ShowConsoleWindow = true;
 		m_ShowSettingsWindow = false;
+		m_ShowProfilerWindow = false;
+		m_ShowRenderStatsWindow = false;
+		m_ShowAssetsWindow = false;
+		m_ProfilerSelectedFrame = -1;
 		m_SelectedSceneNode = nullptr;
+		m_SelectionScene = nullptr;
 		m_SceneNodeToBeRemoved = nullptr;
 		m_Mode = Editor;
 		m_HasWindowFocused = true;
@@ -144,6 +155,13 @@ namespace annileen
 
 	void EditorGui::render(Scene* scene, float deltaTime)
 	{
+		if (scene != m_SelectionScene)
+		{
+			m_SelectedSceneNode = nullptr;
+			m_SceneNodeToBeRemoved = nullptr;
+			m_SelectionScene = scene;
+		}
+
 		processInput(scene->getCamera(), deltaTime);
 
 		drawMainWindowToolbar();
@@ -161,6 +179,9 @@ namespace annileen
 
 		if (m_ShowConsoleWindow) drawConsoleWindow();
 		if (m_ShowSettingsWindow) drawSettingsWindow();
+		if (m_ShowProfilerWindow) drawProfilerWindow();
+		if (m_ShowRenderStatsWindow) drawRenderStatsWindow();
+		if (m_ShowAssetsWindow) drawAssetsWindow();
 
 		if (m_SceneNodeToBeRemoved != nullptr)
 		{
@@ -188,6 +209,11 @@ namespace annileen
 				ImGui::SetWindowFocus(NULL);
 				m_HasWindowFocused = false;
 				Engine::getInstance()->getInput()->m_Enabled = true && m_Mode == Game;
+
+				if (io.MouseClicked[0] && m_Mode == Editor && scene != nullptr)
+				{
+					pickSceneNode(scene, glm::vec2(io.MousePos.x, io.MousePos.y));
+				}
 			}
 			else
 			{
@@ -197,6 +223,28 @@ namespace annileen
 		}
 	}
 
+	void EditorGui::pickSceneNode(Scene* scene, const glm::vec2& mousePosition)
+	{
+		Camera* camera = scene->getCamera();
+		if (camera == nullptr) return;
+
+		ImGuiIO& io = ImGui::GetIO();
+		glm::vec2 ndc(2.0f * mousePosition.x / io.DisplaySize.x - 1.0f, 1.0f - 2.0f * mousePosition.y / io.DisplaySize.y);
+
+		// Unproject the cursor on the near and far planes, the matrices are the ones of the frame on screen.
+		glm::mat4 inverseViewProjection = glm::inverse(camera->getViewProjectionMatrix());
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+		nearPoint /= nearPoint.w;
+		farPoint /= farPoint.w;
+
+		Ray ray{ glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint - nearPoint)) };
+
+		// Picks by bounding box, the closest box under the cursor wins.
+		Model* model = scene->raycast(ray, glm::length(glm::vec3(farPoint - nearPoint)));
+		m_SelectedSceneNode = model != nullptr ? model->getSceneNode() : nullptr;
+	}
+
 	void EditorGui::drawMainWindowToolbar()
 	{
 		if (ImGui::BeginMainMenuBar())
@@ -205,9 +253,20 @@ namespace annileen
 			{
 				//if (ImGui::MenuItem("New Scene", "CTRL+N", false, false)) {}
 				//ImGui::Separator();
-				//if (ImGui::MenuItem("Open Scene", "CTRL+O", false, false)) {}  // Disabled item
-				//if (ImGui::MenuItem("Save Scene", "CTRL+S", false, false)) {}  // Disabled item
-				//ImGui::Separator();
+				Scene* scene = Engine::getInstance()->getScene();
+				if (ImGui::MenuItem("Open Scene", 0, false, scene != nullptr))
+				{
+					// Replaces the current scene content, nothing selected can survive it.
+					m_SelectedSceneNode = nullptr;
+					m_SceneNodeToBeRemoved = nullptr;
+					scene->clear();
+					SceneSerializer::load(scene, "annileen-scene.anscene");
+				}
+				if (ImGui::MenuItem("Save Scene", 0, false, scene != nullptr))
+				{
+					SceneSerializer::save(scene, "annileen-scene.anscene");
+				}
+				ImGui::Separator();
 				if (ImGui::MenuItem("Exit", 0, false, true))
 				{
 					Engine::getInstance()->terminate();
@@ -235,6 +294,9 @@ namespace annileen
 					m_ShowSceneNodePropertiesWindow = true;
 					m_ShowConsoleWindow = true;
 					m_ShowSettingsWindow = false;
+					m_ShowProfilerWindow = false;
+					m_ShowRenderStatsWindow = false;
+					m_ShowAssetsWindow = false;
 				}
 				ImGui::Separator();
 				ImGui::MenuItem("Toolbar", nullptr, &m_ShowToolsWindow);
@@ -243,6 +305,9 @@ namespace annileen
 				ImGui::MenuItem("Console", 0, &m_ShowConsoleWindow);
 				ImGui::Separator();
 				ImGui::MenuItem("Settings", 0, &m_ShowSettingsWindow);
+				ImGui::MenuItem("Profiler", 0, &m_ShowProfilerWindow);
+				ImGui::MenuItem("Render Stats", 0, &m_ShowRenderStatsWindow);
+				ImGui::MenuItem("Assets", 0, &m_ShowAssetsWindow);
 				ImGui::EndMenu();
 			}
 
@@ -413,7 +478,7 @@ namespace annileen
 
 		if (nodeChildren.empty())
 		{
-			ImGui::PushID(sceneNode->getId());
+			ImGui::PushID(sceneNode);
 			if (ImGui::Selectable(sceneNode->name.c_str(), sceneNode == m_SelectedSceneNode))
 			{
 				m_SelectedSceneNode = sceneNode;
@@ -636,6 +701,356 @@ namespace annileen
 		if (ImGui::CollapsingHeader("Shadows", ImGuiTreeNodeFlags_DefaultOpen))
 		{
 			ImGui::Checkbox("Enabled", &settings->shadows.enabled);
+			ImGui::Checkbox("Cache Static Layer", &settings->shadows.cacheStaticLayer);
+			ImGui::DragFloat("Cache Snap Distance", &settings->shadows.cacheSnapDistance, 0.5f, 0.0f, 64.0f);
+
+			const ShadowStats& shadowStats = Engine::getInstance()->getRenderer()->getShadowStats();
+			ImGui::Text("Static layer rebuilds: %u", shadowStats.staticLayerRebuilds);
+			ImGui::Text("Cached frames: %u", shadowStats.cachedFrames);
+			ImGui::Text("Casters: %u static, %u dynamic", shadowStats.staticCasters, shadowStats.dynamicCasters);
+		}
+
+		ImGui::End();
+	}
+
+	void EditorGui::drawProfilerWindow()
+	{
+		ImGui::SetNextWindowPos(
+			ImVec2(820.0f, 520.0f)
+			, ImGuiCond_FirstUseEver
+		);
+		ImGui::SetNextWindowSize(
+			ImVec2(700.0f, 400.0f)
+			, ImGuiCond_FirstUseEver
+		);
+
+		if (!ImGui::Begin("Profiler", &m_ShowProfilerWindow))
+		{
+			ImGui::End();
+			return;
+		}
+
+#if !ANNILEEN_PROFILER_ENABLED
+		ImGui::Text("The profiler was compiled out (ANNILEEN_PROFILER_ENABLED=0).");
+#endif
+
+		bool paused = Profiler::isPaused();
+		if (ImGui::Checkbox("Pause", &paused))
+		{
+			Profiler::setPaused(paused);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Export Chrome Trace"))
+		{
+			const char* traceFile = "annileen-trace.json";
+			if (Profiler::exportChromeTrace(traceFile))
+			{
+				ANNILEEN_LOGF_INFO(LoggingChannel::Editor, "Profiler trace exported to '{}'.", traceFile);
+			}
+			else
+			{
+				ANNILEEN_LOGF_ERROR(LoggingChannel::Editor, "Could not export profiler trace to '{}'.", traceFile);
+			}
+		}
+
+		const std::deque<ProfilerFrame>& frames = Profiler::getFrames();
+		if (frames.empty())
+		{
+			ImGui::End();
+			return;
+		}
+
+		// Frame time history, pick a frame to inspect with the slider.
+		std::vector<float> frameTimes;
+		for (const auto& frame : frames)
+		{
+			frameTimes.push_back((frame.end - frame.start) / 1000000.0f);
+		}
+		ImGui::PlotHistogram("##FrameTimes", frameTimes.data(), static_cast<int>(frameTimes.size()), 0, "Frame time (ms)", 0.0f, 50.0f, ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+
+		int lastFrame = static_cast<int>(frames.size()) - 1;
+		int frameIndex = m_ProfilerSelectedFrame < 0 || m_ProfilerSelectedFrame > lastFrame ? lastFrame : m_ProfilerSelectedFrame;
+		if (ImGui::SliderInt("Frame", &frameIndex, 0, lastFrame))
+		{
+			m_ProfilerSelectedFrame = frameIndex == lastFrame ? -1 : frameIndex;
+		}
+
+		const ProfilerFrame& frame = frames[frameIndex];
+		const double frameDuration = static_cast<double>(frame.end - frame.start);
+		ImGui::Text("Frame: %.3f ms, %zu scopes", frameDuration / 1000000.0, frame.events.size());
+
+		// Flame graph, one lane per thread and one row per nesting depth.
+		const std::vector<std::string> threadNames = Profiler::getThreadNames();
+		const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+		const float width = ImGui::GetContentRegionAvail().x;
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+		for (uint32_t thread = 0; thread < threadNames.size(); ++thread)
+		{
+			uint32_t maxDepth = 0;
+			bool hasEvents = false;
+			for (const auto& event : frame.events)
+			{
+				if (event.thread != thread) continue;
+				hasEvents = true;
+				maxDepth = std::max(maxDepth, event.depth);
+			}
+			if (!hasEvents) continue;
+
+			ImGui::Text("%s", threadNames[thread].c_str());
+
+			ImVec2 origin = ImGui::GetCursorScreenPos();
+			ImGui::InvisibleButton(threadNames[thread].c_str(), ImVec2(width, rowHeight * (maxDepth + 1)));
+			const bool laneHovered = ImGui::IsItemHovered();
+			const ImVec2 mouse = ImGui::GetIO().MousePos;
+
+			for (const auto& event : frame.events)
+			{
+				if (event.thread != thread) continue;
+
+				const double start = std::max(0.0, static_cast<double>(static_cast<int64_t>(event.start - frame.start)));
+				const double end = static_cast<double>(event.end - frame.start);
+
+				ImVec2 min(origin.x + static_cast<float>(start / frameDuration) * width, origin.y + event.depth * rowHeight);
+				ImVec2 max(origin.x + static_cast<float>(end / frameDuration) * width, min.y + rowHeight - 1.0f);
+				max.x = std::max(max.x, min.x + 1.0f);
+
+				// Stable color per scope name
+				const ImU32 hash = static_cast<ImU32>(std::hash<std::string>{}(event.name));
+				const ImU32 color = IM_COL32(100 + (hash & 0x7f), 100 + ((hash >> 8) & 0x7f), 100 + ((hash >> 16) & 0x7f), 255);
+
+				drawList->AddRectFilled(min, max, color);
+
+				const float textWidth = ImGui::CalcTextSize(event.name).x;
+				if (textWidth + 4.0f < max.x - min.x)
+				{
+					drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), event.name);
+				}
+
+				if (laneHovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+				{
+					ImGui::SetTooltip("%s: %.3f ms", event.name, (event.end - event.start) / 1000000.0);
+				}
+			}
+		}
+
+		// Rolling percentiles over the frame history
+		if (ImGui::CollapsingHeader("Percentiles", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			ImGui::Columns(4, "ProfilerPercentiles");
+			ImGui::Text("Scope"); ImGui::NextColumn();
+			ImGui::Text("p50 (ms)"); ImGui::NextColumn();
+			ImGui::Text("p95 (ms)"); ImGui::NextColumn();
+			ImGui::Text("p99 (ms)"); ImGui::NextColumn();
+			ImGui::Separator();
+
+			ProfilerPercentiles framePercentiles = Profiler::getFramePercentiles();
+			ImGui::Text("Frame"); ImGui::NextColumn();
+			ImGui::Text("%.3f", framePercentiles.p50); ImGui::NextColumn();
+			ImGui::Text("%.3f", framePercentiles.p95); ImGui::NextColumn();
+			ImGui::Text("%.3f", framePercentiles.p99); ImGui::NextColumn();
+
+			for (const auto& [name, percentiles] : Profiler::getScopePercentiles())
+			{
+				ImGui::Text("%s", name.c_str()); ImGui::NextColumn();
+				ImGui::Text("%.3f", percentiles.p50); ImGui::NextColumn();
+				ImGui::Text("%.3f", percentiles.p95); ImGui::NextColumn();
+				ImGui::Text("%.3f", percentiles.p99); ImGui::NextColumn();
+			}
+
+			ImGui::Columns(1);
+		}
+
+		ImGui::End();
+	}
+
+	void EditorGui::drawRenderStatsWindow()
+	{
+		ImGui::SetNextWindowPos(
+			ImVec2(820.0f, 50.0f)
+			, ImGuiCond_FirstUseEver
+		);
+		ImGui::SetNextWindowSize(
+			ImVec2(420.0f, 460.0f)
+			, ImGuiCond_FirstUseEver
+		);
+
+		if (!ImGui::Begin("Render Stats", &m_ShowRenderStatsWindow))
+		{
+			ImGui::End();
+			return;
+		}
+
+		const RenderStats& renderStats = Engine::getInstance()->getRenderer()->getStats();
+		const FrameStats* stats = renderStats.getLastFrame();
+		if (stats == nullptr)
+		{
+			ImGui::End();
+			return;
+		}
+
+		std::vector<float> submitTimes, gpuTimes, drawCalls;
+		for (const auto& frame : renderStats.getHistory())
+		{
+			submitTimes.push_back(static_cast<float>(frame.cpuSubmitTime));
+			gpuTimes.push_back(static_cast<float>(frame.gpuTime));
+			drawCalls.push_back(static_cast<float>(frame.drawCalls));
+		}
+
+		const ImVec2 plotSize(ImGui::GetContentRegionAvail().x, 40.0f);
+		ImGui::Text("CPU submit: %.3f ms, cull: %.3f ms", stats->cpuSubmitTime, stats->cpuCullTime);
+		ImGui::PlotLines("##SubmitTime", submitTimes.data(), static_cast<int>(submitTimes.size()), 0, nullptr, 0.0f, FLT_MAX, plotSize);
+		ImGui::Text("GPU: %.3f ms (bgfx CPU %.3f ms, wait render %.3f ms, wait submit %.3f ms)", stats->gpuTime, stats->bgfxCpuTime, stats->waitRender, stats->waitSubmit);
+		ImGui::PlotLines("##GpuTime", gpuTimes.data(), static_cast<int>(gpuTimes.size()), 0, nullptr, 0.0f, FLT_MAX, plotSize);
+		ImGui::Text("Draw calls: %u (bgfx %u), primitives: %llu (bgfx %llu)", stats->drawCalls, stats->gpuDrawCalls,
+			static_cast<unsigned long long>(stats->primitives), static_cast<unsigned long long>(stats->gpuPrimitives));
+		ImGui::PlotLines("##DrawCalls", drawCalls.data(), static_cast<int>(drawCalls.size()), 0, nullptr, 0.0f, FLT_MAX, plotSize);
+
+		if (ImGui::CollapsingHeader("Views", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			ImGui::Columns(4, "RenderStatsViews");
+			ImGui::Text("View"); ImGui::NextColumn();
+			ImGui::Text("Draw calls"); ImGui::NextColumn();
+			ImGui::Text("Primitives"); ImGui::NextColumn();
+			ImGui::Text("GPU"); ImGui::NextColumn();
+			ImGui::Separator();
+
+			for (const auto& view : stats->views)
+			{
+				ImGui::Text("%u %s", view.viewId, view.name.c_str()); ImGui::NextColumn();
+				ImGui::Text("%u", view.drawCalls); ImGui::NextColumn();
+				ImGui::Text("%llu", static_cast<unsigned long long>(view.primitives)); ImGui::NextColumn();
+				ImGui::Text("%.3f ms", view.gpuTime); ImGui::NextColumn();
+			}
+
+			ImGui::Columns(1);
+		}
+
+		if (ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			ImGui::Text("Transient vertex buffer: %.1f KB", stats->transientVertexBufferUsed / 1024.0f);
+			ImGui::Text("Transient index buffer: %.1f KB", stats->transientIndexBufferUsed / 1024.0f);
+			ImGui::Text("Dynamic buffers: %u vertex, %u index", stats->dynamicVertexBuffers, stats->dynamicIndexBuffers);
+			ImGui::Text("Textures: %.1f MB, render targets: %.1f MB", stats->textureMemoryUsed / (1024.0f * 1024.0f), stats->renderTargetMemoryUsed / (1024.0f * 1024.0f));
+			// bgfx reports a negative value when the backend can't query it
+			if (stats->gpuMemoryUsed >= 0)
+				ImGui::Text("GPU memory used: %.1f MB", stats->gpuMemoryUsed / (1024.0f * 1024.0f));
+			else
+				ImGui::Text("GPU memory used: n/a");
+		}
+
+		Scene* scene = Engine::getInstance()->getScene();
+		if (scene != nullptr && ImGui::CollapsingHeader("Scene Pools"))
+		{
+			auto drawPoolStats = [](const char* name, const PoolStats& pool)
+			{
+				ImGui::Text("%s", name); ImGui::NextColumn();
+				ImGui::Text("%zu / %zu", pool.used, pool.capacity); ImGui::NextColumn();
+				ImGui::Text("%zu", pool.peak); ImGui::NextColumn();
+			};
+
+			ImGui::Columns(3, "RenderStatsPools");
+			ImGui::Text("Pool"); ImGui::NextColumn();
+			ImGui::Text("Used / capacity"); ImGui::NextColumn();
+			ImGui::Text("Peak"); ImGui::NextColumn();
+			ImGui::Separator();
+
+			drawPoolStats("SceneNode", scene->getNodePoolStats());
+			drawPoolStats("Model", scene->getModuleStorage<Model>().getStats());
+			drawPoolStats("Light", scene->getModuleStorage<Light>().getStats());
+			drawPoolStats("Camera", scene->getModuleStorage<Camera>().getStats());
+			drawPoolStats("Text", scene->getModuleStorage<Text>().getStats());
+
+			ImGui::Columns(1);
+		}
+
+		ImGui::End();
+	}
+
+	void EditorGui::drawAssetsWindow()
+	{
+		ImGui::SetNextWindowPos(
+			ImVec2(820.0f, 520.0f)
+			, ImGuiCond_FirstUseEver
+		);
+		ImGui::SetNextWindowSize(
+			ImVec2(520.0f, 360.0f)
+			, ImGuiCond_FirstUseEver
+		);
+
+		if (!ImGui::Begin("Assets", &m_ShowAssetsWindow))
+		{
+			ImGui::End();
+			return;
+		}
+
+		AssetManager* assetManager = ServiceProvider::getAssetManager();
+		const float mebibyte = 1024.0f * 1024.0f;
+
+		// Same setting the engine starts with, changed here for this run only.
+		Settings* settings = ServiceProvider::getSettings();
+		int budget = static_cast<int>(settings->assets.memoryBudget);
+		if (ImGui::InputInt("Budget (MiB, 0 = none)", &budget, 16, 128))
+		{
+			settings->assets.memoryBudget = static_cast<uint32_t>(std::max(budget, 0));
+			assetManager->setMemoryBudget(static_cast<uint64_t>(settings->assets.memoryBudget) * 1024 * 1024);
+		}
+
+		bool hotReload = assetManager->isHotReloading();
+		if (ImGui::Checkbox("Hot reload", &hotReload))
+		{
+			settings->assets.hotReload = assetManager->setHotReload(hotReload) && hotReload;
+		}
+
+		ImGui::Text("Loaded: %.2f MiB (textures %.2f, cubemaps %.2f, meshes %.2f, fonts %.2f)",
+			assetManager->getMemoryUsage() / mebibyte,
+			assetManager->getMemoryUsage(AssetType::Texture) / mebibyte,
+			assetManager->getMemoryUsage(AssetType::Cubemap) / mebibyte,
+			assetManager->getMemoryUsage(AssetType::Model) / mebibyte,
+			assetManager->getMemoryUsage(AssetType::Font) / mebibyte);
+
+		if (ImGui::CollapsingHeader("Residency", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			auto getTypeName = [](AssetType type)
+			{
+				switch (type)
+				{
+				case AssetType::Shader: return "Shader";
+				case AssetType::Texture: return "Texture";
+				case AssetType::Model: return "Mesh";
+				case AssetType::Cubemap: return "Cubemap";
+				case AssetType::Font: return "Font";
+				default: return "-";
+				}
+			};
+
+			auto getStateName = [](const AssetResidency& asset)
+			{
+				if (!asset.loaded) return "Unloaded";
+				if (asset.state == AssetState::Loading) return "Loading";
+				if (asset.state == AssetState::Failed) return "Failed";
+				return asset.pinned ? "Pinned" : "Loaded";
+			};
+
+			ImGui::Columns(5, "AssetsResidency");
+			ImGui::Text("Asset"); ImGui::NextColumn();
+			ImGui::Text("Type"); ImGui::NextColumn();
+			ImGui::Text("State"); ImGui::NextColumn();
+			ImGui::Text("References"); ImGui::NextColumn();
+			ImGui::Text("Size"); ImGui::NextColumn();
+			ImGui::Separator();
+
+			for (const AssetResidency& asset : assetManager->getResidency())
+			{
+				ImGui::Text("%s", asset.name.c_str()); ImGui::NextColumn();
+				ImGui::Text("%s", getTypeName(asset.type)); ImGui::NextColumn();
+				ImGui::Text("%s", getStateName(asset)); ImGui::NextColumn();
+				ImGui::Text("%u", asset.references); ImGui::NextColumn();
+				ImGui::Text("%.1f KiB", asset.size / 1024.0f); ImGui::NextColumn();
+			}
+
+			ImGui::Columns(1);
 		}
 
 		ImGui::End();
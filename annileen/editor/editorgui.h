@@ -2,7 +2,7 @@
 
 #include <list>
 #include <vector>
-#include <engine/scenenode.h>
+#include <engine/scene.h>
 
 #include <dear-imgui/imgui.h>
 
@@ -41,6 +41,12 @@ namespace annileen
 		bool m_ShowSceneNodePropertiesWindow;
 		bool m_ShowConsoleWindow;
 		bool m_ShowSettingsWindow;
+		bool m_ShowProfilerWindow;
+		bool m_ShowRenderStatsWindow;
+		bool m_ShowAssetsWindow;
+
+		// Frame inspected in the profiler flame graph, -1 follows the latest frame.
+		int m_ProfilerSelectedFrame;
 
 		bool m_HasWindowFocused;
 
@@ -49,6 +55,8 @@ namespace annileen
 		// These will probably become a list when we start allowing multiple selection.
 		SceneNode* m_SelectedSceneNode;		
 		SceneNode* m_SceneNodeToBeRemoved;
+		// Selection belongs to this scene, it is dropped when the SceneManager swaps scenes.
+		Scene* m_SelectionScene;
 
 		void initialize();
 		void processInput(Camera* camera, float deltaTime);
@@ -59,7 +67,12 @@ namespace annileen
 		void drawSelectedNodePropertiesWindow();
 		void drawConsoleWindow();
 		void drawSettingsWindow();
+		void drawProfilerWindow();
+		void drawRenderStatsWindow();
+		void drawAssetsWindow();
 		void _drawTree(SceneNodePtr const sceneNode);
+		// Selects the node of the model under the mouse.
+		void pickSceneNode(Scene* scene, const glm::vec2& mousePosition);
 
 		// Modules
 		void drawModelModuleProperties(Model* model);
@@ -85,7 +98,7 @@ namespace annileen
 		{
 			newSceneNode = scene->createNode(nodeName);
 			newSceneNode->setParent(sceneNode->getParent());
-			newSceneNode->setSiblingPosition(sceneNode->getSiblingIterator());
+			newSceneNode->moveBefore(sceneNode);
 		}
 		if (ImGui::Selectable("As child"))
 		{
@@ -96,7 +109,7 @@ namespace annileen
 		{
 			newSceneNode = scene->createNode(nodeName);
 			newSceneNode->setParent(sceneNode->getParent());
-			newSceneNode->setSiblingPosition(sceneNode->getSiblingIterator() + 1);
+			newSceneNode->moveAfter(sceneNode);
 		}
 
 		if (newSceneNode != nullptr)
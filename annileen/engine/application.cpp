@@ -1,21 +1,29 @@
 #include "application.h"
+#include <engine/renderer.h>
+#include <engine/benchmark.h>
+#include <engine/core/commandline.h>
+#include <engine/core/profiler.h>
+#include <engine/serviceprovider.h>
+#include <chrono>
 
 namespace annileen
 {
 	Application::Application() : m_Engine(nullptr) {}
 	Application::~Application() {}
 
-	void Application::initAnnileen()
+	void Application::initAnnileen(const CommandLineOptions& options)
 	{
 		m_Engine = annileen::Engine::getInstance();
-		m_Engine->init(1920, 1080, "build_assets/assets.toml", m_ApplicationName);
+		m_Engine->init(1920, 1080, "build_assets/assets.toml", m_ApplicationName, options);
 	}
 
-	int Application::run(std::string applicationName)
+	int Application::run(std::string applicationName, int argc, char* argv[])
 	{
 		m_ApplicationName = applicationName;
 
-		initAnnileen();
+		CommandLineOptions options = CommandLineOptions::parse(argc, argv);
+
+		initAnnileen(options);
 
 #ifdef _DEBUG
 		initializeEditorGui();
@@ -34,8 +42,25 @@ namespace annileen
 
 		m_Engine->setScene(scene);
 
+		SceneManager* sceneManager = ServiceProvider::getSceneManager();
+		AssetManager* assetManager = ServiceProvider::getAssetManager();
+		if (!options.loadScene.empty())
+		{
+			sceneManager->loadSubScene(options.loadScene);
+		}
+
+		Benchmark benchmark(m_ApplicationName);
+		uint32_t frameCount = 0;
+
 		while (m_Engine->run())
 		{
+			auto frameStart = std::chrono::steady_clock::now();
+
+			// Frame boundary: finished loads are swapped in here, so the scene is fetched again.
+			sceneManager->update();
+			assetManager->update();
+			scene = m_Engine->getScene();
+
 			auto dt = m_Engine->getTime().deltaTime;
 			m_Engine->checkInputEvents();
 
@@ -46,17 +71,68 @@ namespace annileen
 			m_Engine->getGui()->beginFrame(m_Engine->getInput()->_getMousePosition(), mouseButton, static_cast<int32_t>(m_Engine->getInput()->_getMouseScroll().y), 
 				m_Engine->getWidth(), m_Engine->getHeight());
 
-			scene->update();
+			auto updateStart = std::chrono::steady_clock::now();
+
+			{
+				ANNILEEN_PROFILE_SCOPE("Fixed update");
+				const float fixedDeltaTime = m_Engine->getTime().fixedDeltaTime;
+
+				for (uint32_t step = 0; step < m_Engine->getFixedStepCount(); ++step)
+				{
+					scene->beginFixedStep();
+					scene->fixedUpdate();
+#ifdef _DEBUG
+					editorFixedUpdate(fixedDeltaTime);
+#else
+					fixedUpdate(fixedDeltaTime);
+#endif
+				}
+			}
 
+			{
+				ANNILEEN_PROFILE_SCOPE("Scene::update");
+				scene->update();
+			}
+
+			{
+				ANNILEEN_PROFILE_SCOPE("Application::update");
 #ifdef _DEBUG
-			editorUpdate(dt);
+				editorUpdate(dt);
 #else
-			update(dt);
+				update(dt);
 #endif
+			}
+
+			auto updateEnd = std::chrono::steady_clock::now();
 
 			m_Engine->getGui()->endFrame();
 
 			m_Engine->renderFrame();
+
+			if (!options.outputFile.empty())
+			{
+				const RenderTimings& renderTimings = m_Engine->getRenderer()->getTimings();
+
+				FrameTiming timing;
+				timing.frame = frameCount;
+				timing.update = std::chrono::duration<double, std::milli>(updateEnd - updateStart).count();
+				timing.cull = renderTimings.cull;
+				timing.submit = renderTimings.submit;
+				timing.total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+				benchmark.addFrame(timing, m_Engine->getRenderer()->getStats().getLastFrame());
+			}
+
+			++frameCount;
+
+			if (options.frames > 0 && frameCount >= options.frames)
+			{
+				m_Engine->terminate();
+			}
+		}
+
+		if (!options.outputFile.empty())
+		{
+			benchmark.writeJson(options.outputFile);
 		}
 
 		return 0;
@@ -9,9 +9,8 @@ namespace annileen
 
 	private:
 
-		void initAnnileen();
+		void initAnnileen(const CommandLineOptions& options);
 		// TODO:
-		// physicsUpdate
 		// beforeRender
 		// afterRender
 
@@ -23,6 +22,7 @@ namespace annileen
 		friend class ApplicationEditor;
 		virtual void initializeEditorGui() = 0;
 		virtual void editorUpdate(float deltaTime) = 0;
+		virtual void editorFixedUpdate(float fixedDeltaTime) = 0;
 #endif
 
 	protected:
@@ -30,6 +30,9 @@ namespace annileen
 		virtual Scene* init() = 0;
 		virtual void finish() = 0;
 		virtual void update(float deltaTime) = 0;
+		// Runs once per simulation step, before update(). Simulation belongs here, it then
+		// gives the same results at any frame rate.
+		virtual void fixedUpdate(float fixedDeltaTime) {}
 
 		void destroy();
 
@@ -39,7 +42,7 @@ namespace annileen
 		}
 
 	public:
-		int run(std::string applicationName);
+		int run(std::string applicationName, int argc = 0, char* argv[] = nullptr);
 		Application();
 		~Application();
 	};
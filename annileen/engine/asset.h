@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 
 namespace annileen
@@ -9,11 +10,30 @@ namespace annileen
 		Undefined,
 		Shader,
 		Texture,
-		Model
+		Model,
+		Cubemap,
+		Font
+	};
+
+	enum class AssetState
+	{
+		// Loaded asynchronously and not there yet, a placeholder stands in.
+		Loading,
+		Ready,
+		// Could not be loaded, the placeholder stays.
+		Failed
 	};
 
 	struct AssetObject
 	{
+		AssetState m_State = AssetState::Ready;
+
+		bool isReady() const { return m_State == AssetState::Ready; }
+
+		// Bytes the asset holds on the CPU and GPU, what the AssetManager memory budget counts.
+		// Placeholders count nothing.
+		virtual size_t getMemorySize() const { return 0; }
+
 		AssetObject() { }
 		virtual ~AssetObject() { }
 	};
@@ -25,6 +45,16 @@ namespace annileen
 
 		bool m_Loaded;
 		AssetObject* m_Asset;
+		// Entry in the asset archive, -1 for loose files.
+		int32_t m_ArchiveIndex = -1;
+
+		// AssetRefs held to the asset. Loaded assets nothing refers to may be unloaded to
+		// stay within the memory budget.
+		uint32_t m_References = 0;
+		// Handed out as a plain pointer by a load function, so it is never unloaded.
+		bool m_Pinned = false;
+		// AssetManager use count when last acquired or released, the oldest is unloaded first.
+		uint64_t m_LastUsed = 0;
 	};
 
 	// Asset descriptors
@@ -0,0 +1,123 @@
+#include <engine/assetarchive.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace annileen
+{
+	static const char s_Magic[4] = { 'A', 'N', 'P', 'K' };
+
+	uint64_t AssetArchive::hashName(const std::string& name)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : name)
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	AssetArchive::AssetArchive(std::shared_ptr<MappedFile> file) : m_File(std::move(file))
+	{
+		m_Header = reinterpret_cast<const Header*>(m_File->getData());
+		m_Entries = reinterpret_cast<const Entry*>(m_File->getData() + sizeof(Header));
+	}
+
+	std::unique_ptr<AssetArchive> AssetArchive::open(const std::string& fileName, std::string& error)
+	{
+		auto file = MappedFile::open(fileName);
+		if (file == nullptr)
+		{
+			error = "Asset archive '" + fileName + "' could not be opened.";
+			return nullptr;
+		}
+
+		const uint64_t fileSize = file->getSize();
+		const Header* header = reinterpret_cast<const Header*>(file->getData());
+
+		if (fileSize < sizeof(Header) || std::memcmp(header->magic, s_Magic, sizeof(s_Magic)) != 0)
+		{
+			error = "'" + fileName + "' is not an asset archive.";
+			return nullptr;
+		}
+
+		if (header->version != currentVersion)
+		{
+			error = "Asset archive '" + fileName + "' is version " + std::to_string(header->version) +
+				", expected " + std::to_string(currentVersion) + ". Rebuild the assets.";
+			return nullptr;
+		}
+
+		// Everything the index points at must be inside the file, then lookups need no checks.
+		const uint64_t indexEnd = sizeof(Header) + static_cast<uint64_t>(header->entryCount) * sizeof(Entry);
+		bool valid = indexEnd <= fileSize && header->namesOffset >= indexEnd && header->namesSize <= fileSize - header->namesOffset;
+
+		const Entry* entries = reinterpret_cast<const Entry*>(file->getData() + sizeof(Header));
+		for (uint32_t i = 0; valid && i < header->entryCount; ++i)
+		{
+			const Entry& entry = entries[i];
+			valid = entry.offset <= fileSize && entry.size <= fileSize - entry.offset &&
+				static_cast<uint64_t>(entry.nameOffset) + entry.nameLength <= header->namesSize &&
+				(i == 0 || entries[i - 1].nameHash <= entry.nameHash);
+		}
+
+		if (!valid)
+		{
+			error = "Asset archive '" + fileName + "' is damaged.";
+			return nullptr;
+		}
+
+		return std::unique_ptr<AssetArchive>(new AssetArchive(std::move(file)));
+	}
+
+	const AssetArchive::Entry* AssetArchive::find(const std::string& name) const
+	{
+		const uint64_t hash = hashName(name);
+		const Entry* end = m_Entries + m_Header->entryCount;
+		const Entry* entry = std::lower_bound(m_Entries, end, hash, [](const Entry& e, uint64_t h) { return e.nameHash < h; });
+
+		// Names of colliding hashes sit next to each other.
+		for (; entry != end && entry->nameHash == hash; ++entry)
+		{
+			const char* entryName = reinterpret_cast<const char*>(m_File->getData() + m_Header->namesOffset + entry->nameOffset);
+			if (entry->nameLength == name.size() && std::memcmp(entryName, name.data(), name.size()) == 0)
+			{
+				return entry;
+			}
+		}
+
+		return nullptr;
+	}
+
+	std::string AssetArchive::getName(const Entry& entry) const
+	{
+		const char* name = reinterpret_cast<const char*>(m_File->getData() + m_Header->namesOffset + entry.nameOffset);
+		return std::string(name, entry.nameLength);
+	}
+
+	std::string AssetArchive::getExtension(const Entry& entry) const
+	{
+		return std::string(entry.extension, strnlen(entry.extension, sizeof(entry.extension)));
+	}
+
+	TextureDescriptor AssetArchive::getTextureDescriptor(const Entry& entry) const
+	{
+		return {
+			entry.mipmap != 0,
+			entry.filtering == 1 ? TextureDescriptor::Filtering::Point : TextureDescriptor::Filtering::Linear
+		};
+	}
+
+	MeshDescriptor AssetArchive::getMeshDescriptor(const Entry& entry) const
+	{
+		auto normals = MeshDescriptor::Normals::Auto;
+
+		if (entry.normals == 1) normals = MeshDescriptor::Normals::Generate;
+		else if (entry.normals == 2) normals = MeshDescriptor::Normals::GenerateSmooth;
+
+		return {
+			normals
+		};
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <engine/asset.h>
+#include <engine/core/file.h>
+
+namespace annileen
+{
+	// All built assets in a single file, written by tools/pack.py. Little endian, laid out as:
+	//   Header
+	//   Entry[entryCount], sorted by name hash
+	//   the asset names, one after the other without terminators
+	//   the built files, each starting at a multiple of the header's alignment
+	// Entries carry their descriptors already parsed, so no .toml is read for them. The whole
+	// archive is mapped once and the files are used where they are.
+	class AssetArchive final
+	{
+	public:
+		enum class Kind : uint8_t
+		{
+			Shader,
+			Texture,
+			Mesh,
+			Cubemap,
+			Font
+		};
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t alignment;
+			uint64_t namesOffset;
+			uint64_t namesSize;
+		};
+
+		struct Entry
+		{
+			uint64_t nameHash;
+			uint64_t offset;
+			uint64_t size;
+			uint32_t nameOffset;
+			uint32_t nameLength;
+			Kind kind;
+			// TextureDescriptor: mipmap, then 0 for linear and 1 for point filtering.
+			uint8_t mipmap;
+			uint8_t filtering;
+			// MeshDescriptor: 0 auto, 1 generate, 2 generate smooth.
+			uint8_t normals;
+			// Of the built file, without the dot. Importers like Assimp go by it.
+			char extension[8];
+			uint32_t reserved;
+		};
+
+		static_assert(sizeof(Header) == 32 && sizeof(Entry) == 48, "The archive layout is shared with tools/pack.py.");
+
+		static constexpr uint32_t currentVersion = 1;
+
+		// 64 bit FNV-1a, the same as tools/pack.py.
+		static uint64_t hashName(const std::string& name);
+
+		// Returns nullptr with the reason in error if the file is missing, of another version
+		// or doesn't hold what its index says.
+		static std::unique_ptr<AssetArchive> open(const std::string& fileName, std::string& error);
+
+		// nullptr if there is no asset of that name.
+		const Entry* find(const std::string& name) const;
+
+		size_t getEntryCount() const { return m_Header->entryCount; }
+		const Entry& getEntry(size_t index) const { return m_Entries[index]; }
+		size_t getIndex(const Entry& entry) const { return &entry - m_Entries; }
+
+		std::string getName(const Entry& entry) const;
+		std::string getExtension(const Entry& entry) const;
+		TextureDescriptor getTextureDescriptor(const Entry& entry) const;
+		MeshDescriptor getMeshDescriptor(const Entry& entry) const;
+
+		const uint8_t* getData(const Entry& entry) const { return m_File->getData() + entry.offset; }
+		// Whoever keeps data of the archive around keeps the mapping too.
+		const std::shared_ptr<MappedFile>& getFile() const { return m_File; }
+
+	private:
+		std::shared_ptr<MappedFile> m_File;
+		const Header* m_Header;
+		const Entry* m_Entries;
+
+		AssetArchive(std::shared_ptr<MappedFile> file);
+	};
+}
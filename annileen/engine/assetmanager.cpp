@@ -3,11 +3,27 @@
 #include "engine.h"
 #include "assetmanager.h"
 #include "modelloader.h"
+#include "mipchain.h"
+#include <engine/serviceprovider.h>
+#include <engine/core/profiler.h>
+
+#include <algorithm>
+#include <chrono>
 
 namespace annileen
 {
-	AssetManager::AssetManager(const std::string& assetfile)
+	AssetManager::AssetManager(const std::string& assetfile, bool useArchive) :
+		m_ShareShaderStages(true), m_FrameBudget(2.0), m_MemoryBudget(0), m_UseCount(0), m_PlaceholderTexture(BGFX_INVALID_HANDLE), m_PlaceholderCubemap(BGFX_INVALID_HANDLE)
 	{
+		if (useArchive)
+		{
+			std::string error;
+			m_Archive = AssetArchive::open(assetfile.substr(0, assetfile.find_last_of(".")) + ".pak", error);
+			if (m_Archive != nullptr) return;
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "{} Loading the loose asset files instead.", error);
+		}
+
 		try
 		{
 			loadAssetTable(assetfile);
@@ -37,59 +53,409 @@ namespace annileen
 
 	AssetType AssetManager::getType(const std::string& typetext)
 	{
-		if (typetext.compare("shader")) return AssetType::Shader;
-		if (typetext.compare("texture")) return AssetType::Texture;
-		if (typetext.compare("mesh")) return AssetType::Model;
+		if (typetext == "shader") return AssetType::Shader;
+		if (typetext == "texture") return AssetType::Texture;
+		if (typetext == "mesh") return AssetType::Model;
+		if (typetext == "cubemap") return AssetType::Cubemap;
+		if (typetext == "font") return AssetType::Font;
 		return AssetType::Undefined;
 	}
 
 	AssetTableEntry* AssetManager::getAssetEntry(const std::string& assetname)
 	{
-		assert(m_Assets.count(assetname) != 0 && "Trying to load an asset that does not exist.");
-		return &m_Assets.at(assetname);
+		auto it = m_Assets.find(assetname);
+		if (it == m_Assets.end() && m_Archive != nullptr)
+		{
+			const AssetArchive::Entry* packed = m_Archive->find(assetname);
+			if (packed != nullptr)
+			{
+				AssetType type = AssetType::Undefined;
+				if (packed->kind == AssetArchive::Kind::Shader) type = AssetType::Shader;
+				else if (packed->kind == AssetArchive::Kind::Texture) type = AssetType::Texture;
+				else if (packed->kind == AssetArchive::Kind::Mesh) type = AssetType::Model;
+				else if (packed->kind == AssetArchive::Kind::Cubemap) type = AssetType::Cubemap;
+				else if (packed->kind == AssetArchive::Kind::Font) type = AssetType::Font;
+
+				AssetTableEntry entry {
+					"",
+					type,
+					false,
+					nullptr,
+					static_cast<int32_t>(m_Archive->getIndex(*packed))
+				};
+
+				it = m_Assets.emplace(assetname, entry).first;
+			}
+		}
+
+		if (it == m_Assets.end())
+		{
+			ANNILEEN_LOGF_ERROR(LoggingChannel::Asset, "There is no asset '{}'.", assetname);
+			return nullptr;
+		}
+
+		return &it->second;
 	}
 
 	void AssetManager::unloadAssets()
 	{
 		for (const auto& [k, v] : m_Assets)
 		{
-			if (v.m_Loaded)
+			if (!v.m_Loaded) continue;
+
+			// Programs still loading or that failed hold no stages.
+			const size_t separator = k.find('|');
+			if (v.m_Type == AssetType::Shader && separator != std::string::npos && v.m_Asset->isReady())
 			{
-				if (v.m_Type == AssetType::Shader)
-				{
-					delete dynamic_cast<Shader*>(v.m_Asset);
-				}
+				releaseShaderStage(k.substr(0, separator));
+				releaseShaderStage(k.substr(separator + 1));
 			}
+
+			delete v.m_Asset;
 		}
 
 		m_Assets.clear();
 	}
 
-	const bgfx::Memory* AssetManager::loadBinaryFile(const std::string& filename)
+	void AssetManager::unloadAsset(AssetTableEntry* entry)
+	{
+		delete entry->m_Asset;
+		entry->m_Asset = nullptr;
+		entry->m_Loaded = false;
+	}
+
+	void addAssetReference(AssetManager* manager, AssetTableEntry* entry)
+	{
+		manager->addReference(entry);
+	}
+
+	void releaseAssetReference(AssetManager* manager, AssetTableEntry* entry)
+	{
+		manager->releaseReference(entry);
+	}
+
+	void AssetManager::addReference(AssetTableEntry* entry)
+	{
+		entry->m_References++;
+		entry->m_LastUsed = ++m_UseCount;
+	}
+
+	void AssetManager::releaseReference(AssetTableEntry* entry)
+	{
+		// Unloading waits for update(), so an asset released and acquired again within a
+		// frame isn't loaded twice.
+		entry->m_References--;
+		entry->m_LastUsed = ++m_UseCount;
+	}
+
+	uint64_t AssetManager::getMemoryUsage() const
+	{
+		uint64_t usage = 0;
+		for (const auto& [name, entry] : m_Assets)
+		{
+			if (entry.m_Loaded) usage += entry.m_Asset->getMemorySize();
+		}
+		return usage;
+	}
+
+	uint64_t AssetManager::getMemoryUsage(AssetType type) const
+	{
+		uint64_t usage = 0;
+		for (const auto& [name, entry] : m_Assets)
+		{
+			if (entry.m_Loaded && entry.m_Type == type) usage += entry.m_Asset->getMemorySize();
+		}
+		return usage;
+	}
+
+	std::vector<AssetResidency> AssetManager::getResidency() const
+	{
+		std::vector<AssetResidency> residency;
+		residency.reserve(m_Assets.size());
+
+		for (const auto& [name, entry] : m_Assets)
+		{
+			residency.push_back({
+				name,
+				entry.m_Type,
+				entry.m_Loaded,
+				entry.m_Loaded ? entry.m_Asset->m_State : AssetState::Ready,
+				entry.m_References,
+				entry.m_Pinned,
+				entry.m_Loaded ? entry.m_Asset->getMemorySize() : 0,
+				entry.m_LastUsed
+			});
+		}
+
+		return residency;
+	}
+
+	uint32_t AssetManager::unloadUnused()
+	{
+		if (m_MemoryBudget == 0) return 0;
+
+		uint64_t usage = getMemoryUsage();
+		if (usage <= m_MemoryBudget) return 0;
+
+		// Assets still loading or reloading are left alone, their requests point at them.
+		std::vector<std::pair<AssetTableEntry*, size_t>> unused;
+		for (auto& [name, entry] : m_Assets)
+		{
+			if (!entry.m_Loaded || entry.m_References > 0 || entry.m_Pinned || entry.m_Asset->m_State == AssetState::Loading) continue;
+			if (findRequest(name) != nullptr) continue;
+
+			const size_t size = entry.m_Asset->getMemorySize();
+			if (size > 0) unused.emplace_back(&entry, size);
+		}
+
+		std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b) { return a.first->m_LastUsed < b.first->m_LastUsed; });
+
+		uint32_t unloaded = 0;
+		for (const auto& [entry, size] : unused)
+		{
+			if (usage <= m_MemoryBudget) break;
+
+			unloadAsset(entry);
+			usage -= size;
+			unloaded++;
+		}
+
+		return unloaded;
+	}
+
+	std::string AssetManager::getProgramName(const std::string& vertex, const std::string& fragment)
+	{
+		// '|' can't be part of a file name, so no two pairs of stages give the same name.
+		return vertex + "|" + fragment;
+	}
+
+	bgfx::ShaderHandle AssetManager::acquireShaderStage(const std::string& name, const AssetBytes& bytes)
+	{
+		m_ShaderStats.stageRequests++;
+
+		auto it = m_ShaderStages.find(name);
+		if (it == m_ShaderStages.end())
+		{
+			AssetBytes code = bytes;
+			if (code.size == 0)
+			{
+				const AssetTableEntry* entry = getAssetEntry(name);
+				if (entry == nullptr) return BGFX_INVALID_HANDLE;
+				code = readAsset(*entry);
+			}
+			if (code.size == 0) return BGFX_INVALID_HANDLE;
+
+			bgfx::ShaderHandle handle = bgfx::createShader(makeRef(code));
+			bgfx::setName(handle, name.c_str());
+			m_ShaderStats.stagesCreated++;
+
+			if (!m_ShareShaderStages) return handle;
+
+			it = m_ShaderStages.emplace(name, ShaderStage { handle, 0 }).first;
+		}
+
+		it->second.references++;
+		return it->second.handle;
+	}
+
+	void AssetManager::releaseShaderStage(const std::string& name)
+	{
+		auto it = m_ShaderStages.find(name);
+		if (it == m_ShaderStages.end()) return;
+
+		// bgfx keeps the shader alive for programs still using it.
+		if (--it->second.references == 0)
+		{
+			bgfx::destroy(it->second.handle);
+			m_ShaderStages.erase(it);
+		}
+	}
+
+	bool AssetManager::createProgram(Shader* shader, const std::string& vertex, const std::string& fragment, const AssetBytes* stageBytes)
+	{
+		const AssetBytes none;
+		bgfx::ShaderHandle vertexHandle = acquireShaderStage(vertex, stageBytes != nullptr ? stageBytes[0] : none);
+		if (!bgfx::isValid(vertexHandle)) return false;
+
+		bgfx::ShaderHandle fragmentHandle = acquireShaderStage(fragment, stageBytes != nullptr ? stageBytes[1] : none);
+		if (!bgfx::isValid(fragmentHandle))
+		{
+			if (m_ShareShaderStages) releaseShaderStage(vertex);
+			else bgfx::destroy(vertexHandle);
+			return false;
+		}
+
+		// Shared stages stay with the cache, unshared ones go with the program.
+		shader->init(bgfx::createProgram(vertexHandle, fragmentHandle, !m_ShareShaderStages));
+		m_ShaderStats.programsCreated++;
+		return true;
+	}
+
+	const bgfx::Memory* AssetManager::makeRef(const AssetBytes& bytes)
+	{
+		// bgfx reads shader code with its size, no terminator is needed past the end.
+		return bgfx::makeRef(bytes.data, static_cast<uint32_t>(bytes.size),
+			[](void*, void* userData) { delete static_cast<std::shared_ptr<MappedFile>*>(userData); },
+			new std::shared_ptr<MappedFile>(bytes.file));
+	}
+
+	AssetManager::AssetBytes AssetManager::mapFile(const std::string& filename)
+	{
+		AssetBytes bytes;
+		bytes.file = MappedFile::open(filename);
+		if (bytes.file != nullptr)
+		{
+			bytes.data = bytes.file->getData();
+			bytes.size = bytes.file->getSize();
+		}
+		return bytes;
+	}
+
+	AssetManager::AssetBytes AssetManager::readAsset(const AssetTableEntry& entry) const
+	{
+		if (entry.m_ArchiveIndex < 0) return mapFile(entry.m_Filepath);
+
+		const AssetArchive::Entry& packed = m_Archive->getEntry(entry.m_ArchiveIndex);
+
+		AssetBytes bytes;
+		bytes.file = m_Archive->getFile();
+		bytes.data = m_Archive->getData(packed);
+		bytes.size = static_cast<size_t>(packed.size);
+		return bytes;
+	}
+
+	AssetManager::AssetBytes AssetManager::readCubemap(const AssetTableEntry& entry) const
+	{
+		if (entry.m_ArchiveIndex >= 0) return readAsset(entry);
+
+		return mapFile(readCubemapDescriptor(entry.m_Filepath).m_StripFile);
+	}
+
+	bool AssetManager::readMeshData(const AssetTableEntry& entry, std::vector<MeshData>& meshes, std::string& error) const
+	{
+		ModelLoader loader;
+		const MeshDescriptor descriptor = loadMeshDescriptor(&entry);
+
+		if (entry.m_ArchiveIndex < 0) return loader.loadMeshData(entry.m_Filepath, descriptor, meshes, error);
+
+		const AssetArchive::Entry& packed = m_Archive->getEntry(entry.m_ArchiveIndex);
+		const AssetBytes bytes = readAsset(entry);
+		return loader.loadMeshData(bytes.data, bytes.size, m_Archive->getExtension(packed), m_Archive->getName(packed), descriptor, meshes, error);
+	}
+
+	bool AssetManager::isCookedMesh(const AssetTableEntry& entry) const
+	{
+		if (entry.m_ArchiveIndex >= 0) return m_Archive->getExtension(m_Archive->getEntry(entry.m_ArchiveIndex)) == "amesh";
+
+		const std::string& path = entry.m_Filepath;
+		return path.size() > 6 && path.compare(path.size() - 6, 6, ".amesh") == 0;
+	}
+
+	bool AssetManager::readCookedMesh(const AssetBytes& bytes, const std::string& name, MeshFile& meshFile, std::string& error)
+	{
+		if (bytes.size == 0)
+		{
+			error = "Could not read mesh '" + name + "'.";
+			return false;
+		}
+
+		if (!meshFile.parse(bytes.data, bytes.size, error))
+		{
+			error = "Mesh '" + name + "': " + error;
+			return false;
+		}
+
+		if (meshFile.getHeader().submeshCount == 0)
+		{
+			error = "Mesh '" + name + "' has no meshes.";
+			return false;
+		}
+
+		return true;
+	}
+
+	void AssetManager::createCookedMeshes(const AssetBytes& bytes, const MeshFile& meshFile, MeshGroup* meshGroup)
 	{
-		std::ifstream file;
-		file.open(filename.c_str(), std::ios::binary);
-		assert(file.is_open() && "Error loading asset file.");
+		const bgfx::VertexLayout layout = meshFile.getLayout();
+		const bool index32 = meshFile.getHeader().indexSize == sizeof(uint32_t);
+
+		for (uint32_t i = 0; i < meshFile.getHeader().submeshCount; ++i)
+		{
+			const MeshFile::Submesh& submesh = meshFile.getSubmesh(i);
+
+			const Aabb bounds {
+				glm::vec3(submesh.boundsMin[0], submesh.boundsMin[1], submesh.boundsMin[2]),
+				glm::vec3(submesh.boundsMax[0], submesh.boundsMax[1], submesh.boundsMax[2])
+			};
 
-		file.seekg(0, std::ios::end);
-		size_t size = file.tellg();
-		file.seekg(0, std::ios::beg);
+			const bgfx::Memory* vertices = makeRef({ bytes.file, meshFile.getVertices(submesh), meshFile.getVertexBytes(submesh) });
+			const bgfx::Memory* indices = submesh.indexCount > 0 ?
+				makeRef({ bytes.file, meshFile.getIndices(submesh), meshFile.getIndexBytes(submesh) }) : nullptr;
 
-		const bgfx::Memory* mem = bgfx::alloc(size + 1);
-		file.read((char*)mem->data, size);
-		file.close();
+			Mesh* mesh = new Mesh();
+			mesh->init(vertices, layout, indices, index32, bounds);
+			meshGroup->m_Meshes.push_back(mesh);
+		}
+	}
+
+	bimg::ImageContainer* AssetManager::decodeImage(const AssetBytes& bytes)
+	{
+		if (bytes.size == 0) return nullptr;
 
-		mem->data[mem->size - 1] = '\0';
-		return mem;
+		// Every decoder copies the pixels out, the mapping can go right after.
+		return bimg::imageParse(Engine::getAllocator(), bytes.data, static_cast<uint32_t>(bytes.size));
 	}
 
-	std::tuple<bgfx::TextureHandle, bgfx::TextureInfo, bimg::ImageContainer*> AssetManager::loadTextureData(const std::string& file, const TextureDescriptor& descriptor)
+	bimg::ImageContainer* AssetManager::prepareImage(bimg::ImageContainer* image, bool generateMips)
 	{
-		auto textureData = loadBinaryFile(file);
-		bx::Error err;
-		auto imageContainer = bimg::imageParse(Engine::getAllocator(), textureData->data, textureData->size);
+		if (image == nullptr) return nullptr;
+
+		// Only reads what bgfx::init filled in, fine off the main thread. Formats the GPU lacks
+		// would be decoded by bgfx anyway, on the render thread.
+		const uint16_t support = bgfx::getCaps()->formats[image->m_format];
+		const uint16_t needed = image->m_cubeMap ? BGFX_CAPS_FORMAT_TEXTURE_CUBE : BGFX_CAPS_FORMAT_TEXTURE_2D;
+
+		if (bimg::isCompressed(image->m_format) && (support & needed) == 0)
+		{
+			bimg::ImageContainer* decoded = bimg::imageConvert(Engine::getAllocator(), bimg::TextureFormat::RGBA8, *image);
+			if (decoded != nullptr)
+			{
+				bimg::imageFree(image);
+				image = decoded;
+			}
+		}
+
+		const bimg::TextureFormat::Enum format = image->m_format;
+		const bool eightBit = format == bimg::TextureFormat::RGBA8 || format == bimg::TextureFormat::BGRA8 ||
+			format == bimg::TextureFormat::RGB8 || format == bimg::TextureFormat::RG8 || format == bimg::TextureFormat::R8;
+
+		if (!generateMips || image->m_numMips > 1 || image->m_cubeMap || image->m_depth > 1 || image->m_numLayers > 1 || !eightBit)
+		{
+			return image;
+		}
+
+		bimg::ImageContainer* rgba8 = image;
+		if (format != bimg::TextureFormat::RGBA8)
+		{
+			rgba8 = bimg::imageConvert(Engine::getAllocator(), bimg::TextureFormat::RGBA8, *image);
+			if (rgba8 == nullptr) return image;
+		}
+
+		bimg::ImageContainer* mipmapped = bimg::imageAlloc(Engine::getAllocator(), bimg::TextureFormat::RGBA8,
+			uint16_t(image->m_width), uint16_t(image->m_height), 1, 1, false, true);
+		MipChain::generate(static_cast<const uint8_t*>(rgba8->m_data), image->m_width, image->m_height, static_cast<uint8_t*>(mipmapped->m_data));
+		mipmapped->m_orientation = image->m_orientation;
+
+		if (rgba8 != image) bimg::imageFree(rgba8);
+		bimg::imageFree(image);
+		return mipmapped;
+	}
 
-		const bgfx::Memory* mem = bgfx::makeRef(imageContainer->m_data, imageContainer->m_size);
+	std::tuple<bgfx::TextureHandle, bgfx::TextureInfo, bimg::Orientation::Enum> AssetManager::createTexture(bimg::ImageContainer* imageContainer, const TextureDescriptor& descriptor, const std::string& name)
+	{
+		// The image is freed once bgfx is done with its pixels.
+		const bgfx::Memory* mem = bgfx::makeRef(imageContainer->m_data, imageContainer->m_size,
+			[](void*, void* userData) { bimg::imageFree(static_cast<bimg::ImageContainer*>(userData)); }, imageContainer);
 
 		auto format = bgfx::TextureFormat::Enum(imageContainer->m_format);
 		uint64_t flags = BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE;
@@ -124,7 +490,7 @@ namespace annileen
 
 		assert(bgfx::isValid(handle) && "Couldn't create texture");
 
-		bgfx::setName(handle, file.c_str());
+		bgfx::setName(handle, name.c_str());
 
 		bgfx::TextureInfo info;
 
@@ -138,129 +504,921 @@ namespace annileen
 			imageContainer->m_numLayers,
 			bgfx::TextureFormat::Enum(imageContainer->m_format));
 
-		delete textureData;
-		return std::make_tuple(handle, info, imageContainer);
+		return std::make_tuple(handle, info, imageContainer->m_orientation);
 	}
 
-	AssetManager::~AssetManager()
+	std::tuple<bgfx::TextureHandle, bgfx::TextureInfo, bimg::Orientation::Enum> AssetManager::loadTextureData(const AssetBytes& bytes, const TextureDescriptor& descriptor, const std::string& name)
 	{
-		unloadAssets();
+		auto imageContainer = prepareImage(decodeImage(bytes), descriptor.m_MipMap);
+		assert(imageContainer != nullptr && "Error loading texture file.");
+
+		return createTexture(imageContainer, descriptor, name);
 	}
 
-	// Load functions
+	void AssetManager::readTexture(const AssetTableEntry& source, LoadRequest& request) const
+	{
+		request.textureDescriptor = loadTextureDescriptor(&source);
+		request.image = prepareImage(decodeImage(readAsset(source)), request.textureDescriptor.m_MipMap);
+	}
 
-	Shader* AssetManager::loadShader(const std::string& vertex, const std::string& fragment)
+	void AssetManager::readMesh(const AssetTableEntry& source, LoadRequest& request) const
 	{
-		std::string vertexfragment = vertex + fragment;
-		if (m_Assets.count(vertexfragment) != 0)
+		if (!isCookedMesh(source))
 		{
-			auto entry = getAssetEntry(vertexfragment);
-			if (entry->m_Loaded)
-			{
-				return static_cast<Shader*>(entry->m_Asset);
-			}
+			readMeshData(source, request.meshes, request.error);
+			return;
 		}
 
-		// TODO: store both handles somewhere, otherwise it will compile both shaders everytime
-		// there's a new combination of vertex+shader.
-
-		auto vertexShaderData = loadBinaryFile(getAssetEntry(vertex)->m_Filepath);
-		bgfx::ShaderHandle vertexHandle = bgfx::createShader(vertexShaderData);
+		// Only the pages are brought in here, the buffers are made from them as they are.
+		request.files[0] = readAsset(source);
+		if (readCookedMesh(request.files[0], request.name, request.cookedMesh, request.error))
+		{
+			request.files[0].prefetch();
+		}
+	}
 
-		auto fragmentShaderData = loadBinaryFile(getAssetEntry(fragment)->m_Filepath);
-		bgfx::ShaderHandle fragmentHandle = bgfx::createShader(fragmentShaderData);
+	void AssetManager::createPlaceholders()
+	{
+		if (bgfx::isValid(m_PlaceholderTexture)) return;
 
-		bgfx::ProgramHandle programHandle = bgfx::createProgram(vertexHandle, fragmentHandle, true);
+		const uint32_t white[6] = { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff };
+		const uint64_t flags = BGFX_TEXTURE_NONE | BGFX_SAMPLER_POINT;
 
-		Shader* shader = new Shader();
-		shader->init(programHandle);
+		m_PlaceholderTexture = bgfx::createTexture2D(1, 1, false, 1, bgfx::TextureFormat::RGBA8, flags, bgfx::copy(white, sizeof(uint32_t)));
+		m_PlaceholderCubemap = bgfx::createTextureCube(1, false, 1, bgfx::TextureFormat::RGBA8, flags, bgfx::copy(white, sizeof(white)));
 
-		m_Assets[vertexfragment] = AssetTableEntry {
-			"",
-			AssetType::Shader,
-			true,
-			dynamic_cast<AssetObject*>(shader)
-		};
-	
-		return shader;
+		bgfx::setName(m_PlaceholderTexture, "Placeholder Texture");
+		bgfx::setName(m_PlaceholderCubemap, "Placeholder Cubemap");
 	}
 
-	Texture* AssetManager::loadTexture(const std::string& tex)
+	AssetManager::LoadRequest& AssetManager::startLoading(LoadKind kind, const std::string& name, AssetObject* asset, const std::function<void(LoadRequest&)>& read, bool reload)
 	{
-		auto entry = getAssetEntry(tex);
-		if (entry->m_Loaded)
+		if (!reload) asset->m_State = AssetState::Loading;
+
+		m_Requests.emplace_back();
+		LoadRequest& request = m_Requests.back();
+		request.kind = kind;
+		request.name = name;
+		request.asset = asset;
+		request.reload = reload;
+
+		// Descriptors and files may be broken, the job must not throw.
+		auto job = [&request, read]()
 		{
-			return static_cast<Texture*>(entry->m_Asset);
-		}
+			ANNILEEN_PROFILE_SCOPE("AssetManager::read");
 
-		auto descriptor = loadTextureDescriptor(entry);
-		
-		bgfx::TextureHandle handle;
-		bgfx::TextureInfo info;
-		bimg::ImageContainer* imageContainer = nullptr;
-		std::tie(handle, info, imageContainer) = loadTextureData(entry->m_Filepath, descriptor);
+			try
+			{
+				read(request);
+			}
+			catch (const std::exception& e)
+			{
+				request.error = "Could not load asset '" + request.name + "': " + e.what();
+			}
+		};
 
-		Texture* texture = new Texture(handle, info, imageContainer->m_orientation);
-		entry->m_Asset = static_cast<AssetObject*>(texture);
-		entry->m_Loaded = true;
-		return texture;
+		JobSystem* jobs = ServiceProvider::getJobSystem();
+		if (jobs != nullptr)
+		{
+			jobs->runBackground(job, &request.reading);
+		}
+		else
+		{
+			job();
+		}
+
+		return request;
 	}
 
-	Cubemap* AssetManager::loadCubemap(const std::string& name)
+	void AssetManager::finishLoading(LoadRequest& request)
 	{
-		auto entry = getAssetEntry(name);
-		if (entry->m_Loaded)
+		ANNILEEN_PROFILE_SCOPE("AssetManager::finishLoading");
+
+		if (request.error.empty())
 		{
-			return static_cast<Cubemap*>(entry->m_Asset);
+			if ((request.kind == LoadKind::Texture || request.kind == LoadKind::Cubemap) && request.image == nullptr)
+			{
+				request.error = "Could not read or decode image '" + request.name + "'.";
+			}
+			else if (request.kind == LoadKind::Mesh && request.meshes.empty() && request.files[0].data == nullptr)
+			{
+				request.error = "Mesh '" + request.name + "' has no meshes.";
+			}
 		}
 
-		auto descriptor = loadCubemapDescriptor(entry);
+		if (!request.error.empty())
+		{
+			ANNILEEN_LOG_ERROR(LoggingChannel::Asset, request.error);
+			if (request.image != nullptr) bimg::imageFree(request.image);
 
-		bgfx::TextureHandle handle;
-		bgfx::TextureInfo info;
-		bimg::ImageContainer* imageContainer = nullptr;
-		std::tie(handle, info, imageContainer) = loadTextureData(descriptor.m_StripFile, {});
+			if (request.reload)
+			{
+				ANNILEEN_LOGF_WARNING(LoggingChannel::Asset, "Reloading '{}' failed, the loaded one stays.", request.name);
+				return;
+			}
 
-		Cubemap* cubemap = new Cubemap(handle, info, imageContainer->m_orientation);
-		entry->m_Asset = static_cast<AssetObject*>(cubemap);
-		entry->m_Loaded = true;
-		return cubemap;
-	}
+			request.asset->m_State = AssetState::Failed;
+			return;
+		}
 
-	MeshGroup* AssetManager::loadMesh(const std::string& name)
-	{
-		auto entry = getAssetEntry(name);
-		if (entry->m_Loaded)
+		switch (request.kind)
 		{
-			return static_cast<MeshGroup*>(entry->m_Asset);
+		case LoadKind::Shader:
+		{
+			if (!createProgram(static_cast<Shader*>(request.asset), request.stages[0], request.stages[1], request.files))
+			{
+				ANNILEEN_LOGF_ERROR(LoggingChannel::Asset, "Could not read shader '{}'.", request.name);
+				request.asset->m_State = AssetState::Failed;
+				return;
+			}
+			break;
 		}
+		case LoadKind::Texture:
+		{
+			Texture* texture = static_cast<Texture*>(request.asset);
+			bgfx::TextureHandle previous = BGFX_INVALID_HANDLE;
+			if (texture->m_OwnsHandle) previous = texture->m_Handle;
 
-		const auto descriptor = loadMeshDescriptor(entry);
-
-		ModelLoader loader;
-		auto meshGroup = loader.loadMesh(entry->m_Filepath, descriptor);
-		entry->m_Asset = static_cast<AssetObject*>(meshGroup);
-		entry->m_Loaded = true;
-		return meshGroup;
-	}
+			std::tie(texture->m_Handle, texture->m_Info, texture->m_Orientation) = createTexture(request.image, request.textureDescriptor, request.name);
+			texture->m_OwnsHandle = true;
 
-	Font* AssetManager::loadFont(const std::string& name)
-	{
-		auto entry = getAssetEntry(name);
-		if (entry->m_Loaded)
+			// bgfx destroys it once the frame submitted with it is done.
+			if (bgfx::isValid(previous)) bgfx::destroy(previous);
+			break;
+		}
+		case LoadKind::Cubemap:
 		{
-			return static_cast<Font*>(entry->m_Asset);
+			Cubemap* cubemap = static_cast<Cubemap*>(request.asset);
+			bgfx::TextureHandle previous = BGFX_INVALID_HANDLE;
+			if (cubemap->m_OwnsHandle) previous = cubemap->m_Handle;
+
+			std::tie(cubemap->m_Handle, cubemap->m_Info, cubemap->m_Orientation) = createTexture(request.image, {}, request.name);
+			cubemap->m_OwnsHandle = true;
+
+			if (bgfx::isValid(previous)) bgfx::destroy(previous);
+			break;
 		}
+		case LoadKind::Mesh:
+		{
+			MeshGroup* meshGroup = static_cast<MeshGroup*>(request.asset);
+			std::vector<Mesh*> previous;
+			previous.swap(meshGroup->m_Meshes);
 
-		Font* font = new Font(entry->m_Filepath);
-		entry->m_Asset = static_cast<AssetObject*>(font);
-		entry->m_Loaded = true;
-		return font;
+			if (request.files[0].data != nullptr)
+			{
+				createCookedMeshes(request.files[0], request.cookedMesh, meshGroup);
+			}
+			for (const MeshData& meshData : request.meshes)
+			{
+				Mesh* mesh = new Mesh();
+				meshData.createMesh(mesh);
+				meshGroup->m_Meshes.push_back(mesh);
+			}
+
+			// Reloaded meshes replace the ones drawn until now.
+			for (Mesh* mesh : previous)
+			{
+				delete mesh;
+			}
+			meshGroup->m_Revision++;
+			break;
+		}
+		case LoadKind::Font:
+			static_cast<Font*>(request.asset)->create(request.files[0].file, request.files[0].data, request.files[0].size);
+			break;
+		case LoadKind::ShaderStage:
+			swapShaderStage(request);
+			break;
+		}
+
+		request.image = nullptr;
+		if (request.asset != nullptr) request.asset->m_State = AssetState::Ready;
+	}
+
+	void AssetManager::swapShaderStage(LoadRequest& request)
+	{
+		// Released while it was read, nothing uses it any more.
+		auto stage = m_ShaderStages.find(request.name);
+		if (stage == m_ShaderStages.end()) return;
+
+		// The programs hold on to the previous stage until they are destroyed below.
+		bgfx::ShaderHandle handle = bgfx::createShader(makeRef(request.files[0]));
+		bgfx::setName(handle, request.name.c_str());
+		bgfx::destroy(stage->second.handle);
+		stage->second.handle = handle;
+		m_ShaderStats.stagesReloaded++;
+
+		for (auto& [name, entry] : m_Assets)
+		{
+			const size_t separator = name.find('|');
+			if (separator == std::string::npos || !entry.m_Loaded || !entry.m_Asset->isReady()) continue;
+
+			const std::string vertex = name.substr(0, separator);
+			const std::string fragment = name.substr(separator + 1);
+			if (vertex != request.name && fragment != request.name) continue;
+
+			Shader* shader = static_cast<Shader*>(entry.m_Asset);
+			const bgfx::ProgramHandle previous = shader->getProgram();
+			shader->init(bgfx::createProgram(m_ShaderStages.at(vertex).handle, m_ShaderStages.at(fragment).handle, false));
+			bgfx::destroy(previous);
+		}
+	}
+
+	AssetManager::LoadRequest* AssetManager::findRequest(const std::string& name)
+	{
+		for (LoadRequest& request : m_Requests)
+		{
+			if (request.name == name) return &request;
+		}
+		return nullptr;
+	}
+
+	void AssetManager::finishRequest(std::list<LoadRequest>::iterator request)
+	{
+		JobSystem* jobs = ServiceProvider::getJobSystem();
+		if (jobs != nullptr) jobs->wait(request->reading);
+
+		finishLoading(*request);
+		m_Requests.erase(request);
+	}
+
+	void AssetManager::waitForAsset(AssetObject* asset)
+	{
+		if (asset == nullptr || asset->m_State != AssetState::Loading) return;
+
+		for (auto it = m_Requests.begin(); it != m_Requests.end(); ++it)
+		{
+			if (it->asset != asset) continue;
+
+			finishRequest(it);
+			return;
+		}
+	}
+
+	void AssetManager::update()
+	{
+		ANNILEEN_PROFILE_FUNCTION();
+
+		if (m_FileWatcher != nullptr) reloadChangedAssets();
+
+		auto start = std::chrono::steady_clock::now();
+		bool first = true;
+
+		for (auto it = m_Requests.begin(); it != m_Requests.end();)
+		{
+			if (!it->reading.isDone())
+			{
+				++it;
+				continue;
+			}
+
+			if (!first && std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= m_FrameBudget)
+			{
+				break;
+			}
+
+			finishLoading(*it);
+			it = m_Requests.erase(it);
+			first = false;
+		}
+
+		unloadUnused();
+	}
+
+	void AssetManager::finishAll()
+	{
+		// Reloads leave their asset Ready, so they are waited for by request.
+		while (!m_Requests.empty())
+		{
+			finishRequest(m_Requests.begin());
+		}
+	}
+
+	AssetManager::~AssetManager()
+	{
+		// The logger may be gone already, loads still running are dropped quietly.
+		JobSystem* jobs = ServiceProvider::getJobSystem();
+		for (auto& request : m_Requests)
+		{
+			if (jobs != nullptr) jobs->wait(request.reading);
+			if (request.image != nullptr) bimg::imageFree(request.image);
+		}
+		m_Requests.clear();
+
+		unloadAssets();
+
+		if (bgfx::isValid(m_PlaceholderTexture)) bgfx::destroy(m_PlaceholderTexture);
+		if (bgfx::isValid(m_PlaceholderCubemap)) bgfx::destroy(m_PlaceholderCubemap);
+	}
+
+	// Load functions
+
+	Shader* AssetManager::loadShader(const std::string& vertex, const std::string& fragment)
+	{
+		return loadShader(vertex, fragment, nullptr);
+	}
+
+	Shader* AssetManager::loadShader(const std::string& vertex, const std::string& fragment, const AssetBytes* stageBytes)
+	{
+		ANNILEEN_PROFILE_SCOPE("AssetManager::loadShader");
+
+		m_ShaderStats.programRequests++;
+
+		const std::string vertexfragment = getProgramName(vertex, fragment);
+		if (m_Assets.count(vertexfragment) != 0)
+		{
+			auto entry = getAssetEntry(vertexfragment);
+			if (entry->m_Loaded)
+			{
+				waitForAsset(entry->m_Asset);
+				return static_cast<Shader*>(entry->m_Asset);
+			}
+		}
+
+		Shader* shader = new Shader();
+		if (!createProgram(shader, vertex, fragment, stageBytes))
+		{
+			ANNILEEN_LOGF_ERROR(LoggingChannel::Asset, "Could not read shader '{}'.", vertexfragment);
+			shader->m_State = AssetState::Failed;
+		}
+
+		m_Assets[vertexfragment] = AssetTableEntry {
+			"",
+			AssetType::Shader,
+			true,
+			dynamic_cast<AssetObject*>(shader)
+		};
+	
+		return shader;
+	}
+
+	Texture* AssetManager::loadTexture(const std::string& tex)
+	{
+		ANNILEEN_PROFILE_SCOPE("AssetManager::loadTexture");
+
+		auto entry = getAssetEntry(tex);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			waitForAsset(entry->m_Asset);
+			return static_cast<Texture*>(entry->m_Asset);
+		}
+
+		auto descriptor = loadTextureDescriptor(entry);
+		
+		bgfx::TextureHandle handle;
+		bgfx::TextureInfo info;
+		bimg::Orientation::Enum orientation;
+		std::tie(handle, info, orientation) = loadTextureData(readAsset(*entry), descriptor, tex);
+
+		Texture* texture = new Texture(handle, info, orientation);
+		texture->m_OwnsHandle = true;
+		entry->m_Asset = static_cast<AssetObject*>(texture);
+		entry->m_Loaded = true;
+		return texture;
+	}
+
+	Cubemap* AssetManager::loadCubemap(const std::string& name)
+	{
+		ANNILEEN_PROFILE_SCOPE("AssetManager::loadCubemap");
+
+		auto entry = getAssetEntry(name);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			waitForAsset(entry->m_Asset);
+			return static_cast<Cubemap*>(entry->m_Asset);
+		}
+
+		bgfx::TextureHandle handle;
+		bgfx::TextureInfo info;
+		bimg::Orientation::Enum orientation;
+		std::tie(handle, info, orientation) = loadTextureData(readCubemap(*entry), {}, name);
+
+		Cubemap* cubemap = new Cubemap(handle, info, orientation);
+		cubemap->m_OwnsHandle = true;
+		entry->m_Asset = static_cast<AssetObject*>(cubemap);
+		entry->m_Loaded = true;
+		return cubemap;
+	}
+
+	MeshGroup* AssetManager::loadMesh(const std::string& name)
+	{
+		ANNILEEN_PROFILE_SCOPE("AssetManager::loadMesh");
+
+		auto entry = getAssetEntry(name);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			waitForAsset(entry->m_Asset);
+			return static_cast<MeshGroup*>(entry->m_Asset);
+		}
+
+		MeshGroup* meshGroup = new MeshGroup();
+		std::vector<MeshData> meshes;
+		std::string error;
+
+		if (isCookedMesh(*entry))
+		{
+			const AssetBytes bytes = readAsset(*entry);
+			MeshFile meshFile;
+			if (!readCookedMesh(bytes, name, meshFile, error))
+			{
+				ANNILEEN_LOG_ERROR(LoggingChannel::Asset, error);
+				exit(-1);
+			}
+
+			createCookedMeshes(bytes, meshFile, meshGroup);
+		}
+		else if (!readMeshData(*entry, meshes, error))
+		{
+			ANNILEEN_LOG_ERROR(LoggingChannel::Asset, error);
+			exit(-1);
+		}
+
+		for (const MeshData& meshData : meshes)
+		{
+			Mesh* mesh = new Mesh();
+			meshData.createMesh(mesh);
+			meshGroup->m_Meshes.push_back(mesh);
+		}
+
+		entry->m_Asset = static_cast<AssetObject*>(meshGroup);
+		entry->m_Loaded = true;
+		return meshGroup;
+	}
+
+	void AssetManager::addShaderPermutation(const ShaderPermutation& permutation)
+	{
+		m_ShaderPermutations.push_back(permutation);
+	}
+
+	void AssetManager::loadShaderPermutations()
+	{
+		ANNILEEN_PROFILE_SCOPE("AssetManager::loadShaderPermutations");
+
+		// The permutations not loaded yet, and each of their stages not created yet, once.
+		std::vector<const ShaderPermutation*> permutations;
+		std::vector<std::string> stageNames;
+		for (const ShaderPermutation& permutation : m_ShaderPermutations)
+		{
+			if (m_Assets.count(getProgramName(permutation.vertex, permutation.fragment)) != 0) continue;
+
+			if (!hasAsset(permutation.vertex) || !hasAsset(permutation.fragment))
+			{
+				ANNILEEN_LOGF_WARNING(LoggingChannel::Asset, "Shader permutation '{}' with features {:#x} skipped, '{}' or '{}' is not an asset.",
+					permutation.program, permutation.features, permutation.vertex, permutation.fragment);
+				continue;
+			}
+
+			permutations.push_back(&permutation);
+			for (const std::string* stage : { &permutation.vertex, &permutation.fragment })
+			{
+				if (m_ShaderStages.count(*stage) == 0 && std::find(stageNames.begin(), stageNames.end(), *stage) == stageNames.end())
+				{
+					stageNames.push_back(*stage);
+				}
+			}
+		}
+
+		// Looked up here, finding archived entries adds them to the table.
+		std::vector<AssetTableEntry> entries;
+		for (const std::string& name : stageNames) entries.push_back(*getAssetEntry(name));
+
+		std::vector<AssetBytes> stageBytes(stageNames.size());
+		auto read = [this, &entries, &stageBytes](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				stageBytes[i] = readAsset(entries[i]);
+				stageBytes[i].prefetch();
+			}
+		};
+
+		JobSystem* jobs = ServiceProvider::getJobSystem();
+		if (jobs != nullptr) jobs->parallelFor(stageNames.size(), 1, read);
+		else read(0, stageNames.size());
+
+		auto bytesOf = [&stageNames, &stageBytes](const std::string& name)
+		{
+			const size_t index = std::find(stageNames.begin(), stageNames.end(), name) - stageNames.begin();
+			return index < stageBytes.size() ? stageBytes[index] : AssetBytes();
+		};
+
+		for (const ShaderPermutation* permutation : permutations)
+		{
+			const AssetBytes bytes[2] = { bytesOf(permutation->vertex), bytesOf(permutation->fragment) };
+			loadShader(permutation->vertex, permutation->fragment, bytes);
+		}
+	}
+
+	Shader* AssetManager::getShaderPermutation(const std::string& program, uint32_t features)
+	{
+		for (const ShaderPermutation& permutation : m_ShaderPermutations)
+		{
+			if (permutation.program == program && permutation.features == features)
+			{
+				return loadShader(permutation.vertex, permutation.fragment);
+			}
+		}
+
+		ANNILEEN_LOGF_ERROR(LoggingChannel::Asset, "There is no permutation of shader '{}' with features {:#x}.", program, features);
+		return nullptr;
+	}
+
+	Font* AssetManager::loadFont(const std::string& name)
+	{
+		ANNILEEN_PROFILE_SCOPE("AssetManager::loadFont");
+
+		auto entry = getAssetEntry(name);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			waitForAsset(entry->m_Asset);
+			return static_cast<Font*>(entry->m_Asset);
+		}
+
+		Font* font = new Font();
+		const AssetBytes bytes = readAsset(*entry);
+		font->create(bytes.file, bytes.data, bytes.size);
+		entry->m_Asset = static_cast<AssetObject*>(font);
+		entry->m_Loaded = true;
+		return font;
+	}
+
+	Shader* AssetManager::loadShaderAsync(const std::string& vertex, const std::string& fragment)
+	{
+		m_ShaderStats.programRequests++;
+
+		const std::string vertexfragment = getProgramName(vertex, fragment);
+		if (m_Assets.count(vertexfragment) != 0 && m_Assets.at(vertexfragment).m_Loaded)
+		{
+			return static_cast<Shader*>(m_Assets.at(vertexfragment).m_Asset);
+		}
+
+		const AssetTableEntry* vertexEntry = getAssetEntry(vertex);
+		const AssetTableEntry* fragmentEntry = getAssetEntry(fragment);
+		if (vertexEntry == nullptr || fragmentEntry == nullptr) return nullptr;
+
+		// An invalid program until it is loaded, bgfx drops draws submitted with it.
+		Shader* shader = new Shader();
+		m_Assets[vertexfragment] = AssetTableEntry {
+			"",
+			AssetType::Shader,
+			true,
+			dynamic_cast<AssetObject*>(shader)
+		};
+
+		// Stages already created aren't read again. One released before the load finishes is
+		// read then, on the main thread.
+		const AssetTableEntry stages[2] = { *vertexEntry, *fragmentEntry };
+		const bool read[2] = { m_ShaderStages.count(vertex) == 0, m_ShaderStages.count(fragment) == 0 };
+
+		LoadRequest& loading = startLoading(LoadKind::Shader, vertexfragment, shader, [this, stages, read](LoadRequest& request)
+		{
+			// Read in here, not on the render thread when bgfx creates the shaders.
+			for (int stage = 0; stage < 2; ++stage)
+			{
+				if (!read[stage]) continue;
+
+				request.files[stage] = readAsset(stages[stage]);
+				if (request.files[stage].size == 0)
+				{
+					request.error = "Could not read shader '" + request.name + "'.";
+					return;
+				}
+				request.files[stage].prefetch();
+			}
+		});
+
+		// Only used by finishLoading, on this thread.
+		loading.stages[0] = vertex;
+		loading.stages[1] = fragment;
+
+		return shader;
+	}
+
+	Texture* AssetManager::loadTextureAsync(const std::string& tex)
+	{
+		auto entry = getAssetEntry(tex);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			return static_cast<Texture*>(entry->m_Asset);
+		}
+
+		createPlaceholders();
+
+		bgfx::TextureInfo info;
+		bgfx::calcTextureSize(info, 1, 1, 1, false, false, 1, bgfx::TextureFormat::RGBA8);
+
+		Texture* texture = new Texture(m_PlaceholderTexture, info, bimg::Orientation::R0);
+		entry->m_Asset = static_cast<AssetObject*>(texture);
+		entry->m_Loaded = true;
+
+		const AssetTableEntry source = *entry;
+		startLoading(LoadKind::Texture, tex, texture, [this, source](LoadRequest& request) { readTexture(source, request); });
+
+		return texture;
+	}
+
+	Cubemap* AssetManager::loadCubemapAsync(const std::string& name)
+	{
+		auto entry = getAssetEntry(name);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			return static_cast<Cubemap*>(entry->m_Asset);
+		}
+
+		createPlaceholders();
+
+		bgfx::TextureInfo info;
+		bgfx::calcTextureSize(info, 1, 1, 1, true, false, 1, bgfx::TextureFormat::RGBA8);
+
+		Cubemap* cubemap = new Cubemap(m_PlaceholderCubemap, info, bimg::Orientation::R0);
+		entry->m_Asset = static_cast<AssetObject*>(cubemap);
+		entry->m_Loaded = true;
+
+		const AssetTableEntry source = *entry;
+		startLoading(LoadKind::Cubemap, name, cubemap, [this, source](LoadRequest& request)
+		{
+			request.image = prepareImage(decodeImage(readCubemap(source)), false);
+		});
+
+		return cubemap;
+	}
+
+	MeshGroup* AssetManager::loadMeshAsync(const std::string& name)
+	{
+		auto entry = getAssetEntry(name);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			return static_cast<MeshGroup*>(entry->m_Asset);
+		}
+
+		// Empty until loaded, so models using it draw nothing and have no bounds.
+		MeshGroup* meshGroup = new MeshGroup();
+		entry->m_Asset = static_cast<AssetObject*>(meshGroup);
+		entry->m_Loaded = true;
+
+		const AssetTableEntry source = *entry;
+		startLoading(LoadKind::Mesh, name, meshGroup, [this, source](LoadRequest& request) { readMesh(source, request); });
+
+		return meshGroup;
+	}
+
+	Font* AssetManager::loadFontAsync(const std::string& name)
+	{
+		auto entry = getAssetEntry(name);
+		if (entry == nullptr) return nullptr;
+
+		entry->m_Pinned = true;
+		if (entry->m_Loaded)
+		{
+			return static_cast<Font*>(entry->m_Asset);
+		}
+
+		Font* font = new Font();
+		entry->m_Asset = static_cast<AssetObject*>(font);
+		entry->m_Loaded = true;
+
+		const AssetTableEntry source = *entry;
+		startLoading(LoadKind::Font, name, font, [this, source](LoadRequest& request)
+		{
+			request.files[0] = readAsset(source);
+			if (request.files[0].size == 0)
+			{
+				request.error = "Could not read font '" + request.name + "'.";
+				return;
+			}
+			request.files[0].prefetch();
+		});
+
+		return font;
+	}
+
+	template <typename T>
+	AssetRef<T> AssetManager::acquire(const std::string& name, T* (AssetManager::*load)(const std::string&))
+	{
+		AssetTableEntry* entry = getAssetEntry(name);
+		if (entry == nullptr) return {};
+
+		// The load functions pin what they hand out, a reference doesn't need to.
+		const bool pinned = entry->m_Pinned;
+		T* asset = (this->*load)(name);
+		entry->m_Pinned = pinned;
+
+		if (asset == nullptr) return {};
+		return AssetRef<T>(this, entry, asset);
+	}
+
+	AssetRef<Texture> AssetManager::acquireTexture(const std::string& name, bool async)
+	{
+		return acquire(name, async ? &AssetManager::loadTextureAsync : &AssetManager::loadTexture);
+	}
+
+	AssetRef<Cubemap> AssetManager::acquireCubemap(const std::string& name, bool async)
+	{
+		return acquire(name, async ? &AssetManager::loadCubemapAsync : &AssetManager::loadCubemap);
+	}
+
+	AssetRef<MeshGroup> AssetManager::acquireMesh(const std::string& name, bool async)
+	{
+		return acquire(name, async ? &AssetManager::loadMeshAsync : &AssetManager::loadMesh);
+	}
+
+	AssetRef<Font> AssetManager::acquireFont(const std::string& name, bool async)
+	{
+		return acquire(name, async ? &AssetManager::loadFontAsync : &AssetManager::loadFont);
+	}
+
+	bool AssetManager::setHotReload(bool enabled, FileWatcher::Mode mode)
+	{
+		m_FileWatcher = nullptr;
+		m_ChangedAssets.clear();
+		if (!enabled) return true;
+
+		if (m_Archive != nullptr)
+		{
+			ANNILEEN_LOG_WARNING(LoggingChannel::Asset, "Hot reload watches the loose asset files, it is off while loading from the asset archive.");
+			return false;
+		}
+
+		// Every file of the table is watched, whether it is loaded yet or not.
+		m_FileWatcher = std::make_unique<FileWatcher>(mode);
+		for (const auto& [name, entry] : m_Assets)
+		{
+			if (!entry.m_Filepath.empty() && !m_FileWatcher->watch(entry.m_Filepath))
+			{
+				ANNILEEN_LOGF_WARNING(LoggingChannel::Asset, "Can't watch '{}' for hot reload.", entry.m_Filepath);
+			}
+		}
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Hot reload on, {}.",
+			m_FileWatcher->getMode() == FileWatcher::Mode::Notify ? "notified of file changes" : "polling file changes");
+		return true;
+	}
+
+	void AssetManager::reloadChangedAssets()
+	{
+		for (const std::string& path : m_FileWatcher->poll())
+		{
+			for (const auto& [name, entry] : m_Assets)
+			{
+				if (entry.m_Filepath == path) m_ChangedAssets.insert(name);
+			}
+		}
+
+		for (auto it = m_ChangedAssets.begin(); it != m_ChangedAssets.end();)
+		{
+			// The running load may have read the file before it changed.
+			if (findRequest(*it) != nullptr)
+			{
+				++it;
+				continue;
+			}
+
+			startReload(*it, m_Assets.at(*it));
+			it = m_ChangedAssets.erase(it);
+		}
+	}
+
+	bool AssetManager::startReload(const std::string& name, const AssetTableEntry& entry)
+	{
+		const AssetTableEntry source = entry;
+
+		// Compiled stages aren't assets of their own, the programs using them are.
+		if (m_ShaderStages.count(name) != 0)
+		{
+			startLoading(LoadKind::ShaderStage, name, nullptr, [this, source](LoadRequest& request)
+			{
+				request.files[0] = readAsset(source);
+				if (request.files[0].size == 0)
+				{
+					request.error = "Could not read shader '" + request.name + "'.";
+					return;
+				}
+				request.files[0].prefetch();
+			}, true);
+		}
+		else if (!entry.m_Loaded || !entry.m_Asset->isReady())
+		{
+			// Never asked for or failed, the new file is read when it is next asked for.
+			return false;
+		}
+		else if (dynamic_cast<Texture*>(entry.m_Asset) != nullptr)
+		{
+			startLoading(LoadKind::Texture, name, entry.m_Asset, [this, source](LoadRequest& request) { readTexture(source, request); }, true);
+		}
+		else if (dynamic_cast<MeshGroup*>(entry.m_Asset) != nullptr)
+		{
+			startLoading(LoadKind::Mesh, name, entry.m_Asset, [this, source](LoadRequest& request) { readMesh(source, request); }, true);
+		}
+		else
+		{
+			return false;
+		}
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Reloading '{}'.", name);
+		return true;
+	}
+
+	bool AssetManager::hasAsset(const std::string& name) const
+	{
+		return m_Assets.count(name) != 0 || (m_Archive != nullptr && m_Archive->find(name) != nullptr);
+	}
+
+	std::vector<std::string> AssetManager::getAssetNames() const
+	{
+		std::vector<std::string> names;
+		if (m_Archive != nullptr)
+		{
+			for (size_t i = 0; i < m_Archive->getEntryCount(); ++i)
+			{
+				names.push_back(m_Archive->getName(m_Archive->getEntry(i)));
+			}
+			return names;
+		}
+
+		for (const auto& [name, entry] : m_Assets)
+		{
+			// Shader programs are stored under their two stage names put together.
+			if (!entry.m_Filepath.empty()) names.push_back(name);
+		}
+		return names;
+	}
+
+	std::string AssetManager::getAssetName(const AssetObject* asset) const
+	{
+		if (asset == nullptr) return "";
+
+		for (const auto& [name, entry] : m_Assets)
+		{
+			if (entry.m_Loaded && entry.m_Asset == asset)
+			{
+				return name;
+			}
+		}
+
+		return "";
+	}
+
+	std::string AssetManager::getFontName(TrueTypeHandle font) const
+	{
+		for (const auto& [name, entry] : m_Assets)
+		{
+			if (!entry.m_Loaded) continue;
+
+			const Font* asset = dynamic_cast<const Font*>(entry.m_Asset);
+			if (asset != nullptr && asset->getHandle().idx == font.idx)
+			{
+				return name;
+			}
+		}
+
+		return "";
+	}
+
+	TextureDescriptor AssetManager::loadTextureDescriptor(const AssetTableEntry* asset) const
+	{
+		if (asset->m_ArchiveIndex >= 0) return m_Archive->getTextureDescriptor(m_Archive->getEntry(asset->m_ArchiveIndex));
+
+		return readTextureDescriptor(asset->m_Filepath);
+	}
+
+	MeshDescriptor AssetManager::loadMeshDescriptor(const AssetTableEntry* asset) const
+	{
+		if (asset->m_ArchiveIndex >= 0) return m_Archive->getMeshDescriptor(m_Archive->getEntry(asset->m_ArchiveIndex));
+
+		return readMeshDescriptor(asset->m_Filepath);
+	}
+
+	CubemapDescriptor AssetManager::loadCubemapDescriptor(const AssetTableEntry* asset) const
+	{
+		if (asset->m_ArchiveIndex >= 0) return {};
+
+		return readCubemapDescriptor(asset->m_Filepath);
 	}
 
-	TextureDescriptor AssetManager::loadTextureDescriptor(AssetTableEntry* asset)
+	TextureDescriptor AssetManager::readTextureDescriptor(const std::string& filepath)
 	{
-		auto assetfile = asset->m_Filepath.substr(0, asset->m_Filepath.find_last_of(".")) + ".toml";
+		auto assetfile = filepath.substr(0, filepath.find_last_of(".")) + ".toml";
 		auto data = toml::parse(assetfile);
 		return {
 			toml::find(data, "mipmap").as_boolean(),
@@ -268,9 +1426,9 @@ namespace annileen
 		};
 	}
 
-	MeshDescriptor AssetManager::loadMeshDescriptor(AssetTableEntry* asset)
+	MeshDescriptor AssetManager::readMeshDescriptor(const std::string& filepath)
 	{
-		auto assetfile = asset->m_Filepath.substr(0, asset->m_Filepath.find_last_of(".")) + ".toml";
+		auto assetfile = filepath.substr(0, filepath.find_last_of(".")) + ".toml";
 		auto data = toml::parse(assetfile);
 
 		auto normalsValue = toml::find(data, "normals").as_string();
@@ -284,9 +1442,9 @@ namespace annileen
 		};
 	}
 
-	CubemapDescriptor AssetManager::loadCubemapDescriptor(AssetTableEntry* asset)
+	CubemapDescriptor AssetManager::readCubemapDescriptor(const std::string& filepath)
 	{
-		auto assetfile = asset->m_Filepath;
+		auto assetfile = filepath;
 		auto data = toml::parse(assetfile);
 		const auto cubemap = toml::find(data, "cubemap");
 		return {
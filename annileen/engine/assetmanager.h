@@ -1,8 +1,15 @@
 
 #pragma once
 
+#include <functional>
 #include <iostream>
+#include <list>
 #include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include <bimg/decode.h>
@@ -10,32 +17,209 @@
 #include <toml.hpp>
 
 #include <engine/asset.h>
+#include <engine/assetref.h>
+#include <engine/assetarchive.h>
 #include <engine/shader.h>
 #include <engine/texture.h>
 #include <engine/cubemap.h>
 #include <engine/mesh.h>
+#include <engine/meshfile.h>
 #include <engine/font.h>
+#include <engine/rawmesh.h>
+#include <engine/core/file.h>
+#include <engine/core/filewatcher.h>
+#include <engine/core/jobsystem.h>
 
 namespace annileen
 {
+	// Shader creation counts, stages and programs asked for against those actually created.
+	struct ShaderStats
+	{
+		uint32_t stageRequests = 0;
+		uint32_t stagesCreated = 0;
+		uint32_t programRequests = 0;
+		uint32_t programsCreated = 0;
+		// Stages swapped in by hot reloading.
+		uint32_t stagesReloaded = 0;
+	};
+
+	// One asset of the asset table as the memory budget sees it.
+	struct AssetResidency
+	{
+		std::string name;
+		AssetType type;
+		bool loaded;
+		AssetState state;
+		uint32_t references;
+		bool pinned;
+		size_t size;
+		uint64_t lastUsed;
+	};
+
+	// Loads assets by name, from the asset archive next to the asset table when there is one
+	// (assets.pak for assets.toml), from the table and the loose files it lists otherwise.
+	// The load functions block until the asset is
+	// there; the Async ones return right away with a placeholder standing in (a white texture,
+	// an empty mesh group, a shader that draws nothing, an invalid font handle), read and
+	// decode the files on the job system, and swap the real asset in from update() on the
+	// main thread, where the bgfx resources are created.
 	class AssetManager final
 	{
 	private:
+		// Bytes of an asset, a whole loose file or a part of the archive, and the mapping
+		// they live in.
+		struct AssetBytes
+		{
+			std::shared_ptr<MappedFile> file;
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+
+			void prefetch() const { if (file != nullptr) file->prefetch(data - file->getData(), size); }
+		};
+
+		enum class LoadKind
+		{
+			Shader,
+			Texture,
+			Cubemap,
+			Mesh,
+			Font,
+			// A changed stage of programs already created, for hot reloading.
+			ShaderStage
+		};
+
+		// Compiled stages are shared by every program using them, and destroyed with the last.
+		struct ShaderStage
+		{
+			bgfx::ShaderHandle handle;
+			uint32_t references;
+		};
+
+		struct LoadRequest
+		{
+			LoadKind kind;
+			std::string name;
+			AssetObject* asset;
+			JobCounter reading;
+			// Hot reload of a loaded asset, which keeps being used until the new one is swapped in.
+			bool reload = false;
+
+			// Filled in by the job: the bytes of shaders, fonts and cooked meshes, decoded
+			// images and converted meshes, or what went wrong.
+			AssetBytes files[2];
+			std::string stages[2];
+			MeshFile cookedMesh;
+			bimg::ImageContainer* image = nullptr;
+			TextureDescriptor textureDescriptor = {};
+			std::vector<MeshData> meshes;
+			std::string error;
+		};
+
 		std::map<std::string, AssetTableEntry> m_Assets;
+		// With an archive m_Assets starts out empty, entries are added as assets are asked for.
+		std::unique_ptr<AssetArchive> m_Archive;
+
+		std::map<std::string, ShaderStage> m_ShaderStages;
+		std::vector<ShaderPermutation> m_ShaderPermutations;
+		ShaderStats m_ShaderStats;
+		// Off creates the stages of every program anew, as before they were shared, for comparing.
+		bool m_ShareShaderStages;
+
+		std::list<LoadRequest> m_Requests;
+		double m_FrameBudget;
+		// Bytes of loaded assets past which unreferenced ones are unloaded, 0 for no budget.
+		uint64_t m_MemoryBudget;
+		// Counts acquires and releases, the clock m_LastUsed is read from.
+		uint64_t m_UseCount;
+
+		// Set while hot reloading, watching the loose files of the asset table.
+		std::unique_ptr<FileWatcher> m_FileWatcher;
+		// Changed while a load of them was still running, reloaded once it is done.
+		std::set<std::string> m_ChangedAssets;
+		bgfx::TextureHandle m_PlaceholderTexture;
+		bgfx::TextureHandle m_PlaceholderCubemap;
 
 		void loadAssetTable(const std::string& assetfile);
 		AssetType getType(const std::string& typetext);
 		AssetTableEntry* getAssetEntry(const std::string& assetname);
 
 		void unloadAssets();
+		// Unloaded assets keep their entry, so references and archive indices stay valid.
+		void unloadAsset(AssetTableEntry* entry);
+
+		template <typename T>
+		AssetRef<T> acquire(const std::string& name, T* (AssetManager::*load)(const std::string&));
+		void addReference(AssetTableEntry* entry);
+		void releaseReference(AssetTableEntry* entry);
+
+		std::tuple<bgfx::TextureHandle, bgfx::TextureInfo, bimg::Orientation::Enum> loadTextureData(const AssetBytes& bytes, const TextureDescriptor& descriptor, const std::string& name);
 
-		const bgfx::Memory* loadBinaryFile(const std::string& filename);
-		std::tuple<bgfx::TextureHandle, bgfx::TextureInfo, bimg::ImageContainer*> loadTextureData(const std::string& file, const TextureDescriptor& descriptor);
+		// Memory bgfx reads straight from the mapping, which it keeps alive until it is done.
+		static const bgfx::Memory* makeRef(const AssetBytes& bytes);
 
-		AssetManager(const std::string& assetfile);
+		// Safe on any thread, none of them touch bgfx or the asset table.
+		static AssetBytes mapFile(const std::string& filename);
+		AssetBytes readAsset(const AssetTableEntry& entry) const;
+		AssetBytes readCubemap(const AssetTableEntry& entry) const;
+		bool readMeshData(const AssetTableEntry& entry, std::vector<MeshData>& meshes, std::string& error) const;
+		// Meshes cooked by the asset tools skip Assimp, the others are imported.
+		bool isCookedMesh(const AssetTableEntry& entry) const;
+		static bool readCookedMesh(const AssetBytes& bytes, const std::string& name, MeshFile& meshFile, std::string& error);
+		static bimg::ImageContainer* decodeImage(const AssetBytes& bytes);
+		// Takes ownership of the image and returns the one to upload: compressed formats the
+		// GPU can't sample decoded to RGBA8, and 8 bit images given a mip chain if they have
+		// none and generateMips is set.
+		static bimg::ImageContainer* prepareImage(bimg::ImageContainer* image, bool generateMips);
+		static TextureDescriptor readTextureDescriptor(const std::string& filepath);
+		static MeshDescriptor readMeshDescriptor(const std::string& filepath);
+		static CubemapDescriptor readCubemapDescriptor(const std::string& filepath);
+
+		// Takes ownership of the image.
+		std::tuple<bgfx::TextureHandle, bgfx::TextureInfo, bimg::Orientation::Enum> createTexture(bimg::ImageContainer* image, const TextureDescriptor& descriptor, const std::string& name);
+
+		// One mesh per submesh, with buffers made straight from the cooked file.
+		static void createCookedMeshes(const AssetBytes& bytes, const MeshFile& meshFile, MeshGroup* meshGroup);
+
+		// Programs are stored in the asset table under both stage names.
+		static std::string getProgramName(const std::string& vertex, const std::string& fragment);
+		// bytes may be empty, the stage is read if it isn't there already.
+		bgfx::ShaderHandle acquireShaderStage(const std::string& name, const AssetBytes& bytes);
+		void releaseShaderStage(const std::string& name);
+		// Fills in the program of shader from the two stages. False if a stage couldn't be read.
+		bool createProgram(Shader* shader, const std::string& vertex, const std::string& fragment, const AssetBytes* stageBytes);
+		// loadShader with the bytes of both stages already read, or nullptr.
+		Shader* loadShader(const std::string& vertex, const std::string& fragment, const AssetBytes* stageBytes);
+
+		// What the jobs of the Async loads and of reloads read and decode.
+		void readTexture(const AssetTableEntry& source, LoadRequest& request) const;
+		void readMesh(const AssetTableEntry& source, LoadRequest& request) const;
+
+		void createPlaceholders();
+		// Reloads leave the asset Ready, it is used as it was until finishLoading() swaps the
+		// new resources in.
+		LoadRequest& startLoading(LoadKind kind, const std::string& name, AssetObject* asset, const std::function<void(LoadRequest&)>& read, bool reload = false);
+		void finishLoading(LoadRequest& request);
+		// Points the programs using the stage at the reloaded one.
+		void swapShaderStage(LoadRequest& request);
+		LoadRequest* findRequest(const std::string& name);
+		// Waits for the request's job and finishes it.
+		void finishRequest(std::list<LoadRequest>::iterator request);
+		// Blocks until the asset is there, if it is being loaded asynchronously.
+		void waitForAsset(AssetObject* asset);
+
+		// Starts reloading the assets whose files changed. Loads already running are left to
+		// finish first.
+		void reloadChangedAssets();
+		bool startReload(const std::string& name, const AssetTableEntry& entry);
+
+		// useArchive false ignores the archive, for comparing the two.
+		AssetManager(const std::string& assetfile, bool useArchive = true);
 		~AssetManager();
 
 		friend class Engine;
+		friend class TestAssetManager;
+		friend void addAssetReference(AssetManager* manager, AssetTableEntry* entry);
+		friend void releaseAssetReference(AssetManager* manager, AssetTableEntry* entry);
 
 	public:
 		// Asset loading functions
@@ -45,9 +229,77 @@ namespace annileen
 		MeshGroup* loadMesh(const std::string& name);
 		Font* loadFont(const std::string& name);
 
+		// The permutation table: programs built from precompiled stages, one per set of
+		// features. loadShaderPermutations() creates everything added so far in one batch,
+		// reading all the stages in parallel first; getShaderPermutation() loads on demand
+		// whatever wasn't. nullptr if no permutation was added for those features.
+		void addShaderPermutation(const ShaderPermutation& permutation);
+		void loadShaderPermutations();
+		Shader* getShaderPermutation(const std::string& program, uint32_t features);
+		const ShaderStats& getShaderStats() const { return m_ShaderStats; }
+
+		Shader* loadShaderAsync(const std::string& vertex, const std::string& fragment);
+		Texture* loadTextureAsync(const std::string& tex);
+		Cubemap* loadCubemapAsync(const std::string& name);
+		MeshGroup* loadMeshAsync(const std::string& name);
+		Font* loadFontAsync(const std::string& name);
+
+		// Counted references, see AssetRef. The asset is loaded like the load functions above
+		// do, the Async ones when async is set. Empty if there is no such asset.
+		AssetRef<Texture> acquireTexture(const std::string& name, bool async = false);
+		AssetRef<Cubemap> acquireCubemap(const std::string& name, bool async = false);
+		AssetRef<MeshGroup> acquireMesh(const std::string& name, bool async = false);
+		AssetRef<Font> acquireFont(const std::string& name, bool async = false);
+
+		bool isLoading() const { return !m_Requests.empty(); }
+		size_t getPendingLoads() const { return m_Requests.size(); }
+
+		// Main thread time spent creating the loaded assets per frame, in milliseconds. At
+		// least one asset is finished every frame, whatever the budget.
+		void setFrameBudget(double milliseconds) { m_FrameBudget = milliseconds; }
+		double getFrameBudget() const { return m_FrameBudget; }
+
+		// Assets handed out only through AssetRefs are unloaded, least recently used first,
+		// while nothing refers to them and the loaded assets take more than this, in bytes.
+		// Assets from the load functions stay loaded. 0 (the default) never unloads.
+		void setMemoryBudget(uint64_t bytes) { m_MemoryBudget = bytes; }
+		uint64_t getMemoryBudget() const { return m_MemoryBudget; }
+		// Bytes held by the loaded assets, all or of one type. Shader programs count nothing,
+		// bgfx doesn't know what the driver keeps for them.
+		uint64_t getMemoryUsage() const;
+		uint64_t getMemoryUsage(AssetType type) const;
+		// Every asset that was asked for, loaded or not, in name order.
+		std::vector<AssetResidency> getResidency() const;
+		// Unloads what the budget requires. update() calls it, returns how many went.
+		uint32_t unloadUnused();
+
+		// Watches the files of the shaders, textures and meshes that are loaded and reloads
+		// them when they change, on the job system like the Async loads. update() swaps the new
+		// bgfx handles into the Shader, Texture and MeshGroup objects already handed out, so
+		// whatever uses them keeps working; until then, or if the new file is broken, the
+		// loaded one stays. Needs the loose files, false with an asset archive.
+		bool setHotReload(bool enabled, FileWatcher::Mode mode = FileWatcher::Mode::Notify);
+		bool isHotReloading() const { return m_FileWatcher != nullptr; }
+
+		// Call once per frame, swaps in the assets whose files are read and decoded, then
+		// keeps within the memory budget.
+		void update();
+		// Blocks until every asynchronous load is done.
+		void finishAll();
+
+		bool hasAsset(const std::string& name) const;
+		std::vector<std::string> getAssetNames() const;
+		// Reverse lookups, so references can be stored by name. They return an empty
+		// string for assets that were not loaded by the AssetManager.
+		std::string getAssetName(const AssetObject* asset) const;
+		std::string getFontName(TrueTypeHandle font) const;
+
+		bool isUsingArchive() const { return m_Archive != nullptr; }
+
 		// Asset descriptor loading functions
-		TextureDescriptor loadTextureDescriptor(AssetTableEntry* asset);
-		MeshDescriptor loadMeshDescriptor(AssetTableEntry* asset);
-		CubemapDescriptor loadCubemapDescriptor(AssetTableEntry* asset);
+		TextureDescriptor loadTextureDescriptor(const AssetTableEntry* asset) const;
+		MeshDescriptor loadMeshDescriptor(const AssetTableEntry* asset) const;
+		// Archived cubemaps have no descriptor, the archive holds their strip texture instead.
+		CubemapDescriptor loadCubemapDescriptor(const AssetTableEntry* asset) const;
 	};
 }
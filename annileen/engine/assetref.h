@@ -0,0 +1,92 @@
+#pragma once
+
+#include <utility>
+
+namespace annileen
+{
+	class AssetManager;
+	struct AssetTableEntry;
+
+	// Reference counting of AssetRef, defined with the AssetManager so holding a reference
+	// needs no more than this header.
+	void addAssetReference(AssetManager* manager, AssetTableEntry* entry);
+	void releaseAssetReference(AssetManager* manager, AssetTableEntry* entry);
+
+	// Counted reference to an asset of the AssetManager. The asset stays loaded while any
+	// reference to it is held; once the last is gone it may be unloaded to keep within the
+	// memory budget, and acquiring it again loads it again. The pointer is valid for as long
+	// as the reference is held.
+	template <typename T>
+	class AssetRef final
+	{
+	private:
+		AssetManager* m_Manager = nullptr;
+		AssetTableEntry* m_Entry = nullptr;
+		T* m_Asset = nullptr;
+
+		AssetRef(AssetManager* manager, AssetTableEntry* entry, T* asset);
+
+		friend class AssetManager;
+
+	public:
+		T* get() const { return m_Asset; }
+		T* operator->() const { return m_Asset; }
+		explicit operator bool() const { return m_Asset != nullptr; }
+
+		void reset();
+
+		AssetRef() = default;
+		AssetRef(const AssetRef& other);
+		AssetRef(AssetRef&& other) noexcept;
+		AssetRef& operator=(AssetRef other) noexcept;
+		~AssetRef();
+	};
+
+	template <typename T>
+	AssetRef<T>::AssetRef(AssetManager* manager, AssetTableEntry* entry, T* asset) :
+		m_Manager(manager), m_Entry(entry), m_Asset(asset)
+	{
+		addAssetReference(m_Manager, m_Entry);
+	}
+
+	template <typename T>
+	AssetRef<T>::AssetRef(const AssetRef& other) :
+		m_Manager(other.m_Manager), m_Entry(other.m_Entry), m_Asset(other.m_Asset)
+	{
+		if (m_Entry != nullptr) addAssetReference(m_Manager, m_Entry);
+	}
+
+	template <typename T>
+	AssetRef<T>::AssetRef(AssetRef&& other) noexcept :
+		m_Manager(other.m_Manager), m_Entry(other.m_Entry), m_Asset(other.m_Asset)
+	{
+		other.m_Manager = nullptr;
+		other.m_Entry = nullptr;
+		other.m_Asset = nullptr;
+	}
+
+	template <typename T>
+	AssetRef<T>& AssetRef<T>::operator=(AssetRef other) noexcept
+	{
+		std::swap(m_Manager, other.m_Manager);
+		std::swap(m_Entry, other.m_Entry);
+		std::swap(m_Asset, other.m_Asset);
+		return *this;
+	}
+
+	template <typename T>
+	void AssetRef<T>::reset()
+	{
+		if (m_Entry != nullptr) releaseAssetReference(m_Manager, m_Entry);
+
+		m_Manager = nullptr;
+		m_Entry = nullptr;
+		m_Asset = nullptr;
+	}
+
+	template <typename T>
+	AssetRef<T>::~AssetRef()
+	{
+		reset();
+	}
+}
@@ -0,0 +1,76 @@
+#include <engine/benchmark.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <fstream>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	Benchmark::Benchmark(const std::string& name) : m_Name(name)
+	{
+	}
+
+	Benchmark::~Benchmark()
+	{
+	}
+
+	void Benchmark::addFrame(const FrameTiming& timing, const FrameStats* stats)
+	{
+		m_Frames.push_back(timing);
+		m_Stats.push_back(stats != nullptr ? *stats : FrameStats{});
+	}
+
+	bool Benchmark::writeJson(const std::string& fileName) const
+	{
+		std::ofstream file(fileName, std::ios::out | std::ios::trunc);
+		if (!file.is_open())
+		{
+			ANNILEEN_LOGF_ERROR(LoggingChannel::Core, "Could not write benchmark results to '{}'.", fileName);
+			return false;
+		}
+
+		double totalSum = 0.0;
+		double totalMax = 0.0;
+		for (const auto& frame : m_Frames)
+		{
+			totalSum += frame.total;
+			totalMax = std::max(totalMax, frame.total);
+		}
+		const double totalAvg = m_Frames.empty() ? 0.0 : totalSum / m_Frames.size();
+
+		file << "{\n";
+		file << fmt::format("  \"name\": \"{}\",\n", m_Name);
+		file << fmt::format("  \"frameCount\": {},\n", m_Frames.size());
+		file << fmt::format("  \"averageFrameMs\": {:.4f},\n", totalAvg);
+		file << fmt::format("  \"maxFrameMs\": {:.4f},\n", totalMax);
+		file << "  \"frames\": [\n";
+
+		for (size_t i = 0; i < m_Frames.size(); ++i)
+		{
+			const FrameTiming& frame = m_Frames[i];
+			const FrameStats& stats = m_Stats[i];
+
+			std::string views;
+			for (const auto& view : stats.views)
+			{
+				views += fmt::format("{}{{ \"name\": \"{}\", \"drawCalls\": {}, \"primitives\": {}, \"gpuTime\": {:.4f} }}",
+					views.empty() ? "" : ", ", view.name, view.drawCalls, view.primitives, view.gpuTime);
+			}
+
+			file << fmt::format("    {{ \"frame\": {}, \"update\": {:.4f}, \"cull\": {:.4f}, \"submit\": {:.4f}, \"total\": {:.4f}, ",
+				frame.frame, frame.update, frame.cull, frame.submit, frame.total);
+			file << fmt::format("\"drawCalls\": {}, \"primitives\": {}, \"gpuTime\": {:.4f}, \"gpuDrawCalls\": {}, \"transientVertexBufferUsed\": {}, \"transientIndexBufferUsed\": {}, ",
+				stats.drawCalls, stats.primitives, stats.gpuTime, stats.gpuDrawCalls, stats.transientVertexBufferUsed, stats.transientIndexBufferUsed);
+			file << fmt::format("\"dynamicVertexBuffers\": {}, \"dynamicIndexBuffers\": {}, \"views\": [{}] }}{}\n",
+				stats.dynamicVertexBuffers, stats.dynamicIndexBuffers, views, i + 1 < m_Frames.size() ? "," : "");
+		}
+
+		file << "  ]\n";
+		file << "}\n";
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Benchmark: {} frames, {:.3f} ms average, written to '{}'.", m_Frames.size(), totalAvg, fileName);
+
+		return true;
+	}
+}
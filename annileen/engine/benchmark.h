@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <engine/renderstats.h>
+
+namespace annileen
+{
+	// CPU timings of a single frame, in milliseconds.
+	struct FrameTiming
+	{
+		uint32_t frame;
+		double update;
+		double cull;
+		double submit;
+		double total;
+	};
+
+	class Benchmark
+	{
+	private:
+		std::string m_Name;
+		std::vector<FrameTiming> m_Frames;
+		std::vector<FrameStats> m_Stats;
+
+	public:
+		void addFrame(const FrameTiming& timing, const FrameStats* stats = nullptr);
+		const std::vector<FrameTiming>& getFrames() const { return m_Frames; }
+
+		bool writeJson(const std::string& fileName) const;
+
+		Benchmark(const std::string& name);
+		~Benchmark();
+	};
+}
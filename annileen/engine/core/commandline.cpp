@@ -0,0 +1,72 @@
+#include <engine/core/commandline.h>
+#include <iostream>
+#include <stdexcept>
+
+namespace annileen
+{
+	CommandLineOptions CommandLineOptions::parse(int argc, char* argv[])
+	{
+		CommandLineOptions options;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			// A malformed number leaves the option at its default, it doesn't end the program.
+			try
+			{
+				if (arg == "--headless")
+				{
+					options.headless = true;
+				}
+				else if (arg == "--frames" && hasValue)
+				{
+					options.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+				}
+				else if (arg == "--output" && hasValue)
+				{
+					options.outputFile = argv[++i];
+				}
+				else if (arg == "--submit-threads" && hasValue)
+				{
+					options.submitThreads = std::stoi(argv[++i]);
+				}
+				else if (arg == "--job-workers" && hasValue)
+				{
+					options.jobWorkers = std::stoi(argv[++i]);
+				}
+				else if (arg == "--fixed-rate" && hasValue)
+				{
+					options.fixedRate = std::stof(argv[++i]);
+				}
+				else if (arg == "--fps-limit" && hasValue)
+				{
+					options.frameRateLimit = std::stoi(argv[++i]);
+				}
+				else if (arg == "--no-vsync")
+				{
+					options.noVsync = true;
+				}
+				else if (arg == "--hot-reload")
+				{
+					options.hotReload = true;
+				}
+				else if (arg == "--load-scene" && hasValue)
+				{
+					options.loadScene = argv[++i];
+				}
+				else
+				{
+					std::cerr << "Unknown command line argument: " << arg << std::endl;
+				}
+			}
+			catch (const std::logic_error&)
+			{
+				std::cerr << "Invalid value for command line argument " << arg << ": " << argv[i] << std::endl;
+			}
+		}
+
+		return options;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace annileen
+{
+	// Options the engine understands from the application command line:
+	//   --headless            run without a window, using the bgfx Noop renderer
+	//   --frames <n>          quit after n frames (0 = run until closed)
+	//   --output <file.json>  write per frame CPU timings to a JSON file
+	//   --submit-threads <n>  override rendering.submitThreads
+	//   --job-workers <n>     override jobs.workerThreads
+	//   --fixed-rate <hz>     override timing.fixedTimestep with 1 / hz
+	//   --fps-limit <n>       override timing.frameRateLimit (0 = uncapped)
+	//   --no-vsync            present frames as soon as they are ready
+	//   --hot-reload          override assets.hotReload, reloading shaders, textures and meshes when their files change
+	//   --load-scene <file>   stream a .anscene file into the running scene through the SceneManager
+	struct CommandLineOptions
+	{
+		bool headless = false;
+		uint32_t frames = 0;
+		std::string outputFile;
+		int32_t submitThreads = -1;
+		int32_t jobWorkers = -1;
+		float fixedRate = 0.0f;
+		int32_t frameRateLimit = -1;
+		bool noVsync = false;
+		bool hotReload = false;
+		std::string loadScene;
+
+		static CommandLineOptions parse(int argc, char* argv[]);
+	};
+}
@@ -1,5 +1,16 @@
 #include <engine/core/file.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace annileen
 {
 	File::File(std::string name, FileMode mode)
@@ -39,4 +50,97 @@ namespace annileen
 			m_File << line << std::endl;
 		}
 	}
-}
\ No newline at end of file
+
+	MappedFile::MappedFile() : m_Data(nullptr), m_Size(0)
+#ifdef _WIN32
+		, m_File(nullptr), m_Mapping(nullptr)
+#endif
+	{
+	}
+
+#ifdef _WIN32
+	std::shared_ptr<MappedFile> MappedFile::open(const std::string& name)
+	{
+		HANDLE file = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+		std::shared_ptr<MappedFile> mapped(new MappedFile());
+		mapped->m_File = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) return nullptr;
+		if (size.QuadPart == 0) return mapped;
+
+		// Mapping objects can't be made for empty files, those keep the null view.
+		mapped->m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapped->m_Mapping == nullptr) return nullptr;
+
+		mapped->m_Data = static_cast<const uint8_t*>(MapViewOfFile(mapped->m_Mapping, FILE_MAP_READ, 0, 0, 0));
+		if (mapped->m_Data == nullptr) return nullptr;
+
+		mapped->m_Size = static_cast<size_t>(size.QuadPart);
+		return mapped;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data != nullptr) UnmapViewOfFile(m_Data);
+		if (m_Mapping != nullptr) CloseHandle(m_Mapping);
+		if (m_File != nullptr) CloseHandle(m_File);
+	}
+#else
+	std::shared_ptr<MappedFile> MappedFile::open(const std::string& name)
+	{
+		int file = ::open(name.c_str(), O_RDONLY);
+		if (file < 0) return nullptr;
+
+		struct stat info;
+		if (fstat(file, &info) != 0)
+		{
+			::close(file);
+			return nullptr;
+		}
+
+		std::shared_ptr<MappedFile> mapped(new MappedFile());
+
+		// mmap refuses empty ranges, empty files keep the null view.
+		if (info.st_size > 0)
+		{
+			void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (data == MAP_FAILED)
+			{
+				::close(file);
+				return nullptr;
+			}
+
+			mapped->m_Data = static_cast<const uint8_t*>(data);
+			mapped->m_Size = static_cast<size_t>(info.st_size);
+		}
+
+		// The mapping stays valid without the descriptor.
+		::close(file);
+		return mapped;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data != nullptr) munmap(const_cast<uint8_t*>(m_Data), m_Size);
+	}
+#endif
+
+	void MappedFile::prefetch(size_t offset, size_t size) const
+	{
+		// Smaller than or equal to the page size everywhere the engine runs.
+		static const size_t s_PageSize = 4096;
+
+		if (offset >= m_Size || size == 0) return;
+		const size_t end = size < m_Size - offset ? offset + size : m_Size;
+
+		// The last byte too, a range that doesn't start on a page can end on one more.
+		volatile uint8_t sink = m_Data[end - 1];
+		for (; offset < end; offset += s_PageSize)
+		{
+			sink = sink + m_Data[offset];
+		}
+	}
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include<cstdint>
+#include<cstddef>
 #include<string>
 #include<iostream>
 #include<fstream>
+#include<memory>
 #include<engine/definitions.h>
 
 namespace annileen
@@ -39,4 +42,36 @@ namespace annileen
 		FileMode m_Mode;
 		std::fstream m_File;
 	};
-}
\ No newline at end of file
+
+	// Read-only view of a whole file mapped into memory. Nothing is read up front: pages come
+	// in from disk when first touched and, being backed by the file, the system can drop them
+	// again instead of swapping. It is shared, so whoever hands the bytes on (to bgfx, to the
+	// font manager) keeps the mapping alive for as long as they are used.
+	class MappedFile final
+	{
+	public:
+		// Returns nullptr if the file can't be opened or mapped. Empty files give an empty view.
+		static std::shared_ptr<MappedFile> open(const std::string& name);
+
+		const uint8_t* getData() const { return m_Data; }
+		size_t getSize() const { return m_Size; }
+
+		// Touches every page of the range, so they are read from disk on the calling thread
+		// rather than on the one that uses the data later.
+		void prefetch(size_t offset = 0, size_t size = SIZE_MAX) const;
+
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+	private:
+		MappedFile();
+
+		const uint8_t* m_Data;
+		size_t m_Size;
+#ifdef _WIN32
+		void* m_File;
+		void* m_Mapping;
+#endif
+	};
+}
@@ -0,0 +1,132 @@
+#include <engine/core/filewatcher.h>
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace annileen
+{
+	FileWatcher::FileWatcher(Mode mode, double pollInterval) :
+		m_Mode(mode), m_PollInterval(pollInterval), m_LastPoll(std::chrono::steady_clock::now()), m_Notify(-1)
+	{
+#ifdef __linux__
+		if (m_Mode == Mode::Notify)
+		{
+			m_Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		}
+#endif
+
+		if (m_Notify < 0) m_Mode = Mode::Polling;
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+#ifdef __linux__
+		if (m_Notify >= 0) close(m_Notify);
+#endif
+	}
+
+	FileWatcher::PolledFile FileWatcher::getFileState(const std::string& path)
+	{
+		// Missing files get the zero time, so creating them counts as a change.
+		std::error_code error;
+		PolledFile state { std::filesystem::last_write_time(path, error), 0 };
+		if (error) return { std::filesystem::file_time_type::min(), 0 };
+
+		state.size = std::filesystem::file_size(path, error);
+		if (error) state.size = 0;
+		return state;
+	}
+
+	bool FileWatcher::watch(const std::string& path)
+	{
+		if (m_Mode == Mode::Polling)
+		{
+			m_PolledFiles.emplace(path, getFileState(path));
+			return true;
+		}
+
+#ifdef __linux__
+		// Directories are watched rather than the files, so files replaced by a rename (as
+		// tools writing atomically do) are still seen. The same directory gives the same watch.
+		const std::filesystem::path file(path);
+		const std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+
+		const int watch = inotify_add_watch(m_Notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB);
+		if (watch < 0) return false;
+
+		m_Directories[watch][file.filename().string()] = path;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	std::vector<std::string> FileWatcher::poll()
+	{
+		std::vector<std::string> changed;
+
+		if (m_Mode == Mode::Polling)
+		{
+			const auto now = std::chrono::steady_clock::now();
+			if (now - m_LastPoll < m_PollInterval) return changed;
+			m_LastPoll = now;
+
+			for (auto& [path, state] : m_PolledFiles)
+			{
+				const PolledFile current = getFileState(path);
+				if (current.time != state.time || current.size != state.size)
+				{
+					state = current;
+					changed.push_back(path);
+				}
+			}
+			return changed;
+		}
+
+#ifdef __linux__
+		alignas(inotify_event) char buffer[4096];
+		bool overflowed = false;
+
+		for (;;)
+		{
+			const ssize_t length = read(m_Notify, buffer, sizeof(buffer));
+			if (length <= 0) break;
+
+			for (ssize_t offset = 0; offset < length;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW) overflowed = true;
+				if (event->len == 0) continue;
+
+				auto directory = m_Directories.find(event->wd);
+				if (directory == m_Directories.end()) continue;
+
+				auto file = directory->second.find(event->name);
+				if (file != directory->second.end() && std::find(changed.begin(), changed.end(), file->second) == changed.end())
+				{
+					changed.push_back(file->second);
+				}
+			}
+		}
+
+		// Events were dropped, any file may have changed.
+		if (overflowed)
+		{
+			changed.clear();
+			for (const auto& [watch, files] : m_Directories)
+			{
+				for (const auto& [name, path] : files) changed.push_back(path);
+			}
+		}
+#endif
+
+		return changed;
+	}
+}
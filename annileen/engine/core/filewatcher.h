@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace annileen
+{
+	// Tells which of a set of files changed on disk. poll() is cheap enough to call every
+	// frame: with system notifications (inotify on Linux) it is one read of the events queued
+	// since the last call, without them the files' modification times are compared, at most
+	// once per poll interval.
+	class FileWatcher final
+	{
+	public:
+		enum class Mode
+		{
+			// System notifications where there are any, polling elsewhere.
+			Notify,
+			Polling
+		};
+
+		// Notify falls back to polling where notifications can't be had, getMode() tells.
+		FileWatcher(Mode mode = Mode::Notify, double pollInterval = 0.25);
+		~FileWatcher();
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		Mode getMode() const { return m_Mode; }
+
+		// False if the file's directory can't be watched. Files that don't exist yet are
+		// reported once they are written.
+		bool watch(const std::string& path);
+
+		// Paths of the watched files written, replaced or touched since the last call, each
+		// once, as they were given to watch().
+		std::vector<std::string> poll();
+
+	private:
+		struct PolledFile
+		{
+			std::filesystem::file_time_type time;
+			uintmax_t size;
+		};
+
+		Mode m_Mode;
+		std::chrono::duration<double> m_PollInterval;
+		std::chrono::steady_clock::time_point m_LastPoll;
+		std::map<std::string, PolledFile> m_PolledFiles;
+
+		// inotify instance, and the watched files of each watched directory by name.
+		int m_Notify;
+		std::map<int, std::map<std::string, std::string>> m_Directories;
+
+		static PolledFile getFileState(const std::string& path);
+	};
+}
@@ -0,0 +1,51 @@
+#include <engine/core/fixedtimestep.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace annileen
+{
+	FixedTimestep::FixedTimestep(double stepTime, uint32_t maxSteps) :
+		m_StepTime(stepTime), m_Accumulator(0.0), m_MaxSteps(maxSteps), m_StepCount(0), m_DroppedTime(0.0)
+	{
+	}
+
+	uint32_t FixedTimestep::advance(double frameTime)
+	{
+		if (m_StepTime <= 0.0) return 0;
+
+		m_Accumulator += std::max(frameTime, 0.0);
+
+		uint32_t steps = 0;
+		while (m_Accumulator >= m_StepTime && steps < m_MaxSteps)
+		{
+			m_Accumulator -= m_StepTime;
+			++steps;
+		}
+
+		// Keep less than a step, what is left after the maximum is lost.
+		if (m_Accumulator >= m_StepTime)
+		{
+			const double kept = std::fmod(m_Accumulator, m_StepTime);
+			m_DroppedTime += m_Accumulator - kept;
+			m_Accumulator = kept;
+		}
+
+		m_StepCount += steps;
+		return steps;
+	}
+
+	float FixedTimestep::getInterpolation() const
+	{
+		if (m_StepTime <= 0.0) return 1.0f;
+
+		return static_cast<float>(std::min(m_Accumulator / m_StepTime, 1.0));
+	}
+
+	void FixedTimestep::reset()
+	{
+		m_Accumulator = 0.0;
+		m_StepCount = 0;
+		m_DroppedTime = 0.0;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+namespace annileen
+{
+	// Turns variable frame times into a whole number of fixed simulation steps. Time that
+	// doesn't fill a step is carried over to the next frame, so the simulation advances by
+	// exactly stepTime per step whatever the frame rate, and the same steps give the same
+	// results.
+	class FixedTimestep final
+	{
+	private:
+		double m_StepTime;
+		double m_Accumulator;
+		uint32_t m_MaxSteps;
+		uint64_t m_StepCount;
+		// Time dropped because a frame was due more than m_MaxSteps steps.
+		double m_DroppedTime;
+
+	public:
+		void setStepTime(double stepTime) { m_StepTime = stepTime; }
+		double getStepTime() const { return m_StepTime; }
+		// A frame never runs more steps than this. Past it the simulation slows down instead
+		// of falling further behind, every step making the next frame longer.
+		void setMaxSteps(uint32_t maxSteps) { m_MaxSteps = maxSteps; }
+		uint32_t getMaxSteps() const { return m_MaxSteps; }
+
+		// Adds the frame time and returns how many steps are due.
+		uint32_t advance(double frameTime);
+
+		// Fraction of a step carried over after the last advance(), from 0 to 1. Rendering
+		// the state in between the last two steps by that much hides the steps.
+		float getInterpolation() const;
+
+		// Steps handed out since the start or the last reset.
+		uint64_t getStepCount() const { return m_StepCount; }
+		double getDroppedTime() const { return m_DroppedTime; }
+
+		void reset();
+
+		FixedTimestep(double stepTime, uint32_t maxSteps);
+	};
+}
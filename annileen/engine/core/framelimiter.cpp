@@ -0,0 +1,61 @@
+#include <engine/core/framelimiter.h>
+#include <engine/core/profiler.h>
+
+#include <cmath>
+#include <thread>
+
+namespace annileen
+{
+	// Weight of a new sleep measurement, recent ones matter most as the system load changes.
+	static const double s_SleepSmoothing = 0.05;
+
+	FrameLimiter::FrameLimiter() : m_Started(false), m_SleepMean(0.002), m_SleepVariance(0.0)
+	{
+	}
+
+	void FrameLimiter::wait(double frameTime)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const Clock::time_point now = Clock::now();
+		const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frameTime));
+
+		if (!m_Started || frameTime <= 0.0)
+		{
+			m_Started = true;
+			m_LastFrame = now;
+			return;
+		}
+
+		const Clock::time_point target = m_LastFrame + period;
+		if (now >= target)
+		{
+			m_LastFrame = now - target < period ? target : now;
+			return;
+		}
+
+		ANNILEEN_PROFILE_SCOPE("FrameLimiter::wait");
+
+		while (true)
+		{
+			const double remaining = std::chrono::duration<double>(target - Clock::now()).count();
+			const double estimate = m_SleepMean + std::sqrt(m_SleepVariance);
+			if (remaining <= estimate) break;
+
+			const Clock::time_point sleepStart = Clock::now();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			const double slept = std::chrono::duration<double>(Clock::now() - sleepStart).count();
+
+			const double difference = slept - m_SleepMean;
+			m_SleepMean += s_SleepSmoothing * difference;
+			m_SleepVariance = (1.0 - s_SleepSmoothing) * (m_SleepVariance + s_SleepSmoothing * difference * difference);
+		}
+
+		while (Clock::now() < target)
+		{
+			std::this_thread::yield();
+		}
+
+		m_LastFrame = target;
+	}
+}
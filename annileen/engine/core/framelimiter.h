@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+
+namespace annileen
+{
+	// Holds frames to a target rate. Sleeping overshoots by up to a millisecond or two, so
+	// it sleeps while there is clearly time left and spins for the rest. How much sleeps
+	// overshoot is measured as it goes, keeping the spin as short as the system allows.
+	class FrameLimiter final
+	{
+	private:
+		std::chrono::steady_clock::time_point m_LastFrame;
+		bool m_Started;
+
+		// Running mean and variance of how long a 1 ms sleep really takes, in seconds.
+		double m_SleepMean;
+		double m_SleepVariance;
+
+	public:
+		// Returns once frameTime seconds have passed since the previous frame. Frames are
+		// kept on a fixed grid, so short waits don't drift; a frame late by more than a whole
+		// frame starts a new grid rather than rushing the next ones.
+		void wait(double frameTime);
+
+		// Forgets the previous frame, the next wait() returns right away.
+		void reset() { m_Started = false; }
+
+		FrameLimiter();
+	};
+}
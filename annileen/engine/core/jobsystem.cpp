@@ -0,0 +1,272 @@
+#include <engine/core/jobsystem.h>
+#include <engine/core/logger.h>
+#include <engine/core/profiler.h>
+
+#include <algorithm>
+
+namespace annileen
+{
+	namespace
+	{
+		// Worker threads remember their queue, per system since several may exist.
+		struct ThreadQueue
+		{
+			const JobSystem* system = nullptr;
+			size_t index = 0;
+		};
+
+		thread_local ThreadQueue t_ThreadQueue;
+	}
+
+	size_t JobSystem::getQueueIndex() const
+	{
+		return t_ThreadQueue.system == this ? t_ThreadQueue.index : 0;
+	}
+
+	void JobSystem::push(Job job)
+	{
+		Queue& queue = *m_Queues[getQueueIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+		}
+
+		m_QueuedJobs.fetch_add(1, std::memory_order_release);
+		wake();
+	}
+
+	void JobSystem::pushBackground(Job job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_BackgroundQueue.mutex);
+			m_BackgroundQueue.jobs.push_back(std::move(job));
+		}
+
+		m_QueuedBackgroundJobs.fetch_add(1, std::memory_order_release);
+		wake();
+	}
+
+	void JobSystem::wake()
+	{
+		// Taking the lock orders this against a worker checking the queued counts before sleeping.
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_WakeCondition.notify_one();
+	}
+
+	bool JobSystem::pop(size_t queueIndex, Job& job)
+	{
+		Queue& queue = *m_Queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.jobs.empty()) return false;
+
+		// Newest first, its data is the most likely to still be in cache.
+		job = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+		m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool JobSystem::steal(size_t thiefIndex, Job& job)
+	{
+		for (size_t i = 1; i < m_Queues.size(); ++i)
+		{
+			Queue& queue = *m_Queues[(thiefIndex + i) % m_Queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if (queue.jobs.empty()) continue;
+
+			// Oldest first, usually the largest piece of work left.
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool JobSystem::popBackground(Job& job)
+	{
+		if (m_QueuedBackgroundJobs.load(std::memory_order_acquire) == 0) return false;
+
+		std::lock_guard<std::mutex> lock(m_BackgroundQueue.mutex);
+		if (m_BackgroundQueue.jobs.empty()) return false;
+
+		job = std::move(m_BackgroundQueue.jobs.front());
+		m_BackgroundQueue.jobs.pop_front();
+		m_QueuedBackgroundJobs.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool JobSystem::runOne(bool background)
+	{
+		Job job;
+
+		if (m_QueuedJobs.load(std::memory_order_acquire) > 0)
+		{
+			const size_t queueIndex = getQueueIndex();
+			if (pop(queueIndex, job) || steal(queueIndex, job))
+			{
+				job();
+				return true;
+			}
+		}
+
+		if (background && popBackground(job))
+		{
+			job();
+			return true;
+		}
+
+		return false;
+	}
+
+	void JobSystem::finish(JobCounter* counter)
+	{
+		if (counter == nullptr) return;
+
+		std::vector<Job> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter->m_Mutex);
+			if (counter->m_Pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+			continuations.swap(counter->m_Continuations);
+		}
+
+		for (Job& continuation : continuations)
+		{
+			push(std::move(continuation));
+		}
+	}
+
+	JobSystem::Job JobSystem::counted(Job job, JobCounter* counter)
+	{
+		if (counter == nullptr) return job;
+
+		counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+		return [this, job = std::move(job), counter]()
+		{
+			job();
+			finish(counter);
+		};
+	}
+
+	void JobSystem::run(Job job, JobCounter* counter)
+	{
+		push(counted(std::move(job), counter));
+	}
+
+	void JobSystem::runBackground(Job job, JobCounter* counter)
+	{
+		pushBackground(counted(std::move(job), counter));
+	}
+
+	void JobSystem::runAfter(JobCounter& dependency, Job job, JobCounter* counter)
+	{
+		Job continuation = counted(std::move(job), counter);
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+			if (dependency.m_Pending.load(std::memory_order_acquire) != 0)
+			{
+				dependency.m_Continuations.push_back(std::move(continuation));
+				return;
+			}
+		}
+
+		push(std::move(continuation));
+	}
+
+	void JobSystem::wait(JobCounter& counter)
+	{
+		ANNILEEN_PROFILE_FUNCTION();
+
+		while (!counter.isDone())
+		{
+			if (!runOne(m_Threads.empty()))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::parallelFor(size_t count, size_t minRangeSize, const RangeJob& job)
+	{
+		if (count == 0) return;
+
+		// A few ranges per thread, so threads that finish early can steal the rest.
+		const size_t maxRanges = (m_Threads.size() + 1) * 4;
+		const size_t rangeCount = std::min(maxRanges, (count + std::max<size_t>(minRangeSize, 1) - 1) / std::max<size_t>(minRangeSize, 1));
+
+		if (rangeCount <= 1)
+		{
+			job(0, count);
+			return;
+		}
+
+		const size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+		JobCounter counter;
+		for (size_t begin = rangeSize; begin < count; begin += rangeSize)
+		{
+			const size_t end = std::min(begin + rangeSize, count);
+			run([&job, begin, end]() { job(begin, end); }, &counter);
+		}
+
+		// The first range runs here, then this thread helps with the others.
+		job(0, std::min(rangeSize, count));
+		wait(counter);
+	}
+
+	void JobSystem::workerLoop(size_t queueIndex)
+	{
+		t_ThreadQueue.system = this;
+		t_ThreadQueue.index = queueIndex;
+
+		ANNILEEN_PROFILE_THREAD(fmt::format("Job Worker {}", queueIndex - 1));
+
+		while (true)
+		{
+			if (runOne(true)) continue;
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_WakeCondition.wait(lock, [this] { return m_Quit || hasQueuedJobs(); });
+
+			if (m_Quit && !hasQueuedJobs()) return;
+		}
+	}
+
+	JobSystem::JobSystem(size_t workerCount) : m_QueuedJobs(0), m_QueuedBackgroundJobs(0), m_Quit(false)
+	{
+		for (size_t i = 0; i < workerCount + 1; ++i)
+		{
+			m_Queues.push_back(std::make_unique<Queue>());
+		}
+
+		for (size_t i = 0; i < workerCount; ++i)
+		{
+			m_Threads.emplace_back(&JobSystem::workerLoop, this, i + 1);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		while (runOne(true))
+		{
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_Quit = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (auto& thread : m_Threads)
+		{
+			thread.join();
+		}
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace annileen
+{
+	class JobSystem;
+
+	// Counts the jobs still running in a group. Jobs can be made to wait for a counter to
+	// reach zero, and any thread can wait for it while helping to run jobs.
+	// A counter must outlive the jobs it counts and the jobs that wait for it.
+	class JobCounter final
+	{
+	private:
+		std::atomic<uint32_t> m_Pending;
+
+		// Guards the jobs waiting for the counter to reach zero. Also held while the count
+		// drops, so once the destructor gets it no finishing job touches the counter anymore.
+		std::mutex m_Mutex;
+		std::vector<std::function<void()>> m_Continuations;
+
+		friend class JobSystem;
+
+	public:
+		bool isDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+		uint32_t getPending() const { return m_Pending.load(std::memory_order_acquire); }
+
+		JobCounter() : m_Pending(0) {}
+		~JobCounter() { std::lock_guard<std::mutex> lock(m_Mutex); }
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+	};
+
+	// Work stealing job system. Every worker thread, and the thread that created the system,
+	// has its own queue: a thread pushes and pops its own jobs at the back, idle workers steal
+	// from the front of the others. Other threads push to the creating thread's queue.
+	// Waiting on a counter runs queued jobs instead of blocking, so jobs may wait on
+	// other jobs too.
+	// Long jobs, like reading and decoding files, go to a background queue instead. Only idle
+	// workers take from it, a thread waiting on a counter never does, so waiting for a
+	// frame's jobs doesn't end up running a load. Without workers the waiting threads run
+	// background jobs too, nothing else would.
+	class JobSystem final
+	{
+	public:
+		typedef std::function<void()> Job;
+		// Runs over the item range [begin, end).
+		typedef std::function<void(size_t begin, size_t end)> RangeJob;
+
+	private:
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		std::vector<std::thread> m_Threads;
+		// Queue 0 belongs to the creating thread, queue i to worker i - 1.
+		std::vector<std::unique_ptr<Queue>> m_Queues;
+
+		// First in, first out, see runBackground().
+		Queue m_BackgroundQueue;
+
+		// Jobs sitting in queues, idle workers sleep while both are zero.
+		std::atomic<uint32_t> m_QueuedJobs;
+		std::atomic<uint32_t> m_QueuedBackgroundJobs;
+		std::mutex m_SleepMutex;
+		std::condition_variable m_WakeCondition;
+		bool m_Quit;
+
+		void push(Job job);
+		void pushBackground(Job job);
+		void wake();
+		bool pop(size_t queueIndex, Job& job);
+		bool steal(size_t thiefIndex, Job& job);
+		bool popBackground(Job& job);
+		// Runs one queued job, if there is any. Background jobs only run if asked for and
+		// there is no other job.
+		bool runOne(bool background);
+		Job counted(Job job, JobCounter* counter);
+		void finish(JobCounter* counter);
+
+		bool hasQueuedJobs() const
+		{
+			return m_QueuedJobs.load(std::memory_order_acquire) > 0 || m_QueuedBackgroundJobs.load(std::memory_order_acquire) > 0;
+		}
+
+		void workerLoop(size_t queueIndex);
+		// Queue of the calling thread, 0 for threads the system does not own.
+		size_t getQueueIndex() const;
+
+	public:
+		// Worker threads, not counting the threads that wait and help.
+		size_t getWorkerCount() const { return m_Threads.size(); }
+
+		// Queues a job. The counter, if any, counts it until it has run.
+		void run(Job job, JobCounter* counter = nullptr);
+		// Queues a job once dependency reaches zero (right away if it is zero already).
+		void runAfter(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+		// Queues a long job on the background queue. Jobs must not wait for background jobs,
+		// with every worker waiting nothing would run them.
+		void runBackground(Job job, JobCounter* counter = nullptr);
+
+		// Runs jobs until the counter reaches zero. Background jobs are left to the workers.
+		void wait(JobCounter& counter);
+
+		// Splits [0, count) into ranges of at least minRangeSize items, runs them as jobs and
+		// waits for all of them.
+		void parallelFor(size_t count, size_t minRangeSize, const RangeJob& job);
+
+		// With 0 workers every job runs on the threads that wait.
+		JobSystem(size_t workerCount);
+		// Runs the jobs still queued, then joins the workers.
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+	};
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace annileen
+{
+	struct PoolStats
+	{
+		// Objects the allocated pages can hold.
+		size_t capacity;
+		size_t used;
+		// Highest used count since the pool was created.
+		size_t peak;
+		size_t pages;
+	};
+
+	// Fixed size allocator for objects of type T. Memory is taken from the heap a page of
+	// PageSize objects at a time and only given back when the pool is destroyed. Freed
+	// objects go to an intrusive free list, so once the pool is warm creating and destroying
+	// objects never reaches the general heap.
+	// Objects still alive when the pool is destroyed are not destructed.
+	template <class T, size_t PageSize = 256>
+	class PoolAllocator final
+	{
+	private:
+		union Block
+		{
+			Block* next;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		std::vector<std::unique_ptr<Block[]>> m_Pages;
+		Block* m_FreeList = nullptr;
+		size_t m_Used = 0;
+		size_t m_Peak = 0;
+
+		void addPage()
+		{
+			Block* page = new Block[PageSize];
+			m_Pages.emplace_back(page);
+
+			// Chain the new blocks in address order, so consecutive allocations are adjacent.
+			for (size_t i = PageSize; i-- > 0;)
+			{
+				page[i].next = m_FreeList;
+				m_FreeList = &page[i];
+			}
+		}
+
+	public:
+		// Uninitialized storage for one T, construct it with placement new.
+		void* allocate()
+		{
+			if (m_FreeList == nullptr) addPage();
+
+			Block* block = m_FreeList;
+			m_FreeList = block->next;
+
+			m_Peak = std::max(m_Peak, ++m_Used);
+			return block->storage;
+		}
+
+		// The object must be destructed already.
+		void deallocate(void* pointer)
+		{
+			Block* block = reinterpret_cast<Block*>(pointer);
+			block->next = m_FreeList;
+			m_FreeList = block;
+			--m_Used;
+		}
+
+		// Allocates pages up front so the next allocations up to count objects in use don't.
+		void reserve(size_t count)
+		{
+			while (m_Pages.size() * PageSize < count)
+			{
+				addPage();
+			}
+		}
+
+		template <class... Args>
+		T* create(Args&&... args)
+		{
+			return new (allocate()) T(std::forward<Args>(args)...);
+		}
+
+		void destroy(T* object)
+		{
+			object->~T();
+			deallocate(object);
+		}
+
+		PoolStats getStats() const
+		{
+			return { m_Pages.size() * PageSize, m_Used, m_Peak, m_Pages.size() };
+		}
+
+		PoolAllocator() = default;
+		PoolAllocator(const PoolAllocator&) = delete;
+		PoolAllocator& operator=(const PoolAllocator&) = delete;
+	};
+}
@@ -0,0 +1,287 @@
+#include <engine/core/profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+namespace annileen
+{
+	namespace
+	{
+		// Events each thread can hold before the frame collects them. Older events are
+		// overwritten if a thread records more than this in a single frame.
+		constexpr uint64_t s_RingCapacity = 1 << 14;
+
+		struct ThreadBuffer
+		{
+			uint32_t index;
+			std::string name;
+			std::vector<ProfilerEvent> ring;
+			// Only the owning thread writes events, the frame collector reads up to head.
+			std::atomic<uint64_t> head{ 0 };
+			uint64_t readCursor = 0;
+			uint32_t depth = 0;
+			bool inUse = true;
+		};
+
+		std::mutex s_ThreadsMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> s_Threads;
+
+		// Hands the buffer back when its thread exits, so short lived threads reuse buffers.
+		struct ThreadBufferOwner
+		{
+			ThreadBuffer* buffer = nullptr;
+
+			~ThreadBufferOwner()
+			{
+				if (buffer != nullptr)
+				{
+					std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+					buffer->inUse = false;
+				}
+			}
+		};
+
+		thread_local ThreadBuffer* t_Buffer = nullptr;
+		thread_local ThreadBufferOwner t_BufferOwner;
+
+		std::deque<ProfilerFrame> s_Frames;
+		uint64_t s_FrameStart = 0;
+		std::atomic<bool> s_Paused{ false };
+
+		ThreadBuffer* getThreadBuffer()
+		{
+			if (t_Buffer == nullptr)
+			{
+				std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+
+				for (auto& buffer : s_Threads)
+				{
+					if (!buffer->inUse)
+					{
+						buffer->inUse = true;
+						buffer->depth = 0;
+						buffer->name = fmt::format("Thread {}", buffer->index);
+						t_Buffer = buffer.get();
+						break;
+					}
+				}
+
+				if (t_Buffer == nullptr)
+				{
+					auto buffer = std::make_unique<ThreadBuffer>();
+					buffer->index = static_cast<uint32_t>(s_Threads.size());
+					buffer->name = fmt::format("Thread {}", buffer->index);
+					buffer->ring.resize(s_RingCapacity);
+
+					t_Buffer = buffer.get();
+					s_Threads.push_back(std::move(buffer));
+				}
+
+				t_BufferOwner.buffer = t_Buffer;
+			}
+
+			return t_Buffer;
+		}
+
+		ProfilerPercentiles computePercentiles(std::vector<double>& values)
+		{
+			if (values.empty())
+			{
+				return { 0.0, 0.0, 0.0 };
+			}
+
+			std::sort(values.begin(), values.end());
+
+			auto at = [&values](double percentile)
+			{
+				size_t index = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+				return values[std::min(index, values.size() - 1)];
+			};
+
+			return { at(0.50), at(0.95), at(0.99) };
+		}
+
+		std::string escapeJson(const std::string& text)
+		{
+			std::string escaped;
+			escaped.reserve(text.size());
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\') escaped.push_back('\\');
+				escaped.push_back(c);
+			}
+			return escaped;
+		}
+	}
+
+	void Profiler::beginScope()
+	{
+		getThreadBuffer()->depth++;
+	}
+
+	void Profiler::endScope(const char* name, uint64_t start)
+	{
+		ThreadBuffer* buffer = t_Buffer;
+		buffer->depth--;
+
+		const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+		buffer->ring[head & (s_RingCapacity - 1)] = { name, start, now(), buffer->depth, buffer->index };
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	void Profiler::newFrame()
+	{
+		const uint64_t frameEnd = now();
+		const bool paused = s_Paused.load();
+
+		ProfilerFrame frame;
+		frame.start = s_FrameStart;
+		frame.end = frameEnd;
+
+		{
+			std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+
+			for (auto& buffer : s_Threads)
+			{
+				const uint64_t head = buffer->head.load(std::memory_order_acquire);
+				uint64_t cursor = std::max(buffer->readCursor, head > s_RingCapacity ? head - s_RingCapacity : 0);
+
+				// Events are pushed when they end, so they are ordered by end time per thread.
+				for (; cursor < head; ++cursor)
+				{
+					const ProfilerEvent& event = buffer->ring[cursor & (s_RingCapacity - 1)];
+					if (event.end > frameEnd) break;
+
+					if (!paused) frame.events.push_back(event);
+				}
+
+				buffer->readCursor = cursor;
+			}
+		}
+
+		if (!paused && s_FrameStart != 0)
+		{
+			s_Frames.push_back(std::move(frame));
+			if (s_Frames.size() > historySize)
+			{
+				s_Frames.pop_front();
+			}
+		}
+
+		s_FrameStart = frameEnd;
+	}
+
+	void Profiler::setThreadName(const std::string& name)
+	{
+		ThreadBuffer* buffer = getThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+		buffer->name = name;
+	}
+
+	void Profiler::setPaused(bool paused)
+	{
+		s_Paused = paused;
+	}
+
+	bool Profiler::isPaused()
+	{
+		return s_Paused;
+	}
+
+	const std::deque<ProfilerFrame>& Profiler::getFrames()
+	{
+		return s_Frames;
+	}
+
+	std::vector<std::string> Profiler::getThreadNames()
+	{
+		std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+
+		std::vector<std::string> names;
+		for (const auto& buffer : s_Threads)
+		{
+			names.push_back(buffer->name);
+		}
+		return names;
+	}
+
+	ProfilerPercentiles Profiler::getFramePercentiles()
+	{
+		std::vector<double> durations;
+		durations.reserve(s_Frames.size());
+		for (const auto& frame : s_Frames)
+		{
+			durations.push_back((frame.end - frame.start) / 1000000.0);
+		}
+
+		return computePercentiles(durations);
+	}
+
+	std::map<std::string, ProfilerPercentiles> Profiler::getScopePercentiles()
+	{
+		std::map<std::string, std::vector<double>> samples;
+
+		for (const auto& frame : s_Frames)
+		{
+			std::map<std::string, double> frameTotals;
+			for (const auto& event : frame.events)
+			{
+				frameTotals[event.name] += (event.end - event.start) / 1000000.0;
+			}
+
+			for (const auto& [name, total] : frameTotals)
+			{
+				samples[name].push_back(total);
+			}
+		}
+
+		std::map<std::string, ProfilerPercentiles> percentiles;
+		for (auto& [name, values] : samples)
+		{
+			percentiles[name] = computePercentiles(values);
+		}
+		return percentiles;
+	}
+
+	bool Profiler::exportChromeTrace(const std::string& fileName)
+	{
+		std::ofstream file(fileName, std::ios::out | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		const uint64_t origin = s_Frames.empty() ? 0 : s_Frames.front().start;
+		const std::vector<std::string> threadNames = getThreadNames();
+
+		file << "{\"traceEvents\":[\n";
+
+		bool first = true;
+		auto separator = [&first]() { const char* s = first ? "" : ",\n"; first = false; return s; };
+
+		for (size_t i = 0; i < threadNames.size(); ++i)
+		{
+			file << separator() << fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+				i, escapeJson(threadNames[i]));
+		}
+
+		for (const auto& frame : s_Frames)
+		{
+			for (const auto& event : frame.events)
+			{
+				file << separator() << fmt::format("{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+					escapeJson(event.name), event.thread, static_cast<int64_t>(event.start - origin) / 1000.0, (event.end - event.start) / 1000.0);
+			}
+		}
+
+		file << "\n]}\n";
+
+		return true;
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// The profiler is compiled in by default. Build with ANNILEEN_PROFILER_ENABLED=0 to
+// remove every marker, they then expand to nothing.
+#ifndef ANNILEEN_PROFILER_ENABLED
+#define ANNILEEN_PROFILER_ENABLED 1
+#endif
+
+#define ANNILEEN_PROFILER_CONCAT_(a, b) a##b
+#define ANNILEEN_PROFILER_CONCAT(a, b) ANNILEEN_PROFILER_CONCAT_(a, b)
+
+#if ANNILEEN_PROFILER_ENABLED
+// Names must be string literals (or otherwise outlive the profiler), only the pointer is stored.
+#define ANNILEEN_PROFILE_SCOPE(_name) \
+	annileen::ProfilerScope ANNILEEN_PROFILER_CONCAT(__profilerScope, __LINE__)(_name);
+#define ANNILEEN_PROFILE_FUNCTION() ANNILEEN_PROFILE_SCOPE(__FUNCTION__)
+#define ANNILEEN_PROFILE_THREAD(_name) annileen::Profiler::setThreadName(_name);
+#define ANNILEEN_PROFILE_FRAME() annileen::Profiler::newFrame();
+#else
+#define ANNILEEN_PROFILE_SCOPE(_name)
+#define ANNILEEN_PROFILE_FUNCTION()
+#define ANNILEEN_PROFILE_THREAD(_name)
+#define ANNILEEN_PROFILE_FRAME()
+#endif
+
+namespace annileen
+{
+	struct ProfilerEvent
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+		uint32_t depth;
+		uint32_t thread;
+	};
+
+	struct ProfilerFrame
+	{
+		uint64_t start;
+		uint64_t end;
+		std::vector<ProfilerEvent> events;
+	};
+
+	struct ProfilerPercentiles
+	{
+		double p50;
+		double p95;
+		double p99;
+	};
+
+	class Profiler final
+	{
+	public:
+		// Number of finished frames kept for the flame graph, percentiles and trace export.
+		static constexpr size_t historySize = 300;
+
+		// Timestamps are nanoseconds on the steady clock.
+		static uint64_t now()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		static void beginScope();
+		static void endScope(const char* name, uint64_t start);
+
+		// Closes the current frame, gathering the events every thread recorded during it.
+		static void newFrame();
+		static void setThreadName(const std::string& name);
+
+		static void setPaused(bool paused);
+		static bool isPaused();
+
+		// All accessors below must be called from the thread calling newFrame().
+		static const std::deque<ProfilerFrame>& getFrames();
+		static std::vector<std::string> getThreadNames();
+		static ProfilerPercentiles getFramePercentiles();
+		// Inclusive time of every scope name per frame, over the history.
+		static std::map<std::string, ProfilerPercentiles> getScopePercentiles();
+
+		static bool exportChromeTrace(const std::string& fileName);
+
+	private:
+		Profiler() = delete;
+	};
+
+	class ProfilerScope final
+	{
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+
+	public:
+		ProfilerScope(const char* name) : m_Name(name), m_Start(Profiler::now())
+		{
+			Profiler::beginScope();
+		}
+
+		~ProfilerScope()
+		{
+			Profiler::endScope(m_Name, m_Start);
+		}
+	};
+}
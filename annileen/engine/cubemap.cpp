@@ -5,11 +5,16 @@ namespace annileen
 	Cubemap::Cubemap(bgfx::TextureHandle handle, bgfx::TextureInfo info, bimg::Orientation::Enum orientation)
 		: m_Handle(handle),
 		m_Info(info),
-		m_Orientation(orientation)
+		m_Orientation(orientation),
+		m_OwnsHandle(false)
 	{
 	}
 
 	Cubemap::~Cubemap()
 	{
+		if (m_OwnsHandle && bgfx::isValid(m_Handle))
+		{
+			bgfx::destroy(m_Handle);
+		}
 	}
 }
@@ -16,13 +16,19 @@ namespace annileen
 		bgfx::TextureHandle m_Handle;
 		bgfx::TextureInfo m_Info;
 		bimg::Orientation::Enum m_Orientation;
+		// Set for handles the AssetManager created for this asset, destroyed with it.
+		bool m_OwnsHandle;
 
 	public:
 		const bgfx::TextureHandle& getHandle() const { return m_Handle; }
 		const bgfx::TextureInfo& getInfo() const { return m_Info; }
 		const bimg::Orientation::Enum& getOrientation() const { return m_Orientation; }
 
+		size_t getMemorySize() const override { return m_OwnsHandle ? m_Info.storageSize : 0; }
+
 		Cubemap(bgfx::TextureHandle handle, bgfx::TextureInfo info, bimg::Orientation::Enum orientation);
 		~Cubemap();
+
+		friend class AssetManager;
 	};
 }
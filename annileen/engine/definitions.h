@@ -3,7 +3,7 @@
 #define ANNILEEN_APP_MAIN(__ApplicationClassName, __ApplicationName) \
     int main(int argc, char* argv[]) { \
         std::unique_ptr<__ApplicationClassName> __app__ = std::make_unique<__ApplicationClassName>(); \
-        return __app__->run(__ApplicationName); \
+        return __app__->run(__ApplicationName, argc, argv); \
     }
 
 #ifdef _DEBUG
@@ -3,12 +3,22 @@
 #include <engine/serviceprovider.h>
 #include <engine/core/logger.h>
 #include <engine/renderview.h>
+#include <engine/core/profiler.h>
 #include <sstream>
+#include <thread>
 #include <bx/math.h>
 #include <glm.hpp>
 
 namespace annileen
 {
+    // Programs the engine itself uses, each variant compiled ahead into its own stages. They
+    // are all created at startup, so switching features never creates shaders. Applications
+    // add their own through AssetManager::addShaderPermutation() in init().
+    static const ShaderPermutation s_ShaderPermutations[] = {
+        { "shadowmap", ShaderFeatures::None, "vs_sms_shadow.vs", "fs_sms_shadow.fs" },
+        { "skybox", ShaderFeatures::None, "skybox.vs", "skybox.fs" }
+    };
+
     // Initialize static variables
     bool Engine::m_Running = true;
     Engine* Engine::s_Instance = nullptr;
@@ -99,73 +109,155 @@ namespace annileen
     }
 
 
-    int Engine::init(int width, int height, std::string assetfile, std::string applicationName)
+    int Engine::init(int width, int height, std::string assetfile, std::string applicationName, const CommandLineOptions& options)
     {
         m_Width = width;
         m_Height = height;
         m_ApplicationName = applicationName;
+        m_Headless = options.headless;
+        m_StartTime = std::chrono::steady_clock::now();
 
-        glfwSetErrorCallback(&Engine::glfw_errorCallback);
-        if (!glfwInit())
-            return 1;
-        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        ANNILEEN_PROFILE_THREAD("Main");
 
-        m_Window = glfwCreateWindow(m_Width, m_Height, "Annileen", nullptr, nullptr);
-        if (!m_Window)
-            return 1;
+        if (!m_Headless)
+        {
+            glfwSetErrorCallback(&Engine::glfw_errorCallback);
+            if (!glfwInit())
+                return 1;
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+            m_Window = glfwCreateWindow(m_Width, m_Height, "Annileen", nullptr, nullptr);
+            if (!m_Window)
+                return 1;
+
+            glfwSetKeyCallback(m_Window, glfw_keyCallback);
+            glfwSetMouseButtonCallback(m_Window, glfw_mouseButtonCallback);
+            glfwSetCursorPosCallback(m_Window, glfw_mouseCursorPositionCallback);
+            glfwSetScrollCallback(m_Window, glfw_mouseScrollCallback);
+            glfwSetCharCallback(m_Window, glfw_charCallback);
+            //glfwSetCursorEnterCallback(m_Window, glfw_mouseCursorEnterCallback);
+            //glfwSetJoystickCallback(glwf_joystickCallback);
+        }
+
+        // Initialize services that don't depend on bgfx
+        Logger* logger = new Logger();
+        ServiceProvider::provideLogger(logger);
+
+        Settings* settings = new Settings();
+        ServiceProvider::provideSettings(settings);
 
-        glfwSetKeyCallback(m_Window, glfw_keyCallback);
-        glfwSetMouseButtonCallback(m_Window, glfw_mouseButtonCallback);
-        glfwSetCursorPosCallback(m_Window, glfw_mouseCursorPositionCallback);
-        glfwSetScrollCallback(m_Window, glfw_mouseScrollCallback);
-        glfwSetCharCallback(m_Window, glfw_charCallback);
-        //glfwSetCursorEnterCallback(m_Window, glfw_mouseCursorEnterCallback);
-        //glfwSetJoystickCallback(glwf_joystickCallback);
+        // Calling renderFrame before init makes bgfx render on this thread. Otherwise
+        // bgfx spawns its own render thread and this one becomes the API thread.
+        if (!settings->rendering.multithreaded)
+        {
+            bgfx::renderFrame();
+        }
 
-        bgfx::renderFrame();
+        if (options.submitThreads >= 0)
+        {
+            settings->rendering.submitThreads = static_cast<uint8_t>(options.submitThreads);
+        }
+
+        if (options.fixedRate > 0.0f)
+        {
+            settings->timing.fixedTimestep = 1.0f / options.fixedRate;
+        }
+
+        if (options.frameRateLimit >= 0)
+        {
+            settings->timing.frameRateLimit = static_cast<uint16_t>(options.frameRateLimit);
+        }
+
+        if (options.noVsync)
+        {
+            settings->timing.vsync = false;
+        }
+
+        if (options.hotReload)
+        {
+            settings->assets.hotReload = true;
+        }
+
+        if (options.jobWorkers >= 0)
+        {
+            settings->jobs.workerThreads = options.jobWorkers;
+        }
+
+        size_t jobWorkers = static_cast<size_t>(settings->jobs.workerThreads);
+        if (settings->jobs.workerThreads < 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            jobWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+
+        ServiceProvider::provideJobSystem(new JobSystem(jobWorkers));
+        ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Job system running {} worker thread(s).", jobWorkers);
 
         bgfx::Init init;
-        init.type = bgfx::RendererType::OpenGL;
-    #if BX_PLATFORM_LINUX || BX_PLATFORM_BSD
-        init.platformData.ndt = glfwGetX11Display();
-        init.platformData.nwh = (void*)(uintptr_t)glfwGetX11Window(m_Window);
-    #elif BX_PLATFORM_OSX
-        init.platformData.nwh = glfwGetCocoaWindow(m_Window);
-    #elif BX_PLATFORM_WINDOWS
-        init.platformData.nwh = glfwGetWin32Window(m_Window);
-    #endif
+
+        if (m_Headless)
+        {
+            // Nothing is presented, so there is no need for a window or vsync.
+            init.type = bgfx::RendererType::Noop;
+            init.resolution.reset = BGFX_RESET_NONE;
+        }
+        else
+        {
+            init.type = bgfx::RendererType::OpenGL;
+        #if BX_PLATFORM_LINUX || BX_PLATFORM_BSD
+            init.platformData.ndt = glfwGetX11Display();
+            init.platformData.nwh = (void*)(uintptr_t)glfwGetX11Window(m_Window);
+        #elif BX_PLATFORM_OSX
+            init.platformData.nwh = glfwGetCocoaWindow(m_Window);
+        #elif BX_PLATFORM_WINDOWS
+            init.platformData.nwh = glfwGetWin32Window(m_Window);
+        #endif
+            init.resolution.reset = settings->timing.vsync ? BGFX_RESET_VSYNC : BGFX_RESET_NONE;
+        }
+
+        m_ResetFlags = init.resolution.reset;
 
         init.resolution.width = m_Width;
         init.resolution.height = m_Height;
-        init.resolution.reset = BGFX_RESET_VSYNC;
 
         if (!bgfx::init(init))
             return 1;
 
         // Initialize services
-        Logger* logger = new Logger();
-        ServiceProvider::provideLogger(logger);
-
         AssetManager* assetManager = new AssetManager(assetfile);
+        assetManager->setMemoryBudget(static_cast<uint64_t>(settings->assets.memoryBudget) * 1024 * 1024);
+        if (settings->assets.hotReload)
+        {
+            assetManager->setHotReload(true);
+        }
         ServiceProvider::provideAssetManager(assetManager);
 
-        Settings* settings = new Settings();
-        ServiceProvider::provideSettings(settings);
+        for (const ShaderPermutation& permutation : s_ShaderPermutations)
+        {
+            assetManager->addShaderPermutation(permutation);
+        }
+        assetManager->loadShaderPermutations();
 
         // TODO: Get parameter from settings.
         FontManager* fontManager = new FontManager(512);
         ServiceProvider::provideFontManager(fontManager);
         //
 
+        ServiceProvider::provideSceneManager(new SceneManager());
+
         m_Renderer = new Renderer();
         m_Renderer->init(this);
 
 
-        m_TargetFPS = 60; 
+        m_TargetFPS = settings->timing.frameRateLimit;
+        m_FixedTimestep.setStepTime(settings->timing.fixedTimestep);
+        m_FixedTimestep.setMaxSteps(settings->timing.maxFixedSteps);
         m_Time.timeScale = 1.0f;
 
         m_Running = true;
         m_Time.deltaTime = m_Time.unscaledDeltaTime = m_Time.time = 0;
+        m_Time.fixedDeltaTime = settings->timing.fixedTimestep;
+        m_Time.interpolation = 1.0f;
 
         m_Gui = new Gui();
 
@@ -233,12 +325,15 @@ namespace annileen
 
     void Engine::setWindowTitle(std::string title)
     {
+        if (m_Headless) return;
+
         glfwSetWindowTitle(m_Window, title.c_str());
     }
 
-    void Engine::setFPSLock(uint8_t fps)
+    void Engine::setFPSLock(uint16_t fps)
     {
         m_TargetFPS = fps;
+        m_FrameLimiter.reset();
     }
 
     int Engine::getFPS() const
@@ -259,11 +354,25 @@ namespace annileen
 
     bool Engine::run()
     {
-        double time = glfwGetTime();
+        ANNILEEN_PROFILE_FRAME();
+
+        if (m_TargetFPS > 0)
+        {
+            m_FrameLimiter.wait(1.0 / m_TargetFPS);
+        }
+
+        double time = m_Headless
+            ? std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count()
+            : glfwGetTime();
         m_Time.unscaledDeltaTime = time - m_Time.time;
         m_Time.deltaTime = m_Time.unscaledDeltaTime * m_Time.timeScale;
         m_Time.time = time;
 
+        // The simulation runs on scaled time, pausing with a time scale of 0.
+        m_FixedSteps = m_FixedTimestep.advance(m_Time.deltaTime);
+        m_Time.fixedDeltaTime = static_cast<float>(m_FixedTimestep.getStepTime());
+        m_Time.interpolation = m_FixedTimestep.getInterpolation();
+
         static float fpsCount = 0.0;
         fpsCount += m_Time.deltaTime;
         if (fpsCount >= 0.3f)
@@ -274,7 +383,7 @@ namespace annileen
             setWindowTitle(ss.str());
         }
 
-        m_Running = m_Running && !glfwWindowShouldClose(m_Window);
+        m_Running = m_Running && (m_Headless || !glfwWindowShouldClose(m_Window));
         return m_Running;
     }
 
@@ -285,6 +394,8 @@ namespace annileen
 
     void Engine::setMouseCapture(bool value)
     {
+        if (m_Headless) return;
+
         if (value)
             glfwSetInputMode(m_Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
         else
@@ -293,7 +404,12 @@ namespace annileen
 
     void Engine::checkInputEvents()
     {
+        ANNILEEN_PROFILE_SCOPE("Engine::checkInputEvents");
+
         m_Input->flushEvents();
+
+        if (m_Headless) return;
+
         glfwPollEvents();
         int oldWidth = m_Width;
         int oldHeight = m_Height;
@@ -301,18 +417,28 @@ namespace annileen
 
         if (m_Width != oldWidth || m_Height != oldHeight)
         {
-            bgfx::reset(m_Width, m_Height, BGFX_RESET_VSYNC);            
+            bgfx::reset(m_Width, m_Height, m_ResetFlags);
         }
     }
 
     void Engine::renderFrame()
     {
+        ANNILEEN_PROFILE_SCOPE("Engine::renderFrame");
+
         if (m_CurrentScene != nullptr)
         {
+            {
+                ANNILEEN_PROFILE_SCOPE("Scene::updateTransforms");
+                m_CurrentScene->updateTransforms(m_Time.interpolation);
+            }
+
             m_Renderer->setActiveCamera(m_CurrentScene->getCamera());            
             m_Renderer->render();            
         }
 
+        m_Renderer->updateStats();
+
+        ANNILEEN_PROFILE_SCOPE("bgfx::frame");
         bgfx::frame();
     }
 
@@ -321,7 +447,8 @@ namespace annileen
         delete[] _ptr;
     }
 
-    Engine::Engine()
+    Engine::Engine() : m_Window(nullptr), m_Headless(false), m_Renderer(nullptr), m_TargetFPS(0), m_FixedTimestep(1.0 / 60.0, 8),
+        m_FixedSteps(0), m_ResetFlags(BGFX_RESET_VSYNC)
     {
         m_Input = std::make_shared<Input>();
     }
@@ -343,6 +470,9 @@ namespace annileen
 
     Engine::~Engine()
     {
+        // Scenes still loading use the other services when deleted, so this goes first.
+        ServiceProvider::provideSceneManager(nullptr);
+
         Logger* logger = ServiceProvider::getLogger();
         ServiceProvider::provideLogger(nullptr);
         if (logger != nullptr)
@@ -376,14 +506,21 @@ namespace annileen
             delete m_Gui;
         }
 
-        SceneManager* sceneManager = ServiceProvider::getSceneManager();
-        if (sceneManager != nullptr)
+        if (m_Renderer != nullptr)
         {
-            delete sceneManager;
+            delete m_Renderer;
         }
 
+        // Runs what is still queued and joins the workers. Jobs may still use bgfx, so this
+        // must happen before it shuts down.
+        ServiceProvider::provideJobSystem(nullptr);
+
         m_Uniform.destroy();
         bgfx::shutdown();
-        glfwTerminate();
+
+        if (!m_Headless)
+        {
+            glfwTerminate();
+        }
     }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <chrono>
 
 #include <bx/bx.h>
 #include <bx/allocator.h>
@@ -22,6 +23,9 @@
 #include <engine/input.h>
 #include <engine/uniform.h>
 #include <engine/gui.h>
+#include <engine/core/commandline.h>
+#include <engine/core/fixedtimestep.h>
+#include <engine/core/framelimiter.h>
 
 namespace annileen
 {
@@ -38,6 +42,10 @@ namespace annileen
         float unscaledDeltaTime;
         double time;
         float timeScale;
+        // Simulation step of fixedUpdate(), scaled time.
+        float fixedDeltaTime;
+        // How far rendering is between the last two simulation steps, from 0 to 1.
+        float interpolation;
     };
 
     class Engine final
@@ -47,6 +55,9 @@ namespace annileen
 
         GLFWwindow* m_Window;
         int m_Width, m_Height;
+        // Runs without a window on the bgfx Noop renderer.
+        bool m_Headless;
+        std::chrono::steady_clock::time_point m_StartTime;
         std::string m_ApplicationName;
 
         std::shared_ptr<Input> m_Input;
@@ -58,7 +69,13 @@ namespace annileen
         Gui* m_Gui;
 
         Time m_Time;
-        uint8_t m_TargetFPS;
+        // Frame rate the limiter holds to, 0 when uncapped.
+        uint16_t m_TargetFPS;
+        FrameLimiter m_FrameLimiter;
+        FixedTimestep m_FixedTimestep;
+        // Simulation steps due this frame.
+        uint32_t m_FixedSteps;
+        uint32_t m_ResetFlags;
 
         Scene* m_CurrentScene = nullptr;
 
@@ -77,19 +94,24 @@ namespace annileen
         static void glfw_charCallback(GLFWwindow* window, unsigned int c);
             
     public:
-        int init(int width, int height, std::string assetfile, std::string applicationName);
+        int init(int width, int height, std::string assetfile, std::string applicationName, const CommandLineOptions& options = CommandLineOptions());
 
         std::shared_ptr<Input> getInput(); 
         Gui* getGui();
         Renderer* getRenderer();
         Uniform* getUniform();
         GLFWwindow* getGLFWWindow();
+        bool isHeadless() const { return m_Headless; }
 
         uint16_t getWidth() const;
         uint16_t getHeight() const;
 
         void setWindowTitle(std::string title);
-        void setFPSLock(uint8_t fps);
+        // Caps the frame rate, 0 uncaps it.
+        void setFPSLock(uint16_t fps);
+        void setFixedTimestep(double stepTime) { m_FixedTimestep.setStepTime(stepTime); }
+        // Simulation steps the application runs this frame, set by run().
+        uint32_t getFixedStepCount() const { return m_FixedSteps; }
 
         int getFPS() const;
         Time getTime();
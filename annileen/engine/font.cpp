@@ -3,24 +3,30 @@
 
 namespace annileen
 {
-	Font::Font(std::string filename) 
+	Font::Font(std::string filename) : m_Size(0)
 	{
-		// TODO: move this to File class.
-		std::ifstream file;
-		file.open(filename, std::ifstream::binary | std::ifstream::in);
+		create(MappedFile::open(filename));
+	}
 
-		file.seekg(0, std::ios::end);
-		size_t size = file.tellg();
-		file.seekg(0, std::ios::beg);
+	Font::Font() : m_Size(0)
+	{
+		m_Handle = BGFX_INVALID_HANDLE;
+	}
 
-		uint8_t* data = new uint8_t[size];
-		file.read(reinterpret_cast<char*>(data), size);
-		file.close();
+	void Font::create(std::shared_ptr<MappedFile> file)
+	{
+		const uint8_t* data = file != nullptr ? file->getData() : nullptr;
+		const size_t size = file != nullptr ? file->getSize() : 0;
+		create(std::move(file), data, size);
+	}
 
-		if (data != nullptr)
+	void Font::create(std::shared_ptr<MappedFile> file, const uint8_t* data, size_t size)
+	{
+		if (file != nullptr && size > 0)
 		{
-			m_Handle = ServiceProvider::getFontManager()->createTtf(data, static_cast<uint32_t>(size));
-			delete[] data;
+			m_File = std::move(file);
+			m_Size = size;
+			m_Handle = ServiceProvider::getFontManager()->createTtfRef(data, static_cast<uint32_t>(size));
 		}
 		else
 		{
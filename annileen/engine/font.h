@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include <engine/asset.h>
+#include <engine/core/file.h>
 #include <engine/text/fontmanager.h>
 
 namespace annileen
@@ -12,9 +13,23 @@ namespace annileen
 	{
 	private:
 		TrueTypeHandle m_Handle;
+		// The font manager reads the font straight from the mapping.
+		std::shared_ptr<MappedFile> m_File;
+		size_t m_Size;
+
+		void create(std::shared_ptr<MappedFile> file);
+		// From part of a mapped file, like a font inside the asset archive.
+		void create(std::shared_ptr<MappedFile> file, const uint8_t* data, size_t size);
+
+		// Loaded asynchronously: the handle is invalid until the AssetManager creates the font.
+		Font();
+		friend class AssetManager;
 	public:
 		const TrueTypeHandle& getHandle() const { return m_Handle; }
 
+		// The font file, which stays mapped while the font is alive.
+		size_t getMemorySize() const override { return m_Size; }
+
 		Font(std::string filename);
 		~Font();
 	};
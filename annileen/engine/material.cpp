@@ -3,8 +3,8 @@
 #include <algorithm>
 
 //#include <engine/shaderpass.h>
-//#include <engine/texture.h>
-//#include <engine/cubemap.h>
+#include <engine/texture.h>
+#include <engine/cubemap.h>
 
 
 namespace annileen
@@ -40,26 +40,42 @@ namespace annileen
 
     void Material::addTexture(const char* name, Texture* texture, uint8_t registerId)
     {
-        m_Textures[name] = std::make_pair(registerId, texture);
+        m_Textures[name] = { registerId, texture, Engine::getInstance()->getUniform()->getSamplerUniformHandle(name) };
     }
 
     void Material::addCubemap(const char* name, Cubemap* cubemap, uint8_t registerId)
     {
-        m_Cubemaps[name] = std::make_pair(registerId, cubemap);
+        m_Cubemaps[name] = { registerId, cubemap, Engine::getInstance()->getUniform()->getSamplerUniformHandle(name) };
     }
 
-    void Material::submitUniforms()
+    void Material::addTexture(const char* name, AssetRef<Texture> texture, uint8_t registerId)
     {
-        auto uniform = Engine::getInstance()->getUniform();
+        Texture* asset = texture.get();
+        m_Textures[name] = { registerId, asset, Engine::getInstance()->getUniform()->getSamplerUniformHandle(name), std::move(texture) };
+    }
 
+    void Material::addCubemap(const char* name, AssetRef<Cubemap> cubemap, uint8_t registerId)
+    {
+        Cubemap* asset = cubemap.get();
+        m_Cubemaps[name] = { registerId, asset, Engine::getInstance()->getUniform()->getSamplerUniformHandle(name), std::move(cubemap) };
+    }
+
+    void Material::submitUniforms(bgfx::Encoder* encoder)
+    {
         for (const auto& [k, v] : m_Textures)
         {
-            uniform->setTextureUniform(k, v.second, v.first);
+            if (encoder != nullptr)
+                encoder->setTexture(v.registerId, v.uniform, v.texture->getHandle());
+            else
+                bgfx::setTexture(v.registerId, v.uniform, v.texture->getHandle());
         }
 
         for (const auto& [k, v] : m_Cubemaps)
         {
-            uniform->setCubemapUniform(k, v.second, v.first);
+            if (encoder != nullptr)
+                encoder->setTexture(v.registerId, v.uniform, v.texture->getHandle());
+            else
+                bgfx::setTexture(v.registerId, v.uniform, v.texture->getHandle());
         }
     }
 
@@ -5,6 +5,10 @@
 #include <vector>
 #include <map>
 
+#include <bgfx/bgfx.h>
+
+#include <engine/assetref.h>
+
 namespace annileen
 {
     class ShaderPass;
@@ -14,10 +18,22 @@ namespace annileen
     class Material
     {
     private:
+        // Sampler uniform handles are resolved when a texture is added, so submitting
+        // a material does not touch the uniform table and is safe from encoder threads.
+        template <class T>
+        struct SamplerBinding
+        {
+            uint8_t registerId;
+            T* texture;
+            bgfx::UniformHandle uniform;
+            // Set when the texture came from the AssetManager, keeps it loaded.
+            AssetRef<T> reference;
+        };
+
         std::string m_Name;
         std::vector<std::shared_ptr<ShaderPass>> m_ShaderPasses;
-        std::map<std::string, std::pair<uint8_t,Texture*>> m_Textures;
-        std::map<std::string, std::pair<uint8_t,Cubemap*>> m_Cubemaps;
+        std::map<std::string, SamplerBinding<Texture>> m_Textures;
+        std::map<std::string, SamplerBinding<Cubemap>> m_Cubemaps;
 
     public:
         void addShaderPass(std::shared_ptr<ShaderPass> shaderPass);
@@ -29,8 +45,11 @@ namespace annileen
         std::string& getName() { return m_Name; }
         void addTexture(const char* name, Texture* texture, uint8_t registerId);
         void addCubemap(const char* name, Cubemap* cubemap, uint8_t registerId);
+        // The material holds the reference, so the asset stays loaded while it is used.
+        void addTexture(const char* name, AssetRef<Texture> texture, uint8_t registerId);
+        void addCubemap(const char* name, AssetRef<Cubemap> cubemap, uint8_t registerId);
 
-        void submitUniforms();
+        void submitUniforms(bgfx::Encoder* encoder = nullptr);
 
         Material();
         ~Material();
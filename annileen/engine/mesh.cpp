@@ -2,13 +2,36 @@
 
 namespace annileen
 {
-	void Mesh::init(const bgfx::Memory* vertexData, bgfx::VertexLayout vertexLayout, const bgfx::Memory* indexData)
+	void Mesh::init(const bgfx::Memory* vertexData, bgfx::VertexLayout vertexLayout, const bgfx::Memory* indexData, bool index32)
+	{
+		const uint32_t vertexCount = vertexLayout.getStride() > 0 ? vertexData->size / vertexLayout.getStride() : 0;
+
+		Aabb bounds = Aabb::empty();
+		if (vertexLayout.has(bgfx::Attrib::Position))
+		{
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				float position[4];
+				bgfx::vertexUnpack(position, bgfx::Attrib::Position, vertexLayout, vertexData->data, i);
+				bounds.expand(glm::vec3(position[0], position[1], position[2]));
+			}
+		}
+
+		init(vertexData, vertexLayout, indexData, index32, bounds);
+	}
+
+	void Mesh::init(const bgfx::Memory* vertexData, bgfx::VertexLayout vertexLayout, const bgfx::Memory* indexData,
+		bool index32, const Aabb& bounds)
 	{
 		m_HasIndices = (indexData != nullptr);
+		m_VertexCount = vertexLayout.getStride() > 0 ? vertexData->size / vertexLayout.getStride() : 0;
+		m_IndexCount = m_HasIndices ? indexData->size / (index32 ? sizeof(uint32_t) : sizeof(uint16_t)) : 0;
+		m_BufferSize = vertexData->size + (m_HasIndices ? indexData->size : 0);
+		m_Bounds = bounds;
 
 		m_VertexBufferHandle = bgfx::createVertexBuffer(vertexData, vertexLayout);
 		if (m_HasIndices)
-			m_IndexBufferHandle = bgfx::createIndexBuffer(indexData, BGFX_BUFFER_INDEX32);
+			m_IndexBufferHandle = bgfx::createIndexBuffer(indexData, index32 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
 
 		m_Loaded = true;
 	}
@@ -29,7 +52,7 @@ namespace annileen
 		}
 	}
 
-	Mesh::Mesh()
+	Mesh::Mesh() : m_HasIndices(false), m_VertexCount(0), m_IndexCount(0), m_BufferSize(0), m_Bounds(Aabb::empty())
 	{
 	}
 
@@ -38,6 +61,26 @@ namespace annileen
 		unload();
 	}
 
+	Aabb MeshGroup::getBounds() const
+	{
+		Aabb bounds = Aabb::empty();
+		for (const Mesh* mesh : m_Meshes)
+		{
+			bounds = bounds.merged(mesh->getBounds());
+		}
+		return bounds;
+	}
+
+	size_t MeshGroup::getMemorySize() const
+	{
+		size_t size = 0;
+		for (const Mesh* mesh : m_Meshes)
+		{
+			size += mesh->getBufferSize();
+		}
+		return size;
+	}
+
 	MeshGroup::~MeshGroup()
 	{
 		for (auto& m : m_Meshes)
@@ -10,6 +10,7 @@
 #include <gtc/matrix_transform.hpp>
 
 #include "asset.h"
+#include "scene/bvh.h"
 
 namespace annileen
 {
@@ -23,12 +24,28 @@ namespace annileen
         bgfx::VertexLayout m_VertexLayout;
 
         bool m_HasIndices;
+        uint32_t m_VertexCount;
+        uint32_t m_IndexCount;
+        // Bytes of the vertex and index buffers.
+        size_t m_BufferSize;
+        // Local space bounds of the vertex positions, invalid if the layout has none.
+        Aabb m_Bounds;
 
     public:
-        void init(const bgfx::Memory* vertexData, bgfx::VertexLayout vertexLayout, const bgfx::Memory* indexData);
+        void init(const bgfx::Memory* vertexData, bgfx::VertexLayout vertexLayout, const bgfx::Memory* indexData, bool index32 = true);
         void init(const bgfx::Memory* vertexData, bgfx::VertexLayout vertexLayout);
+        // For data whose bounds are known ahead, as cooked meshes are, so the vertices aren't
+        // read on the CPU. Indices are 32 bit unless index32 is false.
+        void init(const bgfx::Memory* vertexData, bgfx::VertexLayout vertexLayout, const bgfx::Memory* indexData,
+            bool index32, const Aabb& bounds);
 
         bool hasIndices() { return m_HasIndices; }
+        uint32_t getVertexCount() const { return m_VertexCount; }
+        uint32_t getIndexCount() const { return m_IndexCount; }
+        // Meshes are triangle lists.
+        uint32_t getPrimitiveCount() const { return (m_HasIndices ? m_IndexCount : m_VertexCount) / 3; }
+        const Aabb& getBounds() const { return m_Bounds; }
+        size_t getBufferSize() const { return m_BufferSize; }
 
         bgfx::VertexBufferHandle getVertexBuffer() { return m_VertexBufferHandle; }
         bgfx::IndexBufferHandle getIndexBuffer() { return m_IndexBufferHandle; }
@@ -43,6 +60,14 @@ namespace annileen
     {
     public:
         std::vector<Mesh*> m_Meshes;
+        // Bumped when m_Meshes changes after the group was handed out, as asynchronous loads do.
+        uint32_t m_Revision = 0;
+
+        // Union of the mesh bounds.
+        Aabb getBounds() const;
+
+        size_t getMemorySize() const override;
+
         ~MeshGroup();
     };
 }
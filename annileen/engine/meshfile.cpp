@@ -0,0 +1,79 @@
+#include <engine/meshfile.h>
+
+#include <cstring>
+
+namespace annileen
+{
+	static const char s_Magic[4] = { 'A', 'M', 'S', 'H' };
+
+	MeshFile::MeshFile() : m_Header(nullptr), m_Submeshes(nullptr), m_Vertices(nullptr), m_Indices(nullptr)
+	{
+	}
+
+	bool MeshFile::parse(const uint8_t* data, size_t size, std::string& error)
+	{
+		const Header* header = reinterpret_cast<const Header*>(data);
+
+		if (size < sizeof(Header) || std::memcmp(header->magic, s_Magic, sizeof(s_Magic)) != 0)
+		{
+			error = "Not a cooked mesh.";
+			return false;
+		}
+
+		if (header->version != currentVersion)
+		{
+			error = "Cooked mesh is version " + std::to_string(header->version) + ", expected " +
+				std::to_string(currentVersion) + ". Rebuild the assets.";
+			return false;
+		}
+
+		uint32_t stride = 3 * sizeof(float);
+		if (header->attributes & TexCoord0) stride += 2 * sizeof(float);
+		if (header->attributes & Normal) stride += 3 * sizeof(float);
+
+		const uint64_t submeshesEnd = sizeof(Header) + static_cast<uint64_t>(header->submeshCount) * sizeof(Submesh);
+		const uint64_t verticesEnd = header->vertexOffset + static_cast<uint64_t>(header->vertexCount) * stride;
+		const uint64_t indicesEnd = header->indexOffset + static_cast<uint64_t>(header->indexCount) * header->indexSize;
+
+		bool valid = header->vertexStride == stride && (header->indexSize == 2 || header->indexSize == 4) &&
+			submeshesEnd <= header->vertexOffset && verticesEnd <= header->indexOffset && indicesEnd <= size;
+
+		// Indices aren't checked against the vertex counts, that would be the per index pass
+		// cooking is there to avoid. bgfx skips out of range vertices in debug builds.
+		const Submesh* submeshes = reinterpret_cast<const Submesh*>(data + sizeof(Header));
+		for (uint32_t i = 0; valid && i < header->submeshCount; ++i)
+		{
+			const Submesh& submesh = submeshes[i];
+			valid = static_cast<uint64_t>(submesh.firstVertex) + submesh.vertexCount <= header->vertexCount &&
+				static_cast<uint64_t>(submesh.firstIndex) + submesh.indexCount <= header->indexCount &&
+				submesh.indexCount % 3 == 0 &&
+				(header->indexSize == 4 || submesh.vertexCount <= 65536);
+		}
+
+		if (!valid)
+		{
+			error = "Cooked mesh is damaged.";
+			return false;
+		}
+
+		m_Header = header;
+		m_Submeshes = submeshes;
+		m_Vertices = data + header->vertexOffset;
+		m_Indices = data + header->indexOffset;
+		return true;
+	}
+
+	bgfx::VertexLayout MeshFile::getLayout() const
+	{
+		// Same order as RawMesh builds for imported meshes.
+		bgfx::VertexLayout layout;
+		layout.begin()
+			.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float);
+
+		if (m_Header->attributes & TexCoord0) layout.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float);
+		if (m_Header->attributes & Normal) layout.add(bgfx::Attrib::Normal, 3, bgfx::AttribType::Float);
+
+		layout.end();
+		return layout;
+	}
+}
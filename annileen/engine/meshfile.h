@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <bgfx/bgfx.h>
+
+namespace annileen
+{
+	// Mesh cooked offline by tools/mesh.py (.amesh), ready to hand to bgfx as it is.
+	// Little endian, laid out as:
+	//   Header
+	//   Submesh[submeshCount]
+	//   the vertices of every submesh, interleaved: position, then the texture coordinates and
+	//   the normal if the attributes say so, all floats
+	//   the indices of every submesh, relative to the submesh's first vertex
+	// Vertices and indices start at multiples of 16 bytes.
+	class MeshFile final
+	{
+	public:
+		enum Attributes : uint32_t
+		{
+			TexCoord0 = 0x01,
+			Normal = 0x02
+		};
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t attributes;
+			uint32_t vertexStride;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			// 2 or 4 bytes.
+			uint32_t indexSize;
+			uint32_t submeshCount;
+			float boundsMin[3];
+			float boundsMax[3];
+			uint32_t vertexOffset;
+			uint32_t indexOffset;
+		};
+
+		// One Mesh of the MeshGroup.
+		struct Submesh
+		{
+			uint32_t firstVertex;
+			uint32_t vertexCount;
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			float boundsMin[3];
+			float boundsMax[3];
+		};
+
+		static_assert(sizeof(Header) == 64 && sizeof(Submesh) == 40, "The mesh layout is shared with tools/mesh.py.");
+
+		static constexpr uint32_t currentVersion = 1;
+
+		// Checks the sizes and ranges in the file and points into it, nothing is copied.
+		// Returns false with the reason in error.
+		bool parse(const uint8_t* data, size_t size, std::string& error);
+
+		const Header& getHeader() const { return *m_Header; }
+		const Submesh& getSubmesh(uint32_t index) const { return m_Submeshes[index]; }
+		bgfx::VertexLayout getLayout() const;
+
+		const uint8_t* getVertices(const Submesh& submesh) const { return m_Vertices + static_cast<size_t>(submesh.firstVertex) * m_Header->vertexStride; }
+		size_t getVertexBytes(const Submesh& submesh) const { return static_cast<size_t>(submesh.vertexCount) * m_Header->vertexStride; }
+		const uint8_t* getIndices(const Submesh& submesh) const { return m_Indices + static_cast<size_t>(submesh.firstIndex) * m_Header->indexSize; }
+		size_t getIndexBytes(const Submesh& submesh) const { return static_cast<size_t>(submesh.indexCount) * m_Header->indexSize; }
+
+		MeshFile();
+
+	private:
+		const Header* m_Header;
+		const Submesh* m_Submeshes;
+		const uint8_t* m_Vertices;
+		const uint8_t* m_Indices;
+	};
+}
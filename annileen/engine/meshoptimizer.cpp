@@ -0,0 +1,198 @@
+#include <engine/meshoptimizer.h>
+
+#include <cstring>
+
+namespace annileen
+{
+	float MeshOptimizer::getAcmr(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		if (indices.size() < 3) return 0.0f;
+
+		// Time each vertex entered the cache, a vertex is in it while fewer than cacheSize
+		// others entered after it.
+		std::vector<uint32_t> entered(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		uint32_t misses = 0;
+
+		for (uint32_t index : indices)
+		{
+			if (time - entered[index] > cacheSize)
+			{
+				entered[index] = time++;
+				misses++;
+			}
+		}
+
+		return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	}
+
+	uint32_t MeshOptimizer::weldVertices(std::vector<float>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+	{
+		const uint32_t vertexCount = stride > 0 ? static_cast<uint32_t>(vertices.size() / stride) : 0;
+		const size_t vertexBytes = stride * sizeof(float);
+
+		// Open addressing over the vertex bytes, at most half full.
+		size_t tableSize = 1;
+		while (tableSize < static_cast<size_t>(vertexCount) * 2) tableSize *= 2;
+		std::vector<uint32_t> table(tableSize, UINT32_MAX);
+
+		std::vector<uint32_t> remap(vertexCount);
+		uint32_t welded = 0;
+
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&vertices[static_cast<size_t>(v) * stride]);
+
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t b = 0; b < vertexBytes; ++b)
+			{
+				hash ^= bytes[b];
+				hash *= 1099511628211ull;
+			}
+
+			size_t slot = hash & (tableSize - 1);
+			while (table[slot] != UINT32_MAX &&
+				std::memcmp(&vertices[static_cast<size_t>(table[slot]) * stride], bytes, vertexBytes) != 0)
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if (table[slot] == UINT32_MAX)
+			{
+				// Kept vertices move down in place, never past one still to be read.
+				std::memmove(&vertices[static_cast<size_t>(welded) * stride], bytes, vertexBytes);
+				table[slot] = welded++;
+			}
+
+			remap[v] = table[slot];
+		}
+
+		vertices.resize(static_cast<size_t>(welded) * stride);
+		for (uint32_t& index : indices)
+		{
+			index = remap[index];
+		}
+
+		return welded;
+	}
+
+	void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0) return;
+
+		// Triangles around each vertex, as offsets into one array.
+		std::vector<uint32_t> live(vertexCount, 0);
+		for (uint32_t index : indices) live[index]++;
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t v = 0; v < vertexCount; ++v) adjacencyOffsets[v + 1] = adjacencyOffsets[v] + live[v];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> filled(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t i = 0; i < indices.size(); ++i)
+		{
+			adjacency[filled[indices[i]]++] = i / 3;
+		}
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		uint32_t time = cacheSize + 1;
+		uint32_t cursor = 0;
+		int64_t fanning = 0;
+
+		while (fanning >= 0)
+		{
+			// Emit every triangle left around the fanning vertex.
+			candidates.clear();
+			for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a)
+			{
+				const uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) continue;
+
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t v = indices[triangle * 3 + corner];
+					output.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+
+					if (time - cacheTime[v] > cacheSize)
+					{
+						cacheTime[v] = time++;
+					}
+				}
+
+				emitted[triangle] = true;
+			}
+
+			// Next, the candidate with triangles left that stays in the cache longest once they
+			// are emitted too.
+			fanning = -1;
+			int64_t best = -1;
+			for (uint32_t v : candidates)
+			{
+				if (live[v] == 0) continue;
+
+				int64_t priority = 0;
+				if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+				{
+					priority = time - cacheTime[v];
+				}
+
+				if (priority > best)
+				{
+					best = priority;
+					fanning = v;
+				}
+			}
+
+			// Dead end: the most recent vertex with triangles left, else the next in order.
+			while (fanning < 0 && !deadEnds.empty())
+			{
+				const uint32_t v = deadEnds.back();
+				deadEnds.pop_back();
+				if (live[v] > 0) fanning = v;
+			}
+
+			while (fanning < 0 && cursor < vertexCount)
+			{
+				if (live[cursor] > 0) fanning = cursor;
+				cursor++;
+			}
+		}
+
+		indices.swap(output);
+	}
+
+	uint32_t MeshOptimizer::optimizeVertexFetch(std::vector<float>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+	{
+		const uint32_t vertexCount = stride > 0 ? static_cast<uint32_t>(vertices.size() / stride) : 0;
+
+		std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+		std::vector<float> reordered;
+		reordered.reserve(vertices.size());
+		uint32_t used = 0;
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = used++;
+				const float* vertex = &vertices[static_cast<size_t>(index) * stride];
+				reordered.insert(reordered.end(), vertex, vertex + stride);
+			}
+
+			index = remap[index];
+		}
+
+		vertices.swap(reordered);
+		return used;
+	}
+}
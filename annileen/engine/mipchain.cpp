@@ -0,0 +1,79 @@
+#include <engine/mipchain.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace annileen
+{
+	uint8_t MipChain::getLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t size = std::max(width, height);
+		uint8_t levels = 1;
+		while (size > 1)
+		{
+			size /= 2;
+			levels++;
+		}
+		return levels;
+	}
+
+	size_t MipChain::getChainSize(uint32_t width, uint32_t height)
+	{
+		size_t size = 0;
+		for (uint8_t level = 0; level < getLevelCount(width, height); ++level)
+		{
+			size += static_cast<size_t>(std::max(width >> level, 1u)) * std::max(height >> level, 1u) * 4;
+		}
+		return size;
+	}
+
+	void MipChain::generate(const uint8_t* rgba8, uint32_t width, uint32_t height, uint8_t* chain)
+	{
+		std::memcpy(chain, rgba8, static_cast<size_t>(width) * height * 4);
+
+		uint8_t* source = chain;
+		uint32_t sourceWidth = width;
+		uint32_t sourceHeight = height;
+
+		for (uint8_t level = 1; level < getLevelCount(width, height); ++level)
+		{
+			uint8_t* destination = source + static_cast<size_t>(sourceWidth) * sourceHeight * 4;
+			const uint32_t levelWidth = std::max(sourceWidth / 2, 1u);
+			const uint32_t levelHeight = std::max(sourceHeight / 2, 1u);
+
+			for (uint32_t y = 0; y < levelHeight; ++y)
+			{
+				// The source rows and columns this pixel covers, three of them along an odd edge.
+				const uint32_t y0 = std::min(y * 2, sourceHeight - 1);
+				const uint32_t y1 = (y == levelHeight - 1) ? sourceHeight : y0 + 2;
+
+				for (uint32_t x = 0; x < levelWidth; ++x)
+				{
+					const uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+					const uint32_t x1 = (x == levelWidth - 1) ? sourceWidth : x0 + 2;
+
+					uint32_t sum[4] = { 0, 0, 0, 0 };
+					for (uint32_t sy = y0; sy < y1; ++sy)
+					{
+						for (uint32_t sx = x0; sx < x1; ++sx)
+						{
+							const uint8_t* pixel = source + (static_cast<size_t>(sy) * sourceWidth + sx) * 4;
+							for (uint32_t c = 0; c < 4; ++c) sum[c] += pixel[c];
+						}
+					}
+
+					const uint32_t count = (y1 - y0) * (x1 - x0);
+					uint8_t* pixel = destination + (static_cast<size_t>(y) * levelWidth + x) * 4;
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						pixel[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+					}
+				}
+			}
+
+			source = destination;
+			sourceWidth = levelWidth;
+			sourceHeight = levelHeight;
+		}
+	}
+}
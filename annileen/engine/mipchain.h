@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace annileen
+{
+	// Mip chains for RGBA8 images that come without one, built on the CPU at load time.
+	// Levels are laid out one after the other, the way bgfx takes them: the image, then each
+	// level half the size of the one before, rounded down and at least 1 pixel.
+	class MipChain final
+	{
+	public:
+		static uint8_t getLevelCount(uint32_t width, uint32_t height);
+		// Bytes of all the levels together.
+		static size_t getChainSize(uint32_t width, uint32_t height);
+
+		// Copies the image into chain and fills in the other levels, each pixel the rounded
+		// average of the 2x2 pixels under it in the level before. Odd rows and columns fold
+		// into the last pixel. Channels are averaged as they are stored, there's no colour
+		// space to go by.
+		static void generate(const uint8_t* rgba8, uint32_t width, uint32_t height, uint8_t* chain);
+	};
+}
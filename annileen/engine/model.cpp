@@ -4,17 +4,42 @@ namespace annileen
 {
 	void Model::init(MeshGroup* meshGroup, std::shared_ptr<Material> material)
 	{
-		m_MeshGroup = meshGroup;
+		setMeshGroup(meshGroup);
+		m_Material = material;
+	}
+
+	void Model::init(AssetRef<MeshGroup> meshGroup, std::shared_ptr<Material> material)
+	{
+		setMeshGroup(std::move(meshGroup));
 		m_Material = material;
 	}
 
+	void Model::setMeshGroup(MeshGroup* meshGroup)
+	{
+		m_MeshGroup = meshGroup;
+		m_MeshReference.reset();
+	}
+
+	void Model::setMeshGroup(AssetRef<MeshGroup> meshGroup)
+	{
+		m_MeshGroup = meshGroup.get();
+		m_MeshReference = std::move(meshGroup);
+	}
+
 	std::shared_ptr<Material> Model::getMaterial()
 	{
 		return m_Material;
 	}
 
-	Model::Model() : SceneNodeModule(), m_MeshGroup(nullptr), m_Material(nullptr), castShadows(true),
-		receiveShadows(true), isStatic(false), enabled(true)
+	const glm::mat4& Model::getRenderMatrix()
+	{
+		return interpolate && m_HasPreviousWorld ? m_RenderMatrix : getTransform().getWorldMatrix();
+	}
+
+	Model::Model() : SceneNodeModule(), m_MeshGroup(nullptr), m_Material(nullptr), m_WorldBounds(Aabb::empty()),
+		m_BvhProxy(Bvh::nullNode), m_BvhStatic(false), m_BvhWorldVersion(0), m_BvhMeshGroup(nullptr), m_BvhMeshRevision(0),
+		m_PreviousWorldMatrix(1.0f), m_RenderMatrix(1.0f), m_HasPreviousWorld(false),
+		castShadows(true), receiveShadows(true), isStatic(false), enabled(true), interpolate(false)
 	{
 	}
 
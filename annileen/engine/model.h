@@ -5,6 +5,7 @@
 
 #include "scenenodemodule.h"
 #include "mesh.h"
+#include "assetref.h"
 
 namespace annileen
 {
@@ -16,8 +17,24 @@ namespace annileen
 	{
 	private:
 		MeshGroup* m_MeshGroup = nullptr;
+		// Set when the mesh came from the AssetManager, keeps it loaded.
+		AssetRef<MeshGroup> m_MeshReference;
 		std::shared_ptr<Material> m_Material = nullptr;
 
+		// Spatial index bookkeeping, owned by the Scene.
+		Aabb m_WorldBounds;
+		int32_t m_BvhProxy;
+		bool m_BvhStatic;
+		uint32_t m_BvhWorldVersion;
+		MeshGroup* m_BvhMeshGroup;
+		uint32_t m_BvhMeshRevision;
+
+		// World matrix before the last simulation step, and the one drawn this frame.
+		glm::mat4 m_PreviousWorldMatrix;
+		glm::mat4 m_RenderMatrix;
+		bool m_HasPreviousWorld;
+		friend class Scene;
+
 	public:
 		bool castShadows;
 		bool receiveShadows;
@@ -25,12 +42,25 @@ namespace annileen
 		// Should this be moved to a parent component class? Will model be a "component"?
 		bool isStatic;
 		bool enabled;
+		// Draws the model between its last two simulation steps rather than where the last
+		// step left it, so it moves smoothly whatever the frame rate. Only for models moved
+		// in fixedUpdate(), a model moved every frame would be drawn lagging behind.
+		bool interpolate;
 
 		void init(MeshGroup* meshGroup, std::shared_ptr<Material> material);
+		// The model holds the reference, so the mesh stays loaded while it is drawn.
+		void init(AssetRef<MeshGroup> meshGroup, std::shared_ptr<Material> material);
 
-		void setMeshGroup(MeshGroup* meshGroup) { m_MeshGroup = meshGroup; }
+		void setMeshGroup(MeshGroup* meshGroup);
+		void setMeshGroup(AssetRef<MeshGroup> meshGroup);
 		MeshGroup* getMeshGroup() const { return m_MeshGroup; }
 		std::shared_ptr<Material> getMaterial();
+		// World space bounds as of the last Scene::updateTransforms(), invalid without a mesh.
+		const Aabb& getWorldBounds() const { return m_WorldBounds; }
+		// World matrix the model is drawn with this frame, interpolated if asked to.
+		const glm::mat4& getRenderMatrix();
+		// Skips the interpolation until the next simulation step, after teleporting the model.
+		void resetInterpolation() { m_HasPreviousWorld = false; }
 
 		Model();
 		~Model();
@@ -13,45 +13,81 @@ namespace annileen
 
 	MeshGroup* ModelLoader::loadMesh(const std::string& filename, const MeshDescriptor& descriptor)
 	{
+		std::vector<MeshData> meshes;
+		std::string error;
+		if (!loadMeshData(filename, descriptor, meshes, error))
+		{
+			ANNILEEN_LOG_ERROR(LoggingChannel::Asset, error);
+			exit(-1);
+		}
+
 		MeshGroup* meshGroup = new MeshGroup();
+		for (const MeshData& meshData : meshes)
+		{
+			Mesh* mesh = new Mesh();
+			meshData.createMesh(mesh);
+			meshGroup->m_Meshes.push_back(mesh);
+		}
 
-		Assimp::Importer importer;
-		
+		return meshGroup;
+	}
+
+	uint32_t ModelLoader::getImportFlags(const MeshDescriptor& descriptor) const
+	{
 		uint32_t flags = aiProcess_Triangulate
 			| aiProcess_FlipUVs;
 
 		if (descriptor.m_Normals == MeshDescriptor::Normals::GenerateSmooth) flags |= aiProcess_GenSmoothNormals;
 
-		const aiScene* scene = importer.ReadFile(filename, flags);
+		return flags;
+	}
 
+	bool ModelLoader::convertScene(const aiScene* scene, const std::string& name, const MeshDescriptor& descriptor, std::vector<MeshData>& meshes, std::string& error)
+	{
 		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 		{
-			ANNILEEN_LOG_ERROR(LoggingChannel::Asset, "There's a problem with the mesh.");
-			exit(-1);
+			error = "There's a problem with the mesh '" + name + "'.";
+			return false;
 		}
 
-		processNode(scene->mRootNode, scene, meshGroup, descriptor);
+		processNode(scene->mRootNode, scene, meshes, descriptor);
 
-		return meshGroup;
+		return true;
+	}
+
+	bool ModelLoader::loadMeshData(const std::string& filename, const MeshDescriptor& descriptor, std::vector<MeshData>& meshes, std::string& error)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(filename, getImportFlags(descriptor));
+
+		return convertScene(scene, filename, descriptor, meshes, error);
 	}
 
-	void ModelLoader::processNode(aiNode* node, const aiScene* scene, MeshGroup* meshGroup, const MeshDescriptor& descriptor)
+	bool ModelLoader::loadMeshData(const uint8_t* data, size_t size, const std::string& extension, const std::string& name,
+		const MeshDescriptor& descriptor, std::vector<MeshData>& meshes, std::string& error)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFileFromMemory(data, size, getImportFlags(descriptor), extension.c_str());
+
+		return convertScene(scene, name, descriptor, meshes, error);
+	}
+
+	void ModelLoader::processNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshes, const MeshDescriptor& descriptor)
 	{
  		for (uint16_t i = 0; i < node->mNumMeshes; i++)
 		{
 			aiMesh* aiMesh = scene->mMeshes[node->mMeshes[i]];
-			Mesh* mesh = new Mesh();
-			convertMesh(mesh, aiMesh, scene, descriptor);
-			meshGroup->m_Meshes.push_back(mesh);
+			meshes.emplace_back();
+			convertMesh(meshes.back(), aiMesh, scene, descriptor);
 		}
 
 		for (uint16_t i = 0; i < node->mNumChildren; i++)
 		{
-			processNode(node->mChildren[i], scene, meshGroup, descriptor);
+			processNode(node->mChildren[i], scene, meshes, descriptor);
 		}
 	}
 
-	void ModelLoader::convertMesh(Mesh* mesh, aiMesh* aiMesh, const aiScene* scene, const MeshDescriptor& descriptor)
+	void ModelLoader::convertMesh(MeshData& meshData, aiMesh* aiMesh, const aiScene* scene, const MeshDescriptor& descriptor)
 	{
 		RawMesh rawMesh;
 
@@ -96,6 +132,7 @@ namespace annileen
 				rawMesh.m_Indices.push_back(face.mIndices[j]);
 		}
 
-		rawMesh.getMesh(mesh, descriptor);
+		rawMesh.getMeshData(meshData, descriptor);
+		if (m_Optimize) meshData.optimize();
 	}
 }
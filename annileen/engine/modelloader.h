@@ -12,12 +12,25 @@ namespace annileen
     class ModelLoader
     {
     private:
-        void processNode(aiNode* node, const aiScene* scene, MeshGroup* meshGroup, const MeshDescriptor& descriptor);
-        void convertMesh(Mesh* mesh, aiMesh* aiMesh, const aiScene* scene, const MeshDescriptor& descriptor);
+        bool m_Optimize = true;
+
+        void processNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshes, const MeshDescriptor& descriptor);
+        void convertMesh(MeshData& meshData, aiMesh* aiMesh, const aiScene* scene, const MeshDescriptor& descriptor);
+        bool convertScene(const aiScene* scene, const std::string& name, const MeshDescriptor& descriptor, std::vector<MeshData>& meshes, std::string& error);
+        uint32_t getImportFlags(const MeshDescriptor& descriptor) const;
     public:
         ModelLoader();
         ~ModelLoader();
 
+        // On by default, off keeps Assimp's vertex and triangle order.
+        void setOptimize(bool optimize) { m_Optimize = optimize; }
+
         MeshGroup* loadMesh(const std::string& filename, const MeshDescriptor& descriptor);
+        // Reads and converts the meshes without creating any bgfx resource, safe on any thread.
+        // Returns false with the reason in error if the file can't be imported.
+        bool loadMeshData(const std::string& filename, const MeshDescriptor& descriptor, std::vector<MeshData>& meshes, std::string& error);
+        // Same, from a file already in memory. extension ("obj", "gltf"...) tells Assimp its format.
+        bool loadMeshData(const uint8_t* data, size_t size, const std::string& extension, const std::string& name,
+            const MeshDescriptor& descriptor, std::vector<MeshData>& meshes, std::string& error);
     };
 }
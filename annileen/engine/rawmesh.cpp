@@ -1,5 +1,6 @@
 #include "engine.h"
 #include "rawmesh.h"
+#include "meshoptimizer.h"
 
 namespace annileen
 {
@@ -23,25 +24,57 @@ namespace annileen
 		}
 	}
 
-	void RawMesh::getMesh(Mesh* mesh, const MeshDescriptor& descriptor)
+	void MeshData::optimize()
+	{
+		const uint32_t stride = m_Layout.getStride() / sizeof(float);
+		if (m_Indices.empty() || stride == 0) return;
+
+		const uint32_t vertexCount = MeshOptimizer::weldVertices(m_Vertices, stride, m_Indices);
+		MeshOptimizer::optimizeVertexCache(m_Indices, vertexCount);
+		MeshOptimizer::optimizeVertexFetch(m_Vertices, stride, m_Indices);
+	}
+
+	void MeshData::createMesh(Mesh* mesh) const
+	{
+		const bool index32 = getVertexCount() > 65536;
+
+		const bgfx::Memory* indexData = nullptr;
+		if (!m_Indices.empty() && index32)
+		{
+			indexData = bgfx::copy(m_Indices.data(), static_cast<uint32_t>(m_Indices.size() * sizeof(uint32_t)));
+		}
+		else if (!m_Indices.empty())
+		{
+			indexData = bgfx::alloc(static_cast<uint32_t>(m_Indices.size() * sizeof(uint16_t)));
+			uint16_t* indices = reinterpret_cast<uint16_t*>(indexData->data);
+			for (size_t i = 0; i < m_Indices.size(); ++i)
+			{
+				indices[i] = static_cast<uint16_t>(m_Indices[i]);
+			}
+		}
+
+		mesh->init(bgfx::copy(m_Vertices.data(), static_cast<uint32_t>(m_Vertices.size() * sizeof(float))), m_Layout, indexData, index32);
+	}
+
+	void RawMesh::getMeshData(MeshData& meshData, const MeshDescriptor& descriptor)
 	{
 		if (descriptor.m_Normals == MeshDescriptor::Normals::Generate)
 			generateNormals();
 
-		bool vertexColor = false;
 		bool vertexNormal = m_Vertices[0].m_HasNormal;
 		bool vertexUV = m_Vertices[0].m_HasUV;
 
-		bgfx::VertexLayout vlayout;
-		vlayout.begin()
+		meshData.m_Layout.begin()
 			.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float);
 
-		if (vertexUV) vlayout.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float);
-		if (vertexNormal) vlayout.add(bgfx::Attrib::Normal, 3, bgfx::AttribType::Float);
+		if (vertexUV) meshData.m_Layout.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float);
+		if (vertexNormal) meshData.m_Layout.add(bgfx::Attrib::Normal, 3, bgfx::AttribType::Float);
 
-		vlayout.end();
+		meshData.m_Layout.end();
 
-		std::vector<float> vertexData;
+		std::vector<float>& vertexData = meshData.m_Vertices;
+		vertexData.clear();
+		vertexData.reserve(m_Vertices.size() * meshData.m_Layout.getStride() / sizeof(float));
 
 		for (const auto& v : m_Vertices)
 		{
@@ -64,15 +97,13 @@ namespace annileen
 
 		}
 
-		float* meshData = new float[vertexData.size()];
-		memcpy(meshData, vertexData.data(), vertexData.size() * sizeof(float));
-
-		uint32_t* indexData = new uint32_t[m_Indices.size()];
-		memcpy(indexData, m_Indices.data(), m_Indices.size() * sizeof(uint32_t));
+		meshData.m_Indices = m_Indices;
+	}
 
-		mesh->init(
-			bgfx::makeRef(meshData, vertexData.size() * sizeof(float), Engine::releaseMem), 
-			vlayout,
-			bgfx::makeRef(indexData, m_Indices.size() * sizeof(uint32_t), Engine::releaseMem));
+	void RawMesh::getMesh(Mesh* mesh, const MeshDescriptor& descriptor)
+	{
+		MeshData meshData;
+		getMeshData(meshData, descriptor);
+		meshData.createMesh(mesh);
  	}
 }
@@ -19,6 +19,22 @@ namespace annileen
 		bool m_HasUV;
 	};
 
+	// Vertices and indices of a mesh in their GPU layout. Building them needs no bgfx
+	// resources, so it can happen on any thread; createMesh() does the upload.
+	struct MeshData
+	{
+		bgfx::VertexLayout m_Layout;
+		std::vector<float> m_Vertices;
+		std::vector<uint32_t> m_Indices;
+
+		// Welds duplicate vertices and reorders triangles and vertices for the GPU caches,
+		// see MeshOptimizer.
+		void optimize();
+		uint32_t getVertexCount() const { return m_Layout.getStride() > 0 ? static_cast<uint32_t>(m_Vertices.size() * sizeof(float) / m_Layout.getStride()) : 0; }
+		// Uploads 16 bit indices when every vertex can be reached with them.
+		void createMesh(Mesh* mesh) const;
+	};
+
 	class RawMesh
 	{
 	private:
@@ -28,6 +44,7 @@ namespace annileen
 		std::vector<RawVertex> m_Vertices;
 		std::vector<uint32_t> m_Indices;
 
+		void getMeshData(MeshData& meshData, const MeshDescriptor& descriptor);
 		void getMesh(Mesh* mesh, const MeshDescriptor& descriptor);
 	};
 }
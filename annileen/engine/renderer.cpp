@@ -6,11 +6,36 @@
 #include <engine/model.h>
 #include <engine/mesh.h>
 #include <engine/text/text.h>
+#include <engine/core/profiler.h>
 #include <bx/math.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
 namespace annileen
 {
-    Renderer::Renderer() : useShadows(false), m_Engine(nullptr), m_Capabilities(nullptr), m_Shadow(nullptr)
+    // Below this many draws a view is encoded on the calling thread, waking the
+    // workers costs more than it saves.
+    static constexpr size_t s_MinItemsPerSubmitTask = 256;
+
+    static uint64_t mixHash(uint64_t hash, uint64_t value)
+    {
+        hash ^= value + UINT64_C(0x9e3779b97f4a7c15) + (hash << 6) + (hash >> 2);
+        hash ^= hash >> 33;
+        hash *= UINT64_C(0xff51afd7ed558ccd);
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    Renderer::Renderer() : useShadows(false), m_Engine(nullptr), m_Capabilities(nullptr), m_Shadow(nullptr), m_ShadowStats(), m_Timings(),
+        m_LightMatrixUniform(BGFX_INVALID_HANDLE), m_ShadowMapUniform(BGFX_INVALID_HANDLE), m_BindShadowMap(false), m_MaxSubmitTasks(1),
+        m_ActiveCamera(nullptr), m_Scene(nullptr)
     {
     }
 
@@ -30,7 +55,7 @@ namespace annileen
         // compare less equal feature is supported.
         m_Shadow->useShadowSampler = 0 != (m_Capabilities->supported & BGFX_CAPS_TEXTURE_COMPARE_LEQUAL);;
 
-        Shader* shader = ServiceProvider::getAssetManager()->loadShader("vs_sms_shadow.vs", "fs_sms_shadow.fs");
+        Shader* shader = ServiceProvider::getAssetManager()->getShaderPermutation("shadowmap", ShaderFeatures::None);
         std::shared_ptr<ShaderPass> shaderPass = std::make_shared<ShaderPass>();
 
         shaderPass->init(shader);
@@ -45,6 +70,12 @@ namespace annileen
         m_Shadow->material->setName("ShadowMaterial");
         m_Shadow->material->addShaderPass(shaderPass);
 
+        // The static layer is composited into the shadow map with a blit, so both
+        // textures need to support it.
+        m_Shadow->canCacheStaticLayer = 0 != (m_Capabilities->supported & BGFX_CAPS_TEXTURE_BLIT);
+        m_Shadow->staticLayerValid = false;
+        m_Shadow->staticCasterSignature = 0;
+
         bgfx::TextureHandle fbtextures[] =
         {
             bgfx::createTexture2D(
@@ -54,11 +85,31 @@ namespace annileen
                 , 1
                 , bgfx::TextureFormat::D16
                 , BGFX_TEXTURE_RT | BGFX_SAMPLER_COMPARE_LEQUAL
+                    | (m_Shadow->canCacheStaticLayer ? BGFX_TEXTURE_BLIT_DST : 0)
                 ),
         };
 
         m_Shadow->frameBuffer = bgfx::createFrameBuffer(BX_COUNTOF(fbtextures), fbtextures, true);
 
+        if (m_Shadow->canCacheStaticLayer)
+        {
+            m_Shadow->staticTexture = bgfx::createTexture2D(
+                  uint16_t(ServiceProvider::getSettings()->shadows.shadowMapSize)
+                , uint16_t(ServiceProvider::getSettings()->shadows.shadowMapSize)
+                , false
+                , 1
+                , bgfx::TextureFormat::D16
+                , BGFX_TEXTURE_RT
+                );
+
+            m_Shadow->staticFrameBuffer = bgfx::createFrameBuffer(1, &m_Shadow->staticTexture, true);
+        }
+        else
+        {
+            m_Shadow->staticTexture = BGFX_INVALID_HANDLE;
+            m_Shadow->staticFrameBuffer = BGFX_INVALID_HANDLE;
+        }
+
         bgfx::TextureInfo textureInfo;
         bgfx::calcTextureSize(
             textureInfo,
@@ -83,16 +134,36 @@ namespace annileen
         initializeShadows();
 
         // Initialize Reserved Render Views
+        RenderView::addReservedRenderView(RenderView::ShadowStatic, "Static Shadows");
         RenderView::addReservedRenderView(RenderView::Shadow, "Shadows");
         RenderView::addReservedRenderView(RenderView::Scene, "Scene");
         RenderView::addReservedRenderView(RenderView::Skybox, "Skybox");
         RenderView::addReservedRenderView(RenderView::UI, "UI");
         //RenderView::addReservedRenderView(RenderView::PostProcessing, "Post-processing");
         
+        m_ShadowStaticRenderView = RenderView::getRenderView(RenderView::ShadowStatic);
         m_ShadowRenderView = RenderView::getRenderView(RenderView::Shadow);
         m_SceneRenderView = RenderView::getRenderView(RenderView::Scene);
         m_SkyboxRenderView = RenderView::getRenderView(RenderView::Skybox);
         m_UIRenderView = RenderView::getRenderView(RenderView::UI);
+
+        m_LightMatrixUniform = m_Uniform.getMat4UniformHandle("u_lightMtx");
+        m_ShadowMapUniform = m_Uniform.getSamplerUniformHandle("s_shadowMap");
+
+        // bgfx only times each view with the profiler on, and m_Stats reads those times every frame.
+        bgfx::setDebug(BGFX_DEBUG_PROFILER);
+
+        const Settings::Rendering& renderingSettings = ServiceProvider::getSettings()->rendering;
+        setSubmitWorkers(renderingSettings.multithreaded ? renderingSettings.submitThreads : 0);
+    }
+
+    void Renderer::setSubmitWorkers(size_t workerCount)
+    {
+        // Every task needs its own encoder, and the API thread keeps one for itself.
+        workerCount = std::min<size_t>(workerCount, m_Capabilities->limits.maxEncoders > 2 ? m_Capabilities->limits.maxEncoders - 2 : 0);
+
+        m_MaxSubmitTasks = workerCount + 1;
+        ANNILEEN_LOGF_INFO(LoggingChannel::Renderer, "Submitting draw calls with {} worker thread(s).", workerCount);
     }
 
     void Renderer::setActiveCamera(Camera* camera)
@@ -103,27 +174,36 @@ namespace annileen
 
     void Renderer::setScene(Scene* scene)
     {
+        // Node ids and world versions of another scene can repeat the cached signature.
+        if (m_Scene != scene) invalidateShadowCache();
         m_Scene = scene;   
     }
 
     void Renderer::render()
     {
+        ANNILEEN_PROFILE_SCOPE("Renderer::render");
+
         if (m_ActiveCamera == nullptr || !m_ActiveCamera->enabled)
         {
             // TODO: show black screen with 'no camera' msg
             return;
         }
 
+        m_Timings = {};
+
         Light* mainLightForShadows = nullptr;
+
+        m_FrameUniforms.clear();
+        m_BindShadowMap = false;
         
         // Set light properties and get first light that generate shadows to be main light for shadows.
         for (const auto& light : m_Scene->getLightList())
         {
             if (light->type == LightType::Directional)
             {
-                m_Uniform.setVec3Uniform("u_lightDirection", light->getTransform().getForward());
-                m_Uniform.setVec3Uniform("u_lightColor", light->color);
-                m_Uniform.setFloatUniform("u_lightIntensity", light->intensity);
+                setFrameUniform("u_lightDirection", glm::vec4(light->getTransform().getForward(), 0.0f));
+                setFrameUniform("u_lightColor", glm::vec4(light->color, 0.0f));
+                setFrameUniform("u_lightIntensity", glm::vec4(light->intensity, 0.0f, 0.0f, 0.0f));
             }
 
             if (light->generateShadows && mainLightForShadows == nullptr)
@@ -133,7 +213,6 @@ namespace annileen
         }
 
         glm::mat4 mtxShadow;
-        glm::mat4 lightMtx;
 
         if (ServiceProvider::getSettings()->shadows.enabled && mainLightForShadows != nullptr && mainLightForShadows->generateShadows)
         {
@@ -141,8 +220,17 @@ namespace annileen
             
             if (mainLightForShadows->type == LightType::Directional)
             {
+                // Snap the shadow volume to a grid so it only moves (and invalidates the
+                // static layer) when the camera crosses a cell boundary.
+                glm::vec3 center = m_ActiveCamera->getTransform().position();
+                const float snap = ServiceProvider::getSettings()->shadows.cacheSnapDistance;
+                if (snap > 0.0f)
+                {
+                    center = glm::floor(center / snap) * snap;
+                }
+
 				lightView = glm::lookAt(mainLightForShadows->getTransform().getForward(), glm::vec3(0, 0, 0), mainLightForShadows->getTransform().getUp());
-                lightView = glm::translate(lightView, -m_ActiveCamera->getTransform().position());
+                lightView = glm::translate(lightView, -center);
             }
             else
             {
@@ -154,16 +242,6 @@ namespace annileen
             const float area = 50.0f;
             glm::mat4 lightProj = glm::ortho(-area, area, -area, area, -100.0f, 100.0f);
 
-            // Setup shadow
-            bgfx::setViewRect(m_ShadowRenderView->getViewId(), 0, 0, 
-                ServiceProvider::getSettings()->shadows.shadowMapSize, 
-                ServiceProvider::getSettings()->shadows.shadowMapSize);
-            bgfx::setViewFrameBuffer(m_ShadowRenderView->getViewId(), m_Shadow->frameBuffer);
-            bgfx::setViewTransform(m_ShadowRenderView->getViewId(), glm::value_ptr(lightView), glm::value_ptr(lightProj));
-
-            // Clear backbuffer and shadowmap framebuffer at beginning.
-            bgfx::setViewClear(m_ShadowRenderView->getViewId(), BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0x303030ff, 1.0f, 0);
-
             const float sy = m_Capabilities->originBottomLeft ? 0.5f : -0.5f;
             const float sz = m_Capabilities->homogeneousDepth ? 0.5f : 1.0f;
             const float tz = m_Capabilities->homogeneousDepth ? 0.5f : 0.0f;
@@ -177,30 +255,20 @@ namespace annileen
 
             mtxShadow = mtxCrop * lightProj * lightView;
 
-            for (auto sceneNode : m_Scene->getNodeList())
-            {
-                ModelPtr model = sceneNode->getModule<Model>();
-
-                if (model == nullptr || !sceneNode->getAcive() || !model->enabled) continue;
-
-                if (ServiceProvider::getSettings()->shadows.enabled && model->castShadows)
-                {
-                    renderSceneNode(m_ShadowRenderView->getViewId(), model, m_Shadow->material);
-                }
-            }
+            renderShadows(lightView, lightProj);
 
-            m_Uniform.setTextureUniform("s_shadowMap", m_Shadow->texture, m_Shadow->textureRegisterId);
-            m_Shadow->material->submitUniforms();
+            m_BindShadowMap = true;
         }
 
         // Setup fog
-        glm::vec3 settings{
+        glm::vec4 settings{
             m_Scene->fog.distance,
             m_Scene->fog.power,
             m_Scene->fog.enabled,
+            0.0f
         };
-        m_Uniform.setVec3Uniform("u_fogSettings", settings);
-        m_Uniform.setVec3Uniform("u_fogColor", m_Scene->fog.color);
+        setFrameUniform("u_fogSettings", settings);
+        setFrameUniform("u_fogColor", glm::vec4(m_Scene->fog.color, 0.0f));
 
         // Setup camera
         m_ActiveCamera->updateMatrices();
@@ -211,23 +279,38 @@ namespace annileen
         bgfx::setViewClear(m_SceneRenderView->getViewId(), BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 
             convert_color_vec3_uint32(m_ActiveCamera->clearColor), 1.0f, 0);
 
-        m_Uniform.setVec3Uniform("u_viewPos", m_ActiveCamera->getTransform().position());
+        setFrameUniform("u_viewPos", glm::vec4(m_ActiveCamera->getTransform().position(), 0.0f));
 
-        for (auto sceneNode : m_Scene->getNodeList())
-        {
-            ModelPtr model = sceneNode->getModule<Model>();
+        // Build the draw list here, so the encoding threads never touch the scene.
+        auto cullStart = std::chrono::steady_clock::now();
+        m_RenderQueue.clear();
 
-            if (model == nullptr || model->getMeshGroup() == nullptr || !sceneNode->getAcive() || !model->enabled) continue;
+        // Only models whose bounds reach the camera frustum are drawn.
+        m_VisibleModels.clear();
+        m_Scene->queryFrustum(Frustum::fromMatrix(m_ActiveCamera->getViewProjectionMatrix()), m_VisibleModels);
 
-            if (ServiceProvider::getSettings()->shadows.enabled && model->receiveShadows)
+        for (Model* model : m_VisibleModels)
+        {
+            if (model->getMeshGroup() == nullptr || !model->getSceneNode()->getAcive() || !model->enabled) continue;
+
+            RenderItem item;
+            item.meshGroup = model->getMeshGroup();
+            item.material = model->getMaterial().get();
+            item.transform = model->getRenderMatrix();
+            item.receiveShadows = ServiceProvider::getSettings()->shadows.enabled && model->receiveShadows;
+            if (item.receiveShadows)
             {
-                lightMtx = mtxShadow * sceneNode->getTransform().getModelMatrix();
-                m_Uniform.setMat4Uniform("u_lightMtx", lightMtx);                
+                item.lightMatrix = mtxShadow * item.transform;
             }
 
-            renderSceneNode(m_SceneRenderView->getViewId(), model, model->getMaterial());
+            m_RenderQueue.push_back(item);
         }
 
+        m_Timings.cull += millisecondsSince(cullStart);
+
+        auto submitStart = std::chrono::steady_clock::now();
+        submitRenderQueue(m_SceneRenderView->getViewId(), m_RenderQueue, true);
+
         const bx::Vec3 at = { 0.0f, 0.0f,  0.0f };
         const bx::Vec3 eye = { 0.0f, 0.0f, -1.0f };
 
@@ -251,14 +334,12 @@ namespace annileen
         bgfx::setViewTransform(m_UIRenderView->getViewId(), view, ortho);
         bgfx::setViewRect(m_UIRenderView->getViewId(), 0, 0, Engine::getInstance()->getWidth(), Engine::getInstance()->getHeight());
         
-        for (auto sceneNode : m_Scene->getNodeList())
+        m_Scene->getModuleStorage<Text>().forEach([this](Text* text)
         {
-            TextPtr text = sceneNode->getModule<Text>();
-
-            if (text == nullptr || !text->enabled ) continue;
+            if (!text->enabled) return;
 
             text->render(m_UIRenderView->getViewId());
-        }
+        });
 
         if (m_ActiveCamera->clearType == CameraClearType::CameraClearSkybox)
         {
@@ -273,6 +354,120 @@ namespace annileen
                 ANNILEEN_LOG_WARNING(LoggingChannel::Renderer, "Camera clear type is set for skybox, but no skybox was set.");
             }
         }
+
+        m_Timings.submit += millisecondsSince(submitStart);
+    }
+
+    void Renderer::renderShadows(const glm::mat4& lightView, const glm::mat4& lightProj)
+    {
+        ANNILEEN_PROFILE_SCOPE("Renderer::renderShadows");
+
+        const Settings::Shadows& shadowSettings = ServiceProvider::getSettings()->shadows;
+        const bool useStaticLayer = shadowSettings.cacheStaticLayer && m_Shadow->canCacheStaticLayer;
+
+        auto cullStart = std::chrono::steady_clock::now();
+        m_StaticShadowCasters.clear();
+        m_DynamicShadowCasters.clear();
+
+        // Order independent signature of the static caster set, so adding, removing,
+        // enabling or disabling any of them invalidates the static layer.
+        uint64_t staticCasterSignature = 0;
+
+        // Casters outside the light volume can't land in the shadow map. The culled set only
+        // changes with the light view, which rebuilds the static layer anyway.
+        m_VisibleModels.clear();
+        m_Scene->queryFrustum(Frustum::fromMatrix(lightProj * lightView), m_VisibleModels);
+
+        for (Model* model : m_VisibleModels)
+        {
+            if (model->getMeshGroup() == nullptr || !model->getSceneNode()->getAcive() || !model->enabled || !model->castShadows) continue;
+
+            RenderItem item;
+            item.meshGroup = model->getMeshGroup();
+            item.material = m_Shadow->material.get();
+            item.transform = model->getRenderMatrix();
+            item.receiveShadows = false;
+
+            if (useStaticLayer && model->isStatic)
+            {
+                // The node id has the slot generation, so a caster in a reused slot doesn't
+                // pass for the one before it, the world version changes whenever it moves.
+                uint64_t hash = mixHash(0, model->getSceneNode()->getId());
+                hash = mixHash(hash, reinterpret_cast<uintptr_t>(model));
+                hash = mixHash(hash, reinterpret_cast<uintptr_t>(model->getMeshGroup()));
+                hash = mixHash(hash, model->getMeshGroup()->m_Revision);
+                hash = mixHash(hash, model->getTransform().getWorldVersion());
+                staticCasterSignature += hash;
+
+                m_StaticShadowCasters.push_back(item);
+            }
+            else
+            {
+                m_DynamicShadowCasters.push_back(item);
+            }
+        }
+
+        m_Timings.cull += millisecondsSince(cullStart);
+
+        auto submitStart = std::chrono::steady_clock::now();
+        const uint16_t shadowMapSize = shadowSettings.shadowMapSize;
+
+        bgfx::setViewRect(m_ShadowRenderView->getViewId(), 0, 0, shadowMapSize, shadowMapSize);
+        bgfx::setViewFrameBuffer(m_ShadowRenderView->getViewId(), m_Shadow->frameBuffer);
+        bgfx::setViewTransform(m_ShadowRenderView->getViewId(), glm::value_ptr(lightView), glm::value_ptr(lightProj));
+
+        if (useStaticLayer)
+        {
+            const bool rebuildStaticLayer = !m_Shadow->staticLayerValid
+                || m_Shadow->staticLightView != lightView
+                || m_Shadow->staticCasterSignature != staticCasterSignature;
+
+            if (rebuildStaticLayer)
+            {
+                bgfx::setViewRect(m_ShadowStaticRenderView->getViewId(), 0, 0, shadowMapSize, shadowMapSize);
+                bgfx::setViewFrameBuffer(m_ShadowStaticRenderView->getViewId(), m_Shadow->staticFrameBuffer);
+                bgfx::setViewTransform(m_ShadowStaticRenderView->getViewId(), glm::value_ptr(lightView), glm::value_ptr(lightProj));
+                bgfx::setViewClear(m_ShadowStaticRenderView->getViewId(), BGFX_CLEAR_DEPTH, 0x303030ff, 1.0f, 0);
+                bgfx::touch(m_ShadowStaticRenderView->getViewId());
+
+                submitRenderQueue(m_ShadowStaticRenderView->getViewId(), m_StaticShadowCasters, false);
+
+                m_Shadow->staticLayerValid = true;
+                m_Shadow->staticLightView = lightView;
+                m_Shadow->staticCasterSignature = staticCasterSignature;
+                m_ShadowStats.staticLayerRebuilds++;
+            }
+            else
+            {
+                m_ShadowStats.cachedFrames++;
+            }
+
+            // Start the shadow map from the cached static layer and draw dynamic casters on top.
+            bgfx::setViewClear(m_ShadowRenderView->getViewId(), BGFX_CLEAR_NONE);
+            bgfx::blit(m_ShadowRenderView->getViewId(), m_Shadow->texture->getHandle(), 0, 0, m_Shadow->staticTexture);
+        }
+        else
+        {
+            m_Shadow->staticLayerValid = false;
+            bgfx::setViewClear(m_ShadowRenderView->getViewId(), BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0x303030ff, 1.0f, 0);
+        }
+
+        bgfx::touch(m_ShadowRenderView->getViewId());
+
+        submitRenderQueue(m_ShadowRenderView->getViewId(), m_DynamicShadowCasters, false);
+
+        m_Timings.submit += millisecondsSince(submitStart);
+
+        m_ShadowStats.staticCasters = static_cast<uint32_t>(m_StaticShadowCasters.size());
+        m_ShadowStats.dynamicCasters = static_cast<uint32_t>(m_DynamicShadowCasters.size());
+    }
+
+    void Renderer::invalidateShadowCache()
+    {
+        if (m_Shadow != nullptr)
+        {
+            m_Shadow->staticLayerValid = false;
+        }
     }
 
     void Renderer::initFrame(Scene* scene)
@@ -280,6 +475,11 @@ namespace annileen
         scene->getCamera()->updateMatrices();
     }
 
+    void Renderer::updateStats()
+    {
+        m_Stats.endFrame(m_Timings);
+    }
+
     void Renderer::renderSkybox(bgfx::ViewId viewId, Camera* camera, Skybox* skybox)
     {
         skybox->getModel()->getMaterial()->submitUniforms();
@@ -298,36 +498,117 @@ namespace annileen
             
                 bgfx::setState(shaderPass->getState());
                 bgfx::submit(viewId, shaderPass->getShader()->getProgram());
+
+                m_Stats.addDraws(viewId, 1, mesh->getPrimitiveCount());
             }
         }
     }
 
-    void Renderer::renderSceneNode(bgfx::ViewId viewId, ModelPtr model, std::shared_ptr<Material> material)
+    void Renderer::setFrameUniform(const std::string& name, const glm::vec4& value)
     {
-        material->submitUniforms();
+        m_FrameUniforms.push_back({ m_Uniform.getVec4UniformHandle(name), value });
+    }
+
+    void Renderer::submitRenderQueue(bgfx::ViewId viewId, const std::vector<RenderItem>& queue, bool sceneUniforms)
+    {
+        if (queue.empty())
+        {
+            return;
+        }
 
-        auto meshGroup = model->getMeshGroup();
+        ANNILEEN_PROFILE_SCOPE("Renderer::submitRenderQueue");
 
-        if (meshGroup == nullptr)
+        JobSystem* jobs = ServiceProvider::getJobSystem();
+        const size_t threadCount = jobs != nullptr ? jobs->getWorkerCount() + 1 : 1;
+        const size_t taskCount = std::min({ m_MaxSubmitTasks, threadCount, (queue.size() + s_MinItemsPerSubmitTask - 1) / s_MinItemsPerSubmitTask });
+
+        if (taskCount <= 1)
         {
+            bgfx::Encoder* encoder = bgfx::begin();
+            encodeRenderItems(encoder, viewId, queue.data(), queue.size(), sceneUniforms);
+            bgfx::end(encoder);
             return;
         }
 
-        for (auto& mesh : meshGroup->m_Meshes)
+        const size_t itemsPerTask = (queue.size() + taskCount - 1) / taskCount;
+
+        std::atomic<bool> droppedDraws{ false };
+
+        // Ranges of itemsPerTask items make at most taskCount tasks, so no more encoders than
+        // that are ever in use at once.
+        jobs->parallelFor(queue.size(), itemsPerTask, [&](size_t begin, size_t end)
         {
-            bgfx::setTransform(glm::value_ptr(model->getTransform().getModelMatrix()));
-            bgfx::setVertexBuffer(0, mesh->getVertexBuffer());
-            if (mesh->hasIndices())
-                bgfx::setIndexBuffer(mesh->getIndexBuffer());
-        
-            for (int shaderPassId = 0; shaderPassId < material->getNumberOfShaderPasses(); ++shaderPassId)
+            bgfx::Encoder* encoder = bgfx::begin(true);
+            if (encoder == nullptr)
             {
-                std::shared_ptr<ShaderPass> shaderPass = material->getShaderPassAt(shaderPassId);
+                droppedDraws = true;
+                return;
+            }
 
-                bgfx::setState(shaderPass->getState());
-                bgfx::submit(viewId, shaderPass->getShader()->getProgram());
+            encodeRenderItems(encoder, viewId, queue.data() + begin, end - begin, sceneUniforms);
+            bgfx::end(encoder);
+        });
+
+        // The logger is not thread safe, so report from here.
+        if (droppedDraws)
+        {
+            ANNILEEN_LOG_ERROR(LoggingChannel::Renderer, "Out of bgfx encoders, draw calls were dropped.");
+        }
+    }
+
+    void Renderer::encodeRenderItems(bgfx::Encoder* encoder, bgfx::ViewId viewId, const RenderItem* items, size_t count, bool sceneUniforms)
+    {
+        ANNILEEN_PROFILE_SCOPE("Renderer::encodeRenderItems");
+
+        uint32_t drawCalls = 0;
+        uint64_t primitives = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const RenderItem& item = items[i];
+
+            for (auto& mesh : item.meshGroup->m_Meshes)
+            {
+                for (int shaderPassId = 0; shaderPassId < item.material->getNumberOfShaderPasses(); ++shaderPassId)
+                {
+                    std::shared_ptr<ShaderPass> shaderPass = item.material->getShaderPassAt(shaderPassId);
+
+                    // Uniforms and textures are discarded after every submit.
+                    if (sceneUniforms)
+                    {
+                        for (const auto& uniform : m_FrameUniforms)
+                        {
+                            encoder->setUniform(uniform.handle, glm::value_ptr(uniform.value));
+                        }
+
+                        if (m_BindShadowMap)
+                        {
+                            encoder->setTexture(m_Shadow->textureRegisterId, m_ShadowMapUniform, m_Shadow->texture->getHandle());
+                        }
+
+                        if (item.receiveShadows)
+                        {
+                            encoder->setUniform(m_LightMatrixUniform, glm::value_ptr(item.lightMatrix));
+                        }
+                    }
+
+                    item.material->submitUniforms(encoder);
+
+                    encoder->setTransform(glm::value_ptr(item.transform));
+                    encoder->setVertexBuffer(0, mesh->getVertexBuffer());
+                    if (mesh->hasIndices())
+                        encoder->setIndexBuffer(mesh->getIndexBuffer());
+
+                    encoder->setState(shaderPass->getState());
+                    encoder->submit(viewId, shaderPass->getShader()->getProgram());
+
+                    drawCalls++;
+                    primitives += mesh->getPrimitiveCount();
+                }
             }
         }
+
+        m_Stats.addDraws(viewId, drawCalls, primitives);
     }
 
     const bgfx::Caps* Renderer::getCapabilities() const
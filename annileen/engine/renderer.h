@@ -8,6 +8,7 @@
 
 #include <engine/engine.h>
 #include <engine/renderview.h>
+#include <engine/renderstats.h>
 
 namespace annileen
 {
@@ -18,6 +19,50 @@ namespace annileen
         bgfx::FrameBufferHandle frameBuffer;
         Texture* texture;
         uint8_t textureRegisterId;
+
+        // Static layer cache
+        bool canCacheStaticLayer;
+        bgfx::FrameBufferHandle staticFrameBuffer;
+        bgfx::TextureHandle staticTexture;
+        bool staticLayerValid;
+        glm::mat4 staticLightView;
+        uint64_t staticCasterSignature;
+    };
+
+    struct ShadowStats
+    {
+        uint32_t staticLayerRebuilds;
+        uint32_t cachedFrames;
+        uint32_t staticCasters;
+        uint32_t dynamicCasters;
+    };
+
+    // CPU time spent by the last render() call, in milliseconds.
+    struct RenderTimings
+    {
+        // Walking the scene and building the draw lists.
+        double cull;
+        // Encoding and submitting the draw lists.
+        double submit;
+    };
+
+    // A single draw of a mesh group, resolved on the main thread so it can be
+    // encoded from any thread.
+    struct RenderItem
+    {
+        MeshGroup* meshGroup;
+        Material* material;
+        glm::mat4 transform;
+        glm::mat4 lightMatrix;
+        bool receiveShadows;
+    };
+
+    // Per frame vec4 uniforms (light, fog, camera). They are applied to every draw
+    // because draws from different encoders have no defined order.
+    struct FrameUniform
+    {
+        bgfx::UniformHandle handle;
+        glm::vec4 value;
     };
 
     class Scene;
@@ -32,24 +77,50 @@ namespace annileen
         Uniform m_Uniform;
 
         Shadow* m_Shadow;
+        ShadowStats m_ShadowStats;
+        RenderTimings m_Timings;
+        RenderStats m_Stats;
+        std::vector<RenderItem> m_StaticShadowCasters;
+        std::vector<RenderItem> m_DynamicShadowCasters;
+
+        std::vector<RenderItem> m_RenderQueue;
+        // Models returned by the scene's spatial queries, reused between passes.
+        std::vector<Model*> m_VisibleModels;
+        std::vector<FrameUniform> m_FrameUniforms;
+        bgfx::UniformHandle m_LightMatrixUniform;
+        bgfx::UniformHandle m_ShadowMapUniform;
+        bool m_BindShadowMap;
+
+        // Draw submission is split in at most this many jobs, one encoder each.
+        size_t m_MaxSubmitTasks;
+
         Camera* m_ActiveCamera;
         Scene* m_Scene;
 
         RenderView* m_SceneRenderView;
         RenderView* m_ShadowRenderView;
+        RenderView* m_ShadowStaticRenderView;
         RenderView* m_SkyboxRenderView;
         RenderView* m_UIRenderView;
 
         void initializeShadows();
+        void renderShadows(const glm::mat4& lightView, const glm::mat4& lightProj);
+
+        void setFrameUniform(const std::string& name, const glm::vec4& value);
 
         void renderSkybox(bgfx::ViewId viewId, Camera* camera, Skybox* skybox);
-        void renderSceneNode(bgfx::ViewId viewId, ModelPtr model, std::shared_ptr<Material> material);
+        void submitRenderQueue(bgfx::ViewId viewId, const std::vector<RenderItem>& queue, bool sceneUniforms);
+        void encodeRenderItems(bgfx::Encoder* encoder, bgfx::ViewId viewId, const RenderItem* items, size_t count, bool sceneUniforms);
 
     public:
         void init(Engine* engine);
 
         void setActiveCamera(Camera* camera);
         void setScene(Scene* scene);
+        // Threads encoding draw calls besides the calling one, capped by the bgfx encoder limit.
+        // Init sets it from rendering.submitThreads.
+        void setSubmitWorkers(size_t workerCount);
+        size_t getSubmitWorkers() const { return m_MaxSubmitTasks - 1; }
 
         void render();
 
@@ -57,6 +128,15 @@ namespace annileen
 
         const bgfx::Caps* getCapabilities() const;
 
+        const ShadowStats& getShadowStats() const { return m_ShadowStats; }
+        const RenderTimings& getTimings() const { return m_Timings; }
+        const RenderStats& getStats() const { return m_Stats; }
+        // Closes the statistics of the frame being submitted, call once per frame before bgfx::frame().
+        void updateStats();
+        // Rebuilds the static shadow layer next frame. Changes to the static casters are seen on
+        // their own, this is for anything else that makes the cached layer wrong.
+        void invalidateShadowCache();
+
         bool useShadows;
 
         Renderer();
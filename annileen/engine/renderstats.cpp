@@ -0,0 +1,97 @@
+#include <engine/renderstats.h>
+#include <engine/renderer.h>
+#include <engine/renderview.h>
+
+namespace annileen
+{
+    RenderStats::RenderStats() : m_FrameCount(0)
+    {
+        for (size_t i = 0; i < maxViews; ++i)
+        {
+            m_ViewDrawCalls[i] = 0;
+            m_ViewPrimitives[i] = 0;
+        }
+    }
+
+    RenderStats::~RenderStats()
+    {
+    }
+
+    void RenderStats::addDraws(bgfx::ViewId viewId, uint32_t drawCalls, uint64_t primitives)
+    {
+        if (viewId >= maxViews) return;
+
+        m_ViewDrawCalls[viewId].fetch_add(drawCalls, std::memory_order_relaxed);
+        m_ViewPrimitives[viewId].fetch_add(primitives, std::memory_order_relaxed);
+    }
+
+    void RenderStats::endFrame(const RenderTimings& timings)
+    {
+        FrameStats frame{};
+        frame.frame = m_FrameCount++;
+        frame.cpuCullTime = timings.cull;
+        frame.cpuSubmitTime = timings.submit;
+
+        for (const RenderView* renderView : RenderView::getRenderViews())
+        {
+            const bgfx::ViewId viewId = renderView->getViewId();
+            if (viewId >= maxViews) continue;
+
+            ViewStats view;
+            view.viewId = viewId;
+            view.name = std::string(renderView->getName());
+            view.drawCalls = m_ViewDrawCalls[viewId].exchange(0, std::memory_order_relaxed);
+            view.primitives = m_ViewPrimitives[viewId].exchange(0, std::memory_order_relaxed);
+            view.gpuTime = 0.0;
+
+            frame.drawCalls += view.drawCalls;
+            frame.primitives += view.primitives;
+            frame.views.push_back(view);
+        }
+
+        const bgfx::Stats* stats = bgfx::getStats();
+        if (stats != nullptr)
+        {
+            frame.gpuDrawCalls = stats->numDraw;
+            for (uint32_t topology = 0; topology < bgfx::Topology::Count; ++topology)
+            {
+                frame.gpuPrimitives += stats->numPrims[topology];
+            }
+
+            auto toMilliseconds = [](int64_t ticks, int64_t frequency)
+            {
+                return frequency > 0 ? ticks * 1000.0 / frequency : 0.0;
+            };
+
+            frame.gpuTime = toMilliseconds(stats->gpuTimeEnd - stats->gpuTimeBegin, stats->gpuTimerFreq);
+            for (uint16_t i = 0; i < stats->numViews; ++i)
+            {
+                const bgfx::ViewStats& viewStats = stats->viewStats[i];
+                for (ViewStats& view : frame.views)
+                {
+                    if (view.viewId == viewStats.view)
+                    {
+                        view.gpuTime = toMilliseconds(viewStats.gpuTimeEnd - viewStats.gpuTimeBegin, stats->gpuTimerFreq);
+                        break;
+                    }
+                }
+            }
+            frame.bgfxCpuTime = toMilliseconds(stats->cpuTimeEnd - stats->cpuTimeBegin, stats->cpuTimerFreq);
+            frame.waitRender = toMilliseconds(stats->waitRender, stats->cpuTimerFreq);
+            frame.waitSubmit = toMilliseconds(stats->waitSubmit, stats->cpuTimerFreq);
+            frame.transientVertexBufferUsed = stats->transientVbUsed;
+            frame.transientIndexBufferUsed = stats->transientIbUsed;
+            frame.dynamicVertexBuffers = stats->numDynamicVertexBuffers;
+            frame.dynamicIndexBuffers = stats->numDynamicIndexBuffers;
+            frame.textureMemoryUsed = stats->textureMemoryUsed;
+            frame.renderTargetMemoryUsed = stats->rtMemoryUsed;
+            frame.gpuMemoryUsed = stats->gpuMemoryUsed;
+        }
+
+        m_History.push_back(std::move(frame));
+        if (m_History.size() > historySize)
+        {
+            m_History.pop_front();
+        }
+    }
+}
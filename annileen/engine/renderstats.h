@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <bgfx/bgfx.h>
+
+namespace annileen
+{
+    struct RenderTimings;
+
+    struct ViewStats
+    {
+        bgfx::ViewId viewId;
+        std::string name;
+        uint32_t drawCalls;
+        uint64_t primitives;
+        // Measured by bgfx with BGFX_DEBUG_PROFILER on, zero otherwise and on the Noop renderer.
+        double gpuTime;
+    };
+
+    struct FrameStats
+    {
+        uint64_t frame;
+
+        // Counted by the engine while submitting, so they work on every renderer (Noop included).
+        uint32_t drawCalls;
+        uint64_t primitives;
+        double cpuCullTime;
+        double cpuSubmitTime;
+        std::vector<ViewStats> views;
+
+        // Reported by bgfx for the last frame it rendered. Zero on the Noop renderer.
+        uint32_t gpuDrawCalls;
+        uint64_t gpuPrimitives;
+        double gpuTime;
+        double bgfxCpuTime;
+        double waitRender;
+        double waitSubmit;
+        uint32_t transientVertexBufferUsed;
+        uint32_t transientIndexBufferUsed;
+        uint16_t dynamicVertexBuffers;
+        uint16_t dynamicIndexBuffers;
+        int64_t textureMemoryUsed;
+        int64_t renderTargetMemoryUsed;
+        int64_t gpuMemoryUsed;
+    };
+
+    // Collects draw counters from any submitting thread and a per frame snapshot of bgfx::getStats().
+    class RenderStats
+    {
+    public:
+        static constexpr size_t historySize = 300;
+
+    private:
+        static constexpr size_t maxViews = 256;
+
+        std::array<std::atomic<uint32_t>, maxViews> m_ViewDrawCalls;
+        std::array<std::atomic<uint64_t>, maxViews> m_ViewPrimitives;
+
+        uint64_t m_FrameCount;
+        std::deque<FrameStats> m_History;
+
+    public:
+        // Thread safe, called once per submitted batch.
+        void addDraws(bgfx::ViewId viewId, uint32_t drawCalls, uint64_t primitives);
+
+        // Snapshots the counters of the frame being submitted and resets them.
+        void endFrame(const RenderTimings& timings);
+
+        const FrameStats* getLastFrame() const { return m_History.empty() ? nullptr : &m_History.back(); }
+        const std::deque<FrameStats>& getHistory() const { return m_History; }
+
+        RenderStats();
+        ~RenderStats();
+    };
+}
@@ -87,6 +87,16 @@ namespace annileen
         return (renderViewIt != m_ViewIds.end());
     }
 
+    std::vector<const RenderView*> RenderView::getRenderViews()
+    {
+        std::vector<const RenderView*> renderViews;
+        for (auto renderViewId : m_RenderViewIds)
+        {
+            renderViews.push_back(m_ViewIds[renderViewId]);
+        }
+        return renderViews;
+    }
+
     bool RenderView::insertOrMoveRenderViewAfter(const size_t id, const char* name, const size_t afterThisId)
     {
         if (id <= PostProcessing)
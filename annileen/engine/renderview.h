@@ -4,6 +4,7 @@
 #include<unordered_map>
 #include<string_view>
 #include<list>
+#include<vector>
 
 namespace annileen
 {
@@ -21,6 +22,7 @@ namespace annileen
         enum ReservedIndices : size_t
         {
             Shadow = 0,
+            ShadowStatic,
             Scene,
             Skybox,
             UI,
@@ -28,10 +30,13 @@ namespace annileen
         };
 
         bgfx::ViewId getViewId() const noexcept { return m_Id; }
+        std::string_view getName() const noexcept { return m_Name; }
 
         static bool addRenderView(const size_t id, const char* name);
         static RenderView* getRenderView(const size_t id);
         static bool hasRenderView(const size_t id);
+        // All render views, ordered by view id.
+        static std::vector<const RenderView*> getRenderViews();
         static bool insertOrMoveRenderViewAfter(const size_t id, const char* name, const size_t afterThisId);
         static bool insertOrMoveRenderViewBefore(const size_t id, const char* name, const size_t beforeThisId);
         static bool removeRenderView(const size_t id);
@@ -1,5 +1,8 @@
 #include <engine/scene.h>
 #include <engine/serviceprovider.h>
+#include <engine/core/profiler.h>
+
+#include <algorithm>
 
 namespace annileen
 {
@@ -8,9 +11,271 @@ namespace annileen
         return m_Root;
     }
 
+    // Blends two world matrices without shearing, assuming neither is sheared: translation
+    // and scale are blended linearly, rotation along the shortest arc.
+    static glm::mat4 interpolateMatrix(const glm::mat4& from, const glm::mat4& to, float t)
+    {
+        glm::vec3 fromScale(glm::length(glm::vec3(from[0])), glm::length(glm::vec3(from[1])), glm::length(glm::vec3(from[2])));
+        glm::vec3 toScale(glm::length(glm::vec3(to[0])), glm::length(glm::vec3(to[1])), glm::length(glm::vec3(to[2])));
+
+        // Zero scales have no rotation to speak of, a plain blend is as good as any.
+        if (glm::any(glm::equal(fromScale, glm::vec3(0.0f))) || glm::any(glm::equal(toScale, glm::vec3(0.0f))))
+        {
+            return from + (to - from) * t;
+        }
+
+        glm::quat fromRotation = glm::quat_cast(glm::mat3(glm::vec3(from[0]) / fromScale.x, glm::vec3(from[1]) / fromScale.y, glm::vec3(from[2]) / fromScale.z));
+        glm::quat toRotation = glm::quat_cast(glm::mat3(glm::vec3(to[0]) / toScale.x, glm::vec3(to[1]) / toScale.y, glm::vec3(to[2]) / toScale.z));
+
+        glm::mat4 result = glm::mat4_cast(glm::slerp(fromRotation, toRotation, t));
+        glm::vec3 scale = glm::mix(fromScale, toScale, t);
+        result[0] *= scale.x;
+        result[1] *= scale.y;
+        result[2] *= scale.z;
+        result[3] = glm::mix(from[3], to[3], t);
+        return result;
+    }
+
+    void Scene::beginFixedStep()
+    {
+        m_Models.forEach([](Model* model)
+        {
+            if (!model->interpolate) return;
+
+            model->m_PreviousWorldMatrix = model->getTransform().getWorldMatrix();
+            model->m_HasPreviousWorld = true;
+        });
+    }
+
+    void Scene::updateRenderMatrices(float interpolation)
+    {
+        ANNILEEN_PROFILE_FUNCTION();
+
+        m_Models.forEach([interpolation](Model* model)
+        {
+            if (!model->interpolate || !model->m_HasPreviousWorld) return;
+
+            model->m_RenderMatrix = interpolateMatrix(model->m_PreviousWorldMatrix, model->getTransform().getWorldMatrix(), interpolation);
+        });
+    }
+
+    void Scene::updateTransforms(float interpolation)
+    {
+        JobSystem* jobs = ServiceProvider::getJobSystem();
+
+        // Local matrices don't depend on each other, they are rebuilt in one pass over the
+        // arrays. Only the world matrices need the hierarchy.
+        m_Transforms.updateLocalMatrices(jobs);
+
+        if (jobs != nullptr)
+        {
+            m_Root->getTransform().updateHierarchy(*jobs);
+        }
+        else
+        {
+            m_Root->getTransform().updateHierarchy();
+        }
+
+        updateRenderMatrices(interpolation);
+        updateSpatialIndex();
+    }
+
+    // Static models changed at once, past a quarter of the static tree, for which building the
+    // tree anew is cheaper than changing it a leaf at a time.
+    static const size_t s_MinStaticRebuild = 256;
+
+    void Scene::updateSpatialIndex()
+    {
+        ANNILEEN_PROFILE_FUNCTION();
+
+        m_StaticChanges.clear();
+
+        m_Models.forEach([this](Model* model)
+        {
+            Transform& transform = model->getTransform();
+            MeshGroup* meshGroup = model->getMeshGroup();
+            const bool changed = model->m_BvhWorldVersion != transform.getWorldVersion()
+                || model->m_BvhMeshGroup != meshGroup
+                || (meshGroup != nullptr && model->m_BvhMeshRevision != meshGroup->m_Revision);
+
+            if (model->m_BvhStatic != model->isStatic)
+            {
+                // Out of the tree it was in, below it goes into the other one.
+                if (model->m_BvhProxy != Bvh::nullNode)
+                {
+                    (model->m_BvhStatic ? m_StaticBvh : m_DynamicBvh).remove(model->m_BvhProxy);
+                    model->m_BvhProxy = Bvh::nullNode;
+                }
+
+                model->m_BvhStatic = model->isStatic;
+            }
+            else if (!changed && (model->isStatic || model->m_BvhProxy != Bvh::nullNode))
+            {
+                return;
+            }
+
+            model->m_BvhWorldVersion = transform.getWorldVersion();
+            model->m_BvhMeshGroup = meshGroup;
+            model->m_BvhMeshRevision = meshGroup != nullptr ? meshGroup->m_Revision : 0;
+            model->m_WorldBounds = model->getMeshGroup() != nullptr
+                ? model->getMeshGroup()->getBounds().transformed(transform.getWorldMatrix())
+                : Aabb::empty();
+
+            // Interpolated models are drawn anywhere between their last two steps.
+            if (model->interpolate && model->m_HasPreviousWorld && model->m_WorldBounds.isValid())
+            {
+                model->m_WorldBounds = model->m_WorldBounds.merged(model->getMeshGroup()->getBounds().transformed(model->m_PreviousWorldMatrix));
+            }
+
+            if (model->isStatic)
+            {
+                m_StaticChanges.push_back(model);
+            }
+            else
+            {
+                updateBvhLeaf(m_DynamicBvh, model);
+            }
+        });
+
+        updateStaticBvh();
+    }
+
+    void Scene::updateBvhLeaf(Bvh& bvh, Model* model)
+    {
+        if (!model->m_WorldBounds.isValid())
+        {
+            if (model->m_BvhProxy != Bvh::nullNode) bvh.remove(model->m_BvhProxy);
+            model->m_BvhProxy = Bvh::nullNode;
+        }
+        else if (model->m_BvhProxy == Bvh::nullNode)
+        {
+            model->m_BvhProxy = bvh.insert(model->m_WorldBounds, model);
+        }
+        else
+        {
+            bvh.move(model->m_BvhProxy, model->m_WorldBounds);
+        }
+    }
+
+    void Scene::updateStaticBvh()
+    {
+        if (m_StaticChanges.empty()) return;
+
+        if (m_StaticChanges.size() > std::max(s_MinStaticRebuild, m_StaticBvh.size() / 4))
+        {
+            rebuildStaticBvh();
+            return;
+        }
+
+        for (Model* model : m_StaticChanges)
+        {
+            updateBvhLeaf(m_StaticBvh, model);
+        }
+    }
+
+    void Scene::rebuildStaticBvh()
+    {
+        ANNILEEN_PROFILE_FUNCTION();
+
+        std::vector<std::pair<Aabb, void*>> leaves;
+        m_Models.forEach([&leaves](Model* model)
+        {
+            if (!model->m_BvhStatic) return;
+
+            model->m_BvhProxy = Bvh::nullNode;
+            if (model->m_WorldBounds.isValid())
+            {
+                leaves.emplace_back(model->m_WorldBounds, model);
+            }
+        });
+
+        std::vector<int32_t> proxies;
+        m_StaticBvh.build(leaves, &proxies);
+        for (size_t i = 0; i < leaves.size(); ++i)
+        {
+            static_cast<Model*>(leaves[i].second)->m_BvhProxy = proxies[i];
+        }
+    }
+
+    template <class Test, class Query>
+    void Scene::queryModels(const Test& test, const Query& query, std::vector<Model*>& results)
+    {
+        auto visitor = [&test, &results](void* userData)
+        {
+            // Dynamic leaves are stored with a margin, check the actual bounds.
+            Model* model = static_cast<Model*>(userData);
+            if (test(model->m_WorldBounds)) results.push_back(model);
+        };
+
+        query(m_StaticBvh, visitor);
+        query(m_DynamicBvh, visitor);
+    }
+
+    void Scene::queryFrustum(const Frustum& frustum, std::vector<Model*>& results)
+    {
+        queryModels([&frustum](const Aabb& box) { return frustum.overlaps(box); },
+            [&frustum](const Bvh& bvh, const auto& visitor) { bvh.queryFrustum(frustum, visitor); }, results);
+    }
+
+    void Scene::querySphere(const glm::vec3& center, float radius, std::vector<Model*>& results)
+    {
+        queryModels([&center, radius](const Aabb& box) { return box.overlapsSphere(center, radius); },
+            [&center, radius](const Bvh& bvh, const auto& visitor) { bvh.querySphere(center, radius, visitor); }, results);
+    }
+
+    void Scene::queryAabb(const Aabb& box, std::vector<Model*>& results)
+    {
+        queryModels([&box](const Aabb& other) { return other.overlaps(box); },
+            [&box](const Bvh& bvh, const auto& visitor) { bvh.queryAabb(box, visitor); }, results);
+    }
+
+    Model* Scene::raycast(const Ray& ray, float maxDistance, float* distance)
+    {
+        auto hitTest = [&ray, maxDistance](void* userData, float& hitDistance)
+        {
+            Model* model = static_cast<Model*>(userData);
+            if (!model->enabled || !model->getSceneNode()->getAcive()) return false;
+
+            return ray.intersects(model->m_WorldBounds, maxDistance, hitDistance);
+        };
+
+        float staticDistance, dynamicDistance;
+        Model* staticHit = static_cast<Model*>(m_StaticBvh.raycast(ray, maxDistance, staticDistance, hitTest));
+        Model* dynamicHit = static_cast<Model*>(m_DynamicBvh.raycast(ray, staticHit != nullptr ? staticDistance : maxDistance, dynamicDistance, hitTest));
+
+        Model* hit = dynamicHit != nullptr ? dynamicHit : staticHit;
+        if (distance != nullptr && hit != nullptr)
+        {
+            *distance = dynamicHit != nullptr ? dynamicDistance : staticDistance;
+        }
+
+        return hit;
+    }
+
+    void Scene::destroyModule(ModuleTypeId type, SceneNodeModule* module)
+    {
+        bool destroyed = false;
+
+        if (type == ModuleType::id<Model>())
+        {
+            Model* model = static_cast<Model*>(module);
+            if (model->m_BvhProxy != Bvh::nullNode) (model->m_BvhStatic ? m_StaticBvh : m_DynamicBvh).remove(model->m_BvhProxy);
+
+            destroyed = m_Models.destroy(model);
+        }
+        else if (type == ModuleType::id<Light>()) destroyed = m_LightModules.destroy(static_cast<Light*>(module));
+        else if (type == ModuleType::id<Camera>()) destroyed = m_CameraModules.destroy(static_cast<Camera*>(module));
+        else if (type == ModuleType::id<Text>()) destroyed = m_Texts.destroy(static_cast<Text*>(module));
+
+        if (!destroyed)
+        {
+            delete module;
+        }
+    }
+
     SceneNodePtr Scene::createNode(const std::string& name)
     {
-        auto node = new SceneNode(name);
+        auto node = new (m_NodePool.allocate()) SceneNode(name, m_Transforms);
         node->setParentScene(this);
         node->setParent(getRoot());
         return node;
@@ -18,24 +283,99 @@ namespace annileen
 
     void Scene::destroyNode(SceneNodePtr node)
     {
-        delete node;
+        if (node == nullptr || node == m_Root) return;
+
+        node->~SceneNode();
+        m_NodePool.deallocate(node);
+    }
+
+    void Scene::clear()
+    {
+        while (m_Root->getFirstChild() != nullptr)
+        {
+            destroyNode(m_Root->getFirstChild());
+        }
+    }
+
+    void Scene::reserveNodes(size_t count)
+    {
+        m_NodePool.reserve(count);
+        m_Transforms.reserve(count + 1);
+        m_NodeSlots.reserve(count);
+        m_Nodes.reserve(count);
+        m_NodeModuleMasks.reserve(count);
+    }
+
+    SceneNodePtr Scene::getNode(SceneNodeHandle handle) const
+    {
+        if (handle.index >= m_NodeSlots.size()) return nullptr;
+
+        const NodeSlot& slot = m_NodeSlots[handle.index];
+        return slot.generation == handle.generation ? slot.node : nullptr;
     }
 
     void Scene::addNodeToList(SceneNodePtr node)
     {
+        uint32_t index;
+        if (!m_FreeNodeSlots.empty())
+        {
+            index = m_FreeNodeSlots.back();
+            m_FreeNodeSlots.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_NodeSlots.size());
+            m_NodeSlots.push_back({ nullptr, 0 });
+        }
+
+        m_NodeSlots[index].node = node;
+        node->m_Handle = { index, m_NodeSlots[index].generation };
+
+        node->m_NodeListIndex = m_Nodes.size();
         m_Nodes.push_back(node);
+        m_NodeModuleMasks.push_back(node->m_ModuleMask);
     }
 
     void Scene::removeNodeFromList(SceneNodePtr node)
     {
-        m_Nodes.remove(node);
+        // Nodes are removed once, but the destructor and setParentScene may both ask.
+        if (!node->m_Handle.isValid()) return;
+
+        NodeSlot& slot = m_NodeSlots[node->m_Handle.index];
+        slot.node = nullptr;
+        slot.generation++;
+        m_FreeNodeSlots.push_back(node->m_Handle.index);
+        node->m_Handle = {};
+
+        SceneNodePtr last = m_Nodes.back();
+        m_Nodes[node->m_NodeListIndex] = last;
+        m_NodeModuleMasks[node->m_NodeListIndex] = m_NodeModuleMasks.back();
+        last->m_NodeListIndex = node->m_NodeListIndex;
+        m_Nodes.pop_back();
+        m_NodeModuleMasks.pop_back();
+    }
+
+    void Scene::updateNodeModuleMask(SceneNodePtr node)
+    {
+        // The root is not listed.
+        if (!node->m_Handle.isValid()) return;
+
+        m_NodeModuleMasks[node->m_NodeListIndex] = node->m_ModuleMask;
     }
 
-    std::list<SceneNodePtr>& Scene::getNodeList()
+    const std::vector<SceneNodePtr>& Scene::getNodeList() const
     {
         return m_Nodes;
     }
 
+    void Scene::getNodesWith(ModuleMask mask, std::vector<SceneNodePtr>& results) const
+    {
+        for (size_t i = 0; i < m_NodeModuleMasks.size(); ++i)
+        {
+            if ((m_NodeModuleMasks[i] & mask) == mask) results.push_back(m_Nodes[i]);
+        }
+    }
+
     std::list<Light*>& Scene::getLightList()
     {
         return m_Lights;
@@ -62,8 +402,12 @@ namespace annileen
 
     Scene::Scene() : fog()
     {
+        // Static models don't move, margins would only make their leaves overlap more.
+        m_StaticBvh.setMargin(0.0f);
         //m_Camera = new Camera(60.0f, 0.1f, 300.0f);
-        m_Root = new SceneNode("Root");
+        m_Root = new SceneNode("Root", m_Transforms);
+        // The root is not pooled nor listed, but its children are destroyed through this scene.
+        m_Root->m_ParentScene = this;
     }
 
     Scene::~Scene()
@@ -4,11 +4,18 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <vector>
 
 #include "scenenode.h"
 #include "camera.h"
 #include "skybox.h"
 #include "light.h"
+#include "text/text.h"
+#include "scene/modulestorage.h"
+#include "scene/moduletype.h"
+#include "scene/bvh.h"
+#include "scene/transformstorage.h"
+#include "core/poolallocator.h"
 
 namespace annileen
 {
@@ -20,17 +27,62 @@ namespace annileen
         bool enabled;
     };
 
+    class Material;
+
     class Scene
     {
     private:
-        std::list<SceneNodePtr> m_Nodes;
+        struct NodeSlot
+        {
+            SceneNodePtr node;
+            uint32_t generation;
+        };
+
+        // Slot map behind SceneNodeHandle. Freed slots are reused, bumping their generation.
+        std::vector<NodeSlot> m_NodeSlots;
+        std::vector<uint32_t> m_FreeNodeSlots;
+        // Every node but the root, unordered, nodes are swapped into the hole when one is removed.
+        std::vector<SceneNodePtr> m_Nodes;
+        // Module masks of m_Nodes, in the same order, so finding nodes by module type only
+        // scans this array.
+        std::vector<ModuleMask> m_NodeModuleMasks;
+        PoolAllocator<SceneNode> m_NodePool;
+        // Position, rotation, scale and matrices of every node, the root included.
+        TransformStorage m_Transforms;
         SceneNodePtr m_Root;
         std::list<Light*> m_Lights;
         std::list<Camera*> m_Cameras;        
         Skybox* m_Skybox = nullptr;
 
+        // Engine modules are stored per type. Other module types are heap allocated.
+        ModuleStorage<Model> m_Models;
+        ModuleStorage<Light> m_LightModules;
+        ModuleStorage<Camera> m_CameraModules;
+        ModuleStorage<Text> m_Texts;
+
+        // Spatial index over the model world bounds. Static models share a tree without margins,
+        // changed a leaf at a time, and built anew in one go when many of them change at once,
+        // as after a scene was loaded. The others live in a tree with margins, updated in place.
+        // Models without bounds (no mesh yet) are left out.
+        Bvh m_DynamicBvh;
+        Bvh m_StaticBvh;
+        // Static models whose bounds changed in the current update.
+        std::vector<Model*> m_StaticChanges;
+
+        void updateSpatialIndex();
+        void updateRenderMatrices(float interpolation);
+        // Inserts, moves or removes the leaf of the model in its tree, as its bounds say.
+        void updateBvhLeaf(Bvh& bvh, Model* model);
+        void updateStaticBvh();
+        void rebuildStaticBvh();
+        template <class Test, class Query> void queryModels(const Test& test, const Query& query, std::vector<Model*>& results);
+
         void addNodeToList(SceneNodePtr node);
         void removeNodeFromList(SceneNodePtr node);
+        void updateNodeModuleMask(SceneNodePtr node);
+
+        template <class T> T* createModule();
+        void destroyModule(ModuleTypeId type, SceneNodeModule* module);
 
         friend class SceneNode;
     public:
@@ -38,23 +90,167 @@ namespace annileen
 
         virtual void start() {};
         virtual void update() {};
+        // Runs once per simulation step, Time::fixedDeltaTime apart, before update().
+        virtual void fixedUpdate() {};
+
+        // Materials are built in code, so loaded scenes refer to them by name and the scene
+        // provides them. Models whose material can't be resolved are loaded without a mesh.
+        virtual std::shared_ptr<Material> resolveMaterial(const std::string& name) { return nullptr; }
 
         SceneNodePtr getRoot();
 
+        // Updates the cached world matrices of every node that changed since the last call,
+        // and the model bounds the spatial queries use. Interpolated models are drawn
+        // that far (0 to 1) from their previous simulation step to the last one.
+        void updateTransforms(float interpolation = 1.0f);
+        // Call before every simulation step, keeps where interpolated models were.
+        void beginFixedStep();
+
+        // Packed storage of an engine module type (Model, Light, Camera or Text).
+        template <class T> const ModuleStorage<T>& getModuleStorage() const;
+        PoolStats getNodePoolStats() const { return m_NodePool.getStats(); }
+        const TransformStorage& getTransformStorage() const { return m_Transforms; }
+
+        // Models whose world bounds overlap the volume, appended to results whether they are
+        // enabled or not. Bounds are those of the last updateTransforms().
+        void queryFrustum(const Frustum& frustum, std::vector<Model*>& results);
+        void querySphere(const glm::vec3& center, float radius, std::vector<Model*>& results);
+        void queryAabb(const Aabb& box, std::vector<Model*>& results);
+        // Closest enabled model on an active node whose world bounds the ray hits, or nullptr.
+        Model* raycast(const Ray& ray, float maxDistance, float* distance = nullptr);
+
         SceneNodePtr createNode(const std::string& name);
         void destroyNode(SceneNodePtr node);
+        // Returns nullptr if the node was destroyed.
+        SceneNodePtr getNode(SceneNodeHandle handle) const;
+        // Destroys every node but the root.
+        void clear();
+        // Grows the node storage so creating up to count nodes does not allocate.
+        void reserveNodes(size_t count);
 
         void setSkybox(Skybox* skybox) { m_Skybox = skybox; }
         Skybox* getSkybox() const { return m_Skybox; }
 
-        std::list<SceneNodePtr>& getNodeList();
+        const std::vector<SceneNodePtr>& getNodeList() const;
+        // Appends every node (but the root) that has all the module types in mask, built with
+        // ModuleType::mask<T>().
+        void getNodesWith(ModuleMask mask, std::vector<SceneNodePtr>& results) const;
         std::list<Light*>& getLightList();
         std::list<Camera*>& getCameraList();
         Camera* getCamera();        
 
         Scene();
-        ~Scene();
+        // Virtual, the SceneManager deletes replaced scenes through a Scene pointer.
+        virtual ~Scene();
     };
+
+    template <class T>
+    T* Scene::createModule()
+    {
+        if constexpr (std::is_same<T, Model>::value) return m_Models.create();
+        else if constexpr (std::is_same<T, Light>::value) return m_LightModules.create();
+        else if constexpr (std::is_same<T, Camera>::value) return m_CameraModules.create();
+        else if constexpr (std::is_same<T, Text>::value) return m_Texts.create();
+        else return new T();
+    }
+
+    template <class T>
+    const ModuleStorage<T>& Scene::getModuleStorage() const
+    {
+        static_assert(std::is_same<T, Model>::value || std::is_same<T, Light>::value
+            || std::is_same<T, Camera>::value || std::is_same<T, Text>::value, "Only engine modules have packed storage.");
+
+        if constexpr (std::is_same<T, Model>::value) return m_Models;
+        else if constexpr (std::is_same<T, Light>::value) return m_LightModules;
+        else if constexpr (std::is_same<T, Camera>::value) return m_CameraModules;
+        else return m_Texts;
+    }
+
+    // SceneNode templates that need the complete Scene
+
+    template <class T>
+    T* SceneNode::addModule()
+    {
+        if (!std::is_base_of<SceneNodeModule, T>::value)
+        {
+            //ANNILEEN_LOGF_ERROR(LoggingChannel::General, "\"{0}\" cannot be added because it is not a module.", typeid(T).name());
+            return nullptr;
+        }
+
+        const ModuleTypeId typeId = ModuleType::id<T>();
+        if (typeId >= ModuleType::maxTypes)
+        {
+            return nullptr;
+        }
+
+        if (m_Modules[typeId] != nullptr)
+        {
+            //ANNILEEN_LOG_ERROR(LoggingChannel::General, "This SceneNode has a Module of this type already. Remove the existing module before adding a new one of the same type.");
+            return nullptr;
+        }
+
+        T* module = m_ParentScene != nullptr ? m_ParentScene->createModule<T>() : new T();
+
+        m_Modules[typeId] = static_cast<SceneNodeModulePtr>(module);
+        m_ModuleMask |= ModuleMask(1) << typeId;
+        if (m_ParentScene != nullptr) m_ParentScene->updateNodeModuleMask(this);
+
+        module->m_SceneNode = this;
+
+        // "if constexpr" is a C++17 thing.
+        if constexpr (std::is_same<T, Camera>::value)
+        {
+            m_ParentScene->m_Cameras.push_back(module);
+        }
+        else if constexpr (std::is_same<T, Light>::value)
+        {
+            m_ParentScene->m_Lights.push_back(module);
+        }
+
+        return module;
+    }
+
+    template <class T>
+    bool SceneNode::removeModule()
+    {
+        const ModuleTypeId typeId = ModuleType::id<T>();
+        if (typeId >= ModuleType::maxTypes || m_Modules[typeId] == nullptr)
+        {
+            //ANNILEEN_LOG_ERROR(LoggingChannel::General, "This SceneNode does not have a Module of this type.");
+            return false;
+        }
+
+        T* module = static_cast<T*>(m_Modules[typeId]);
+
+        if (module != nullptr)
+        {
+            module->m_SceneNode = nullptr;
+
+            if constexpr (std::is_same<T, Camera>::value)
+            {
+                m_ParentScene->m_Cameras.remove(module);
+            }
+            else if constexpr (std::is_same<T, Light>::value)
+            {
+                m_ParentScene->m_Lights.remove(module);
+            }
+
+            if (m_ParentScene != nullptr)
+            {
+                m_ParentScene->destroyModule(typeId, module);
+            }
+            else
+            {
+                delete module;
+            }
+        }
+
+        m_Modules[typeId] = nullptr;
+        m_ModuleMask &= ~(ModuleMask(1) << typeId);
+        if (m_ParentScene != nullptr) m_ParentScene->updateNodeModuleMask(this);
+
+        return true;
+    }
 }
 
 #endif
@@ -0,0 +1,412 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace annileen
+{
+    Aabb Aabb::empty()
+    {
+        const float infinity = std::numeric_limits<float>::infinity();
+        return { glm::vec3(infinity), glm::vec3(-infinity) };
+    }
+
+    float Aabb::getSurfaceArea() const
+    {
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool Aabb::contains(const Aabb& other) const
+    {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+            && max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+    }
+
+    bool Aabb::overlaps(const Aabb& other) const
+    {
+        return min.x <= other.max.x && min.y <= other.max.y && min.z <= other.max.z
+            && max.x >= other.min.x && max.y >= other.min.y && max.z >= other.min.z;
+    }
+
+    bool Aabb::overlapsSphere(const glm::vec3& center, float radius) const
+    {
+        glm::vec3 closest = glm::clamp(center, min, max);
+        glm::vec3 offset = closest - center;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    void Aabb::expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    Aabb Aabb::merged(const Aabb& other) const
+    {
+        return { glm::min(min, other.min), glm::max(max, other.max) };
+    }
+
+    Aabb Aabb::inflated(float margin) const
+    {
+        return { min - glm::vec3(margin), max + glm::vec3(margin) };
+    }
+
+    Aabb Aabb::transformed(const glm::mat4& matrix) const
+    {
+        glm::vec3 center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+
+        // Each world axis extent is the sum of the local extents projected on it.
+        glm::mat3 absolute = glm::mat3(matrix);
+        for (int column = 0; column < 3; ++column)
+        {
+            absolute[column] = glm::abs(absolute[column]);
+        }
+        glm::vec3 extents = absolute * getExtents();
+
+        return { center - extents, center + extents };
+    }
+
+    bool Ray::intersects(const Aabb& box, float maxDistance, float& distance) const
+    {
+        // Slab test, a zero direction component divides to infinity and keeps working.
+        glm::vec3 inverse = 1.0f / direction;
+        glm::vec3 t0 = (box.min - origin) * inverse;
+        glm::vec3 t1 = (box.max - origin) * inverse;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+
+        float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+
+        if (entry > exit) return false;
+
+        distance = entry;
+        return true;
+    }
+
+    Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+    {
+        // glm matrices are column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+        glm::mat4 rows = glm::transpose(viewProjection);
+
+        Frustum frustum;
+        frustum.planes[0] = rows[3] + rows[0]; // left
+        frustum.planes[1] = rows[3] - rows[0]; // right
+        frustum.planes[2] = rows[3] + rows[1]; // bottom
+        frustum.planes[3] = rows[3] - rows[1]; // top
+        frustum.planes[4] = rows[3] + rows[2]; // near
+        frustum.planes[5] = rows[3] - rows[2]; // far
+
+        for (glm::vec4& plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return frustum;
+    }
+
+    bool Frustum::overlaps(const Aabb& box) const
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            // The box corner furthest along the plane normal.
+            glm::vec3 corner(
+                plane.x >= 0.0f ? box.max.x : box.min.x,
+                plane.y >= 0.0f ? box.max.y : box.min.y,
+                plane.z >= 0.0f ? box.max.z : box.min.z);
+
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) return false;
+        }
+
+        return true;
+    }
+
+    int32_t Bvh::allocateNode()
+    {
+        int32_t index;
+        if (m_FreeList != nullNode)
+        {
+            index = m_FreeList;
+            m_FreeList = m_Nodes[index].parent;
+        }
+        else
+        {
+            index = static_cast<int32_t>(m_Nodes.size());
+            m_Nodes.emplace_back();
+        }
+
+        Node& node = m_Nodes[index];
+        node.box = Aabb::empty();
+        node.userData = nullptr;
+        node.parent = nullNode;
+        node.left = nullNode;
+        node.right = nullNode;
+        node.height = 0;
+        return index;
+    }
+
+    void Bvh::freeNode(int32_t index)
+    {
+        m_Nodes[index].parent = m_FreeList;
+        m_Nodes[index].height = -1;
+        m_FreeList = index;
+    }
+
+    void Bvh::refit(int32_t index)
+    {
+        Node& node = m_Nodes[index];
+        const Node& left = m_Nodes[node.left];
+        const Node& right = m_Nodes[node.right];
+
+        node.box = left.box.merged(right.box);
+        node.height = 1 + std::max(left.height, right.height);
+    }
+
+    void Bvh::insertLeaf(int32_t leaf)
+    {
+        if (m_Root == nullNode)
+        {
+            m_Root = leaf;
+            m_Nodes[leaf].parent = nullNode;
+            return;
+        }
+
+        // Walk down to the sibling that grows the total surface area the least.
+        const Aabb leafBox = m_Nodes[leaf].box;
+        int32_t index = m_Root;
+
+        while (!m_Nodes[index].isLeaf())
+        {
+            const Node& node = m_Nodes[index];
+            float area = node.box.getSurfaceArea();
+            float combinedArea = node.box.merged(leafBox).getSurfaceArea();
+
+            // Cost of pairing the leaf with this node, and the cost pushed down to the children.
+            float cost = 2.0f * combinedArea;
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto childCost = [this, &leafBox, inheritanceCost](int32_t child)
+            {
+                const Node& childNode = m_Nodes[child];
+                float mergedArea = childNode.box.merged(leafBox).getSurfaceArea();
+                return (childNode.isLeaf() ? mergedArea : mergedArea - childNode.box.getSurfaceArea()) + inheritanceCost;
+            };
+
+            float leftCost = childCost(node.left);
+            float rightCost = childCost(node.right);
+
+            if (cost < leftCost && cost < rightCost) break;
+
+            index = leftCost < rightCost ? node.left : node.right;
+        }
+
+        const int32_t sibling = index;
+        const int32_t oldParent = m_Nodes[sibling].parent;
+
+        // Allocating may grow the node array, no references are held across it.
+        const int32_t newParent = allocateNode();
+        m_Nodes[newParent].parent = oldParent;
+        m_Nodes[newParent].left = sibling;
+        m_Nodes[newParent].right = leaf;
+        m_Nodes[sibling].parent = newParent;
+        m_Nodes[leaf].parent = newParent;
+
+        if (oldParent == nullNode)
+        {
+            m_Root = newParent;
+        }
+        else if (m_Nodes[oldParent].left == sibling)
+        {
+            m_Nodes[oldParent].left = newParent;
+        }
+        else
+        {
+            m_Nodes[oldParent].right = newParent;
+        }
+
+        for (index = newParent; index != nullNode; index = m_Nodes[index].parent)
+        {
+            refit(index);
+            index = balance(index);
+        }
+    }
+
+    void Bvh::removeLeaf(int32_t leaf)
+    {
+        if (leaf == m_Root)
+        {
+            m_Root = nullNode;
+            return;
+        }
+
+        const int32_t parent = m_Nodes[leaf].parent;
+        const int32_t grandParent = m_Nodes[parent].parent;
+        const int32_t sibling = m_Nodes[parent].left == leaf ? m_Nodes[parent].right : m_Nodes[parent].left;
+
+        m_Nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        if (grandParent == nullNode)
+        {
+            m_Root = sibling;
+            return;
+        }
+
+        if (m_Nodes[grandParent].left == parent) m_Nodes[grandParent].left = sibling;
+        else m_Nodes[grandParent].right = sibling;
+
+        for (int32_t index = grandParent; index != nullNode; index = m_Nodes[index].parent)
+        {
+            refit(index);
+            index = balance(index);
+        }
+    }
+
+    int32_t Bvh::balance(int32_t indexA)
+    {
+        Node& a = m_Nodes[indexA];
+        if (a.isLeaf() || a.height < 2) return indexA;
+
+        const int32_t indexB = a.left;
+        const int32_t indexC = a.right;
+        Node& b = m_Nodes[indexB];
+        Node& c = m_Nodes[indexC];
+
+        const int32_t difference = c.height - b.height;
+
+        // Whichever child is too tall takes A's place, A takes the child's shorter grandchild.
+        auto rotateUp = [this, indexA, &a](int32_t indexUp, Node& up, Node& other, bool upIsRight)
+        {
+            const int32_t indexF = up.left;
+            const int32_t indexG = up.right;
+            const bool keepLeft = m_Nodes[indexF].height > m_Nodes[indexG].height;
+            const int32_t kept = keepLeft ? indexF : indexG;
+            const int32_t given = keepLeft ? indexG : indexF;
+
+            up.left = indexA;
+            up.right = kept;
+            up.parent = a.parent;
+            a.parent = indexUp;
+
+            if (up.parent == nullNode) m_Root = indexUp;
+            else if (m_Nodes[up.parent].left == indexA) m_Nodes[up.parent].left = indexUp;
+            else m_Nodes[up.parent].right = indexUp;
+
+            if (upIsRight) a.right = given;
+            else a.left = given;
+            m_Nodes[given].parent = indexA;
+
+            a.box = other.box.merged(m_Nodes[given].box);
+            a.height = 1 + std::max(other.height, m_Nodes[given].height);
+            up.box = a.box.merged(m_Nodes[kept].box);
+            up.height = 1 + std::max(a.height, m_Nodes[kept].height);
+
+            return indexUp;
+        };
+
+        if (difference > 1) return rotateUp(indexC, c, b, true);
+        if (difference < -1) return rotateUp(indexB, b, c, false);
+
+        return indexA;
+    }
+
+    int32_t Bvh::insert(const Aabb& box, void* userData)
+    {
+        const int32_t proxy = allocateNode();
+        m_Nodes[proxy].box = box.inflated(m_Margin);
+        m_Nodes[proxy].userData = userData;
+
+        insertLeaf(proxy);
+        ++m_LeafCount;
+        return proxy;
+    }
+
+    void Bvh::remove(int32_t proxy)
+    {
+        removeLeaf(proxy);
+        freeNode(proxy);
+        --m_LeafCount;
+    }
+
+    bool Bvh::move(int32_t proxy, const Aabb& box)
+    {
+        if (m_Nodes[proxy].box.contains(box)) return false;
+
+        removeLeaf(proxy);
+        m_Nodes[proxy].box = box.inflated(m_Margin);
+        insertLeaf(proxy);
+        return true;
+    }
+
+    int32_t Bvh::buildRange(std::vector<int32_t>& leaves, size_t begin, size_t end)
+    {
+        if (end - begin == 1) return leaves[begin];
+
+        // Split at the median centroid along the axis the centroids spread the most.
+        Aabb centroids = Aabb::empty();
+        for (size_t i = begin; i < end; ++i)
+        {
+            centroids.expand(m_Nodes[leaves[i]].box.getCenter());
+        }
+
+        glm::vec3 spread = centroids.max - centroids.min;
+        int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(leaves.begin() + begin, leaves.begin() + middle, leaves.begin() + end,
+            [this, axis](int32_t first, int32_t second)
+            {
+                return m_Nodes[first].box.getCenter()[axis] < m_Nodes[second].box.getCenter()[axis];
+            });
+
+        const int32_t left = buildRange(leaves, begin, middle);
+        const int32_t right = buildRange(leaves, middle, end);
+
+        const int32_t index = allocateNode();
+        m_Nodes[index].left = left;
+        m_Nodes[index].right = right;
+        m_Nodes[left].parent = index;
+        m_Nodes[right].parent = index;
+        refit(index);
+
+        return index;
+    }
+
+    void Bvh::build(const std::vector<std::pair<Aabb, void*>>& leaves, std::vector<int32_t>* proxies)
+    {
+        clear();
+        if (proxies != nullptr) proxies->clear();
+        if (leaves.empty()) return;
+
+        m_Nodes.reserve(leaves.size() * 2 - 1);
+
+        std::vector<int32_t> leafIndices;
+        leafIndices.reserve(leaves.size());
+        for (const auto& leaf : leaves)
+        {
+            const int32_t index = allocateNode();
+            m_Nodes[index].box = leaf.first;
+            m_Nodes[index].userData = leaf.second;
+            leafIndices.push_back(index);
+        }
+
+        // Before building, which reorders the indices.
+        if (proxies != nullptr) *proxies = leafIndices;
+
+        m_Root = buildRange(leafIndices, 0, leafIndices.size());
+        m_LeafCount = leaves.size();
+    }
+
+    void Bvh::clear()
+    {
+        m_Nodes.clear();
+        m_Root = nullNode;
+        m_FreeList = nullNode;
+        m_LeafCount = 0;
+    }
+
+    Bvh::Bvh() : m_Root(nullNode), m_FreeList(nullNode), m_LeafCount(0), m_Margin(0.5f)
+    {
+    }
+}
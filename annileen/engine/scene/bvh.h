@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <glm.hpp>
+
+namespace annileen
+{
+    struct Aabb
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+
+        // Inverted box, merging anything into it gives that thing's box.
+        static Aabb empty();
+
+        bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+        glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+        glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+        float getSurfaceArea() const;
+
+        bool contains(const Aabb& other) const;
+        bool overlaps(const Aabb& other) const;
+        bool overlapsSphere(const glm::vec3& center, float radius) const;
+
+        void expand(const glm::vec3& point);
+        Aabb merged(const Aabb& other) const;
+        Aabb inflated(float margin) const;
+        // Box around this box once transformed, usually larger than the transformed box itself.
+        Aabb transformed(const glm::mat4& matrix) const;
+    };
+
+    struct Ray
+    {
+        glm::vec3 origin;
+        // Normalized, so distances are in world units.
+        glm::vec3 direction;
+
+        // Distance to where the ray enters the box, 0 if it starts inside.
+        bool intersects(const Aabb& box, float maxDistance, float& distance) const;
+    };
+
+    struct Frustum
+    {
+        // Normals point inwards, a point is inside a plane when dot(xyz, point) + w >= 0.
+        glm::vec4 planes[6];
+
+        // Planes of a view projection matrix with a -1..1 depth range (glm's default). For a
+        // 0..1 depth range the near plane ends up behind the camera, which only makes culling
+        // a little less tight.
+        static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+        // Conservative, boxes near a frustum corner may pass while being outside.
+        bool overlaps(const Aabb& box) const;
+    };
+
+    // Bounding volume hierarchy over boxes, each leaf carrying a user pointer.
+    // Leaves can be inserted, moved and removed one at a time: the tree stays balanced with
+    // rotations and leaves are stored with a margin, so small moves don't touch the tree.
+    // It can also be built in one go from a list of boxes, which gives a better tree for
+    // things that don't move, and then changed a leaf at a time like any other.
+    class Bvh final
+    {
+    public:
+        static constexpr int32_t nullNode = -1;
+
+    private:
+        struct Node
+        {
+            Aabb box;
+            void* userData;
+            // Next free node while the node is on the free list.
+            int32_t parent;
+            int32_t left;
+            int32_t right;
+            // 0 for leaves, -1 for free nodes.
+            int32_t height;
+
+            bool isLeaf() const { return left == nullNode; }
+        };
+
+        std::vector<Node> m_Nodes;
+        int32_t m_Root;
+        int32_t m_FreeList;
+        size_t m_LeafCount;
+        float m_Margin;
+
+        int32_t allocateNode();
+        void freeNode(int32_t index);
+
+        void insertLeaf(int32_t leaf);
+        void removeLeaf(int32_t leaf);
+        // Rotates the subtree at index if its children heights differ by more than one.
+        // Returns the new subtree root.
+        int32_t balance(int32_t index);
+        // Recomputes box and height of an inner node from its children.
+        void refit(int32_t index);
+
+        int32_t buildRange(std::vector<int32_t>& leaves, size_t begin, size_t end);
+
+        // Calls visitor with every leaf whose box passes the test, subtrees whose box fails it
+        // are skipped.
+        template <class Test, class Visitor>
+        void traverse(Test test, Visitor visitor) const;
+
+    public:
+        // Boxes inserted or moved are grown by margin on every side.
+        void setMargin(float margin) { m_Margin = margin; }
+        float getMargin() const { return m_Margin; }
+
+        // Returns the proxy of the new leaf.
+        int32_t insert(const Aabb& box, void* userData);
+        void remove(int32_t proxy);
+        // Returns true if the leaf had to be reinserted, false if its fat box still holds box.
+        bool move(int32_t proxy, const Aabb& box);
+
+        // Replaces the whole tree with one built top down from the boxes, without margins.
+        // The proxy of every leaf, in the order of leaves, goes to proxies if given.
+        void build(const std::vector<std::pair<Aabb, void*>>& leaves, std::vector<int32_t>* proxies = nullptr);
+        void clear();
+
+        void* getUserData(int32_t proxy) const { return m_Nodes[proxy].userData; }
+        const Aabb& getFatBox(int32_t proxy) const { return m_Nodes[proxy].box; }
+        size_t size() const { return m_LeafCount; }
+        int32_t getHeight() const { return m_Root == nullNode ? 0 : m_Nodes[m_Root].height; }
+
+        // The visitor is called with the user data of every leaf whose box passes the test.
+        template <class Visitor> void queryAabb(const Aabb& box, Visitor visitor) const;
+        template <class Visitor> void querySphere(const glm::vec3& center, float radius, Visitor visitor) const;
+        template <class Visitor> void queryFrustum(const Frustum& frustum, Visitor visitor) const;
+
+        // Closest hit along the ray. For every leaf whose box the ray enters before the closest
+        // hit so far, hitTest(userData, distance) tells whether the ray hits the object itself
+        // and where. Returns the user data of the closest hit, or nullptr.
+        template <class HitTest> void* raycast(const Ray& ray, float maxDistance, float& distance, HitTest hitTest) const;
+
+        Bvh();
+    };
+
+    template <class Test, class Visitor>
+    void Bvh::traverse(Test test, Visitor visitor) const
+    {
+        if (m_Root == nullNode) return;
+
+        // Depth first, the stack never holds more than the tree height plus one entries.
+        // Balanced trees stay far below the fixed part, deeper ones spill to the heap.
+        int32_t stack[64];
+        size_t count = 0;
+        std::vector<int32_t> spill;
+
+        stack[count++] = m_Root;
+
+        while (count > 0 || !spill.empty())
+        {
+            int32_t index;
+            if (!spill.empty())
+            {
+                index = spill.back();
+                spill.pop_back();
+            }
+            else
+            {
+                index = stack[--count];
+            }
+
+            const Node& node = m_Nodes[index];
+            if (!test(node.box)) continue;
+
+            if (node.isLeaf())
+            {
+                visitor(node);
+                continue;
+            }
+
+            for (int32_t child : { node.left, node.right })
+            {
+                if (count < 64) stack[count++] = child;
+                else spill.push_back(child);
+            }
+        }
+    }
+
+    template <class Visitor>
+    void Bvh::queryAabb(const Aabb& box, Visitor visitor) const
+    {
+        traverse([&box](const Aabb& nodeBox) { return nodeBox.overlaps(box); },
+            [&visitor](const Node& leaf) { visitor(leaf.userData); });
+    }
+
+    template <class Visitor>
+    void Bvh::querySphere(const glm::vec3& center, float radius, Visitor visitor) const
+    {
+        traverse([&center, radius](const Aabb& nodeBox) { return nodeBox.overlapsSphere(center, radius); },
+            [&visitor](const Node& leaf) { visitor(leaf.userData); });
+    }
+
+    template <class Visitor>
+    void Bvh::queryFrustum(const Frustum& frustum, Visitor visitor) const
+    {
+        traverse([&frustum](const Aabb& nodeBox) { return frustum.overlaps(nodeBox); },
+            [&visitor](const Node& leaf) { visitor(leaf.userData); });
+    }
+
+    template <class HitTest>
+    void* Bvh::raycast(const Ray& ray, float maxDistance, float& distance, HitTest hitTest) const
+    {
+        void* closest = nullptr;
+        float closestDistance = maxDistance;
+
+        // Subtrees the ray enters past the closest hit so far are skipped.
+        traverse([&ray, &closestDistance](const Aabb& nodeBox)
+            {
+                float entry;
+                return ray.intersects(nodeBox, closestDistance, entry);
+            },
+            [&](const Node& leaf)
+            {
+                float hitDistance;
+                if (!hitTest(leaf.userData, hitDistance) || hitDistance > closestDistance) return;
+
+                closest = leaf.userData;
+                closestDistance = hitDistance;
+            });
+
+        distance = closestDistance;
+        return closest;
+    }
+}
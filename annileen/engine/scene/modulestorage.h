@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <engine/core/poolallocator.h>
+
+namespace annileen
+{
+    // Refers to a module slot. A handle goes stale once its module is destroyed, even if
+    // the slot is reused.
+    struct ModuleHandle
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool isValid() const { return index != UINT32_MAX; }
+    };
+
+    // Storage for one module type (T derives from SceneNodeModule). Modules are stored by
+    // value in fixed size pages, so pointers stay valid for their whole life and forEach
+    // walks them in address order. Freed slots are reused lowest first to keep the live
+    // modules at the front of the pages.
+    template <class T>
+    class ModuleStorage final
+    {
+    public:
+        static constexpr uint32_t pageSize = 256;
+
+    private:
+        // Bookkeeping is kept apart from the modules, so iterating touches module memory only.
+        struct Page
+        {
+            alignas(T) unsigned char storage[pageSize * sizeof(T)];
+            uint64_t live[pageSize / 64] = {};
+            uint32_t generations[pageSize] = {};
+
+            T* get(uint32_t slot) { return std::launder(reinterpret_cast<T*>(storage + slot * sizeof(T))); }
+            bool isLive(uint32_t slot) const { return (live[slot / 64] >> (slot % 64)) & 1; }
+            void setLive(uint32_t slot, bool value)
+            {
+                const uint64_t bit = uint64_t(1) << (slot % 64);
+                live[slot / 64] = value ? live[slot / 64] | bit : live[slot / 64] & ~bit;
+            }
+        };
+
+        std::vector<std::unique_ptr<Page>> m_Pages;
+        uint32_t m_SlotCount = 0;
+        // Min heap of free slot indices.
+        std::vector<uint32_t> m_FreeSlots;
+
+        size_t m_Size = 0;
+        size_t m_Peak = 0;
+
+        Page& getPage(uint32_t index) const { return *m_Pages[index / pageSize]; }
+
+    public:
+        T* create(ModuleHandle* handle = nullptr)
+        {
+            uint32_t index;
+            if (!m_FreeSlots.empty())
+            {
+                std::pop_heap(m_FreeSlots.begin(), m_FreeSlots.end(), std::greater<uint32_t>());
+                index = m_FreeSlots.back();
+                m_FreeSlots.pop_back();
+            }
+            else
+            {
+                if (m_SlotCount % pageSize == 0)
+                {
+                    m_Pages.emplace_back(new Page);
+                }
+                index = m_SlotCount++;
+            }
+
+            Page& page = getPage(index);
+            const uint32_t slot = index % pageSize;
+            T* module = new (page.storage + slot * sizeof(T)) T();
+            module->m_StorageIndex = index;
+            page.setLive(slot, true);
+
+            m_Size++;
+            m_Peak = std::max(m_Peak, m_Size);
+
+            if (handle != nullptr)
+            {
+                *handle = { index, page.generations[slot] };
+            }
+
+            return module;
+        }
+
+        // Returns false if the module does not belong to this storage.
+        bool destroy(T* module)
+        {
+            uint32_t index = module->m_StorageIndex;
+            if (index >= m_SlotCount) return false;
+
+            Page& page = getPage(index);
+            const uint32_t slot = index % pageSize;
+            if (!page.isLive(slot) || page.get(slot) != module) return false;
+
+            module->~T();
+            page.setLive(slot, false);
+            page.generations[slot]++;
+            m_Size--;
+
+            m_FreeSlots.push_back(index);
+            std::push_heap(m_FreeSlots.begin(), m_FreeSlots.end(), std::greater<uint32_t>());
+            return true;
+        }
+
+        T* get(ModuleHandle handle)
+        {
+            if (handle.index >= m_SlotCount) return nullptr;
+
+            Page& page = getPage(handle.index);
+            const uint32_t slot = handle.index % pageSize;
+            return page.isLive(slot) && page.generations[slot] == handle.generation ? page.get(slot) : nullptr;
+        }
+
+        ModuleHandle getHandle(const T* module) const
+        {
+            uint32_t index = module->m_StorageIndex;
+            if (index >= m_SlotCount) return {};
+
+            return { index, getPage(index).generations[index % pageSize] };
+        }
+
+        // Calls function(T*) for every live module, in address order. Creating or destroying
+        // modules from function is not allowed.
+        template <class F>
+        void forEach(F&& function) const
+        {
+            for (const std::unique_ptr<Page>& page : m_Pages)
+            {
+                for (uint32_t word = 0; word < pageSize / 64; ++word)
+                {
+                    uint64_t bits = page->live[word];
+                    for (uint32_t bit = 0; bits != 0; ++bit, bits >>= 1)
+                    {
+                        if (bits & 1) function(page->get(word * 64 + bit));
+                    }
+                }
+            }
+        }
+
+        size_t size() const { return m_Size; }
+
+        PoolStats getStats() const
+        {
+            return { m_Pages.size() * pageSize, m_Size, m_Peak, m_Pages.size() };
+        }
+
+        ModuleStorage() = default;
+        ModuleStorage(const ModuleStorage&) = delete;
+        ModuleStorage& operator=(const ModuleStorage&) = delete;
+
+        ~ModuleStorage()
+        {
+            forEach([](T* module) { module->~T(); });
+        }
+    };
+}
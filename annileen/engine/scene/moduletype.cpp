@@ -0,0 +1,19 @@
+#include "moduletype.h"
+
+#include <engine/serviceprovider.h>
+
+#include <atomic>
+
+namespace annileen
+{
+    ModuleTypeId ModuleType::next()
+    {
+        static std::atomic<ModuleTypeId> s_Next(engineTypes);
+
+        ModuleTypeId typeId = s_Next++;
+        if (typeId < maxTypes) return typeId;
+
+        ANNILEEN_LOGF_ERROR(LoggingChannel::Core, "Too many module types, only {} are supported. Modules of the new type can't be added.", maxTypes);
+        return invalidId;
+    }
+}
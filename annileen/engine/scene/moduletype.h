@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+namespace annileen
+{
+    class Model;
+    class Light;
+    class Camera;
+    class Text;
+
+    typedef uint32_t ModuleTypeId;
+    // One bit per module type id.
+    typedef uint32_t ModuleMask;
+
+    // Compact integer ids for module types, so scene nodes can keep their modules in a fixed
+    // array and tell which types they have from a bitmask. Engine modules have fixed ids, other
+    // module types get the next free id the first time they are used.
+    class ModuleType final
+    {
+    public:
+        static constexpr ModuleTypeId maxTypes = 32;
+        static constexpr ModuleTypeId invalidId = UINT32_MAX;
+        static constexpr ModuleTypeId engineTypes = 4;
+
+        // invalidId once maxTypes ids are taken.
+        template <class T> static ModuleTypeId id();
+        // 0 if the type has no valid id.
+        template <class T> static ModuleMask mask();
+
+    private:
+        static ModuleTypeId next();
+
+        ModuleType() = delete;
+    };
+
+    template <class T>
+    ModuleTypeId ModuleType::id()
+    {
+        static const ModuleTypeId s_Id = next();
+        return s_Id;
+    }
+
+    template <> inline ModuleTypeId ModuleType::id<Model>() { return 0; }
+    template <> inline ModuleTypeId ModuleType::id<Light>() { return 1; }
+    template <> inline ModuleTypeId ModuleType::id<Camera>() { return 2; }
+    template <> inline ModuleTypeId ModuleType::id<Text>() { return 3; }
+
+    template <class T>
+    ModuleMask ModuleType::mask()
+    {
+        const ModuleTypeId typeId = id<T>();
+        return typeId < maxTypes ? ModuleMask(1) << typeId : 0;
+    }
+}
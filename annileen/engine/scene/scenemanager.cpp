@@ -1,6 +1,236 @@
 #include "scenemanager.h"
 
+#include <engine/engine.h>
+#include <engine/scene.h>
+#include <engine/serviceprovider.h>
+#include <engine/core/profiler.h>
+
+#include <chrono>
+
 namespace annileen
 {
-    
+    // Nodes created between two checks of the frame budget.
+    static const size_t s_NodesPerSlice = 64;
+
+    SceneLoadId SceneManager::startLoading(const std::string& fileName, Scene* scene, bool additive)
+    {
+        // Requests stay where they are in the list, the reading job writes into them.
+        m_Requests.emplace_back();
+        LoadRequest& request = m_Requests.back();
+        request.id = m_NextId++;
+        request.additive = additive;
+        request.scene = scene;
+        request.state = LoadState::Reading;
+        request.data = std::make_unique<SceneData>();
+
+        auto job = [fileName, &request]()
+        {
+            ANNILEEN_PROFILE_SCOPE("SceneSerializer::read");
+            request.read = SceneSerializer::read(fileName, *request.data);
+        };
+
+        // Reading is a long job, it goes where the AssetManager's loads go.
+        JobSystem* jobs = ServiceProvider::getJobSystem();
+        if (jobs != nullptr)
+        {
+            jobs->runBackground(job, &request.reading);
+        }
+        else
+        {
+            job();
+        }
+
+        return m_Requests.back().id;
+    }
+
+    SceneLoadId SceneManager::loadScene(const std::string& fileName, SceneFactory factory)
+    {
+        Scene* scene = factory != nullptr ? factory() : new Scene();
+        if (scene == nullptr)
+        {
+            ANNILEEN_LOGF_ERROR(LoggingChannel::Core, "Scene '{}' was not loaded, the scene factory returned no scene.", fileName);
+            return invalidLoad;
+        }
+
+        return startLoading(fileName, scene, false);
+    }
+
+    SceneLoadId SceneManager::loadSubScene(const std::string& fileName)
+    {
+        Scene* scene = Engine::getInstance()->getScene();
+        if (scene == nullptr)
+        {
+            ANNILEEN_LOGF_ERROR(LoggingChannel::Core, "Sub-scene '{}' was not loaded, there is no current scene.", fileName);
+            return invalidLoad;
+        }
+
+        return startLoading(fileName, scene, true);
+    }
+
+    void SceneManager::unloadSubScene(SceneLoadId id)
+    {
+        for (auto it = m_SubScenes.begin(); it != m_SubScenes.end(); ++it)
+        {
+            if (it->id != id) continue;
+
+            for (SceneNodeHandle handle : it->roots)
+            {
+                it->scene->destroyNode(it->scene->getNode(handle));
+            }
+
+            m_SubScenes.erase(it);
+            return;
+        }
+    }
+
+    bool SceneManager::isLoading(SceneLoadId id) const
+    {
+        for (const auto& request : m_Requests)
+        {
+            if (request.id == id) return true;
+        }
+
+        return false;
+    }
+
+    float SceneManager::getProgress(SceneLoadId id) const
+    {
+        for (const auto& request : m_Requests)
+        {
+            if (request.id != id) continue;
+
+            // Reading is quick next to creating the nodes, it does not get its own share.
+            if (request.state == LoadState::Reading || request.data->nodeCount == 0) return 0.0f;
+
+            return static_cast<float>(request.data->nextNode) / request.data->nodeCount;
+        }
+
+        return 1.0f;
+    }
+
+    void SceneManager::update()
+    {
+        ANNILEEN_PROFILE_FUNCTION();
+
+        auto start = std::chrono::steady_clock::now();
+        auto budgetLeft = [this, &start]()
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() < m_FrameBudget;
+        };
+
+        bool firstSlice = true;
+
+        for (auto it = m_Requests.begin(); it != m_Requests.end();)
+        {
+            LoadRequest& request = *it;
+
+            if (request.state == LoadState::Reading)
+            {
+                if (!request.reading.isDone())
+                {
+                    ++it;
+                    continue;
+                }
+
+                if (!request.read)
+                {
+                    ANNILEEN_LOG_ERROR(LoggingChannel::Core, request.data->error);
+                    if (!request.additive) delete request.scene;
+                    it = m_Requests.erase(it);
+                    continue;
+                }
+
+                request.state = LoadState::Instantiating;
+            }
+
+            // The scene this sub-scene was meant for has been replaced.
+            if (request.scene == nullptr)
+            {
+                it = m_Requests.erase(it);
+                continue;
+            }
+
+            if (!firstSlice && !budgetLeft())
+            {
+                ++it;
+                continue;
+            }
+
+            bool finished = false;
+            do
+            {
+                finished = SceneSerializer::instantiate(request.scene, *request.data, s_NodesPerSlice);
+                firstSlice = false;
+            } while (!finished && budgetLeft());
+
+            if (!finished)
+            {
+                ++it;
+                continue;
+            }
+
+            // Taken out of the list first, swapping scenes may touch other requests.
+            std::list<LoadRequest> finishedRequest;
+            finishedRequest.splice(finishedRequest.begin(), m_Requests, it++);
+            finishLoading(finishedRequest.front());
+        }
+    }
+
+    void SceneManager::finishLoading(LoadRequest& request)
+    {
+        ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Scene loaded from '{}' ({} nodes).", request.data->fileName, request.data->nodeCount);
+
+        if (request.additive)
+        {
+            m_SubScenes.push_back({ request.id, request.scene, std::move(request.data->roots) });
+        }
+        else
+        {
+            swapScene(request.scene);
+        }
+    }
+
+    void SceneManager::swapScene(Scene* scene)
+    {
+        Engine* engine = Engine::getInstance();
+        Scene* previous = engine->getScene();
+
+        engine->setScene(scene);
+        scene->start();
+
+        if (previous != nullptr && previous != scene)
+        {
+            forgetScene(previous);
+            delete previous;
+        }
+    }
+
+    void SceneManager::forgetScene(Scene* scene)
+    {
+        for (auto it = m_SubScenes.begin(); it != m_SubScenes.end();)
+        {
+            if (it->scene == scene) it = m_SubScenes.erase(it);
+            else ++it;
+        }
+
+        // Requests still reading are dropped once their job is done, see update().
+        for (auto& request : m_Requests)
+        {
+            if (request.scene == scene) request.scene = nullptr;
+        }
+    }
+
+    SceneManager::SceneManager() : m_NextId(invalidLoad + 1), m_FrameBudget(2.0)
+    {
+    }
+
+    SceneManager::~SceneManager()
+    {
+        JobSystem* jobs = ServiceProvider::getJobSystem();
+        for (auto& request : m_Requests)
+        {
+            if (jobs != nullptr) jobs->wait(request.reading);
+            if (!request.additive) delete request.scene;
+        }
+    }
 }
@@ -1,9 +1,92 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <engine/scene/sceneserializer.h>
+#include <engine/core/jobsystem.h>
+
 namespace annileen
 {
-    class SceneManager
+    class Scene;
+
+    typedef uint32_t SceneLoadId;
+
+    // Loads scene files without stalling the running scene. Files are read and checked on a
+    // background thread, then their nodes are created on the main thread a slice at a time,
+    // within a per frame budget, and the new scene is swapped in at a frame boundary.
+    class SceneManager final
     {
+    public:
+        // Creates the empty scene a file is loaded into, so applications can use their own Scene class.
+        typedef std::function<Scene*()> SceneFactory;
+
+        static constexpr SceneLoadId invalidLoad = 0;
+
+    private:
+        enum class LoadState
+        {
+            Reading,
+            Instantiating
+        };
+
+        struct LoadRequest
+        {
+            SceneLoadId id;
+            bool additive;
+            // The new scene, or the scene a sub-scene is added to. Null once that scene is gone.
+            Scene* scene;
+            LoadState state;
+            std::unique_ptr<SceneData> data;
+            // Counts the background job reading the file, which sets read once it succeeds.
+            JobCounter reading;
+            bool read = false;
+        };
+
+        struct SubScene
+        {
+            SceneLoadId id;
+            Scene* scene;
+            std::vector<SceneNodeHandle> roots;
+        };
+
+        std::list<LoadRequest> m_Requests;
+        std::list<SubScene> m_SubScenes;
+        SceneLoadId m_NextId;
+        double m_FrameBudget;
+
+        SceneLoadId startLoading(const std::string& fileName, Scene* scene, bool additive);
+        void finishLoading(LoadRequest& request);
+        void swapScene(Scene* scene);
+        void forgetScene(Scene* scene);
+
+    public:
+        // Loads a scene file into a new scene, which replaces (and deletes) the current one once
+        // it is complete. The new scene's start() is called right after the swap.
+        SceneLoadId loadScene(const std::string& fileName, SceneFactory factory = nullptr);
+        // Loads a scene file into the current scene, next to what is already there.
+        SceneLoadId loadSubScene(const std::string& fileName);
+        // Destroys the nodes a finished sub-scene added.
+        void unloadSubScene(SceneLoadId id);
+
+        bool isLoading() const { return !m_Requests.empty(); }
+        bool isLoading(SceneLoadId id) const;
+        // From 0 to 1. Finished, failed and unknown loads report 1.
+        float getProgress(SceneLoadId id) const;
+
+        // Main thread time spent creating nodes per frame, in milliseconds. At least one slice
+        // of nodes is created every frame, whatever the budget.
+        void setFrameBudget(double milliseconds) { m_FrameBudget = milliseconds; }
+        double getFrameBudget() const { return m_FrameBudget; }
+
+        // Call once per frame, before the scene updates.
+        void update();
 
+        SceneManager();
+        ~SceneManager();
     };
 }
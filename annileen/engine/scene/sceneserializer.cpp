@@ -0,0 +1,598 @@
+#include <engine/scene/sceneserializer.h>
+#include <engine/scene.h>
+#include <engine/material.h>
+#include <engine/serviceprovider.h>
+#include <engine/core/profiler.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace annileen
+{
+    namespace
+    {
+        const char s_Magic[4] = { 'A', 'N', 'S', 'C' };
+        const uint32_t s_NoParent = UINT32_MAX;
+
+        enum class SerializedModule : uint32_t
+        {
+            Model = 1,
+            Light = 2,
+            Camera = 3,
+            Text = 4
+        };
+
+        // Every record only has 4 byte fields, so there is no padding to worry about.
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t nodeCount;
+            uint32_t moduleCount;
+            uint32_t stringBytes;
+        };
+
+        struct FileNode
+        {
+            uint32_t parent;
+            uint32_t name;
+            uint32_t active;
+            float position[3];
+            float euler[3];
+            float scale[3];
+        };
+
+        struct FileModule
+        {
+            uint32_t node;
+            SerializedModule type;
+            uint32_t size;
+        };
+
+        enum ModuleFlags : uint32_t
+        {
+            FlagEnabled = 1 << 0,
+            FlagStatic = 1 << 1,
+            FlagCastShadows = 1 << 2,
+            FlagReceiveShadows = 1 << 3,
+            FlagGenerateShadows = 1 << 4,
+            FlagSdf = 1 << 5
+        };
+
+        struct ModelBlob
+        {
+            uint32_t mesh;
+            uint32_t material;
+            uint32_t flags;
+        };
+
+        struct LightBlob
+        {
+            uint32_t type;
+            uint32_t flags;
+            float color[3];
+            float intensity;
+        };
+
+        struct CameraBlob
+        {
+            uint32_t clearType;
+            uint32_t flags;
+            float fieldOfView;
+            float nearClip;
+            float farClip;
+            float clearColor[3];
+        };
+
+        struct TextBlob
+        {
+            uint32_t text;
+            uint32_t font;
+            uint32_t pixelSize;
+            uint32_t style;
+            uint32_t flags;
+            float screenPosition[2];
+            float backgroundColor[3];
+            float textColor[3];
+            float underlineColor[3];
+            float overlineColor[3];
+            float strikeThroughColor[3];
+        };
+
+        void storeVec(float* out, const glm::vec3& value)
+        {
+            out[0] = value.x; out[1] = value.y; out[2] = value.z;
+        }
+
+        glm::vec3 loadVec(const float* in)
+        {
+            return glm::vec3(in[0], in[1], in[2]);
+        }
+
+        uint32_t flag(bool value, ModuleFlags bit)
+        {
+            return value ? bit : 0;
+        }
+
+        class SceneWriter
+        {
+        private:
+            std::string m_Strings;
+            std::unordered_map<std::string, uint32_t> m_StringOffsets;
+            std::vector<FileNode> m_Nodes;
+            std::vector<uint8_t> m_Modules;
+            uint32_t m_ModuleCount = 0;
+
+        public:
+            SceneWriter() : m_Strings(1, '\0') {}
+
+            uint32_t addString(const std::string& value)
+            {
+                if (value.empty()) return 0;
+
+                auto it = m_StringOffsets.find(value);
+                if (it != m_StringOffsets.end()) return it->second;
+
+                uint32_t offset = static_cast<uint32_t>(m_Strings.size());
+                m_Strings.append(value);
+                m_Strings.push_back('\0');
+                m_StringOffsets.emplace(value, offset);
+                return offset;
+            }
+
+            uint32_t addNode(SceneNodePtr node, uint32_t parent)
+            {
+                Transform& transform = node->getTransform();
+
+                FileNode fileNode;
+                fileNode.parent = parent;
+                fileNode.name = addString(node->name);
+                fileNode.active = node->getAcive() ? 1 : 0;
+                storeVec(fileNode.position, transform.position());
+                storeVec(fileNode.euler, transform.euler());
+                storeVec(fileNode.scale, transform.scale());
+
+                m_Nodes.push_back(fileNode);
+                return static_cast<uint32_t>(m_Nodes.size() - 1);
+            }
+
+            template <class T>
+            void addModule(uint32_t node, SerializedModule type, const T& blob)
+            {
+                FileModule record = { node, type, static_cast<uint32_t>(sizeof(T)) };
+
+                size_t offset = m_Modules.size();
+                m_Modules.resize(offset + sizeof(FileModule) + sizeof(T));
+                std::memcpy(m_Modules.data() + offset, &record, sizeof(FileModule));
+                std::memcpy(m_Modules.data() + offset + sizeof(FileModule), &blob, sizeof(T));
+                m_ModuleCount++;
+            }
+
+            bool write(const std::string& fileName) const
+            {
+                std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) return false;
+
+                FileHeader header;
+                std::memcpy(header.magic, s_Magic, sizeof(s_Magic));
+                header.version = SceneSerializer::version;
+                header.nodeCount = static_cast<uint32_t>(m_Nodes.size());
+                header.moduleCount = m_ModuleCount;
+                header.stringBytes = static_cast<uint32_t>(m_Strings.size());
+
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(m_Strings.data(), m_Strings.size());
+                file.write(reinterpret_cast<const char*>(m_Nodes.data()), m_Nodes.size() * sizeof(FileNode));
+                file.write(reinterpret_cast<const char*>(m_Modules.data()), m_Modules.size());
+
+                return file.good();
+            }
+        };
+
+        void writeModules(SceneWriter& writer, SceneNodePtr node, uint32_t index)
+        {
+            AssetManager* assetManager = ServiceProvider::getAssetManager();
+
+            if (Model* model = node->getModule<Model>())
+            {
+                std::shared_ptr<Material> material = model->getMaterial();
+
+                ModelBlob blob;
+                blob.mesh = writer.addString(assetManager->getAssetName(model->getMeshGroup()));
+                blob.material = writer.addString(material != nullptr ? material->getName() : "");
+                blob.flags = flag(model->enabled, FlagEnabled) | flag(model->isStatic, FlagStatic)
+                    | flag(model->castShadows, FlagCastShadows) | flag(model->receiveShadows, FlagReceiveShadows);
+                writer.addModule(index, SerializedModule::Model, blob);
+            }
+
+            if (Light* light = node->getModule<Light>())
+            {
+                LightBlob blob;
+                blob.type = static_cast<uint32_t>(light->type);
+                blob.flags = flag(light->enabled, FlagEnabled) | flag(light->isStatic, FlagStatic)
+                    | flag(light->generateShadows, FlagGenerateShadows);
+                storeVec(blob.color, light->color);
+                blob.intensity = light->intensity;
+                writer.addModule(index, SerializedModule::Light, blob);
+            }
+
+            if (Camera* camera = node->getModule<Camera>())
+            {
+                CameraBlob blob;
+                blob.clearType = static_cast<uint32_t>(camera->clearType);
+                blob.flags = flag(camera->enabled, FlagEnabled) | flag(camera->isStatic, FlagStatic);
+                blob.fieldOfView = camera->fieldOfView;
+                blob.nearClip = camera->nearClip;
+                blob.farClip = camera->farClip;
+                storeVec(blob.clearColor, camera->clearColor);
+                writer.addModule(index, SerializedModule::Camera, blob);
+            }
+
+            if (Text* text = node->getModule<Text>())
+            {
+                TextBlob blob;
+                blob.text = writer.addString(text->getText());
+                blob.font = writer.addString(assetManager->getFontName(text->getFont()));
+                blob.pixelSize = text->getPixelSize();
+                blob.style = static_cast<uint32_t>(text->getStyle());
+                blob.flags = flag(text->enabled, FlagEnabled) | flag(text->isStatic(), FlagStatic) | flag(text->isSdf(), FlagSdf);
+                blob.screenPosition[0] = text->getScreenPosition().x;
+                blob.screenPosition[1] = text->getScreenPosition().y;
+                storeVec(blob.backgroundColor, text->getBackgroundColor());
+                storeVec(blob.textColor, text->getTextColor());
+                storeVec(blob.underlineColor, text->getUnderlineColor());
+                storeVec(blob.overlineColor, text->getOverlineColor());
+                storeVec(blob.strikeThroughColor, text->getStrikeThroughColor());
+                writer.addModule(index, SerializedModule::Text, blob);
+            }
+        }
+
+        class SceneReader
+        {
+        private:
+            const std::vector<uint8_t>& m_Data;
+            size_t m_Cursor = 0;
+
+        public:
+            SceneReader(const std::vector<uint8_t>& data) : m_Data(data) {}
+
+            size_t getCursor() const { return m_Cursor; }
+
+            const uint8_t* readBytes(size_t size)
+            {
+                if (size > m_Data.size() - m_Cursor) return nullptr;
+
+                const uint8_t* pointer = m_Data.data() + m_Cursor;
+                m_Cursor += size;
+                return pointer;
+            }
+
+            template <class T>
+            bool read(T& value)
+            {
+                const uint8_t* pointer = readBytes(sizeof(T));
+                if (pointer == nullptr) return false;
+
+                std::memcpy(&value, pointer, sizeof(T));
+                return true;
+            }
+        };
+
+        void readModel(Scene* scene, SceneNodePtr node, const ModelBlob& blob, const char* strings)
+        {
+            Model* model = node->addModule<Model>();
+            if (model == nullptr) return;
+
+            model->enabled = (blob.flags & FlagEnabled) != 0;
+            model->isStatic = (blob.flags & FlagStatic) != 0;
+            model->castShadows = (blob.flags & FlagCastShadows) != 0;
+            model->receiveShadows = (blob.flags & FlagReceiveShadows) != 0;
+
+            std::string meshName = strings + blob.mesh;
+            std::string materialName = strings + blob.material;
+
+            // Procedural meshes have no asset name, the application has to provide them again.
+            if (meshName.empty()) return;
+
+            if (!ServiceProvider::getAssetManager()->hasAsset(meshName))
+            {
+                ANNILEEN_LOGF_WARNING(LoggingChannel::Asset, "Scene node '{}' refers to mesh '{}', which is not in the asset table.", node->name, meshName);
+                return;
+            }
+
+            std::shared_ptr<Material> material = scene->resolveMaterial(materialName);
+            if (material == nullptr)
+            {
+                ANNILEEN_LOGF_WARNING(LoggingChannel::Asset, "Scene node '{}' refers to material '{}', which the scene could not resolve.", node->name, materialName);
+                return;
+            }
+
+            // Loaded in the background, the model draws nothing until the mesh is in.
+            model->init(ServiceProvider::getAssetManager()->acquireMesh(meshName, true), material);
+        }
+
+        void readLight(SceneNodePtr node, const LightBlob& blob)
+        {
+            Light* light = node->addModule<Light>();
+            if (light == nullptr) return;
+
+            light->type = static_cast<LightType>(blob.type);
+            light->enabled = (blob.flags & FlagEnabled) != 0;
+            light->isStatic = (blob.flags & FlagStatic) != 0;
+            light->generateShadows = (blob.flags & FlagGenerateShadows) != 0;
+            light->color = loadVec(blob.color);
+            light->intensity = blob.intensity;
+        }
+
+        void readCamera(SceneNodePtr node, const CameraBlob& blob)
+        {
+            Camera* camera = node->addModule<Camera>();
+            if (camera == nullptr) return;
+
+            camera->clearType = static_cast<CameraClearType>(blob.clearType);
+            camera->enabled = (blob.flags & FlagEnabled) != 0;
+            camera->isStatic = (blob.flags & FlagStatic) != 0;
+            camera->fieldOfView = blob.fieldOfView;
+            camera->nearClip = blob.nearClip;
+            camera->farClip = blob.farClip;
+            camera->clearColor = loadVec(blob.clearColor);
+        }
+
+        void readText(SceneNodePtr node, const TextBlob& blob, const char* strings)
+        {
+            Text* text = node->addModule<Text>();
+            if (text == nullptr) return;
+
+            text->init((blob.flags & FlagStatic) != 0, (blob.flags & FlagSdf) != 0);
+            text->enabled = (blob.flags & FlagEnabled) != 0;
+
+            std::string fontName = strings + blob.font;
+            if (!fontName.empty() && ServiceProvider::getAssetManager()->hasAsset(fontName))
+            {
+                text->setFont(ServiceProvider::getAssetManager()->acquireFont(fontName, true));
+            }
+
+            text->setPixelSize(blob.pixelSize);
+            text->setScreenPosition(blob.screenPosition[0], blob.screenPosition[1]);
+            text->setBackgroundColor(loadVec(blob.backgroundColor));
+            text->setTextColor(loadVec(blob.textColor));
+            text->setUnderlineColor(loadVec(blob.underlineColor));
+            text->setOverlineColor(loadVec(blob.overlineColor));
+            text->setStrikeThroughColor(loadVec(blob.strikeThroughColor));
+            text->setStyle(static_cast<Text::TextStyle>(blob.style));
+            text->setText(strings + blob.text);
+        }
+
+        // Payloads can grow in later versions, only the part this build knows is read.
+        template <class T>
+        bool readBlob(const uint8_t* payload, uint32_t size, T& blob)
+        {
+            if (size < sizeof(T)) return false;
+
+            std::memcpy(&blob, payload, sizeof(T));
+            return true;
+        }
+    }
+
+    bool SceneSerializer::save(Scene* scene, const std::string& fileName)
+    {
+        ANNILEEN_PROFILE_FUNCTION();
+
+        SceneWriter writer;
+
+        // Breadth first, so a node is always written after its parent and siblings keep their order.
+        std::vector<std::pair<SceneNodePtr, uint32_t>> pending;
+        for (SceneNodePtr child = scene->getRoot()->getFirstChild(); child != nullptr; child = child->getNextSibling())
+        {
+            pending.emplace_back(child, s_NoParent);
+        }
+
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            SceneNodePtr node = pending[i].first;
+            uint32_t index = writer.addNode(node, pending[i].second);
+            writeModules(writer, node, index);
+
+            for (SceneNodePtr child = node->getFirstChild(); child != nullptr; child = child->getNextSibling())
+            {
+                pending.emplace_back(child, index);
+            }
+        }
+
+        if (!writer.write(fileName))
+        {
+            ANNILEEN_LOGF_ERROR(LoggingChannel::Core, "Could not write scene to '{}'.", fileName);
+            return false;
+        }
+
+        ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Scene saved to '{}' ({} nodes).", fileName, pending.size());
+        return true;
+    }
+
+    bool SceneSerializer::read(const std::string& fileName, SceneData& data)
+    {
+        ANNILEEN_PROFILE_FUNCTION();
+
+        data = SceneData();
+        data.fileName = fileName;
+
+        // The whole file is read at once, everything else works on memory.
+        std::ifstream file(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            data.error = fmt::format("Could not open scene '{}'.", fileName);
+            return false;
+        }
+
+        data.bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.bytes.data()), data.bytes.size());
+        if (!file)
+        {
+            data.error = fmt::format("Could not read scene '{}'.", fileName);
+            return false;
+        }
+
+        SceneReader reader(data.bytes);
+
+        FileHeader header;
+        if (!reader.read(header) || std::memcmp(header.magic, s_Magic, sizeof(s_Magic)) != 0)
+        {
+            data.error = fmt::format("'{}' is not a scene file.", fileName);
+            return false;
+        }
+
+        if (header.version > version)
+        {
+            data.error = fmt::format("Scene '{}' has version {}, this build reads up to version {}.", fileName, header.version, version);
+            return false;
+        }
+
+        const uint8_t* strings = reader.readBytes(header.stringBytes);
+        const uint8_t* nodes = reader.readBytes(static_cast<size_t>(header.nodeCount) * sizeof(FileNode));
+        if (strings == nullptr || header.stringBytes == 0 || strings[header.stringBytes - 1] != '\0' || nodes == nullptr)
+        {
+            data.error = fmt::format("Scene '{}' is truncated or corrupted.", fileName);
+            return false;
+        }
+
+        data.nodeCount = header.nodeCount;
+        data.stringsOffset = strings - data.bytes.data();
+        data.stringBytes = header.stringBytes;
+        data.nodesOffset = nodes - data.bytes.data();
+
+        data.moduleOffsets.reserve(header.moduleCount);
+        for (uint32_t i = 0; i < header.moduleCount; ++i)
+        {
+            const size_t recordOffset = reader.getCursor();
+            FileModule record;
+            if (!reader.read(record) || reader.readBytes(record.size) == nullptr)
+            {
+                data.error = fmt::format("Scene '{}' is truncated, {} of {} modules can be loaded.", fileName, i, header.moduleCount);
+                data.nodeCount = 0;
+                data.moduleOffsets.clear();
+                return false;
+            }
+
+            if (record.node < header.nodeCount)
+            {
+                data.moduleOffsets.push_back(recordOffset);
+            }
+        }
+
+        return true;
+    }
+
+    bool SceneSerializer::instantiate(Scene* scene, SceneData& data, size_t maxNodes)
+    {
+        ANNILEEN_PROFILE_FUNCTION();
+
+        const char* strings = reinterpret_cast<const char*>(data.bytes.data() + data.stringsOffset);
+        // Offsets out of the table read as the empty string.
+        auto validString = [&data](uint32_t offset) { return offset < data.stringBytes ? offset : 0; };
+
+        if (data.nextNode == 0)
+        {
+            scene->reserveNodes(scene->getNodeList().size() + data.nodeCount);
+            data.nodes.assign(data.nodeCount, nullptr);
+        }
+
+        const size_t endNode = data.nextNode + std::min(maxNodes, data.nodeCount - data.nextNode);
+        for (; data.nextNode < endNode; ++data.nextNode)
+        {
+            const size_t i = data.nextNode;
+
+            FileNode fileNode;
+            std::memcpy(&fileNode, data.bytes.data() + data.nodesOffset + i * sizeof(FileNode), sizeof(FileNode));
+
+            SceneNodePtr node = scene->createNode(strings + validString(fileNode.name));
+            if (fileNode.parent < i)
+            {
+                node->setParent(data.nodes[fileNode.parent]);
+            }
+            else
+            {
+                data.roots.push_back(node->getHandle());
+            }
+
+            node->setAcive(fileNode.active != 0);
+
+            Transform& transform = node->getTransform();
+            transform.position(loadVec(fileNode.position));
+            transform.euler(loadVec(fileNode.euler));
+            transform.scale(loadVec(fileNode.scale));
+
+            data.nodes[i] = node;
+        }
+
+        // Modules are written in node order, add the ones whose node exists now.
+        for (; data.nextModule < data.moduleOffsets.size(); ++data.nextModule)
+        {
+            const uint8_t* recordData = data.bytes.data() + data.moduleOffsets[data.nextModule];
+
+            FileModule record;
+            std::memcpy(&record, recordData, sizeof(FileModule));
+            if (record.node >= data.nextNode) break;
+
+            SceneNodePtr node = data.nodes[record.node];
+            const uint8_t* payload = recordData + sizeof(FileModule);
+
+            switch (record.type)
+            {
+            case SerializedModule::Model:
+            {
+                ModelBlob blob;
+                if (!readBlob(payload, record.size, blob)) break;
+                blob.mesh = validString(blob.mesh);
+                blob.material = validString(blob.material);
+                readModel(scene, node, blob, strings);
+                break;
+            }
+            case SerializedModule::Light:
+            {
+                LightBlob blob;
+                if (readBlob(payload, record.size, blob)) readLight(node, blob);
+                break;
+            }
+            case SerializedModule::Camera:
+            {
+                CameraBlob blob;
+                if (readBlob(payload, record.size, blob)) readCamera(node, blob);
+                break;
+            }
+            case SerializedModule::Text:
+            {
+                TextBlob blob;
+                if (!readBlob(payload, record.size, blob)) break;
+                blob.text = validString(blob.text);
+                blob.font = validString(blob.font);
+                readText(node, blob, strings);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        return data.isInstantiated();
+    }
+
+    bool SceneSerializer::load(Scene* scene, const std::string& fileName)
+    {
+        SceneData data;
+        if (!read(fileName, data))
+        {
+            ANNILEEN_LOG_ERROR(LoggingChannel::Core, data.error);
+            return false;
+        }
+
+        instantiate(scene, data);
+
+        ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Scene loaded from '{}' ({} nodes, {} modules).", fileName, data.nodeCount, data.moduleOffsets.size());
+        return true;
+    }
+}
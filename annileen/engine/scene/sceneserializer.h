@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <engine/scenenode.h>
+
+namespace annileen
+{
+    class Scene;
+
+    // A scene file read into memory and checked. Reading touches no engine state, so it can
+    // run on any thread; SceneSerializer::instantiate() then creates the nodes on the main thread.
+    struct SceneData
+    {
+        std::string fileName;
+        std::vector<uint8_t> bytes;
+        // Set when reading fails, the Logger can't be used off the main thread.
+        std::string error;
+
+        uint32_t nodeCount = 0;
+        size_t stringsOffset = 0;
+        size_t stringBytes = 0;
+        size_t nodesOffset = 0;
+        std::vector<size_t> moduleOffsets;
+
+        // Instantiation progress.
+        std::vector<SceneNodePtr> nodes;
+        size_t nextNode = 0;
+        size_t nextModule = 0;
+        // Top level nodes created so far, destroying them removes everything the file added.
+        std::vector<SceneNodeHandle> roots;
+
+        bool isInstantiated() const { return nextNode == nodeCount && nextModule == moduleOffsets.size(); }
+    };
+
+    // Binary scene files (.anscene). The layout, all little endian:
+    //   header       magic "ANSC", version, node count, module count, string table size
+    //   strings      zero terminated strings, referenced by byte offset (0 is the empty string)
+    //   nodes        flat node table in breadth first order, every parent comes before its children
+    //   modules      one record per module: node index, type, payload size, then the payload
+    // Asset references (meshes, fonts) are stored by asset name and resolved by the AssetManager
+    // on load, materials by name through Scene::resolveMaterial(). Unknown module types are
+    // skipped, so older builds can read files with newer modules.
+    class SceneSerializer final
+    {
+    public:
+        static constexpr uint32_t version = 1;
+
+        static bool save(Scene* scene, const std::string& fileName);
+
+        static bool read(const std::string& fileName, SceneData& data);
+        // Creates up to maxNodes more nodes of the file under the scene root, with their modules.
+        // Returns true once everything is created.
+        static bool instantiate(Scene* scene, SceneData& data, size_t maxNodes = SIZE_MAX);
+
+        // read() and instantiate() in one go. Appends the file contents under the scene root.
+        static bool load(Scene* scene, const std::string& fileName);
+
+    private:
+        SceneSerializer() = delete;
+    };
+}
@@ -0,0 +1,89 @@
+#include <engine/scene/transformstorage.h>
+#include <engine/core/jobsystem.h>
+
+#include <gtc/matrix_transform.hpp>
+
+namespace annileen
+{
+    // Fewer slots than this are cheaper to walk than to hand out as jobs.
+    static constexpr size_t s_MinSlotsPerJob = 1024;
+
+    uint32_t TransformStorage::allocate()
+    {
+        uint32_t slot;
+        if (!m_FreeSlots.empty())
+        {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(m_Positions.size());
+            m_Positions.emplace_back();
+            m_Eulers.emplace_back();
+            m_Rotations.emplace_back();
+            m_Scales.emplace_back();
+            m_LocalMatrices.emplace_back();
+            m_WorldMatrices.emplace_back();
+            m_LocalDirty.emplace_back();
+        }
+
+        m_Positions[slot] = glm::vec3(0.0f);
+        m_Eulers[slot] = glm::vec3(0.0f);
+        m_Rotations[slot] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        m_Scales[slot] = glm::vec3(1.0f);
+        m_LocalMatrices[slot] = glm::mat4(1.0f);
+        m_WorldMatrices[slot] = glm::mat4(1.0f);
+        m_LocalDirty[slot] = 0;
+
+        return slot;
+    }
+
+    void TransformStorage::free(uint32_t slot)
+    {
+        m_LocalDirty[slot] = 0;
+        m_FreeSlots.push_back(slot);
+    }
+
+    void TransformStorage::reserve(size_t count)
+    {
+        m_Positions.reserve(count);
+        m_Eulers.reserve(count);
+        m_Rotations.reserve(count);
+        m_Scales.reserve(count);
+        m_LocalMatrices.reserve(count);
+        m_WorldMatrices.reserve(count);
+        m_LocalDirty.reserve(count);
+    }
+
+    void TransformStorage::updateLocalMatrix(uint32_t slot)
+    {
+        m_Rotations[slot] = glm::quat(glm::radians(m_Eulers[slot]));
+
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), m_Positions[slot]);
+        local *= glm::mat4_cast(m_Rotations[slot]);
+        m_LocalMatrices[slot] = glm::scale(local, m_Scales[slot]);
+
+        m_LocalDirty[slot] = 0;
+    }
+
+    void TransformStorage::updateLocalMatrices(JobSystem* jobs)
+    {
+        auto update = [this](size_t begin, size_t end)
+        {
+            for (size_t slot = begin; slot < end; ++slot)
+            {
+                if (m_LocalDirty[slot]) updateLocalMatrix(static_cast<uint32_t>(slot));
+            }
+        };
+
+        if (jobs != nullptr)
+        {
+            jobs->parallelFor(size(), s_MinSlotsPerJob, update);
+        }
+        else
+        {
+            update(0, size());
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+namespace annileen
+{
+    class JobSystem;
+
+    // Position, rotation, scale and matrices of every Transform in a scene, one array per
+    // field, indexed by the slot of the transform. Passes over many transforms walk the
+    // arrays in order instead of following nodes around the heap. Slots of destroyed
+    // transforms are reused.
+    class TransformStorage final
+    {
+    private:
+        std::vector<glm::vec3> m_Positions;
+        // Rotation as set, in degrees. m_Rotations is derived from it with the local matrix.
+        std::vector<glm::vec3> m_Eulers;
+        std::vector<glm::quat> m_Rotations;
+        std::vector<glm::vec3> m_Scales;
+        std::vector<glm::mat4> m_LocalMatrices;
+        std::vector<glm::mat4> m_WorldMatrices;
+        // Bytes rather than std::vector<bool>, slots are cleared from several threads at once.
+        std::vector<uint8_t> m_LocalDirty;
+        std::vector<uint32_t> m_FreeSlots;
+
+        void updateLocalMatrix(uint32_t slot);
+
+        friend class Transform;
+
+    public:
+        // Returns a slot at the origin, unrotated and unscaled.
+        uint32_t allocate();
+        void free(uint32_t slot);
+        // Grows the arrays so allocating up to count slots does not reallocate them.
+        void reserve(size_t count);
+        // Slots in use and free alike.
+        size_t size() const { return m_Positions.size(); }
+
+        // Rebuilds the local matrix of every slot whose position, rotation or scale changed,
+        // in slot order, spread over the job system when there is one.
+        void updateLocalMatrices(JobSystem* jobs);
+
+        // World matrices as of the last update, indexed by slot.
+        const std::vector<glm::mat4>& getWorldMatrices() const { return m_WorldMatrices; }
+    };
+}
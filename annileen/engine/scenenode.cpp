@@ -1,23 +1,50 @@
-#include <algorithm>
 #include <engine/scenenode.h>
 #include <engine/scene.h>
 #include <engine/serviceprovider.h>
 
 namespace annileen
 {
-	size_t SceneNode::m_IdCount = 0;
+	SceneNode::SceneNode(const std::string& name, TransformStorage& transforms) : m_Transform(transforms), m_Parent(nullptr), m_ParentScene(nullptr), m_FirstChild(nullptr), m_LastChild(nullptr),
+		m_PrevSibling(nullptr), m_NextSibling(nullptr), m_ChildCount(0), m_Active(true), m_NodeListIndex(0), m_Modules(), m_ModuleMask(0), name(name)
+	{
+	}
 
-	SceneNode::SceneNode(const std::string& name) : m_ParentScene(nullptr), m_Parent(nullptr), m_Active(true), name(name)
+	void SceneNode::unlink()
 	{
-		m_Id = m_IdCount++;
+		if (m_Parent == nullptr) return;
+
+		if (m_PrevSibling != nullptr) m_PrevSibling->m_NextSibling = m_NextSibling;
+		else m_Parent->m_FirstChild = m_NextSibling;
+
+		if (m_NextSibling != nullptr) m_NextSibling->m_PrevSibling = m_PrevSibling;
+		else m_Parent->m_LastChild = m_PrevSibling;
+
+		m_PrevSibling = nullptr;
+		m_NextSibling = nullptr;
+		m_Parent->m_ChildCount--;
+	}
+
+	void SceneNode::linkBefore(SceneNodePtr sibling)
+	{
+		// A null sibling links this node as the last child.
+		m_NextSibling = sibling;
+		m_PrevSibling = sibling != nullptr ? sibling->m_PrevSibling : m_Parent->m_LastChild;
+
+		if (m_PrevSibling != nullptr) m_PrevSibling->m_NextSibling = this;
+		else m_Parent->m_FirstChild = this;
+
+		if (sibling != nullptr) sibling->m_PrevSibling = this;
+		else m_Parent->m_LastChild = this;
+
+		m_Parent->m_ChildCount++;
 	}
 
 	void SceneNode::deParent()
 	{
-		if (m_Parent != nullptr)
-			m_Parent->m_Children.erase(
-				std::remove(m_Parent->m_Children.begin(), m_Parent->m_Children.end(), this),
-				m_Parent->m_Children.end());
+		unlink();
+		m_Parent = nullptr;
+
+		m_Transform.setParent(nullptr);
 	}
 
 	void SceneNode::setParentScene(Scene* scene)
@@ -45,7 +72,8 @@ namespace annileen
 		else
 			m_Parent = m_ParentScene->getRoot();
 
-		m_Parent->m_Children.push_back(this);
+		linkBefore(nullptr);
+		m_Transform.setParent(&m_Parent->m_Transform);
 	}
 
 	SceneNodePtr SceneNode::getParent()
@@ -55,7 +83,15 @@ namespace annileen
 
 	std::vector<SceneNodePtr> SceneNode::getChildren()
 	{
-		return m_Children;
+		std::vector<SceneNodePtr> children;
+		children.reserve(m_ChildCount);
+
+		for (SceneNodePtr child = m_FirstChild; child != nullptr; child = child->m_NextSibling)
+		{
+			children.push_back(child);
+		}
+
+		return children;
 	}
 
 	Transform& SceneNode::getTransform()
@@ -65,36 +101,49 @@ namespace annileen
 
 	void SceneNode::setSiblingIndex(size_t index)
 	{
-		index = std::min(index, m_Parent->m_Children.size() - 1);
-		setSiblingPosition(m_Parent->m_Children.begin() + index);
+		if (m_Parent == nullptr) return;
+
+		unlink();
+
+		SceneNodePtr sibling = m_Parent->m_FirstChild;
+		for (size_t i = 0; i < index && sibling != nullptr; ++i)
+		{
+			sibling = sibling->m_NextSibling;
+		}
+
+		linkBefore(sibling);
 	}
 
-	void SceneNode::setSiblingPosition(std::vector<SceneNodePtr>::iterator position)
+	void SceneNode::moveBefore(SceneNodePtr sibling)
 	{
-		std::rotate(position, getSiblingIterator(), m_Parent->m_Children.end());
+		if (sibling == nullptr || sibling == this || sibling->m_Parent != m_Parent || m_Parent == nullptr) return;
+
+		unlink();
+		linkBefore(sibling);
 	}
 
-	std::vector<SceneNodePtr>::iterator SceneNode::getSiblingIterator()
+	void SceneNode::moveAfter(SceneNodePtr sibling)
 	{
-		auto it = std::find(m_Parent->m_Children.begin(), m_Parent->m_Children.end(), this);
-		return it;
+		if (sibling == nullptr || sibling == this || sibling->m_Parent != m_Parent || m_Parent == nullptr) return;
+
+		unlink();
+		linkBefore(sibling->m_NextSibling);
 	}
 
 	size_t SceneNode::getSiblingIndex()
 	{
-		return std::distance(
-			m_Parent->m_Children.begin(),
-			std::find(m_Parent->m_Children.begin(), m_Parent->m_Children.end(), this));
-	}
+		size_t index = 0;
+		for (SceneNodePtr sibling = m_PrevSibling; sibling != nullptr; sibling = sibling->m_PrevSibling)
+		{
+			++index;
+		}
 
-	std::vector<SceneNodePtr>::iterator SceneNode::findChild(SceneNodePtr node)
-	{
-		return std::find(m_Children.begin(), m_Children.end(), node);
+		return index;
 	}
 
 	bool SceneNode::hasChild(SceneNodePtr node)
 	{
-		return findChild(node) != m_Children.end();
+		return node != nullptr && node->m_Parent == this;
 	}
 
 
@@ -105,47 +154,49 @@ namespace annileen
 			m_ParentScene->removeNodeFromList(this);
 		}
 
-		for (auto child : m_Children)
+		// Each child unlinks itself from this node when destroyed.
+		while (m_FirstChild != nullptr)
 		{
-			if (child != nullptr)
+			if (m_ParentScene != nullptr)
+			{
+				m_ParentScene->destroyNode(m_FirstChild);
+			}
+			else
 			{
-				m_ParentScene->destroyNode(child);
+				delete m_FirstChild;
 			}
 		}
-
-		m_Children.clear();
 	
-		for (auto moduleIt : m_Modules)
+		for (ModuleTypeId typeId = 0; typeId < ModuleType::maxTypes && (m_ModuleMask >> typeId) != 0; ++typeId)
 		{
-			SceneNodeModulePtr sceneNodeModule = moduleIt.second;
+			SceneNodeModulePtr sceneNodeModule = m_Modules[typeId];
+			if (sceneNodeModule == nullptr) continue;
 
-			if (sceneNodeModule != nullptr)
+			if (m_ParentScene != nullptr)
 			{
-				if (m_ParentScene != nullptr)
+				if (typeId == ModuleType::id<Camera>())
 				{
-					if (moduleIt.first == typeid(Camera))
-					{
-						Camera* camera = static_cast<Camera*>(sceneNodeModule);
-						m_ParentScene->m_Cameras.remove(camera);
-						camera = nullptr;
-					}
-					else if (moduleIt.first == typeid(Light))
-					{
-						Light* light = static_cast<Light*>(sceneNodeModule);
-						m_ParentScene->m_Lights.remove(light);
-						light = nullptr;
-					}
+					m_ParentScene->m_Cameras.remove(static_cast<Camera*>(sceneNodeModule));
+				}
+				else if (typeId == ModuleType::id<Light>())
+				{
+					m_ParentScene->m_Lights.remove(static_cast<Light*>(sceneNodeModule));
 				}
 
+				m_ParentScene->destroyModule(typeId, sceneNodeModule);
+			}
+			else
+			{
 				delete sceneNodeModule;
-				sceneNodeModule = nullptr;
 			}
+
+			m_Modules[typeId] = nullptr;
 		}
 
 		deParent();
 		setParentScene(nullptr);
 
-		m_Modules.clear();
+		m_ModuleMask = 0;
 
 		m_Parent = nullptr;
 		m_ParentScene = nullptr;
@@ -2,13 +2,12 @@
 
 #include <iostream>
 #include <vector>
-#include <unordered_map>
-#include <typeindex>
-#include <typeinfo>
 #include <memory>
+#include <cstdint>
 
 #include <engine/transform.h>
 #include <engine/model.h>
+#include <engine/scene/moduletype.h>
 
 namespace annileen
 {
@@ -22,56 +21,89 @@ namespace annileen
 
 	// TODO: move this kind of defs to separate header
 	typedef SceneNode* SceneNodePtr;
+
+	// Refers to a node slot in its Scene. A handle goes stale once the node is destroyed,
+	// even if the slot is reused by a new node.
+	struct SceneNodeHandle
+	{
+		uint32_t index = UINT32_MAX;
+		uint32_t generation = 0;
+
+		bool isValid() const { return index != UINT32_MAX; }
+		bool operator==(const SceneNodeHandle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const SceneNodeHandle& other) const { return !(*this == other); }
+	};
 	
 	class SceneNode final
 	{
 
 	private:
 		Transform m_Transform;
-		std::vector<SceneNodePtr> m_Children;
 		SceneNodePtr m_Parent;
 		Scene* m_ParentScene;
 
+		// Children are an intrusive doubly linked list, so linking and unlinking is O(1).
+		SceneNodePtr m_FirstChild;
+		SceneNodePtr m_LastChild;
+		SceneNodePtr m_PrevSibling;
+		SceneNodePtr m_NextSibling;
+		size_t m_ChildCount;
+
 		bool m_Active;
-		size_t m_Id;
 
-		std::unordered_map<std::type_index, SceneNodeModule*> m_Modules;
+		// Slot in the parent scene and position in its node list, both set by the Scene.
+		SceneNodeHandle m_Handle;
+		size_t m_NodeListIndex;
 
-		// TODO: this is temporary id, not safe, not ideal. Replace someday.
-		static size_t m_IdCount;
+		// Indexed by ModuleTypeId, with a bit set in the mask for every module present.
+		SceneNodeModule* m_Modules[ModuleType::maxTypes];
+		ModuleMask m_ModuleMask;
 
 		void deParent();
+		void unlink();
+		void linkBefore(SceneNodePtr sibling);
+
+		// A node belongs to the scene that created it for its whole life, its memory and its
+		// modules come from that scene's pools.
+		void setParentScene(Scene* scene);
 
-		SceneNode(const std::string& name);
+		SceneNode(const std::string& name, TransformStorage& transforms);
 
 		friend class Scene;
 
 	public:
 		std::string name = "SceneNode";
 		
-		void setParentScene(Scene* scene);
 		void setParent(SceneNodePtr node);
 		SceneNodePtr getParent();
 		Scene* getParentScene() { return m_ParentScene; }
 		std::vector<SceneNodePtr> getChildren();
+		SceneNodePtr getFirstChild() const { return m_FirstChild; }
+		SceneNodePtr getNextSibling() const { return m_NextSibling; }
+		SceneNodePtr getPrevSibling() const { return m_PrevSibling; }
+		size_t getChildCount() const { return m_ChildCount; }
 
 		void setAcive(bool active) { m_Active = active; }
 		bool getAcive() { return m_Active; }
 
-		size_t getId() { return m_Id; };
+		SceneNodeHandle getHandle() const { return m_Handle; }
+		// Unique among every node the scene ever had, a recreated node never gets the id of a destroyed one.
+		uint64_t getId() const { return (static_cast<uint64_t>(m_Handle.generation) << 32) | m_Handle.index; }
 
 		Transform& getTransform();
 
 		void setSiblingIndex(size_t index);
-		void setSiblingPosition(std::vector<SceneNodePtr>::iterator position);
+		// Moves this node right before or after a sibling. Both must share the same parent.
+		void moveBefore(SceneNodePtr sibling);
+		void moveAfter(SceneNodePtr sibling);
 
-		std::vector<SceneNodePtr>::iterator getSiblingIterator();
 		size_t getSiblingIndex();
 
-		std::vector<SceneNodePtr>::iterator findChild(SceneNodePtr node);
 		bool hasChild(SceneNodePtr node);
 		
 		template <class T> T* getModule() const;
+		template <class T> bool hasModule() const { return (m_ModuleMask & ModuleType::mask<T>()) != 0; }
+		ModuleMask getModuleMask() const { return m_ModuleMask; }
 		template <class T> T* addModule();
 		template <class T> bool removeModule();
 
@@ -83,84 +115,10 @@ namespace annileen
 	template <class T>
 	T* SceneNode::getModule() const
 	{
-		auto moduleIt = m_Modules.find(typeid(T));
-
-		if (moduleIt != m_Modules.end())
-		{
-			return static_cast<T*>(moduleIt->second);
-		}
-
-		return nullptr;
+		const ModuleTypeId typeId = ModuleType::id<T>();
+		return typeId < ModuleType::maxTypes ? static_cast<T*>(m_Modules[typeId]) : nullptr;
 	}
 
-	template <class T>
-	T* SceneNode::addModule()
-	{
-		if (!std::is_base_of<SceneNodeModule, T>::value)
-		{
-			//ANNILEEN_LOGF_ERROR(LoggingChannel::General, "\"{0}\" cannot be added because it is not a module.", typeid(T).name());
-			return nullptr;
-		}
-
-		auto moduleIt = m_Modules.find(typeid(T));
-
-		if (moduleIt != m_Modules.end())
-		{
-			//ANNILEEN_LOG_ERROR(LoggingChannel::General, "This SceneNode has a Module of this type already. Remove the existing module before adding a new one of the same type.");
-			return nullptr;
-		}
-
-		T* module = new T();
-
-		m_Modules[typeid(T)] = static_cast<SceneNodeModulePtr>(module);
-
-		module->m_SceneNode = this;
-
-		// "if constexpr" is a C++17 thing.
-		if constexpr (std::is_same<T, Camera>::value)
-		{
-			m_ParentScene->m_Cameras.push_back(module);
-		}
-		else if constexpr (std::is_same<T, Light>::value)
-		{
-			m_ParentScene->m_Lights.push_back(module);
-		}
-
-		return module;
-	}
-
-	template <class T>
-	bool SceneNode::removeModule()
-	{
-		auto moduleIt = m_Modules.find(typeid(T));
-
-		if (moduleIt == m_Modules.end())
-		{
-			//ANNILEEN_LOG_ERROR(LoggingChannel::General, "This SceneNode does not have a Module of this type.");
-			return false;
-		}
-
-		T* module = static_cast<T*>(moduleIt->second);
-
-		if (module != nullptr)
-		{
-			module->m_SceneNode = nullptr;
-
-			if constexpr (std::is_same<T, Camera>::value)
-			{
-				m_ParentScene->m_Cameras.remove(module);
-			}
-			else if constexpr (std::is_same<T, Light>::value)
-			{
-				m_ParentScene->m_Lights.remove(module);
-			}
-
-			delete module;
-		}
-
-		m_Modules.erase(moduleIt);
-
-		return true;
-	}
+	// addModule and removeModule are implemented in scene.h, they need the complete Scene.
 
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace annileen
 {
 	class SceneNode;
@@ -11,14 +13,19 @@ namespace annileen
 		// Reference to scene node where module is attached.
 		SceneNode* m_SceneNode;
 
+		// Slot in the scene's ModuleStorage, if the module was created by one.
+		uint32_t m_StorageIndex = UINT32_MAX;
+
 		friend class SceneNode;
+		template <class T> friend class ModuleStorage;
 
 	public:
 
-		SceneNodeModule() {}
+		SceneNodeModule() : m_SceneNode(nullptr) {}
 		virtual ~SceneNodeModule() {}
 
 		Transform& getTransform();
+		SceneNode* getSceneNode() const { return m_SceneNode; }
 	};
 
 	typedef SceneNodeModule* SceneNodeModulePtr;
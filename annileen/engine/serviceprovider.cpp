@@ -8,6 +8,7 @@ namespace annileen
 	FontManager* ServiceProvider::s_FontManager = nullptr;
 	TextBufferManager* ServiceProvider::s_TextBufferManager = nullptr;
 	SceneManager* ServiceProvider::s_SceneManager = nullptr;
+	JobSystem* ServiceProvider::s_JobSystem = nullptr;
 
 	void ServiceProvider::provideLogger(Logger* logger)
 	{
@@ -79,4 +80,19 @@ namespace annileen
 	{
 		return s_SceneManager;
 	}
+
+	void ServiceProvider::provideJobSystem(JobSystem* jobSystem)
+	{
+		if (s_JobSystem != nullptr)
+		{
+			delete s_JobSystem;
+		}
+
+		s_JobSystem = jobSystem;
+	}
+
+	JobSystem* ServiceProvider::getJobSystem()
+	{
+		return s_JobSystem;
+	}
 }
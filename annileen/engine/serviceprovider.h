@@ -2,6 +2,7 @@
 
 //#include <engine/audio.h>
 #include <engine/core/logger.h>
+#include <engine/core/jobsystem.h>
 #include <engine/assetmanager.h>
 #include <engine/settings.h>
 #include <engine/text/fontmanager.h>
@@ -27,6 +28,7 @@ namespace annileen
 		static FontManager* s_FontManager;
 		static TextBufferManager* s_TextBufferManager;
 		static SceneManager* s_SceneManager;
+		static JobSystem* s_JobSystem;
 
 	public:
 		ServiceProvider(const ServiceProvider&) = delete;
@@ -54,5 +56,8 @@ namespace annileen
 
 		static void provideSceneManager(SceneManager* sceneManager);
 		static SceneManager* getSceneManager();
+
+		static void provideJobSystem(JobSystem* jobSystem);
+		static JobSystem* getJobSystem();
 	};
 }
@@ -8,6 +8,21 @@ namespace annileen
 	{
 		shadows.enabled = true;
 		shadows.shadowMapSize = 2048;
+		shadows.cacheStaticLayer = true;
+		shadows.cacheSnapDistance = 8.0f;
+
+		rendering.multithreaded = true;
+		rendering.submitThreads = 3;
+
+		timing.fixedTimestep = 1.0f / 60.0f;
+		timing.maxFixedSteps = 8;
+		timing.vsync = true;
+		timing.frameRateLimit = 0;
+
+		jobs.workerThreads = -1;
+
+		assets.memoryBudget = 0;
+		assets.hotReload = false;
 
 		loadSettings();
 	}
@@ -23,9 +23,53 @@ namespace annileen
         {
             bool enabled;
             uint16_t shadowMapSize;
+
+            // Static casters are rendered to a separate layer that is only rebuilt when
+            // the light moves, the static caster set changes or the camera crosses
+            // a multiple of cacheSnapDistance.
+            bool cacheStaticLayer;
+            float cacheSnapDistance;
+        };
+
+        struct Rendering
+        {
+            // Runs bgfx with a separate render thread instead of rendering on the API thread.
+            bool multithreaded;
+            // Job system workers encoding draw calls alongside the main thread (0 = main thread only).
+            uint8_t submitThreads;
+        };
+
+        struct Timing
+        {
+            // Simulation step, in seconds. Scene and application fixedUpdate() run this often.
+            float fixedTimestep;
+            // Steps a single frame may run, past that the simulation slows down instead.
+            uint32_t maxFixedSteps;
+            // Waits for the display refresh before presenting a frame.
+            bool vsync;
+            // Frames per second the frame limiter holds to (0 = uncapped).
+            uint16_t frameRateLimit;
+        };
+
+        struct Jobs
+        {
+            // Worker threads of the job system (-1 = one per hardware thread, minus the main thread).
+            int32_t workerThreads;
+        };
+
+        struct Assets
+        {
+            // Memory loaded assets may take before the unreferenced ones are unloaded, in MiB (0 = no budget).
+            uint32_t memoryBudget;
+            // Reloads shaders, textures and meshes when their built files change (needs the loose files, not the archive).
+            bool hotReload;
         };
 
         Shadows shadows;
+        Rendering rendering;
+        Timing timing;
+        Jobs jobs;
+        Assets assets;
 
         std::string getFontDefault() { return m_FontDefault; }
     };
@@ -5,14 +5,17 @@
 
 namespace annileen
 {
-    Shader::Shader()
+    Shader::Shader() : m_ProgramHandle(BGFX_INVALID_HANDLE)
     {
 
     }
 
     Shader::~Shader()
     {
-        bgfx::destroy(m_ProgramHandle);
+        if (bgfx::isValid(m_ProgramHandle))
+        {
+            bgfx::destroy(m_ProgramHandle);
+        }
     }
 
     void Shader::init(bgfx::ProgramHandle handle)
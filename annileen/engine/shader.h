@@ -12,6 +12,25 @@
 
 namespace annileen
 {
+    // Features a shader permutation is built with, combined as a mask.
+    namespace ShaderFeatures
+    {
+        enum : uint32_t
+        {
+            None = 0,
+            Shadows = 1 << 0
+        };
+    }
+
+    // One variant of a program, compiled ahead into stages of its own.
+    struct ShaderPermutation
+    {
+        std::string program;
+        uint32_t features;
+        std::string vertex;
+        std::string fragment;
+    };
+
     class Shader : public AssetObject
     {
     private:
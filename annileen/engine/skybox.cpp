@@ -9,7 +9,7 @@ namespace annileen
 {
 	void Skybox::createModel()
 	{
-		Shader* shader = ServiceProvider::getAssetManager()->loadShader("skybox.vs", "skybox.fs");
+		Shader* shader = ServiceProvider::getAssetManager()->getShaderPermutation("skybox", ShaderFeatures::None);
 		std::shared_ptr<Material> material = std::make_shared<Material>();
 		
 		std::shared_ptr<ShaderPass> shaderPass = std::make_shared<ShaderPass>();
@@ -44,6 +44,11 @@ namespace annileen
 	{
 		createModel();
 	}
+
+	Skybox::Skybox(AssetRef<Cubemap> cubemap) : m_Cubemap(cubemap.get()), m_CubemapReference(std::move(cubemap))
+	{
+		createModel();
+	}
 	
 	Skybox::~Skybox()
 	{
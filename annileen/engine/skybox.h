@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cubemap.h"
+#include "assetref.h"
 
 const float s_skyboxCubeVertices[8][3] =
 {
@@ -40,6 +41,8 @@ namespace annileen
         std::shared_ptr<Model> m_Model;
         MeshGroup* m_MeshGroup;
         Cubemap* m_Cubemap;
+        // Set when the cubemap came from the AssetManager, keeps it loaded.
+        AssetRef<Cubemap> m_CubemapReference;
         void createModel();
 
     public:
@@ -47,6 +50,7 @@ namespace annileen
         Cubemap* getCubemap() const { return m_Cubemap; }
 
         Skybox(Cubemap* cubemap);
+        Skybox(AssetRef<Cubemap> cubemap);
         ~Skybox();
     };
 }
@@ -268,9 +268,23 @@ TrueTypeHandle FontManager::createTtf(const uint8_t* _buffer, uint32_t _size)
 {
 	uint16_t id = m_filesHandles.alloc();
 	BX_ASSERT(id != bx::kInvalidHandle, "Invalid handle used");
-	m_cachedFiles[id].buffer = new uint8_t[_size];
+	uint8_t* buffer = new uint8_t[_size];
+	bx::memCopy(buffer, _buffer, _size);
+	m_cachedFiles[id].buffer = buffer;
 	m_cachedFiles[id].bufferSize = _size;
-	bx::memCopy(m_cachedFiles[id].buffer, _buffer, _size);
+	m_cachedFiles[id].ownsBuffer = true;
+
+	TrueTypeHandle ret = { id };
+	return ret;
+}
+
+TrueTypeHandle FontManager::createTtfRef(const uint8_t* _buffer, uint32_t _size)
+{
+	uint16_t id = m_filesHandles.alloc();
+	BX_ASSERT(id != bx::kInvalidHandle, "Invalid handle used");
+	m_cachedFiles[id].buffer = _buffer;
+	m_cachedFiles[id].bufferSize = _size;
+	m_cachedFiles[id].ownsBuffer = false;
 
 	TrueTypeHandle ret = { id };
 	return ret;
@@ -279,7 +293,10 @@ TrueTypeHandle FontManager::createTtf(const uint8_t* _buffer, uint32_t _size)
 void FontManager::destroyTtf(TrueTypeHandle _handle)
 {
 	BX_ASSERT(bgfx::isValid(_handle), "Invalid handle used");
-	delete m_cachedFiles[_handle.idx].buffer;
+	if (m_cachedFiles[_handle.idx].ownsBuffer)
+	{
+		delete[] m_cachedFiles[_handle.idx].buffer;
+	}
 	m_cachedFiles[_handle.idx].bufferSize = 0;
 	m_cachedFiles[_handle.idx].buffer = NULL;
 	m_filesHandles.free(_handle.idx);
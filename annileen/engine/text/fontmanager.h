@@ -140,6 +140,12 @@ public:
 	/// @return invalid handle if the loading fail
 	TrueTypeHandle createTtf(const uint8_t* _buffer, uint32_t _size);
 
+	/// Load a TrueType font from a given buffer without copying it. The
+	/// buffer must stay valid until the font is destroyed with destroyTtf.
+	///
+	/// @return invalid handle if the loading fail
+	TrueTypeHandle createTtfRef(const uint8_t* _buffer, uint32_t _size);
+
 	/// Unload a TrueType font (free font memory) but keep loaded glyphs.
 	void destroyTtf(TrueTypeHandle _handle);
 
@@ -180,8 +186,9 @@ private:
 	struct CachedFont;
 	struct CachedFile
 	{
-		uint8_t* buffer;
+		const uint8_t* buffer;
 		uint32_t bufferSize;
+		bool ownsBuffer;
 	};
 
 	void init();
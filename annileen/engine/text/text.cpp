@@ -11,8 +11,8 @@ namespace annileen
 		// If font is not defined or valid, use font default.
 		if (!isValid(m_Font))
 		{
-			m_Font = ServiceProvider::getAssetManager()->loadFont(
-				ServiceProvider::getSettings()->getFontDefault())->getHandle();
+			m_FontReference = ServiceProvider::getAssetManager()->acquireFont(ServiceProvider::getSettings()->getFontDefault());
+			if (m_FontReference) m_Font = m_FontReference->getHandle();
 		}
 
 		if (isValid(m_FontHandle))
@@ -36,10 +36,28 @@ namespace annileen
 	void Text::setFont(TrueTypeHandle font)
 	{
 		m_Font = font;
+		m_FontReference.reset();
+		m_PendingFont.reset();
 		
 		createFont();
 	}
 
+	void Text::setFont(AssetRef<Font> font)
+	{
+		if (font && !isValid(font->getHandle()))
+		{
+			m_PendingFont = std::move(font);
+			return;
+		}
+
+		m_PendingFont.reset();
+		m_Font = BGFX_INVALID_HANDLE;
+		if (font) m_Font = font->getHandle();
+		m_FontReference = std::move(font);
+
+		createFont();
+	}
+
 	void Text::setPixelSize(uint32_t pixelSize)
 	{
 		m_PixelSize = pixelSize;
@@ -266,6 +284,17 @@ namespace annileen
 	{
 		TextBufferManager* textBufferManager = ServiceProvider::getTextBufferManager();
 
+		if (m_PendingFont && isValid(m_PendingFont->getHandle()))
+		{
+			m_Font = m_PendingFont->getHandle();
+			m_FontReference = std::move(m_PendingFont);
+			m_PendingFont.reset();
+
+			// A new buffer, static ones are not filled again once submitted.
+			init(m_IsStatic, m_Sdf);
+			applyProperties();
+		}
+
 		if (!m_IsStatic)
 		{
 			textBufferManager->clearTextBuffer(m_TextBufferHandle);
@@ -308,8 +337,7 @@ namespace annileen
 		m_TextBufferHandle(BGFX_INVALID_HANDLE), m_Font(BGFX_INVALID_HANDLE), m_Sdf(false), m_ScreenPosition(glm::vec2(0.0f))
 	{
 		init(false);
-		setFont(ServiceProvider::getAssetManager()->loadFont(
-			ServiceProvider::getSettings()->getFontDefault())->getHandle());
+		setFont(ServiceProvider::getAssetManager()->acquireFont(ServiceProvider::getSettings()->getFontDefault()));
 	}
 
 	Text::~Text()
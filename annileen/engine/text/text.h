@@ -1,6 +1,8 @@
 #pragma once
 
 #include <engine/scenenodemodule.h>
+#include <engine/assetref.h>
+#include <engine/font.h>
 #include <engine/text/fontmanager.h>
 #include <engine/text/textbuffermanager.h>
 #include <glm.hpp>
@@ -23,6 +25,11 @@ namespace annileen
 
 	private:
 		TrueTypeHandle m_Font;
+		// Set when the font came from the AssetManager, keeps it loaded.
+		AssetRef<Font> m_FontReference;
+		// A font set while the AssetManager was still loading it. The text keeps its current
+		// font until render() finds this one created.
+		AssetRef<Font> m_PendingFont;
 		uint32_t m_PixelSize = 32;
 		FontHandle m_FontHandle;
 		TextBufferHandle m_TextBufferHandle;
@@ -57,6 +64,10 @@ namespace annileen
 		bool isStatic() { return m_IsStatic; }
 
 		void setFont(TrueTypeHandle font);
+		// The text holds the reference, so the font stays loaded while it is drawn. A font
+		// loaded asynchronously is used from the first frame it is ready.
+		void setFont(AssetRef<Font> font);
+		TrueTypeHandle getFont() const { return m_Font; }
 		void setPixelSize(uint32_t pixelSize);
 		uint32_t getPixelSize() { return m_PixelSize; }
 
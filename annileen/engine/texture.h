@@ -16,6 +16,8 @@ namespace annileen
 		bgfx::TextureHandle m_Handle;
 		bgfx::TextureInfo m_Info;
 		bimg::Orientation::Enum m_Orientation;
+		// Set for handles the AssetManager created for this asset, destroyed with it.
+		bool m_OwnsHandle;
 
 		TextureDescriptor m_Descriptor;
 
@@ -24,10 +26,14 @@ namespace annileen
 		const bgfx::TextureInfo& getInfo() const { return m_Info; }
 		const bimg::Orientation::Enum& getOrientation() const { return m_Orientation; }
 
+		size_t getMemorySize() const override { return m_OwnsHandle ? m_Info.storageSize : 0; }
+
 		const TextureDescriptor& getDescriptor() const { return m_Descriptor; }
 		void setDescriptor(TextureDescriptor descriptor) { m_Descriptor = descriptor; }
 
 		Texture(bgfx::TextureHandle handle, bgfx::TextureInfo info, bimg::Orientation::Enum orientation);
 		~Texture();
+
+		friend class AssetManager;
 	};
 }
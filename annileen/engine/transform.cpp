@@ -1,47 +1,162 @@
 #include "transform.h"
 
+#include <engine/core/jobsystem.h>
+
 namespace annileen
 {
-    glm::mat4 Transform::getModelMatrix()
+    // Fewer children than this are cheaper to walk than to hand out as jobs.
+    static constexpr size_t s_MinChildrenPerJob = 32;
+
+    void Transform::markDirty()
+    {
+        m_Storage->m_LocalDirty[m_Slot] = 1;
+        markWorldDirty();
+        markAncestorsChildrenDirty();
+    }
+
+    void Transform::markWorldDirty()
+    {
+        // A dirty world matrix implies dirty descendants, so there is nothing more to do.
+        if (m_WorldDirty) return;
+
+        m_WorldDirty = true;
+        m_ChildrenDirty = !m_Children.empty();
+
+        for (auto child : m_Children)
+        {
+            child->markWorldDirty();
+        }
+    }
+
+    void Transform::markAncestorsChildrenDirty()
+    {
+        for (Transform* parent = m_Parent; parent != nullptr && !parent->m_ChildrenDirty; parent = parent->m_Parent)
+        {
+            parent->m_ChildrenDirty = true;
+        }
+    }
+
+    void Transform::updateLocalMatrix()
     {
-        glm::mat4 matrix(1.0f);
+        m_Storage->updateLocalMatrix(m_Slot);
+    }
 
-        computeQuaternion();
+    void Transform::updateWorldMatrix()
+    {
+        const glm::mat4& local = getLocalMatrix();
+        m_Storage->m_WorldMatrices[m_Slot] = m_Parent != nullptr ? m_Parent->getWorldMatrix() * local : local;
+        m_WorldDirty = false;
+        m_WorldVersion++;
+    }
 
-        matrix = glm::translate(matrix, m_Position);
-        glm::mat4 mrot = glm::mat4_cast(m_RotationQuat);
-        matrix *= mrot;
-        matrix = glm::scale(matrix, m_Scale);
+    void Transform::setParent(Transform* parent)
+    {
+        if (m_Parent == parent) return;
 
-        return matrix;
+        if (m_Parent != nullptr)
+        {
+            std::vector<Transform*>& siblings = m_Parent->m_Children;
+            siblings[m_ChildIndex] = siblings.back();
+            siblings[m_ChildIndex]->m_ChildIndex = m_ChildIndex;
+            siblings.pop_back();
+        }
+
+        m_Parent = parent;
+
+        if (m_Parent != nullptr)
+        {
+            m_ChildIndex = m_Parent->m_Children.size();
+            m_Parent->m_Children.push_back(this);
+        }
+
+        // Force the whole subtree dirty, it may have been clean under the old parent.
+        m_WorldDirty = false;
+        markWorldDirty();
+        markAncestorsChildrenDirty();
     }
 
-    glm::quat Transform::computeQuaternion()
+    glm::quat Transform::rotation()
     {
-        m_RotationQuat = glm::quat(glm::radians(m_RotationEuler));
-        return m_RotationQuat;
+        if (m_Storage->m_LocalDirty[m_Slot]) updateLocalMatrix();
+        return m_Storage->m_Rotations[m_Slot];
+    }
+
+    void Transform::rotation(const glm::quat& rotation)
+    {
+        m_Storage->m_Eulers[m_Slot] = glm::degrees(glm::eulerAngles(rotation));
+        markDirty();
+    }
+
+    const glm::mat4& Transform::getLocalMatrix()
+    {
+        if (m_Storage->m_LocalDirty[m_Slot]) updateLocalMatrix();
+        return m_Storage->m_LocalMatrices[m_Slot];
+    }
+
+    const glm::mat4& Transform::getWorldMatrix()
+    {
+        if (m_WorldDirty) updateWorldMatrix();
+        return m_Storage->m_WorldMatrices[m_Slot];
+    }
+
+    glm::vec3 Transform::getWorldPosition()
+    {
+        return glm::vec3(getWorldMatrix()[3]);
+    }
+
+    void Transform::updateHierarchy()
+    {
+        if (m_WorldDirty) updateWorldMatrix();
+
+        if (!m_ChildrenDirty) return;
+        m_ChildrenDirty = false;
+
+        for (auto child : m_Children)
+        {
+            child->updateHierarchy();
+        }
+    }
+
+    void Transform::updateHierarchy(JobSystem& jobs)
+    {
+        if (m_WorldDirty) updateWorldMatrix();
+
+        if (!m_ChildrenDirty) return;
+        m_ChildrenDirty = false;
+
+        jobs.parallelFor(m_Children.size(), s_MinChildrenPerJob, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                m_Children[i]->updateHierarchy();
+            }
+        });
     }
 
     void Transform::translate(const glm::vec3& pos, bool local)
     {
         if (local)
         {
-            m_Position += rotation() * pos;
+            m_Storage->m_Positions[m_Slot] += rotation() * pos;
         }
         else
         {
-            m_Position += pos;
+            m_Storage->m_Positions[m_Slot] += pos;
         }
+
+        markDirty();
     }
 
     void Transform::rotate(const glm::vec3& axis)
     {
-        m_RotationEuler += axis;
+        m_Storage->m_Eulers[m_Slot] += axis;
+        markDirty();
     }
 
     void Transform::rotate(const glm::quat& quat)
     {
-        m_RotationEuler += glm::degrees(glm::eulerAngles(quat));
+        m_Storage->m_Eulers[m_Slot] += glm::degrees(glm::eulerAngles(quat));
+        markDirty();
     }
 
     void Transform::rotateYaw(float angle)
@@ -76,34 +191,46 @@ namespace annileen
 
     void Transform::setForward(glm::vec3 forward)
     {
-        lookAt(m_Position + forward);
+        lookAt(position() + forward);
     }
 
-    void Transform::lookAt(Transform transform)
+    void Transform::lookAt(const Transform& transform)
     {
         lookAt(transform.position());
     }
 
     void Transform::lookAt(glm::vec3 pos)
     {
-        glm::vec3 direction = glm::normalize(m_Position - pos);
+        glm::vec3 direction = glm::normalize(position() - pos);
         float dot = glm::dot(glm::vec3(0.0f, 0.0f, 1.0f), direction);
         float angle = (float)acos(dot);
         glm::vec3 rotationAxis = glm::normalize(glm::cross(glm::vec3(0.0f, 0.0f, 1.0f), direction));
-        m_RotationEuler = glm::normalize(rotationAxis * angle);
+        m_Storage->m_Eulers[m_Slot] = glm::normalize(rotationAxis * angle);
+        markDirty();
     }
 
 
-    Transform::Transform()
+    Transform::Transform(TransformStorage& storage) : m_Storage(&storage), m_Slot(storage.allocate()), m_WorldDirty(true),
+        m_ChildrenDirty(false), m_WorldVersion(0), m_Parent(nullptr), m_ChildIndex(0)
     {
-        m_Scale = glm::vec3(1.0f, 1.0f, 1.0f);
-        m_Position = glm::vec3(0.0f, 0.0f, 0.0f);
-        m_RotationEuler = glm::vec3(0.0f, 0.0f, 0.0f);
-        computeQuaternion();
     }
 
+    Transform::Transform(const Transform& other) : Transform(*other.m_Storage)
+    {
+        *this = other;
+    }
+
+    Transform& Transform::operator=(const Transform& other)
+    {
+        m_Storage->m_Scales[m_Slot] = other.scale();
+        m_Storage->m_Positions[m_Slot] = other.position();
+        m_Storage->m_Eulers[m_Slot] = other.euler();
+        markDirty();
+        return *this;
+    }
 
     Transform::~Transform()
     {
+        m_Storage->free(m_Slot);
     }
 }
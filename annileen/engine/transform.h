@@ -1,35 +1,83 @@
 #ifndef _TRANSFORM_H_
 #define _TRANSFORM_H_
 
+#include <cstdint>
+#include <vector>
+
 #include <glm.hpp>
 #include <gtc/type_ptr.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/quaternion.hpp>
 
+#include <engine/scene/transformstorage.h>
+
 namespace annileen
 {
+    class SceneNode;
+    class JobSystem;
+
+    // Position, rotation, scale and the cached matrices live in the TransformStorage of the
+    // scene, the transform keeps its slot there and its place in the hierarchy.
     class Transform
     {
     private:
-        glm::vec3 m_Scale;
-        glm::vec3 m_Position;
-        glm::vec3 m_RotationEuler;
-        glm::quat m_RotationQuat;
+        TransformStorage* m_Storage;
+        uint32_t m_Slot;
+
+        // The local matrix is rebuilt when position, rotation or scale change (the storage
+        // keeps that flag), the world matrix when the local matrix or any ancestor changes.
+        bool m_WorldDirty;
+        // Some descendant has a dirty world matrix, so updateHierarchy() has to visit the children.
+        bool m_ChildrenDirty;
+        // Bumped every time the world matrix is rebuilt.
+        uint32_t m_WorldVersion;
+
+        Transform* m_Parent;
+        // Unordered, children are swapped into the hole when one is removed.
+        std::vector<Transform*> m_Children;
+        size_t m_ChildIndex;
 
-        glm::quat computeQuaternion();
+        void markDirty();
+        void markWorldDirty();
+        void markAncestorsChildrenDirty();
+
+        void updateLocalMatrix();
+        void updateWorldMatrix();
+
+        // The hierarchy mirrors the scene node hierarchy and is only changed by SceneNode.
+        void setParent(Transform* parent);
+        friend class SceneNode;
 
     public:
-        inline glm::vec3 scale() const { return m_Scale; }
-        inline glm::vec3 position() const { return m_Position; }
-        inline glm::quat rotation() { return computeQuaternion(); }
-        inline glm::vec3 euler() const { return m_RotationEuler; }
+        inline glm::vec3 scale() const { return m_Storage->m_Scales[m_Slot]; }
+        inline glm::vec3 position() const { return m_Storage->m_Positions[m_Slot]; }
+        glm::quat rotation();
+        inline glm::vec3 euler() const { return m_Storage->m_Eulers[m_Slot]; }
+
+        void scale(const glm::vec3& scale) { m_Storage->m_Scales[m_Slot] = scale; markDirty(); }
+        void position(const glm::vec3& position) { m_Storage->m_Positions[m_Slot] = position; markDirty(); }
+        void euler(const glm::vec3& euler) { m_Storage->m_Eulers[m_Slot] = euler; markDirty(); }
+        void rotation(const glm::quat& rotation);
+
+        Transform* getParent() const { return m_Parent; }
+        // Index of this transform in the arrays of the scene's TransformStorage.
+        uint32_t getSlot() const { return m_Slot; }
 
-        void scale(const glm::vec3& scale) { m_Scale = scale; }
-        void position(const glm::vec3& position) { m_Position = position; }
-        void euler(const glm::vec3& euler) { m_RotationEuler = euler; }
-        void rotation(const glm::quat& rotation) { m_RotationQuat = rotation; }
+        // References into the scene's storage, valid until the next node is created.
+        const glm::mat4& getLocalMatrix();
+        const glm::mat4& getWorldMatrix();
+        // World matrix, kept for existing callers.
+        const glm::mat4& getModelMatrix() { return getWorldMatrix(); }
+        glm::vec3 getWorldPosition();
+        // Changes whenever the world matrix may have changed, cheaper to compare than the matrix.
+        uint32_t getWorldVersion() const { return m_WorldVersion; }
 
-        glm::mat4 getModelMatrix();
+        // Brings every dirty world matrix in this subtree up to date. Scene calls it on
+        // the root once per frame, before rendering.
+        void updateHierarchy();
+        // Same, with the children's subtrees spread over the job system. Subtrees don't share
+        // any state, and each reads its parent only once the parent is up to date.
+        void updateHierarchy(JobSystem& jobs);
         
         void translate(const glm::vec3& pos, bool local = true);
 
@@ -40,16 +88,22 @@ namespace annileen
         void rotatePitch(float angle);
         void rotateRoll(float angle);
 
+        // Directions in the parent space.
         glm::vec3 getForward();
         glm::vec3 getRight();
         glm::vec3 getUp();
 
         void setForward(glm::vec3 forward);
 
-        void lookAt(Transform transform);
+        void lookAt(const Transform& transform);
         void lookAt(glm::vec3 pos);
 
-        Transform();
+        // Takes a slot in storage, which must outlive the transform.
+        explicit Transform(TransformStorage& storage);
+        // Copies position, rotation and scale only, never the place in the hierarchy. The
+        // copy takes a slot of its own in the same storage.
+        Transform(const Transform& other);
+        Transform& operator=(const Transform& other);
         ~Transform();
     };
 }
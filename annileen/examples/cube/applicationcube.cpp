@@ -21,15 +21,15 @@ private:
         Scene* scene = new Scene();
         //getEngine()->setScene(scene);
 
+        // The voxel programs are this example's own, created in one batch before they are used.
+        AssetManager* assetManager = ServiceProvider::getAssetManager();
+        assetManager->addShaderPermutation({ "voxel", ShaderFeatures::None, "voxel_noshadow.vs", "voxel_noshadow.fs" });
+        assetManager->addShaderPermutation({ "voxel", ShaderFeatures::Shadows, "voxel_shadow.vs", "voxel_shadow.fs" });
+        assetManager->loadShaderPermutations();
+
         annileen::Shader* shader = nullptr;
-        if (ServiceProvider::getSettings()->shadows.enabled)
-        {
-            shader = ServiceProvider::getAssetManager()->loadShader("voxel_shadow.vs", "voxel_shadow.fs");
-        }
-        else
-        {
-            shader = ServiceProvider::getAssetManager()->loadShader("voxel_noshadow.vs", "voxel_noshadow.fs");
-        }
+        shader = assetManager->getShaderPermutation("voxel",
+            ServiceProvider::getSettings()->shadows.enabled ? ShaderFeatures::Shadows : ShaderFeatures::None);
 
         std::shared_ptr<ShaderPass> shaderPass = std::make_shared<ShaderPass>();
         shaderPass->init(shader);
@@ -48,7 +48,7 @@ private:
 
         m_ModelNode = scene->createNode("Model");
         ModelPtr model = m_ModelNode->addModule<Model>();
-        model->init(ServiceProvider::getAssetManager()->loadMesh("bunny.obj"), material);
+        model->init(assetManager->acquireMesh("bunny.obj"), material);
 
         m_ModelNode->getTransform().translate(glm::vec3(-1.0, -1.0, -1.0));
          
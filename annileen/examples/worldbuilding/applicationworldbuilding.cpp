@@ -8,6 +8,12 @@ ApplicationWorldBuilding::~ApplicationWorldBuilding() {}
 
 annileen::Scene* ApplicationWorldBuilding::init()
 {
+    // The voxel programs are this example's own, created in one batch before the scene builds its map.
+    AssetManager* assetManager = ServiceProvider::getAssetManager();
+    assetManager->addShaderPermutation({ "voxel", ShaderFeatures::None, "voxel_noshadow.vs", "voxel_noshadow.fs" });
+    assetManager->addShaderPermutation({ "voxel", ShaderFeatures::Shadows, "voxel_shadow.vs", "voxel_shadow.fs" });
+    assetManager->loadShaderPermutations();
+
 	GameScene* scene = new GameScene();
 
     // Initialize Camera
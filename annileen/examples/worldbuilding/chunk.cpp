@@ -1,23 +1,28 @@
 #include "chunk.h"
 #include <engine/engine.h>
 #include <engine/mesh.h>
+#include <engine/serviceprovider.h>
+#include <engine/core/profiler.h>
 
 #define GRID_AT(X, Y, Z)        Z + Y * CHUNK_WIDTH + X * CHUNK_HEIGHT * CHUNK_DEPTH
 
 void Chunk::generateMesh()
 {
+    ANNILEEN_PROFILE_SCOPE("Chunk::generateMesh");
+
     if (m_MeshGroup != nullptr)
     {
-        delete m_Node;
+        Scene* scene = Engine::getInstance()->getScene();
+        if (scene != nullptr)
+        {
+            scene->destroyNode(scene->getNode(m_NodeHandle));
+        }
+        m_NodeHandle = {};
         delete m_MeshGroup;
     }
 
     m_MeshGroup = new annileen::MeshGroup();
 
-    int meshSize;
-    int indexSize;
-    float* meshData = generateMeshData(&meshSize);
-
     bgfx::VertexLayout vlayout;
     vlayout.begin()
         .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
@@ -26,12 +31,16 @@ void Chunk::generateMesh()
         .end();
 
     auto mesh = new Mesh();
-    mesh->init(bgfx::makeRef(meshData, meshSize * sizeof(float), Engine::releaseMem), vlayout);
+    // The mesh owns the vertices from here on.
+    mesh->init(bgfx::makeRef(m_MeshData, m_MeshSize * sizeof(float), Engine::releaseMem), vlayout);
+    m_MeshData = nullptr;
     m_MeshGroup->m_Meshes.push_back(mesh);
 }
 
 float* Chunk::generateMeshData(int* meshSize)
 {
+    ANNILEEN_PROFILE_SCOPE("Chunk::generateMeshData");
+
     size_t ds = 0;
     for (int x = 0; x < CHUNK_WIDTH; x++)
     {
@@ -135,7 +144,7 @@ bool Chunk::gridEmpty(int x, int y, int z)
 
 void Chunk::generateGrid()
 {
-    srand(time(NULL));
+    ANNILEEN_PROFILE_SCOPE("Chunk::generateGrid");
 
     m_Grid = new BlockType[CHUNK_TOTAL_VOXELS];
 
@@ -201,27 +210,60 @@ void Chunk::generateGrid()
             }
         }
     }
+}
 
-    generateMesh();
+void Chunk::generate()
+{
+    auto job = [this]()
+    {
+        generateGrid();
+        m_MeshData = generateMeshData(&m_MeshSize);
+    };
+
+    JobSystem* jobs = ServiceProvider::getJobSystem();
+    if (jobs != nullptr)
+    {
+        jobs->runBackground(job, &m_Generation);
+    }
+    else
+    {
+        job();
+    }
 }
 
 SceneNodePtr Chunk::getSceneNode()
 {
-    if (m_Node == nullptr)
+    Scene* scene = Engine::getInstance()->getScene();
+    SceneNodePtr node = scene->getNode(m_NodeHandle);
+
+    if (node == nullptr)
     {
-        Scene* scene = Engine::getInstance()->getScene();
-        m_Node = scene->createNode("Chunk");
+        if (!isGenerated())
+        {
+            return nullptr;
+        }
+
+        if (m_MeshGroup == nullptr)
+        {
+            generateMesh();
+        }
 
-        m_Model = m_Node->addModule<Model>();
-        m_Model->init(m_MeshGroup, m_Material);
+        node = scene->createNode("Chunk");
+        m_NodeHandle = node->getHandle();
 
-        m_Node->getTransform().position(glm::vec3(
-            m_WorldX * CHUNK_WIDTH,
-            0,
-            m_WorldZ * CHUNK_DEPTH));
+        ModelPtr model = node->addModule<Model>();
+        model->init(m_MeshGroup, m_Material);
+        model->isStatic = true;
+
+        node->getTransform().position(getWorldPosition());
     }
 
-    return m_Node;
+    return node;
+}
+
+glm::vec3 Chunk::getWorldPosition() const
+{
+    return glm::vec3(m_WorldX * CHUNK_WIDTH, 0, m_WorldZ * CHUNK_DEPTH);
 }
 
 Chunk::Chunk(int wx, int wz)
@@ -232,6 +274,14 @@ Chunk::Chunk(int wx, int wz)
 
 Chunk::~Chunk()
 {
+    // The generation job writes to this chunk until it is done.
+    JobSystem* jobs = ServiceProvider::getJobSystem();
+    if (jobs != nullptr)
+    {
+        jobs->wait(m_Generation);
+    }
+
     delete m_MeshGroup;
-    delete m_Grid;
+    delete[] m_MeshData;
+    delete[] m_Grid;
 }
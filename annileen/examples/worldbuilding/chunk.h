@@ -8,6 +8,7 @@
 #include "engine/material.h"
 #include "engine/model.h"
 #include "engine/scenenode.h"
+#include "engine/core/jobsystem.h"
 #include "data.h"
 
 #define CHUNK_WIDTH             16
@@ -36,13 +37,18 @@ private:
     
     siv::PerlinNoise* m_Noise;
 
-    BlockType* m_Grid;
+    BlockType* m_Grid = nullptr;
+    // Vertices made by the generation job, handed to a Mesh on the main thread.
+    float* m_MeshData = nullptr;
+    int m_MeshSize = 0;
+    JobCounter m_Generation;
 
     std::shared_ptr<Material> m_Material;
     MeshGroup* m_MeshGroup = nullptr;
-    ModelPtr m_Model = nullptr;
-    SceneNodePtr m_Node = nullptr;
+    // A handle rather than a pointer, the node may be destroyed by someone else (the editor clearing the scene).
+    SceneNodeHandle m_NodeHandle;
 
+    void generateGrid();
     void generateMesh();
     float* generateMeshData(int* meshSize);
 
@@ -52,8 +58,14 @@ public:
     void setNoise(siv::PerlinNoise* noise) { m_Noise = noise; };
     void setMaterial(std::shared_ptr<Material> material) { m_Material = material; }
 
-    void generateGrid();
+    // Builds the grid and the mesh vertices, as a job when there is a job system.
+    void generate();
+    bool isGenerated() const { return m_Generation.isDone(); }
+
+    // Null until the generation is done, the node is created on the first call after that.
     SceneNodePtr getSceneNode();
+    SceneNodeHandle getSceneNodeHandle() const { return m_NodeHandle; }
+    glm::vec3 getWorldPosition() const;
 
     Chunk(int wx, int wz);
     ~Chunk();
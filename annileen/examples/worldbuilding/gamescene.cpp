@@ -10,18 +10,12 @@ using namespace annileen;
 
 void GameScene::buildMap()
 {
-    auto texture = ServiceProvider::getAssetManager()->loadTexture("blocks.png");
+    AssetRef<Texture> texture = ServiceProvider::getAssetManager()->acquireTexture("blocks.png");
 
     Shader* shader = nullptr;
 
-    if (ServiceProvider::getSettings()->shadows.enabled)
-    {
-        shader = ServiceProvider::getAssetManager()->loadShader("voxel_shadow.vs", "voxel_shadow.fs");
-    }
-    else
-    {
-        shader = ServiceProvider::getAssetManager()->loadShader("voxel_noshadow.vs", "voxel_noshadow.fs");
-    }
+    shader = ServiceProvider::getAssetManager()->getShaderPermutation("voxel",
+        ServiceProvider::getSettings()->shadows.enabled ? ShaderFeatures::Shadows : ShaderFeatures::None);
 
     std::shared_ptr<ShaderPass> shaderPass = std::make_shared<ShaderPass>();
     shaderPass->init(shader);
@@ -34,7 +28,7 @@ void GameScene::buildMap()
         | UINT64_C(0));
 
     m_BlockMaterial = std::make_shared<Material>();
-    m_BlockMaterial->addTexture("s_mainTex", texture, 0);
+    m_BlockMaterial->addTexture("s_mainTex", std::move(texture), 0);
     m_BlockMaterial->addShaderPass(shaderPass);
     m_BlockMaterial->setName("BlockMaterial");
 
@@ -63,7 +57,7 @@ void GameScene::buildMap()
     text->setStatic(true);
     text->setSdf(true);
 
-    text->setFont(ServiceProvider::getAssetManager()->loadFont("droidsans.ttf")->getHandle());
+    text->setFont(ServiceProvider::getAssetManager()->acquireFont("droidsans.ttf"));
     text->setScreenPosition(Engine::getInstance()->getWidth()- 300.0f, 200.0f);
     text->setTextColor(glm::vec3(1, 0, 0));
     text->setBackgroundColor(glm::vec3(0.5));
@@ -73,14 +67,13 @@ void GameScene::buildMap()
     SceneNodePtr textNode2 = createNode("Text2");
     Text* text2 = textNode2->addModule<Text>();
 
-    text2->setFont(ServiceProvider::getAssetManager()->loadFont("bleeding_cowboys.ttf")->getHandle());
+    text2->setFont(ServiceProvider::getAssetManager()->acquireFont("bleeding_cowboys.ttf"));
     text2->setScreenPosition(Engine::getInstance()->getWidth() - 200.0f, 300.0f);
     text2->setTextColor(glm::vec3(0, 1, 0));
     text2->setStyle(Text::TextStyle::StrikeThrough);
     text2->setText("OH YEAH");
 
-    auto cubemap = ServiceProvider::getAssetManager()->loadCubemap("skybox.toml");
-    auto skybox = new Skybox(cubemap);
+    auto skybox = new Skybox(ServiceProvider::getAssetManager()->acquireCubemap("skybox.toml"));
     this->setSkybox(skybox);
 
     getCamera()->clearType = CameraClearType::CameraClearSkybox;
@@ -93,7 +86,7 @@ void GameScene::createChunkAt(int x, int z)
     Chunk* chunk = new Chunk(x, z);
     chunk->setMaterial(m_BlockMaterial);
     chunk->setNoise(m_Noise);
-    chunk->generateGrid();
+    chunk->generate();
 	m_AvailableChunks.insert(std::pair<uint64_t, Chunk*>((uint32_t)x | (((uint64_t)z) << 32), chunk));
 }
 
@@ -112,7 +105,7 @@ void GameScene::removeFarthestChunk()
             continue;
         }
 
-        auto d = glm::abs(glm::length(cameraPos - c.second->getSceneNode()->getTransform().position()));
+        auto d = glm::abs(glm::length(cameraPos - c.second->getWorldPosition()));
         if (dist < d)
         {
             k = true;
@@ -138,11 +131,22 @@ void GameScene::addChunk(Chunk* chunk)
 
 void GameScene::removeChunk(Chunk* chunk)
 {
-    SceneNode* node = chunk->getSceneNode();
+    // By handle, asking the chunk for its node would build it.
+    SceneNodePtr node = getNode(chunk->getSceneNodeHandle());
     if (node != nullptr)
     {
-        delete node;
+        destroyNode(node);
+    }
+}
+
+std::shared_ptr<Material> GameScene::resolveMaterial(const std::string& name)
+{
+    if (m_BlockMaterial != nullptr && name == m_BlockMaterial->getName())
+    {
+        return m_BlockMaterial;
     }
+
+    return nullptr;
 }
 
 void GameScene::start()
@@ -167,8 +171,10 @@ void GameScene::update()
     int cx = static_cast<int>(cameraPos.x / CHUNK_WIDTH);
     int cz = static_cast<int>(cameraPos.z / CHUNK_DEPTH);
 
-	// Create chunk from list
-	if (m_ChunksToCreate.size() > 0)
+	// Create chunks from list, as many as there are threads to generate them
+	JobSystem* jobs = ServiceProvider::getJobSystem();
+	size_t chunksToStart = jobs != nullptr ? jobs->getWorkerCount() + 1 : 1;
+	while (m_ChunksToCreate.size() > 0 && chunksToStart-- > 0)
 	{
 		auto chunk_addr = m_ChunksToCreate.front();
 		createChunkAt((int32_t)(chunk_addr & 0xFFFFFFFF), (int32_t)(((int64_t)(chunk_addr) >> 32) & 0xFFFFFFFF));
@@ -176,7 +182,7 @@ void GameScene::update()
 	}
 
 	// Destroy chunk if needed
-    if (m_AvailableChunks.size() > GAME_CHUNK_MAX)
+    while (m_AvailableChunks.size() > GAME_CHUNK_MAX)
     {
         // TODO: need to fix this removing routine
         removeFarthestChunk();
@@ -37,6 +37,7 @@ public:
 
     void start() override;
     void update() override;
+    std::shared_ptr<Material> resolveMaterial(const std::string& name) override;
 
     GameScene();
     ~GameScene();
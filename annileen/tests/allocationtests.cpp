@@ -0,0 +1,167 @@
+#include "test.h"
+#include "testscene.h"
+
+#include <engine/scene.h>
+#include <engine/model.h>
+#include <engine/core/logger.h>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <fmt/format.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// The global allocation functions of the test executable count the allocations a thread
+// makes while it sets s_CountAllocations. Other threads and other times cost a thread local
+// read. Every replaceable form is replaced, so none of them reaches the default heap on its
+// own and frees memory the others allocated.
+namespace annileen
+{
+	static thread_local bool s_CountAllocations = false;
+	static thread_local size_t s_Allocations = 0;
+
+	static void* allocate(std::size_t size) noexcept
+	{
+		if (s_CountAllocations) ++s_Allocations;
+		return std::malloc(size != 0 ? size : 1);
+	}
+
+	static void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+	{
+		if (s_CountAllocations) ++s_Allocations;
+
+		const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+		return _aligned_malloc(size != 0 ? size : 1, align);
+#else
+		void* memory = nullptr;
+		return posix_memalign(&memory, align < sizeof(void*) ? sizeof(void*) : align, size != 0 ? size : 1) == 0 ? memory : nullptr;
+#endif
+	}
+
+	static void freeAligned(void* memory) noexcept
+	{
+#ifdef _WIN32
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	if (void* memory = annileen::allocate(size)) return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	if (void* memory = annileen::allocate(size)) return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return annileen::allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return annileen::allocate(size); }
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void* memory = annileen::allocateAligned(size, alignment)) return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	if (void* memory = annileen::allocateAligned(size, alignment)) return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return annileen::allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return annileen::allocateAligned(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept { annileen::freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { annileen::freeAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { annileen::freeAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { annileen::freeAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { annileen::freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { annileen::freeAligned(memory); }
+
+namespace annileen
+{
+	// Without this the steady state check would pass for nothing, if the counting forms were
+	// not the ones linked in.
+	ANNILEEN_TEST(allocationCounting, "scene/allocations/counting")
+	{
+		struct alignas(64) Aligned
+		{
+			float values[16];
+		};
+
+		s_Allocations = 0;
+		s_CountAllocations = true;
+		int* volatile single = new int(0);
+		int* volatile array = new int[4];
+		Aligned* volatile aligned = new Aligned();
+		delete single;
+		delete[] array;
+		delete aligned;
+		s_CountAllocations = false;
+
+		test.expect(s_Allocations == 3, fmt::format("{} of 3 heap allocations were counted", s_Allocations));
+	}
+
+	// Creating and destroying nodes with models must not reach the general heap once the
+	// pools are warm.
+	ANNILEEN_TEST(allocationSteadyState, "scene/allocations/steady-state")
+	{
+		const uint32_t nodeCount = 2000;
+		const uint32_t warmupRounds = 3;
+		const uint32_t rounds = 100;
+
+		std::unique_ptr<MeshGroup> cube = createCube();
+		Scene scene;
+		std::vector<SceneNodePtr> nodes;
+		nodes.reserve(nodeCount);
+
+		// Nodes with a model each, as chunk streaming makes them. Names fit in the small string
+		// buffer. Lights and cameras are left out, the scene keeps them in lists, and so are
+		// children, whose parent's Transform keeps them in an array of its own.
+		auto round = [&scene, &nodes, &cube, nodeCount]()
+		{
+			for (uint32_t i = 0; i < nodeCount; ++i)
+			{
+				SceneNodePtr node = scene.createNode("Chunk");
+				node->addModule<Model>()->setMeshGroup(cube.get());
+				nodes.push_back(node);
+			}
+
+			for (SceneNodePtr node : nodes)
+			{
+				scene.destroyNode(node);
+			}
+			nodes.clear();
+		};
+
+		for (uint32_t i = 0; i < warmupRounds; ++i) round();
+
+		s_Allocations = 0;
+		s_CountAllocations = true;
+		for (uint32_t i = 0; i < rounds; ++i) round();
+		s_CountAllocations = false;
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Allocation count: {} heap allocations creating and destroying {} nodes with models {} times, node pool {} pages, model storage {} pages.",
+			s_Allocations, nodeCount, rounds, scene.getNodePoolStats().pages, scene.getModuleStorage<Model>().getStats().pages);
+
+		test.expect(s_Allocations == 0, fmt::format("the steady state create and destroy loop made {} heap allocations", s_Allocations));
+	}
+}
@@ -0,0 +1,343 @@
+#include "test.h"
+#include "testassets.h"
+
+#include <engine/serviceprovider.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace annileen
+{
+	// Starts an asynchronous load of every asset of the set, returning them in set order.
+	static std::vector<AssetObject*> loadAllAsync(AssetManager& assetManager, const AssetLoadingSet& set)
+	{
+		std::vector<AssetObject*> assets;
+		assets.reserve(set.size());
+
+		for (const auto& [vertex, fragment] : set.shaders) assets.push_back(assetManager.loadShaderAsync(vertex, fragment));
+		for (const auto& name : set.textures) assets.push_back(assetManager.loadTextureAsync(name));
+		for (const auto& name : set.cubemaps) assets.push_back(assetManager.loadCubemapAsync(name));
+		for (const auto& name : set.meshes) assets.push_back(assetManager.loadMeshAsync(name));
+		for (const auto& name : set.fonts) assets.push_back(assetManager.loadFontAsync(name));
+
+		return assets;
+	}
+
+	// Every asset of the table loaded asynchronously ends up ready, swapped in by update().
+	ANNILEEN_TEST(assetAsyncLoading, "assets/async-loading")
+	{
+		const uint32_t maxUpdates = 100000;
+
+		TestAssetManager assetManager(testAssetFile);
+		const AssetLoadingSet set = sortAssets(assetManager.get());
+		if (!test.expect(set.size() > 0, fmt::format("no assets in '{}', build the assets first", testAssetFile))) return;
+
+		const std::vector<AssetObject*> assets = loadAllAsync(assetManager.get(), set);
+
+		uint32_t updates = 0;
+		while (assetManager->isLoading() && updates < maxUpdates)
+		{
+			assetManager->update();
+			++updates;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		if (!test.expect(!assetManager->isLoading(), fmt::format("{} loads were still running after {} updates", assetManager->getPendingLoads(), maxUpdates))) return;
+
+		const size_t failed = std::count_if(assets.begin(), assets.end(), [](const AssetObject* asset) { return asset->m_State == AssetState::Failed; });
+		const size_t ready = std::count_if(assets.begin(), assets.end(), [](const AssetObject* asset) { return asset->isReady(); });
+		test.expect(failed == 0, fmt::format("{} of {} assets failed to load asynchronously", failed, assets.size()));
+		test.expect(ready == assets.size(), fmt::format("{} of {} assets are ready once nothing is loading", ready, assets.size()));
+	}
+
+	// Every asset loaded blocking and asynchronously, with the time update() held the main thread.
+	ANNILEEN_BENCHMARK(assetLoading, "assets/loading")
+	{
+		using Clock = std::chrono::steady_clock;
+		auto millisecondsSince = [](Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		};
+
+		// Separate managers, so the asynchronous loads don't find the blocking ones done.
+		double blockingTime;
+		size_t assetCount;
+		{
+			TestAssetManager assetManager(testAssetFile);
+			const AssetLoadingSet set = sortAssets(assetManager.get());
+			assetCount = set.size();
+
+			auto start = Clock::now();
+			for (const auto& [vertex, fragment] : set.shaders) assetManager->loadShader(vertex, fragment);
+			for (const auto& name : set.textures) assetManager->loadTexture(name);
+			for (const auto& name : set.cubemaps) assetManager->loadCubemap(name);
+			for (const auto& name : set.meshes) assetManager->loadMesh(name);
+			for (const auto& name : set.fonts) assetManager->loadFont(name);
+			blockingTime = millisecondsSince(start);
+		}
+
+		TestAssetManager assetManager(testAssetFile);
+		const AssetLoadingSet set = sortAssets(assetManager.get());
+
+		auto start = Clock::now();
+		const std::vector<AssetObject*> assets = loadAllAsync(assetManager.get(), set);
+		double stallTime = millisecondsSince(start);
+		const double startTime = stallTime;
+
+		// One update per simulated frame, the main thread is otherwise free.
+		double worstUpdate = 0.0;
+		uint32_t updates = 0;
+		while (assetManager->isLoading())
+		{
+			auto updateStart = Clock::now();
+			assetManager->update();
+			const double updateTime = millisecondsSince(updateStart);
+
+			stallTime += updateTime;
+			worstUpdate = std::max(worstUpdate, updateTime);
+			updates++;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		const double asyncTime = millisecondsSince(start);
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset loading: {} assets, blocking {:.2f} ms.", assetCount, blockingTime);
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset loading: asynchronous {:.2f} ms, main thread {:.2f} ms ({:.2f} ms starting, worst of {} updates {:.2f} ms).",
+			asyncTime, stallTime, startTime, updates, worstUpdate);
+
+		const size_t failed = std::count_if(assets.begin(), assets.end(), [](const AssetObject* asset) { return asset->m_State == AssetState::Failed; });
+		test.expect(failed == 0, fmt::format("{} assets failed to load asynchronously", failed));
+	}
+
+	// Drops every file under the directory from the system file cache. Returns false where
+	// that isn't possible.
+	static bool evictFromCache(const std::filesystem::path& directory)
+	{
+#if defined(__linux__)
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+		{
+			if (!entry.is_regular_file()) continue;
+
+			int file = open(entry.path().c_str(), O_RDONLY);
+			if (file < 0) continue;
+
+			// Clean pages only, which a cache of files nobody writes to is made of.
+			posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+			close(file);
+		}
+		return !error;
+#else
+		return false;
+#endif
+	}
+
+	// The archive holds the bytes and descriptors of the loose files it was packed from.
+	ANNILEEN_TEST(assetArchiveContents, "assets/archive-contents")
+	{
+		TestAssetManager archive(testAssetFile);
+		TestAssetManager loose(testAssetFile, false);
+		if (!test.expect(archive->isUsingArchive(), fmt::format("no usable archive next to '{}', build the assets first", testAssetFile))) return;
+
+		const AssetLoadingSet set = sortAssets(loose.get());
+		std::vector<std::string> names = set.textures;
+		names.insert(names.end(), set.cubemaps.begin(), set.cubemaps.end());
+		names.insert(names.end(), set.meshes.begin(), set.meshes.end());
+		names.insert(names.end(), set.fonts.begin(), set.fonts.end());
+		for (const auto& [vertex, fragment] : set.shaders)
+		{
+			names.push_back(vertex);
+			names.push_back(fragment);
+		}
+
+		for (const std::string& name : names)
+		{
+			if (!test.expect(archive.getEntry(name) != nullptr, fmt::format("'{}' is missing from the archive", name))) continue;
+
+			test.expect(archive.readBytes(name) == loose.readBytes(name), fmt::format("'{}' has other bytes in the archive", name));
+		}
+
+		for (const std::string& name : set.textures)
+		{
+			const TextureDescriptor archived = archive->loadTextureDescriptor(archive.getEntry(name));
+			const TextureDescriptor descriptor = loose->loadTextureDescriptor(loose.getEntry(name));
+			test.expect(archived.m_MipMap == descriptor.m_MipMap && archived.m_Filtering == descriptor.m_Filtering,
+				fmt::format("'{}' has another texture descriptor in the archive", name));
+		}
+
+		for (const std::string& name : set.meshes)
+		{
+			test.expect(archive->loadMeshDescriptor(archive.getEntry(name)).m_Normals == loose->loadMeshDescriptor(loose.getEntry(name)).m_Normals,
+				fmt::format("'{}' has another mesh descriptor in the archive", name));
+		}
+	}
+
+	// Finding and reading every asset through the archive and through loose files, cold and warm.
+	ANNILEEN_BENCHMARK(assetStartup, "assets/startup")
+	{
+		using Clock = std::chrono::steady_clock;
+		const uint32_t warmRuns = 5;
+
+		// Everything startup does per asset short of decoding it.
+		auto startup = [](bool useArchive)
+		{
+			auto start = Clock::now();
+
+			TestAssetManager assetManager(testAssetFile, useArchive);
+			const AssetLoadingSet set = sortAssets(assetManager.get());
+
+			for (const auto& [vertex, fragment] : set.shaders)
+			{
+				assetManager.prefetch(vertex);
+				assetManager.prefetch(fragment);
+			}
+			for (const auto& name : set.textures)
+			{
+				assetManager->loadTextureDescriptor(assetManager.getEntry(name));
+				assetManager.prefetch(name);
+			}
+			for (const auto& name : set.meshes)
+			{
+				assetManager->loadMeshDescriptor(assetManager.getEntry(name));
+				assetManager.prefetch(name);
+			}
+			for (const auto& name : set.cubemaps) assetManager.prefetch(name);
+			for (const auto& name : set.fonts) assetManager.prefetch(name);
+
+			return std::make_pair(std::chrono::duration<double, std::milli>(Clock::now() - start).count(), assetManager->isUsingArchive());
+		};
+
+		const std::filesystem::path directory = std::filesystem::path(testAssetFile).parent_path();
+
+		for (bool useArchive : { true, false })
+		{
+			const char* name = useArchive ? "archive" : "loose files";
+
+			// Cold first, the warm runs would fill the cache anyway.
+			double cold = -1.0;
+			if (evictFromCache(directory))
+			{
+				cold = startup(useArchive).first;
+			}
+
+			double warm = 0.0;
+			for (uint32_t run = 0; run < warmRuns; ++run)
+			{
+				const auto [time, usedArchive] = startup(useArchive);
+				if (!test.expect(!useArchive || usedArchive, fmt::format("no usable archive next to '{}', build the assets first", testAssetFile))) return;
+				warm += time / warmRuns;
+			}
+
+			if (cold >= 0.0)
+			{
+				ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset startup, {}: cold {:.2f} ms, warm {:.2f} ms.", name, cold, warm);
+			}
+			else
+			{
+				ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset startup, {}: warm {:.2f} ms (cold runs need Linux).", name, warm);
+			}
+		}
+	}
+
+	// The format and memory of every texture, against the RGBA8 without mips loading gave before.
+	ANNILEEN_BENCHMARK(textureMemory, "assets/texture-memory")
+	{
+		TestAssetManager assetManager(testAssetFile);
+		uint64_t uncompressedTotal = 0;
+		uint64_t total = 0;
+
+		for (const std::string& name : sortAssets(assetManager.get()).textures)
+		{
+			const Texture* texture = assetManager->loadTexture(name);
+			if (!test.expect(texture->isReady(), fmt::format("'{}' failed to load", name))) continue;
+
+			const bgfx::TextureInfo& info = texture->getInfo();
+			const uint64_t uncompressed = static_cast<uint64_t>(info.width) * info.height * 4;
+			uncompressedTotal += uncompressed;
+			total += info.storageSize;
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Texture memory, {}: {}x{} {}, {} mips, {:.1f} KiB (RGBA8 without mips {:.1f} KiB).",
+				name, info.width, info.height, bimg::getName(bimg::TextureFormat::Enum(info.format)), info.numMips,
+				info.storageSize / 1024.0, uncompressed / 1024.0);
+		}
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Texture memory: {:.2f} MiB, {:.2f} MiB as RGBA8 without mips.",
+			total / (1024.0 * 1024.0), uncompressedTotal / (1024.0 * 1024.0));
+	}
+
+	// Loads the engine's permutation table and every shader pair of the asset table, returning
+	// the time it took. Expects every program to load.
+	static double loadAllShaders(TestContext& test, TestAssetManager& assetManager, const std::vector<ShaderPermutation>& permutations)
+	{
+		const AssetLoadingSet set = sortAssets(assetManager.get());
+
+		auto start = std::chrono::steady_clock::now();
+		for (const ShaderPermutation& permutation : permutations) assetManager->addShaderPermutation(permutation);
+		assetManager->loadShaderPermutations();
+		for (const auto& [vertex, fragment] : set.shaders)
+		{
+			const Shader* shader = assetManager->loadShader(vertex, fragment);
+			test.expect(shader->m_State != AssetState::Failed, fmt::format("the program of '{}' and '{}' failed to load", vertex, fragment));
+		}
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		for (const ShaderPermutation& permutation : permutations)
+		{
+			const Shader* shader = assetManager->getShaderPermutation(permutation.program, permutation.features);
+			test.expect(shader != nullptr && shader->m_State != AssetState::Failed,
+				fmt::format("permutation {} of '{}' failed to load", permutation.features, permutation.program));
+		}
+
+		return time;
+	}
+
+	// Every permutation loads whether programs share their stages or not, and sharing
+	// creates no more stages than creating them per program.
+	ANNILEEN_TEST(shaderPermutations, "assets/shader-permutations")
+	{
+		const std::vector<ShaderPermutation> permutations = TestAssetManager::getShaderPermutations(*ServiceProvider::getAssetManager());
+
+		auto createShaders = [&test, &permutations](bool share)
+		{
+			TestAssetManager assetManager(testAssetFile);
+			assetManager.setShareShaderStages(share);
+			loadAllShaders(test, assetManager, permutations);
+			return assetManager->getShaderStats();
+		};
+
+		const ShaderStats perProgram = createShaders(false);
+		const ShaderStats shared = createShaders(true);
+
+		test.expect(shared.stageRequests == perProgram.stageRequests && shared.programRequests == perProgram.programRequests,
+			"sharing stages changed what was asked for");
+		test.expect(shared.stagesCreated <= perProgram.stagesCreated,
+			fmt::format("{} stages were created shared and {} per program", shared.stagesCreated, perProgram.stagesCreated));
+	}
+
+	// Shader permutations created with stages shared and per program.
+	ANNILEEN_BENCHMARK(shaderStartup, "assets/shader-startup")
+	{
+		const std::vector<ShaderPermutation> permutations = TestAssetManager::getShaderPermutations(*ServiceProvider::getAssetManager());
+
+		for (const bool share : { false, true })
+		{
+			TestAssetManager assetManager(testAssetFile);
+			assetManager.setShareShaderStages(share);
+			const double time = loadAllShaders(test, assetManager, permutations);
+
+			const ShaderStats& stats = assetManager->getShaderStats();
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Shader startup, stages {}: {:.2f} ms, {} of {} stages and {} of {} programs created.",
+				share ? "shared" : "per program", time, stats.stagesCreated, stats.stageRequests, stats.programsCreated, stats.programRequests);
+		}
+	}
+}
@@ -0,0 +1,185 @@
+#include "test.h"
+#include "testassets.h"
+
+#include <engine/core/file.h>
+#include <engine/core/logger.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace annileen
+{
+	// Resident memory of the process in bytes, 0 where it can't be queried.
+	static size_t getResidentBytes()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return counters.WorkingSetSize;
+#elif defined(__linux__)
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+		{
+			if (line.compare(0, 6, "VmRSS:") == 0) return std::stoull(line.substr(6)) * 1024;
+		}
+		return 0;
+#else
+		return 0;
+#endif
+	}
+
+	// Every regular file under the directory, none if it can't be listed.
+	static std::vector<std::filesystem::path> findFiles(const std::string& directory)
+	{
+		std::vector<std::filesystem::path> files;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+		{
+			if (entry.is_regular_file()) files.push_back(entry.path());
+		}
+		return files;
+	}
+
+	// A mapping sees the bytes a stream reads, for every asset source.
+	ANNILEEN_TEST(fileMappedReads, "files/mapped-reads")
+	{
+		const std::vector<std::filesystem::path> files = findFiles(testSourceDirectory);
+		if (!test.expect(!files.empty(), fmt::format("no files found in '{}'", testSourceDirectory))) return;
+
+		for (const auto& path : files)
+		{
+			const std::vector<char> streamed = readWholeFile(path);
+			auto file = MappedFile::open(path.string());
+			if (!test.expect(file != nullptr, fmt::format("'{}' could not be mapped", path.string()))) continue;
+
+			file->prefetch();
+			test.expect(file->getSize() == streamed.size() && std::memcmp(file->getData(), streamed.data(), streamed.size()) == 0,
+				fmt::format("the mapping of '{}' has other bytes than a stream reads", path.string()));
+		}
+	}
+
+	// Empty files give an empty view, missing ones none.
+	ANNILEEN_TEST(fileMappedEdges, "files/mapped-edges")
+	{
+		TestDirectory directory("annileen_mapped_edges");
+		if (!test.expect(directory.isValid(), "the temporary directory could not be created")) return;
+
+		const std::filesystem::path empty = directory.getPath() / "empty.bin";
+		writeWholeFile(empty, {});
+
+		auto file = MappedFile::open(empty.string());
+		if (test.expect(file != nullptr, "an empty file could not be mapped"))
+		{
+			file->prefetch();
+			test.expect(file->getSize() == 0, fmt::format("an empty file maps to {} bytes", file->getSize()));
+		}
+
+		test.expect(MappedFile::open((directory.getPath() / "missing.bin").string()) == nullptr, "a missing file was mapped");
+	}
+
+	// Every asset source read through streams and through memory mappings.
+	ANNILEEN_BENCHMARK(fileReading, "files/reading")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const std::vector<std::filesystem::path> files = findFiles(testSourceDirectory);
+		if (!test.expect(!files.empty(), fmt::format("no files found in '{}'", testSourceDirectory))) return;
+
+		// Once through first, so both passes find the files in the page cache.
+		for (const auto& path : files)
+		{
+			auto file = MappedFile::open(path.string());
+			if (file != nullptr) file->prefetch();
+		}
+
+		// Summed over every byte, so the reads can't be optimized away.
+		uint64_t streamChecksum = 0;
+		uint64_t mappedChecksum = 0;
+		uint64_t totalBytes = 0;
+		uint32_t unreadable = 0;
+
+		// Streams, as AssetManager::loadBinaryFile and Font did: a heap buffer per file, and
+		// a second one for fonts, which the font manager used to copy.
+		double streamTime;
+		int64_t streamResident;
+		{
+			const size_t residentBefore = getResidentBytes();
+			std::vector<std::unique_ptr<uint8_t[]>> buffers;
+
+			auto start = Clock::now();
+			for (const auto& path : files)
+			{
+				std::ifstream file(path, std::ios::binary | std::ios::ate);
+				if (!file.is_open())
+				{
+					++unreadable;
+					continue;
+				}
+
+				const size_t size = static_cast<size_t>(file.tellg());
+				file.seekg(0, std::ios::beg);
+
+				buffers.emplace_back(new uint8_t[size + 1]);
+				file.read(reinterpret_cast<char*>(buffers.back().get()), size);
+				buffers.back()[size] = '\0';
+
+				const std::string extension = path.extension().string();
+				if (extension == ".ttf" || extension == ".otf")
+				{
+					buffers.emplace_back(new uint8_t[size]);
+					std::memcpy(buffers.back().get(), buffers[buffers.size() - 2].get(), size);
+				}
+
+				for (size_t i = 0; i < size; ++i) streamChecksum += buffers.back()[i];
+				totalBytes += size;
+			}
+			streamTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			streamResident = static_cast<int64_t>(getResidentBytes()) - static_cast<int64_t>(residentBefore);
+		}
+
+		double mappedTime;
+		int64_t mappedResident;
+		{
+			const size_t residentBefore = getResidentBytes();
+			std::vector<std::shared_ptr<MappedFile>> mappings;
+
+			auto start = Clock::now();
+			for (const auto& path : files)
+			{
+				auto file = MappedFile::open(path.string());
+				if (file == nullptr)
+				{
+					++unreadable;
+					continue;
+				}
+
+				for (size_t i = 0; i < file->getSize(); ++i) mappedChecksum += file->getData()[i];
+				mappings.push_back(std::move(file));
+			}
+			mappedTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			mappedResident = static_cast<int64_t>(getResidentBytes()) - static_cast<int64_t>(residentBefore);
+		}
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "File reading: {} files, {:.2f} MB from '{}'.", files.size(), totalBytes / (1024.0 * 1024.0), testSourceDirectory);
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "File reading: streams {:.2f} ms, resident +{:.2f} MB.", streamTime, streamResident / (1024.0 * 1024.0));
+		// Mapped pages count as resident too, but they are clean file pages the system can drop.
+		ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "File reading: mappings {:.2f} ms, resident +{:.2f} MB, none of it heap.", mappedTime, mappedResident / (1024.0 * 1024.0));
+
+		test.expect(unreadable == 0, fmt::format("{} files could not be read", unreadable));
+		test.expect(streamChecksum == mappedChecksum, "streams and mappings read different bytes");
+	}
+}
@@ -0,0 +1,210 @@
+#include "test.h"
+#include "testassets.h"
+
+#include <engine/core/logger.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// Copies of assets in a directory of their own with an asset table listing them, so
+	// rewriting them leaves the built assets alone, and a manager hot reloading them.
+	struct HotReloadCase
+	{
+		TestDirectory directory;
+		std::string table;
+		std::unique_ptr<TestAssetManager> assetManager;
+
+		// Copies the loose file of the asset and its descriptor. Each type gets a directory of
+		// its own, textures and meshes may have descriptors of the same name.
+		bool copy(TestAssetManager& source, const std::string& name, const char* type)
+		{
+			const AssetTableEntry* entry = source.getEntry(name);
+			if (entry == nullptr || entry->m_Filepath.empty()) return false;
+
+			std::error_code error;
+			const std::filesystem::path from(entry->m_Filepath);
+			const std::filesystem::path to = directory.getPath() / type / from.filename();
+			std::filesystem::create_directories(to.parent_path(), error);
+			if (!std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, error)) return false;
+
+			std::filesystem::path descriptor = from;
+			descriptor.replace_extension(".toml");
+			if (descriptor != from && std::filesystem::exists(descriptor))
+			{
+				std::filesystem::copy_file(descriptor, to.parent_path() / descriptor.filename(), std::filesystem::copy_options::overwrite_existing, error);
+			}
+
+			table += fmt::format("[asset.\"{}\"]\npath = \"{}\"\ntype = \"{}\"\n\n", name, to.generic_string(), type);
+			return true;
+		}
+
+		// Starts hot reloading the copies. False if the mode isn't there, which only happens
+		// to Notify where there are no file notifications.
+		bool start(FileWatcher::Mode mode)
+		{
+			const std::string tableFile = (directory.getPath() / "assets.toml").string();
+			std::ofstream(tableFile) << table;
+
+			assetManager = std::make_unique<TestAssetManager>(tableFile, false);
+			(*assetManager)->setHotReload(true, mode);
+			return (*assetManager)->isHotReloading() && assetManager->getWatchMode() == mode;
+		}
+
+		// Rewritten as the asset tools do, and dated a second later for file systems with
+		// coarse times.
+		void rewrite(const std::string& name)
+		{
+			const std::string& path = assetManager->getEntry(name)->m_Filepath;
+			writeWholeFile(path, readWholeFile(path));
+
+			std::error_code error;
+			std::filesystem::last_write_time(path, std::filesystem::last_write_time(path, error) + std::chrono::seconds(1), error);
+		}
+
+		// Updates the manager once a millisecond until done returns true and nothing is
+		// loading, for 3 seconds at most. Returns whether it got there.
+		template <typename Done>
+		bool updateUntil(Done done)
+		{
+			auto start = std::chrono::steady_clock::now();
+			while (std::chrono::steady_clock::now() - start < std::chrono::seconds(3))
+			{
+				(*assetManager)->update();
+				if (done() && !(*assetManager)->isLoading()) return true;
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			return false;
+		}
+
+		HotReloadCase() : directory("annileen_hot_reload")
+		{
+		}
+	};
+
+	static const char* getModeName(FileWatcher::Mode mode)
+	{
+		return mode == FileWatcher::Mode::Notify ? "notified" : "polling";
+	}
+
+	// The rewritten texture gets a new handle of the same size.
+	static void checkTextureReload(TestContext& test, FileWatcher::Mode mode)
+	{
+		HotReloadCase reload;
+		if (!test.expect(reload.directory.isValid(), "the temporary directory could not be created")) return;
+
+		TestAssetManager source(testAssetFile, false);
+		const AssetLoadingSet set = sortAssets(source.get());
+		if (!test.expect(!set.textures.empty() && reload.copy(source, set.textures[0], "texture"), "needs a texture in the asset table as a loose file")) return;
+		if (!reload.start(mode))
+		{
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset hot reload, {}: not available here, skipped.", getModeName(mode));
+			return;
+		}
+
+		const std::string& name = set.textures[0];
+		Texture* texture = (*reload.assetManager)->loadTexture(name);
+		const bgfx::TextureHandle handle = texture->getHandle();
+		const bgfx::TextureInfo info = texture->getInfo();
+
+		reload.rewrite(name);
+		if (!test.expect(reload.updateUntil([&]() { return texture->getHandle().idx != handle.idx; }),
+			fmt::format("'{}' was not swapped within 3 seconds, {}", name, getModeName(mode)))) return;
+
+		test.expect(texture->isReady() && texture->getInfo().width == info.width && texture->getInfo().height == info.height,
+			fmt::format("'{}' came back different, {}", name, getModeName(mode)));
+	}
+
+	// The rewritten mesh replaces the meshes of its group with as many new ones.
+	static void checkMeshReload(TestContext& test, FileWatcher::Mode mode)
+	{
+		HotReloadCase reload;
+		if (!test.expect(reload.directory.isValid(), "the temporary directory could not be created")) return;
+
+		TestAssetManager source(testAssetFile, false);
+		const AssetLoadingSet set = sortAssets(source.get());
+		if (!test.expect(!set.meshes.empty() && reload.copy(source, set.meshes[0], "mesh"), "needs a mesh in the asset table as a loose file")) return;
+		if (!reload.start(mode))
+		{
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset hot reload, {}: not available here, skipped.", getModeName(mode));
+			return;
+		}
+
+		const std::string& name = set.meshes[0];
+		MeshGroup* meshGroup = (*reload.assetManager)->loadMesh(name);
+		const uint32_t revision = meshGroup->m_Revision;
+		const size_t meshCount = meshGroup->m_Meshes.size();
+
+		reload.rewrite(name);
+		if (!test.expect(reload.updateUntil([&]() { return meshGroup->m_Revision != revision; }),
+			fmt::format("'{}' was not swapped within 3 seconds, {}", name, getModeName(mode)))) return;
+
+		test.expect(meshGroup->m_Meshes.size() == meshCount, fmt::format("'{}' came back with {} meshes, {} expected, {}", name, meshGroup->m_Meshes.size(), meshCount, getModeName(mode)));
+	}
+
+	// The rewritten stage is swapped in and the program using it stays valid. Shaders of the
+	// same bytes are the same to bgfx, so there's no new handle to look for.
+	static void checkShaderReload(TestContext& test, FileWatcher::Mode mode)
+	{
+		HotReloadCase reload;
+		if (!test.expect(reload.directory.isValid(), "the temporary directory could not be created")) return;
+
+		TestAssetManager source(testAssetFile, false);
+		const AssetLoadingSet set = sortAssets(source.get());
+		if (!test.expect(!set.shaders.empty() && reload.copy(source, set.shaders[0].first, "shader") && reload.copy(source, set.shaders[0].second, "shader"),
+			"needs a shader in the asset table as loose files")) return;
+		if (!reload.start(mode))
+		{
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset hot reload, {}: not available here, skipped.", getModeName(mode));
+			return;
+		}
+
+		const auto& [vertex, fragment] = set.shaders[0];
+		Shader* shader = (*reload.assetManager)->loadShader(vertex, fragment);
+
+		const uint32_t reloaded = (*reload.assetManager)->getShaderStats().stagesReloaded;
+
+		reload.rewrite(vertex);
+		if (!test.expect(reload.updateUntil([&]() { return (*reload.assetManager)->getShaderStats().stagesReloaded > reloaded; }),
+			fmt::format("'{}' was not swapped within 3 seconds, {}", vertex, getModeName(mode)))) return;
+
+		test.expect(shader->isReady() && bgfx::isValid(shader->getProgram()), fmt::format("the program of '{}' is no longer valid, {}", vertex, getModeName(mode)));
+	}
+
+	ANNILEEN_TEST(hotReloadTextureNotified, "assets/hot-reload/texture-notified")
+	{
+		checkTextureReload(test, FileWatcher::Mode::Notify);
+	}
+
+	ANNILEEN_TEST(hotReloadTexturePolling, "assets/hot-reload/texture-polling")
+	{
+		checkTextureReload(test, FileWatcher::Mode::Polling);
+	}
+
+	ANNILEEN_TEST(hotReloadMeshNotified, "assets/hot-reload/mesh-notified")
+	{
+		checkMeshReload(test, FileWatcher::Mode::Notify);
+	}
+
+	ANNILEEN_TEST(hotReloadMeshPolling, "assets/hot-reload/mesh-polling")
+	{
+		checkMeshReload(test, FileWatcher::Mode::Polling);
+	}
+
+	ANNILEEN_TEST(hotReloadShaderNotified, "assets/hot-reload/shader-notified")
+	{
+		checkShaderReload(test, FileWatcher::Mode::Notify);
+	}
+
+	ANNILEEN_TEST(hotReloadShaderPolling, "assets/hot-reload/shader-polling")
+	{
+		checkShaderReload(test, FileWatcher::Mode::Polling);
+	}
+}
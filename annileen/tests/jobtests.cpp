@@ -0,0 +1,191 @@
+#include "test.h"
+
+#include <engine/core/jobsystem.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// Job systems of every size the cases run on. 0 workers runs every job on the waiting thread.
+	static const size_t s_WorkerCounts[] = { 0, 1, 3, 7 };
+	static const uint32_t s_Rounds = 20;
+
+	// Chains of jobs, each queued to run after the one before. Returns the jobs that ran
+	// before the one they depend on, or never ran.
+	static uint32_t runDependencyChains(JobSystem& jobs)
+	{
+		const size_t chainCount = 64;
+		const size_t chainLength = 32;
+
+		std::atomic<uint32_t> failures{ 0 };
+
+		std::vector<std::unique_ptr<JobCounter>> links;
+		std::vector<std::atomic<bool>> done(chainCount * chainLength);
+		for (size_t i = 0; i < chainCount * chainLength; ++i)
+		{
+			links.push_back(std::make_unique<JobCounter>());
+			done[i] = false;
+		}
+
+		JobCounter chainsDone;
+		for (size_t chain = 0; chain < chainCount; ++chain)
+		{
+			for (size_t link = 0; link < chainLength; ++link)
+			{
+				const size_t index = chain * chainLength + link;
+				auto job = [&done, &failures, index, link]()
+				{
+					if (link > 0 && !done[index - 1]) ++failures;
+					done[index] = true;
+				};
+
+				if (link == 0) jobs.run(job, links[index].get());
+				else jobs.runAfter(*links[index - 1], job, links[index].get());
+			}
+
+			jobs.runAfter(*links[chain * chainLength + chainLength - 1], []() {}, &chainsDone);
+		}
+
+		jobs.wait(chainsDone);
+		for (const auto& linkDone : done)
+		{
+			if (!linkDone) ++failures;
+		}
+
+		return failures;
+	}
+
+	ANNILEEN_TEST(jobDependencyChains, "jobs/dependency-chains")
+	{
+		for (size_t workers : s_WorkerCounts)
+		{
+			JobSystem jobs(workers);
+			uint32_t failures = 0;
+			for (uint32_t round = 0; round < s_Rounds; ++round)
+			{
+				failures += runDependencyChains(jobs);
+			}
+
+			test.expect(failures == 0, fmt::format("{} jobs with {} workers ran before their dependency or not at all", failures, workers));
+		}
+	}
+
+	// Every job waits for jobs it queued itself, which only finishes if waiting runs them.
+	ANNILEEN_TEST(jobNestedWaits, "jobs/nested-waits")
+	{
+		const uint32_t outerCount = 32;
+		const uint32_t innerCount = 16;
+
+		for (size_t workers : s_WorkerCounts)
+		{
+			JobSystem jobs(workers);
+			for (uint32_t round = 0; round < s_Rounds; ++round)
+			{
+				std::atomic<uint32_t> innerRuns{ 0 };
+				JobCounter outer;
+				for (uint32_t i = 0; i < outerCount; ++i)
+				{
+					jobs.run([&jobs, &innerRuns]()
+					{
+						JobCounter inner;
+						for (uint32_t j = 0; j < innerCount; ++j)
+						{
+							jobs.run([&innerRuns]() { ++innerRuns; }, &inner);
+						}
+						jobs.wait(inner);
+					}, &outer);
+				}
+
+				jobs.wait(outer);
+				if (!test.expect(innerRuns == outerCount * innerCount,
+					fmt::format("{} of {} nested jobs ran with {} workers", innerRuns.load(), outerCount * innerCount, workers))) break;
+			}
+		}
+	}
+
+	// Background jobs all run, and never on a thread waiting for frame jobs while there are
+	// workers to run them.
+	ANNILEEN_TEST(jobBackground, "jobs/background")
+	{
+		const uint32_t jobCount = 4;
+
+		for (size_t workers : s_WorkerCounts)
+		{
+			JobSystem jobs(workers);
+			for (uint32_t round = 0; round < s_Rounds; ++round)
+			{
+				const std::thread::id caller = std::this_thread::get_id();
+				std::atomic<uint32_t> runs{ 0 };
+				std::atomic<uint32_t> callerRuns{ 0 };
+
+				JobCounter background;
+				for (uint32_t i = 0; i < jobCount; ++i)
+				{
+					jobs.runBackground([&runs, &callerRuns, caller]()
+					{
+						if (std::this_thread::get_id() == caller) ++callerRuns;
+						std::this_thread::sleep_for(std::chrono::milliseconds(2));
+						++runs;
+					}, &background);
+				}
+
+				std::atomic<size_t> ranged{ 0 };
+				jobs.parallelFor(1 << 16, 64, [&ranged](size_t begin, size_t end) { ranged += end - begin; });
+				jobs.wait(background);
+
+				bool passed = test.expect(ranged == (1 << 16), fmt::format("parallelFor covered {} of {} items with {} workers", ranged.load(), 1 << 16, workers));
+				passed &= test.expect(runs == jobCount, fmt::format("{} of {} background jobs ran with {} workers", runs.load(), jobCount, workers));
+				passed &= test.expect(workers == 0 || callerRuns == 0, fmt::format("the waiting thread ran {} background jobs with {} workers", callerRuns.load(), workers));
+				if (!passed) break;
+			}
+		}
+	}
+
+	// parallelFor over a million items on 1 to 16 threads.
+	ANNILEEN_BENCHMARK(jobScaling, "jobs/scaling")
+	{
+		const size_t itemCount = 1 << 20;
+		const uint32_t repeats = 20;
+
+		std::vector<float> items(itemCount);
+		double singleThreadTime = 0.0;
+
+		for (size_t threadCount : { 1, 2, 4, 8, 16 })
+		{
+			JobSystem jobs(threadCount - 1);
+			std::fill(items.begin(), items.end(), -1.0f);
+
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t repeat = 0; repeat < repeats; ++repeat)
+			{
+				jobs.parallelFor(itemCount, 1024, [&items](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						const float x = static_cast<float>(i) * 0.001f;
+						items[i] = std::sin(x) * std::cos(x * 0.5f) + std::sqrt(x);
+					}
+				});
+			}
+			const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+			if (threadCount == 1) singleThreadTime = time;
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Job scaling: {} thread(s), parallel for {:.3f} ms, {:.2f}x speedup.",
+				threadCount, time, time > 0.0 ? singleThreadTime / time : 0.0);
+
+			// Every item written, none skipped by the ranges.
+			const size_t missed = static_cast<size_t>(std::count(items.begin(), items.end(), -1.0f));
+			test.expect(missed == 0, fmt::format("parallelFor on {} thread(s) left {} items unwritten", threadCount, missed));
+		}
+	}
+}
@@ -0,0 +1,131 @@
+#include "test.h"
+#include "testassets.h"
+
+#include <engine/engine.h>
+#include <engine/core/commandline.h>
+#include <engine/core/logger.h>
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace annileen;
+
+// Runs the engine test cases headless and returns 1 if any failed:
+//   annileen-tests [--benchmarks] [--list] [--job-workers <n>] [--submit-threads <n>] [name ...]
+// Names select the cases whose name starts with one of them, benchmarks included. Without
+// names every test runs, and the benchmarks too with --benchmarks.
+int main(int argc, char* argv[])
+{
+	CommandLineOptions options;
+	options.headless = true;
+
+	bool benchmarks = false;
+	bool list = false;
+	std::vector<std::string> filters;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		try
+		{
+			if (arg == "--benchmarks")
+			{
+				benchmarks = true;
+			}
+			else if (arg == "--list")
+			{
+				list = true;
+			}
+			else if (arg == "--job-workers" && hasValue)
+			{
+				options.jobWorkers = std::stoi(argv[++i]);
+			}
+			else if (arg == "--submit-threads" && hasValue)
+			{
+				options.submitThreads = std::stoi(argv[++i]);
+			}
+			else if (arg.rfind("--", 0) == 0)
+			{
+				std::cerr << "Unknown command line argument: " << arg << std::endl;
+				return 1;
+			}
+			else
+			{
+				filters.push_back(arg);
+			}
+		}
+		catch (const std::logic_error&)
+		{
+			std::cerr << "Invalid value for command line argument " << arg << ": " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<TestCase> selected;
+	for (const TestCase& testCase : getTestCases())
+	{
+		const std::string name = testCase.name;
+		bool matched = filters.empty() && (testCase.kind == TestKind::Test || benchmarks);
+		for (const std::string& filter : filters)
+		{
+			matched |= name.rfind(filter, 0) == 0;
+		}
+
+		if (matched)
+		{
+			selected.push_back(testCase);
+		}
+	}
+
+	if (list)
+	{
+		for (const TestCase& testCase : selected)
+		{
+			std::cout << testCase.name << (testCase.kind == TestKind::Benchmark ? " (benchmark)" : "") << std::endl;
+		}
+		return 0;
+	}
+
+	Engine* engine = Engine::getInstance();
+	if (engine->init(1920, 1080, testAssetFile, "annileen-tests", options) != 0)
+	{
+		std::cerr << "The engine could not start." << std::endl;
+		return 1;
+	}
+
+	uint32_t failedCount = 0;
+	for (const TestCase& testCase : selected)
+	{
+		TestContext test;
+
+		auto start = std::chrono::steady_clock::now();
+		testCase.function(test);
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (test.passed())
+		{
+			ANNILEEN_LOGF_INFO(LoggingChannel::Core, "[PASS] {}: {} checks, {:.1f} ms.", testCase.name, test.getCheckCount(), time);
+		}
+		else
+		{
+			++failedCount;
+			for (const std::string& failure : test.getFailures())
+			{
+				ANNILEEN_LOGF_ERROR(LoggingChannel::Core, "{}: {}", testCase.name, failure);
+			}
+			ANNILEEN_LOGF_ERROR(LoggingChannel::Core, "[FAIL] {}: {} of {} checks failed.", testCase.name,
+				test.getFailures().size(), test.getCheckCount());
+		}
+	}
+
+	ANNILEEN_LOGF_INFO(LoggingChannel::Core, "{} of {} test cases passed.", selected.size() - failedCount, selected.size());
+
+	Engine::destroy();
+
+	return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include "test.h"
+#include "testassets.h"
+
+#include <engine/modelloader.h>
+#include <engine/meshoptimizer.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// Quads along each side of the grid.
+	static const uint32_t s_GridSize = 128;
+
+	// Every triangle as the bytes of its three vertices, starting from the smallest so the
+	// winding counts, in sorted order. Meshes drawing the same triangles give the same list.
+	static std::vector<std::string> getTriangles(const MeshData& mesh)
+	{
+		const uint32_t stride = mesh.m_Layout.getStride() / sizeof(float);
+		const size_t vertexBytes = stride * sizeof(float);
+
+		std::vector<std::string> triangles;
+		triangles.reserve(mesh.m_Indices.size() / 3);
+
+		for (size_t i = 0; i + 2 < mesh.m_Indices.size(); i += 3)
+		{
+			const char* corners[3];
+			for (size_t c = 0; c < 3; ++c)
+			{
+				corners[c] = reinterpret_cast<const char*>(&mesh.m_Vertices[static_cast<size_t>(mesh.m_Indices[i + c]) * stride]);
+			}
+
+			size_t first = 0;
+			for (size_t c = 1; c < 3; ++c)
+			{
+				if (std::memcmp(corners[c], corners[first], vertexBytes) < 0) first = c;
+			}
+
+			std::string triangle;
+			for (size_t c = 0; c < 3; ++c)
+			{
+				triangle.append(corners[(first + c) % 3], vertexBytes);
+			}
+			triangles.push_back(std::move(triangle));
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// A size by size grid with a vertex per triangle corner in shuffled triangle order, the
+	// worst case for both caches, and where the result is known.
+	static MeshData buildShuffledGrid(uint32_t size)
+	{
+		MeshData grid;
+		grid.m_Layout.begin()
+			.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+			.end();
+
+		std::vector<glm::uvec2> corners;
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				corners.insert(corners.end(), { { x, y }, { x + 1, y }, { x, y + 1 }, { x + 1, y }, { x + 1, y + 1 }, { x, y + 1 } });
+			}
+		}
+
+		std::vector<uint32_t> order(corners.size() / 3);
+		for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+		std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+		for (uint32_t triangle : order)
+		{
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				const glm::vec2 corner(corners[triangle * 3 + c]);
+				grid.m_Vertices.insert(grid.m_Vertices.end(), { corner.x, corner.y, 0.0f, corner.x / size, corner.y / size });
+				grid.m_Indices.push_back(static_cast<uint32_t>(grid.m_Indices.size()));
+			}
+		}
+
+		return grid;
+	}
+
+	static MeshData optimizeCopy(const MeshData& mesh)
+	{
+		MeshData optimized = mesh;
+		optimized.optimize();
+		return optimized;
+	}
+
+	// Every mesh file under the source directory.
+	static std::vector<std::filesystem::path> findMeshFiles()
+	{
+		std::vector<std::filesystem::path> files;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(testSourceDirectory, error))
+		{
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+			if (entry.is_regular_file() && (extension == ".obj" || extension == ".gltf" || extension == ".glb")) files.push_back(entry.path());
+		}
+		return files;
+	}
+
+	// Imports the file as Assimp gives it and optimized. False with the reason in error if it can't.
+	static bool importMeshFile(const std::filesystem::path& file, std::vector<MeshData>& original, std::vector<MeshData>& optimized, std::string& error)
+	{
+		const MeshDescriptor descriptor { MeshDescriptor::Normals::Auto };
+
+		ModelLoader loader;
+		loader.setOptimize(false);
+		if (!loader.loadMeshData(file.string(), descriptor, original, error)) return false;
+
+		loader.setOptimize(true);
+		return loader.loadMeshData(file.string(), descriptor, optimized, error);
+	}
+
+	ANNILEEN_TEST(meshOptimizerGridTriangles, "mesh-optimizer/grid-triangles")
+	{
+		const MeshData grid = buildShuffledGrid(s_GridSize);
+		test.expect(getTriangles(grid) == getTriangles(optimizeCopy(grid)), "the grid draws different triangles once optimized");
+	}
+
+	// The corners the triangles share become one vertex each.
+	ANNILEEN_TEST(meshOptimizerGridVertices, "mesh-optimizer/grid-vertices")
+	{
+		const MeshData optimized = optimizeCopy(buildShuffledGrid(s_GridSize));
+		test.expect(optimized.getVertexCount() == (s_GridSize + 1) * (s_GridSize + 1),
+			fmt::format("the grid has {} vertices once optimized, {} expected", optimized.getVertexCount(), (s_GridSize + 1) * (s_GridSize + 1)));
+	}
+
+	// A grid drawn in cache order misses about once per triangle.
+	ANNILEEN_TEST(meshOptimizerGridAcmr, "mesh-optimizer/grid-acmr")
+	{
+		const MeshData optimized = optimizeCopy(buildShuffledGrid(s_GridSize));
+		const float acmr = MeshOptimizer::getAcmr(optimized.m_Indices, optimized.getVertexCount());
+		test.expect(acmr <= 1.0f, fmt::format("the grid has an ACMR of {:.3f} once optimized, 1 at most expected", acmr));
+	}
+
+	// Every mesh file under the source directory draws the same triangles optimized.
+	ANNILEEN_TEST(meshOptimizerFiles, "mesh-optimizer/files")
+	{
+		const std::vector<std::filesystem::path> files = findMeshFiles();
+		if (!test.expect(!files.empty(), fmt::format("no mesh files found in '{}'", testSourceDirectory))) return;
+
+		for (const auto& file : files)
+		{
+			std::vector<MeshData> original;
+			std::vector<MeshData> optimized;
+			std::string error;
+			if (!test.expect(importMeshFile(file, original, optimized, error), fmt::format("could not import '{}'. {}", file.string(), error))) continue;
+			if (!test.expect(original.size() == optimized.size(), fmt::format("'{}' has another number of meshes optimized", file.string()))) continue;
+
+			for (size_t i = 0; i < original.size(); ++i)
+			{
+				test.expect(getTriangles(original[i]) == getTriangles(optimized[i]), fmt::format("mesh {} of '{}' draws different triangles once optimized", i, file.string()));
+			}
+		}
+	}
+
+	// What optimizing does to the vertices and the vertex cache misses of every mesh file.
+	ANNILEEN_BENCHMARK(meshOptimizerStatistics, "mesh-optimizer/statistics")
+	{
+		for (const auto& file : findMeshFiles())
+		{
+			std::vector<MeshData> original;
+			std::vector<MeshData> optimized;
+			std::string error;
+
+			auto start = std::chrono::steady_clock::now();
+			const bool imported = importMeshFile(file, original, optimized, error);
+			const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			if (!test.expect(imported && original.size() == optimized.size(), fmt::format("could not import '{}'. {}", file.string(), error))) continue;
+
+			uint32_t verticesBefore = 0, verticesAfter = 0, missesBefore = 0, missesAfter = 0, triangles = 0, index16 = 0;
+			for (size_t i = 0; i < original.size(); ++i)
+			{
+				const uint32_t meshTriangles = static_cast<uint32_t>(original[i].m_Indices.size() / 3);
+				verticesBefore += original[i].getVertexCount();
+				verticesAfter += optimized[i].getVertexCount();
+				missesBefore += static_cast<uint32_t>(MeshOptimizer::getAcmr(original[i].m_Indices, original[i].getVertexCount()) * meshTriangles + 0.5f);
+				missesAfter += static_cast<uint32_t>(MeshOptimizer::getAcmr(optimized[i].m_Indices, optimized[i].getVertexCount()) * meshTriangles + 0.5f);
+				triangles += meshTriangles;
+				if (optimized[i].getVertexCount() <= 65536) index16++;
+			}
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Mesh optimizer, {}: {} triangles, {} -> {} vertices, ACMR {:.3f} -> {:.3f}, {} of {} meshes with 16 bit indices, {:.2f} ms importing both ways.",
+				file.filename().string(), triangles, verticesBefore, verticesAfter,
+				triangles > 0 ? static_cast<float>(missesBefore) / triangles : 0.0f,
+				triangles > 0 ? static_cast<float>(missesAfter) / triangles : 0.0f,
+				index16, optimized.size(), time);
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#include "test.h"
+#include "testassets.h"
+
+#include <engine/modelloader.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// The source of a built mesh under the source directory, which keeps the name of the mesh
+	// whatever its case. Empty if there is none.
+	static std::string findMeshSource(const std::string& name)
+	{
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(testSourceDirectory, error))
+		{
+			std::string leaf = entry.path().filename().string();
+			std::transform(leaf.begin(), leaf.end(), leaf.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+			if (entry.is_regular_file() && leaf == name) return entry.path().string();
+		}
+		return std::string();
+	}
+
+	// Cooked meshes draw as many submeshes and triangles as their sources imported through Assimp.
+	ANNILEEN_TEST(meshCooked, "assets/cooked-meshes")
+	{
+		TestAssetManager assetManager(testAssetFile);
+		uint32_t compared = 0;
+
+		for (const std::string& name : sortAssets(assetManager.get()).meshes)
+		{
+			const std::string source = findMeshSource(name);
+			if (!assetManager.isCookedMesh(name) || source.empty()) continue;
+
+			MeshFile::Header header;
+			std::string error;
+			if (!test.expect(assetManager.loadCookedMesh(name, header, nullptr, error), error)) continue;
+
+			ModelLoader loader;
+			std::vector<MeshData> meshes;
+			if (!test.expect(loader.loadMeshData(source, assetManager->loadMeshDescriptor(assetManager.getEntry(name)), meshes, error), error)) continue;
+
+			size_t indexCount = 0;
+			for (const MeshData& meshData : meshes) indexCount += meshData.m_Indices.size();
+
+			test.expect(header.submeshCount == meshes.size(), fmt::format("'{}' has {} submeshes cooked and {} imported", name, header.submeshCount, meshes.size()));
+			test.expect(header.indexCount == indexCount, fmt::format("'{}' has {} triangles cooked and {} imported", name, header.indexCount / 3, indexCount / 3));
+			compared++;
+		}
+
+		test.expect(compared > 0, fmt::format("no cooked mesh with its source under '{}', build the assets first", testSourceDirectory));
+	}
+
+	// Cooked meshes against their sources imported through Assimp, both all the way to bgfx buffers.
+	ANNILEEN_BENCHMARK(meshLoading, "assets/mesh-loading")
+	{
+		using Clock = std::chrono::steady_clock;
+		const uint32_t runs = 5;
+
+		auto millisecondsSince = [](Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		};
+
+		TestAssetManager assetManager(testAssetFile);
+		uint32_t compared = 0;
+
+		for (const std::string& name : sortAssets(assetManager.get()).meshes)
+		{
+			const std::string source = findMeshSource(name);
+			if (!assetManager.isCookedMesh(name) || source.empty()) continue;
+
+			const MeshDescriptor descriptor = assetManager->loadMeshDescriptor(assetManager.getEntry(name));
+			MeshFile::Header header = {};
+
+			double importTime = 0.0;
+			double cookedTime = 0.0;
+			for (uint32_t run = 0; run < runs; ++run)
+			{
+				// The way AssetManager::loadMesh gets there.
+				auto start = Clock::now();
+				{
+					ModelLoader loader;
+					std::vector<MeshData> meshes;
+					std::string error;
+					if (!test.expect(loader.loadMeshData(source, descriptor, meshes, error), error)) return;
+
+					MeshGroup meshGroup;
+					for (const MeshData& meshData : meshes)
+					{
+						meshGroup.m_Meshes.push_back(new Mesh());
+						meshData.createMesh(meshGroup.m_Meshes.back());
+					}
+				}
+				importTime += millisecondsSince(start) / runs;
+
+				start = Clock::now();
+				{
+					MeshGroup meshGroup;
+					std::string error;
+					if (!test.expect(assetManager.loadCookedMesh(name, header, &meshGroup, error), error)) return;
+				}
+				cookedTime += millisecondsSince(start) / runs;
+			}
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Mesh loading, {}: {} meshes, {} vertices, {} triangles. Assimp {:.2f} ms, cooked {:.2f} ms ({:.1f}x).",
+				name, header.submeshCount, header.vertexCount, header.indexCount / 3, importTime, cookedTime, importTime / std::max(cookedTime, 0.001));
+			compared++;
+		}
+
+		test.expect(compared > 0, fmt::format("no cooked mesh with its source under '{}', build the assets first", testSourceDirectory));
+	}
+}
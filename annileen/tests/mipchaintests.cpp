@@ -0,0 +1,108 @@
+#include "test.h"
+
+#include <engine/mipchain.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// Mip chains of images whose every level is known.
+
+	static std::vector<uint8_t> buildChain(const std::vector<uint8_t>& image, uint32_t width, uint32_t height)
+	{
+		std::vector<uint8_t> chain(MipChain::getChainSize(width, height));
+		MipChain::generate(image.data(), width, height, chain.data());
+		return chain;
+	}
+
+	ANNILEEN_TEST(mipChainLevels, "mip-chain/levels")
+	{
+		test.expect(MipChain::getLevelCount(1, 1) == 1 && MipChain::getChainSize(1, 1) == 4, "1x1 does not have a single level");
+		test.expect(MipChain::getLevelCount(256, 256) == 9, fmt::format("256x256 has {} levels, 9 expected", MipChain::getLevelCount(256, 256)));
+		test.expect(MipChain::getLevelCount(256, 1) == 9, fmt::format("256x1 has {} levels, 9 expected", MipChain::getLevelCount(256, 1)));
+		test.expect(MipChain::getLevelCount(5, 3) == 3 && MipChain::getChainSize(5, 3) == (15 + 2 + 1) * 4, "5x3 does not have levels 5x3, 2x1 and 1x1");
+	}
+
+	// A single colour stays that colour, whatever the size.
+	ANNILEEN_TEST(mipChainSolidColour, "mip-chain/solid-colour")
+	{
+		const uint8_t colour[4] = { 10, 200, 30, 255 };
+		std::vector<uint8_t> image;
+		for (uint32_t i = 0; i < 37 * 19; ++i) image.insert(image.end(), colour, colour + 4);
+
+		const std::vector<uint8_t> chain = buildChain(image, 37, 19);
+		bool same = true;
+		for (size_t i = 0; i < chain.size(); ++i) same = same && chain[i] == colour[i % 4];
+		test.expect(same, "a 37x19 single colour image changes colour in a smaller level");
+	}
+
+	// 2x2 to its rounded average, after the image itself.
+	ANNILEEN_TEST(mipChainAverage, "mip-chain/average")
+	{
+		const std::vector<uint8_t> image = { 0, 255, 100, 1,  255, 0, 100, 2,  100, 255, 100, 3,  1, 0, 100, 4 };
+		const std::vector<uint8_t> chain = buildChain(image, 2, 2);
+		if (!test.expect(chain.size() == 20, fmt::format("the 2x2 chain has {} bytes, 20 expected", chain.size()))) return;
+
+		test.expect(std::equal(image.begin(), image.end(), chain.begin()), "level 0 is not the image");
+		test.expect(chain[16] == 89 && chain[17] == 128 && chain[18] == 100 && chain[19] == 3,
+			fmt::format("2x2 averages to ({}, {}, {}, {}), (89, 128, 100, 3) expected", chain[16], chain[17], chain[18], chain[19]));
+	}
+
+	// A one pixel checkerboard turns grey from level 1 down.
+	ANNILEEN_TEST(mipChainCheckerboard, "mip-chain/checkerboard")
+	{
+		std::vector<uint8_t> image;
+		for (uint32_t y = 0; y < 64; ++y)
+		{
+			for (uint32_t x = 0; x < 64; ++x)
+			{
+				const uint8_t value = ((x + y) % 2) ? 255 : 0;
+				image.insert(image.end(), { value, value, value, 255 });
+			}
+		}
+
+		const std::vector<uint8_t> chain = buildChain(image, 64, 64);
+		bool grey = true;
+		for (size_t i = image.size(); i < chain.size(); ++i) grey = grey && chain[i] == ((i % 4 == 3) ? 255 : 128);
+		test.expect(grey, "a 64x64 checkerboard is not grey in every smaller level");
+	}
+
+	// Odd edges fold into the last pixel: a 3x1 row of 0, 30 and 90 gives 40.
+	ANNILEEN_TEST(mipChainOddEdge, "mip-chain/odd-edge")
+	{
+		const std::vector<uint8_t> image = { 0, 0, 0, 0,  30, 30, 30, 30,  90, 90, 90, 90 };
+		const std::vector<uint8_t> chain = buildChain(image, 3, 1);
+		if (!test.expect(chain.size() == 16, fmt::format("the 3x1 chain has {} bytes, 16 expected", chain.size()))) return;
+
+		test.expect(chain[12] == 40, fmt::format("3x1 of 0, 30 and 90 folds to {}, 40 expected", chain[12]));
+	}
+
+	// Every level of a noise image keeps the overall average.
+	ANNILEEN_TEST(mipChainNoise, "mip-chain/noise")
+	{
+		std::mt19937 random(3);
+		std::vector<uint8_t> image(128 * 128 * 4);
+		for (uint8_t& value : image) value = static_cast<uint8_t>(random() & 0xff);
+
+		const std::vector<uint8_t> chain = buildChain(image, 128, 128);
+		double levelZero = 0.0;
+		for (uint8_t value : image) levelZero += value;
+		levelZero /= image.size();
+
+		size_t offset = 0;
+		for (uint8_t level = 0; level < MipChain::getLevelCount(128, 128); ++level)
+		{
+			const size_t size = static_cast<size_t>(128 >> level) * (128 >> level) * 4;
+			double average = 0.0;
+			for (size_t i = offset; i < offset + size; ++i) average += chain[i];
+			average /= size;
+			offset += size;
+
+			test.expect(std::abs(average - levelZero) < 1.0, fmt::format("level {} of 128x128 noise averages {:.2f}, {:.2f} within 1 expected", level, average, levelZero));
+		}
+	}
+}
@@ -0,0 +1,187 @@
+#include "test.h"
+#include "testscene.h"
+
+#include <engine/engine.h>
+#include <engine/renderer.h>
+#include <engine/renderview.h>
+#include <engine/model.h>
+#include <engine/serviceprovider.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// 20000 cube draws encoded by 1, 2, 4 and 8 threads, every frame must count all of them.
+	// The encoding threads come from the job system, so --job-workers 7 or more gets all 8.
+	ANNILEEN_BENCHMARK(drawSubmission, "render/draw-submission")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const uint32_t columns = 200;
+		const uint32_t rows = 100;
+		const uint32_t warmupFrames = 5;
+		const uint32_t frames = 60;
+
+		std::shared_ptr<Material> material = createFlatMaterial();
+		if (!test.expect(material != nullptr, "the shadowmap shader permutation is missing")) return;
+
+		std::unique_ptr<MeshGroup> cube = createCube();
+		Scene scene;
+		Camera* camera = buildCubeWall(scene, cube.get(), material, columns, rows);
+		scene.updateTransforms();
+
+		Renderer* renderer = Engine::getInstance()->getRenderer();
+		const size_t engineWorkers = renderer->getSubmitWorkers();
+		renderer->setScene(&scene);
+		renderer->setActiveCamera(camera);
+
+		JobSystem* jobs = ServiceProvider::getJobSystem();
+		const size_t threadLimit = jobs != nullptr ? jobs->getWorkerCount() + 1 : 1;
+
+		double singleThreaded = 0.0;
+
+		for (size_t threads : { 1, 2, 4, 8 })
+		{
+			renderer->setSubmitWorkers(threads - 1);
+			const size_t usedThreads = std::min(renderer->getSubmitWorkers() + 1, threadLimit);
+
+			double cull = 0.0;
+			double submit = 0.0;
+			double total = 0.0;
+			uint32_t wrongFrames = 0;
+
+			for (uint32_t frame = 0; frame < warmupFrames + frames; ++frame)
+			{
+				auto start = Clock::now();
+				renderer->render();
+				const double renderTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				renderer->updateStats();
+				bgfx::frame();
+
+				const FrameStats* stats = renderer->getStats().getLastFrame();
+				if (stats == nullptr || stats->drawCalls != columns * rows) ++wrongFrames;
+
+				if (frame < warmupFrames) continue;
+
+				cull += renderer->getTimings().cull;
+				submit += renderer->getTimings().submit;
+				total += renderTime;
+			}
+
+			if (threads == 1) singleThreaded = submit;
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Renderer, "Draw submission: {} thread(s) ({} used), {} draws, cull {:.3f} ms, submit {:.3f} ms, render {:.3f} ms per frame, submit {:.2f}x.",
+				threads, usedThreads, columns * rows, cull / frames, submit / frames, total / frames, submit > 0.0 ? singleThreaded / submit : 0.0);
+
+			test.expect(wrongFrames == 0, fmt::format("{} of {} frames with {} thread(s) did not count {} draws",
+				wrongFrames, warmupFrames + frames, threads, columns * rows));
+		}
+
+		renderer->setSubmitWorkers(engineWorkers);
+		renderer->setActiveCamera(nullptr);
+		renderer->setScene(nullptr);
+	}
+
+	// The visible cubes of a known scene are counted, on the scene view only, and the counters
+	// start from zero again the next frame.
+	ANNILEEN_TEST(renderStatsScene, "render/stats/scene")
+	{
+		const uint32_t columns = 10;
+		const uint32_t rows = 5;
+		const uint32_t drawn = columns * rows;
+
+		std::shared_ptr<Material> material = createFlatMaterial();
+		if (!test.expect(material != nullptr, "the shadowmap shader permutation is missing")) return;
+
+		std::unique_ptr<MeshGroup> cube = createCube();
+		const uint64_t primitivesPerCube = cube->m_Meshes[0]->getPrimitiveCount();
+
+		Scene scene;
+		Camera* camera = buildCubeWall(scene, cube.get(), material, columns, rows);
+
+		// Neither of these may be counted: one is disabled, the other behind the camera.
+		SceneNodePtr disabled = scene.createNode("Disabled Cube");
+		Model* disabledModel = disabled->addModule<Model>();
+		disabledModel->init(cube.get(), material);
+		disabledModel->enabled = false;
+		disabled->getTransform().position(glm::vec3(0.0f, 0.0f, 150.0f));
+		SceneNodePtr culled = scene.createNode("Culled Cube");
+		culled->addModule<Model>()->init(cube.get(), material);
+		culled->getTransform().position(glm::vec3(0.0f, 0.0f, -150.0f));
+
+		scene.updateTransforms();
+
+		Renderer* renderer = Engine::getInstance()->getRenderer();
+		renderer->setScene(&scene);
+		renderer->setActiveCamera(camera);
+
+		const bgfx::ViewId sceneView = RenderView::getRenderView(RenderView::Scene)->getViewId();
+
+		renderer->render();
+		renderer->updateStats();
+		bgfx::frame();
+
+		const FrameStats rendered = *renderer->getStats().getLastFrame();
+		test.expect(rendered.drawCalls == drawn, fmt::format("{} draw calls counted, {} expected", rendered.drawCalls, drawn));
+		test.expect(rendered.primitives == drawn * primitivesPerCube, fmt::format("{} primitives counted, {} expected", rendered.primitives, drawn * primitivesPerCube));
+		test.expect(rendered.cpuCullTime == renderer->getTimings().cull && rendered.cpuSubmitTime == renderer->getTimings().submit,
+			"the CPU times differ from the renderer timings");
+
+		uint32_t viewDrawCalls = 0;
+		uint32_t sceneViewDrawCalls = 0;
+		for (const ViewStats& view : rendered.views)
+		{
+			viewDrawCalls += view.drawCalls;
+			if (view.viewId == sceneView) sceneViewDrawCalls = view.drawCalls;
+		}
+		test.expect(sceneViewDrawCalls == drawn, fmt::format("{} draw calls counted on the scene view, {} expected", sceneViewDrawCalls, drawn));
+		test.expect(viewDrawCalls == rendered.drawCalls, "the views don't add up to the frame");
+
+		renderer->updateStats();
+		bgfx::frame();
+
+		const FrameStats* empty = renderer->getStats().getLastFrame();
+		test.expect(empty->drawCalls == 0 && empty->primitives == 0, "the counters were not reset after the frame");
+		test.expect(empty->frame == rendered.frame + 1, "frame numbers are not consecutive");
+
+		renderer->setActiveCamera(nullptr);
+		renderer->setScene(nullptr);
+	}
+
+	// Draws added from every thread at once are all counted.
+	ANNILEEN_TEST(renderStatsConcurrentDraws, "render/stats/concurrent-draws")
+	{
+		const bgfx::ViewId sceneView = RenderView::getRenderView(RenderView::Scene)->getViewId();
+		const size_t concurrentDraws = 100000;
+
+		RenderStats stats;
+		if (JobSystem* jobs = ServiceProvider::getJobSystem())
+		{
+			jobs->parallelFor(concurrentDraws, 1000, [&stats, sceneView](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i) stats.addDraws(sceneView, 1, 3);
+			});
+		}
+		else
+		{
+			for (size_t i = 0; i < concurrentDraws; ++i) stats.addDraws(sceneView, 1, 3);
+		}
+		stats.endFrame({});
+
+		test.expect(stats.getLastFrame()->drawCalls == concurrentDraws && stats.getLastFrame()->primitives == concurrentDraws * 3,
+			fmt::format("{} of {} draws added from the job system were counted", stats.getLastFrame()->drawCalls, concurrentDraws));
+	}
+
+	ANNILEEN_TEST(renderStatsHistory, "render/stats/history")
+	{
+		RenderStats stats;
+		for (size_t i = 0; i < RenderStats::historySize + 10; ++i) stats.endFrame({});
+
+		test.expect(stats.getHistory().size() == RenderStats::historySize && stats.getHistory().front().frame == 10,
+			"the history does not keep the last frames");
+	}
+}
@@ -0,0 +1,116 @@
+#include "test.h"
+#include "testassets.h"
+
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// Assets of one type acquired, the first held throughout and the others released from
+	// the last to the second, so the last is the least recently used. Then a budget the last
+	// two can't fit in unloads what it requires.
+	template <typename T>
+	struct ResidencyCase
+	{
+		using Acquire = AssetRef<T> (AssetManager::*)(const std::string&, bool);
+
+		Acquire acquireAsset;
+		TestAssetManager assetManager;
+		std::vector<std::string> names;
+		// Declared after the manager, so they are released before it goes.
+		std::vector<AssetRef<T>> references;
+		std::vector<size_t> sizes;
+		uint32_t unloaded = 0;
+
+		// Needs 4 assets of the type, false if the table has fewer or one failed to load.
+		bool start(TestContext& test, const char* kind)
+		{
+			if (names.size() < 4)
+			{
+				ANNILEEN_LOGF_INFO(LoggingChannel::Asset, "Asset residency, {}: skipped, {} in the asset table and 4 are needed.", kind, names.size());
+				return false;
+			}
+
+			for (const std::string& name : names)
+			{
+				references.push_back(acquire(name));
+				sizes.push_back(references.back() ? references.back()->getMemorySize() : 0);
+				if (!test.expect(sizes.back() > 0, fmt::format("'{}' failed to load", name))) return false;
+			}
+
+			const size_t last = names.size() - 1;
+			for (size_t i = last; i >= 1; --i) references[i].reset();
+
+			assetManager->setMemoryBudget(assetManager->getMemoryUsage() - sizes[last] - sizes[last - 1]);
+			unloaded = assetManager->unloadUnused();
+			return true;
+		}
+
+		AssetRef<T> acquire(const std::string& name) { return (assetManager.get().*acquireAsset)(name, false); }
+
+		ResidencyCase(std::vector<std::string> AssetLoadingSet::* type, Acquire acquireFunction) :
+			acquireAsset(acquireFunction), assetManager(testAssetFile), names(sortAssets(assetManager.get()).*type)
+		{
+		}
+	};
+
+	// The two least recently used go, the one held and the ones released later stay.
+	template <typename T>
+	static void checkEvictionOrder(TestContext& test, ResidencyCase<T>& residency, const char* kind)
+	{
+		if (!residency.start(test, kind)) return;
+
+		test.expect(residency.unloaded == 2, fmt::format("{} {} were unloaded, 2 expected", residency.unloaded, kind));
+
+		const size_t last = residency.names.size() - 1;
+		for (const AssetResidency& asset : residency.assetManager->getResidency())
+		{
+			const size_t index = std::find(residency.names.begin(), residency.names.end(), asset.name) - residency.names.begin();
+			if (index == residency.names.size()) continue;
+
+			const bool leastRecent = index == last || index == last - 1;
+			test.expect(asset.loaded != leastRecent, fmt::format("'{}' was {}, {} expected", asset.name,
+				asset.loaded ? "kept" : "unloaded", leastRecent ? "unloaded" : "kept"));
+		}
+	}
+
+	// Acquiring an unloaded asset loads it again from scratch, the same as before.
+	template <typename T>
+	static void checkReloadAfterEviction(TestContext& test, ResidencyCase<T>& residency, const char* kind)
+	{
+		if (!residency.start(test, kind)) return;
+
+		const size_t last = residency.names.size() - 1;
+		AssetRef<T> reloaded = residency.acquire(residency.names[last]);
+		test.expect(reloaded && reloaded->isReady() && reloaded->getMemorySize() == residency.sizes[last],
+			fmt::format("'{}' came back different after it was unloaded", residency.names[last]));
+	}
+
+	ANNILEEN_TEST(residencyTextureEviction, "assets/residency/texture-eviction-order")
+	{
+		ResidencyCase<Texture> residency(&AssetLoadingSet::textures, &AssetManager::acquireTexture);
+		checkEvictionOrder(test, residency, "textures");
+	}
+
+	ANNILEEN_TEST(residencyTextureReload, "assets/residency/texture-reload")
+	{
+		ResidencyCase<Texture> residency(&AssetLoadingSet::textures, &AssetManager::acquireTexture);
+		checkReloadAfterEviction(test, residency, "textures");
+	}
+
+	ANNILEEN_TEST(residencyFontEviction, "assets/residency/font-eviction-order")
+	{
+		ResidencyCase<Font> residency(&AssetLoadingSet::fonts, &AssetManager::acquireFont);
+		checkEvictionOrder(test, residency, "fonts");
+	}
+
+	ANNILEEN_TEST(residencyFontReload, "assets/residency/font-reload")
+	{
+		ResidencyCase<Font> residency(&AssetLoadingSet::fonts, &AssetManager::acquireFont);
+		checkReloadAfterEviction(test, residency, "fonts");
+	}
+}
@@ -0,0 +1,267 @@
+#include "test.h"
+#include "testscene.h"
+
+#include <engine/scene.h>
+#include <engine/model.h>
+#include <engine/light.h>
+#include <engine/camera.h>
+#include <engine/core/logger.h>
+
+#include <chrono>
+#include <functional>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// Creating and destroying nodes a hundred times, after a first round that grows the node
+	// pool. It must not grow afterwards, and destroyed nodes must be gone.
+	ANNILEEN_BENCHMARK(sceneChurn, "scene/churn")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const uint32_t nodeCount = 10000;
+		const uint32_t rounds = 100;
+
+		Scene scene;
+		std::vector<SceneNodeHandle> parents;
+		parents.reserve(nodeCount);
+
+		bool leftOver = false;
+		double createTime = 0.0;
+		double destroyTime = 0.0;
+		size_t warmPages = 0;
+
+		for (uint32_t round = 0; round <= rounds; ++round)
+		{
+			auto createStart = Clock::now();
+			// Pairs of parent and child, so sibling links and transforms get exercised too.
+			for (uint32_t i = 0; i < nodeCount; i += 2)
+			{
+				SceneNodePtr parent = scene.createNode("Churn");
+				scene.createNode("Churn Child")->setParent(parent);
+				parents.push_back(parent->getHandle());
+			}
+			auto destroyStart = Clock::now();
+
+			for (SceneNodeHandle handle : parents)
+			{
+				scene.destroyNode(scene.getNode(handle));
+			}
+			auto destroyEnd = Clock::now();
+
+			if (round == 0)
+			{
+				warmPages = scene.getNodePoolStats().pages;
+			}
+			else
+			{
+				createTime += std::chrono::duration<double, std::milli>(destroyStart - createStart).count();
+				destroyTime += std::chrono::duration<double, std::milli>(destroyEnd - destroyStart).count();
+			}
+
+			// Destroyed parents take their children with them, and stale handles find nothing.
+			if (!scene.getNodeList().empty() || (!parents.empty() && scene.getNode(parents.front()) != nullptr))
+			{
+				leftOver = true;
+			}
+			parents.clear();
+		}
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Scene churn: {} nodes, {:.3f} ms to create and {:.3f} ms to destroy, averaged over {} rounds.",
+			nodeCount, createTime / rounds, destroyTime / rounds, rounds);
+
+		test.expect(scene.getNodePoolStats().pages == warmPages, fmt::format("the node pool grew from {} to {} pages after the first round",
+			warmPages, scene.getNodePoolStats().pages));
+		test.expect(!leftOver, "destroyed nodes were left in the scene");
+	}
+
+	// A destroyed node's handle finds nothing, even once a new node has taken its slot.
+	ANNILEEN_TEST(sceneStaleHandles, "scene/stale-handles")
+	{
+		Scene scene;
+		SceneNodePtr node = scene.createNode("Destroyed");
+		const SceneNodeHandle handle = node->getHandle();
+		scene.destroyNode(node);
+
+		SceneNodePtr replacement = scene.createNode("Replacement");
+		test.expect(replacement->getHandle().index == handle.index, "the freed slot was not reused");
+		test.expect(scene.getNode(handle) == nullptr, "a stale handle finds the node that took its slot");
+		test.expect(scene.getNode(replacement->getHandle()) == replacement, "a live handle does not find its node");
+		test.expect(replacement->getId() != (static_cast<uint64_t>(handle.generation) << 32 | handle.index), "a recreated node got the id of a destroyed one");
+	}
+
+	// 100000 models, every third one replaced, iterated through their storage, by module mask
+	// and through every node. All three must find the same models.
+	ANNILEEN_BENCHMARK(moduleIteration, "scene/module-iteration")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const uint32_t nodeCount = 100000;
+		const uint32_t passes = 20;
+
+		std::unique_ptr<MeshGroup> cube = createCube();
+		Scene scene;
+		scene.reserveNodes(nodeCount);
+
+		for (uint32_t i = 0; i < nodeCount; ++i)
+		{
+			SceneNodePtr node = scene.createNode("Iterated");
+			node->addModule<Model>()->setMeshGroup(cube.get());
+			node->getTransform().position(glm::vec3(static_cast<float>(i % 1000) - 500.0f, 0.0f, static_cast<float>(i / 1000)));
+		}
+
+		// Every third node replaced, so the storage has been through holes and reuse.
+		std::vector<SceneNodePtr> nodes = scene.getNodeList();
+		for (size_t i = 0; i < nodes.size(); i += 3)
+		{
+			scene.destroyNode(nodes[i]);
+		}
+		for (size_t i = 0; i < nodes.size(); i += 3)
+		{
+			SceneNodePtr node = scene.createNode("Iterated");
+			node->addModule<Model>()->setMeshGroup(cube.get());
+			node->getTransform().position(glm::vec3(static_cast<float>(i % 1000), 1.0f, 0.0f));
+		}
+		scene.updateTransforms();
+
+		// Each pass counts the models on the positive side of x, and sums their addresses so
+		// the three ways can be compared.
+		struct Result
+		{
+			size_t count = 0;
+			size_t positive = 0;
+			uintptr_t sum = 0;
+
+			void add(const Model* model)
+			{
+				count++;
+				positive += model->getWorldBounds().min.x >= 0.0f ? 1 : 0;
+				sum += reinterpret_cast<uintptr_t>(model);
+			}
+
+			bool operator==(const Result& other) const { return count == other.count && positive == other.positive && sum == other.sum; }
+		};
+
+		auto time = [passes](const std::function<Result()>& pass, Result& result)
+		{
+			auto start = Clock::now();
+			for (uint32_t i = 0; i < passes; ++i)
+			{
+				result = pass();
+			}
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / passes;
+		};
+
+		Result packed, masked, nodeWalk;
+		std::vector<SceneNodePtr> withModel;
+
+		const double packedTime = time([&scene]()
+		{
+			Result result;
+			scene.getModuleStorage<Model>().forEach([&result](Model* model) { result.add(model); });
+			return result;
+		}, packed);
+
+		const double maskedTime = time([&scene, &withModel]()
+		{
+			Result result;
+			withModel.clear();
+			scene.getNodesWith(ModuleType::mask<Model>(), withModel);
+			for (SceneNodePtr node : withModel) result.add(node->getModule<Model>());
+			return result;
+		}, masked);
+
+		const double nodeTime = time([&scene]()
+		{
+			Result result;
+			for (SceneNodePtr node : scene.getNodeList())
+			{
+				if (Model* model = node->getModule<Model>()) result.add(model);
+			}
+			return result;
+		}, nodeWalk);
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Module iteration: {} models, packed storage {:.3f} ms, nodes by module mask {:.3f} ms, every node {:.3f} ms.",
+			packed.count, packedTime, maskedTime, nodeTime);
+
+		test.expect(packed.count == nodeCount && packed == masked && packed == nodeWalk,
+			fmt::format("the packed storage found {} models, the module masks {} and the node list {}, {} expected",
+				packed.count, masked.count, nodeWalk.count, nodeCount));
+	}
+
+	// getModule finds what was added and nothing else, and stops finding what was removed.
+	ANNILEEN_TEST(moduleLookup, "scene/module-lookup")
+	{
+		Scene scene;
+		SceneNodePtr node = scene.createNode("Lookup");
+		Model* model = node->addModule<Model>();
+		Light* light = node->addModule<Light>();
+
+		test.expect(model != nullptr && node->getModule<Model>() == model, "getModule did not find the model added");
+		test.expect(light != nullptr && node->getModule<Light>() == light, "getModule did not find the light added");
+		test.expect(node->getModule<Camera>() == nullptr && !node->hasModule<Camera>(), "getModule found a camera never added");
+
+		test.expect(node->removeModule<Light>(), "the light could not be removed");
+		test.expect(node->getModule<Light>() == nullptr && !node->hasModule<Light>(), "getModule still finds the removed light");
+		test.expect(node->getModule<Model>() == model, "removing the light lost the model");
+	}
+
+	// getModule against the per node hash maps it replaced, over 10000 nodes with a model
+	// each and some with a light or a camera too.
+	ANNILEEN_BENCHMARK(moduleLookups, "scene/module-lookups")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const size_t nodeCount = 10000;
+		const uint32_t lookupCount = 1000000;
+
+		Scene scene;
+		for (size_t i = 0; i < nodeCount; ++i)
+		{
+			SceneNodePtr node = scene.createNode("Lookup");
+			node->addModule<Model>();
+			if (i % 4 == 0) node->addModule<Light>();
+			if (i % 16 == 0) node->addModule<Camera>();
+		}
+
+		// What SceneNode::getModule used to search, built once.
+		const std::vector<SceneNodePtr>& nodes = scene.getNodeList();
+		std::vector<std::unordered_map<std::type_index, SceneNodeModule*>> moduleMaps(nodes.size());
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			moduleMaps[i][typeid(Model)] = nodes[i]->getModule<Model>();
+			if (Light* light = nodes[i]->getModule<Light>()) moduleMaps[i][typeid(Light)] = light;
+			if (Camera* camera = nodes[i]->getModule<Camera>()) moduleMaps[i][typeid(Camera)] = camera;
+		}
+
+		// Summed, so the lookups can't be optimized away, and compared.
+		uintptr_t moduleSum = 0;
+		auto moduleStart = Clock::now();
+		for (uint32_t i = 0; i < lookupCount; ++i)
+		{
+			SceneNodePtr node = nodes[i % nodes.size()];
+			moduleSum += reinterpret_cast<uintptr_t>(node->getModule<Model>()) + reinterpret_cast<uintptr_t>(node->getModule<Light>());
+		}
+		const double moduleTime = std::chrono::duration<double, std::milli>(Clock::now() - moduleStart).count();
+
+		uintptr_t mapSum = 0;
+		auto mapStart = Clock::now();
+		for (uint32_t i = 0; i < lookupCount; ++i)
+		{
+			const auto& modules = moduleMaps[i % nodes.size()];
+			auto model = modules.find(typeid(Model));
+			auto light = modules.find(typeid(Light));
+			mapSum += reinterpret_cast<uintptr_t>(model != modules.end() ? model->second : nullptr)
+				+ reinterpret_cast<uintptr_t>(light != modules.end() ? light->second : nullptr);
+		}
+		const double mapTime = std::chrono::duration<double, std::milli>(Clock::now() - mapStart).count();
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Module lookups: {} model and light lookups over {} nodes, getModule {:.3f} ms, hash maps {:.3f} ms.",
+			lookupCount, nodes.size(), moduleTime, mapTime);
+
+		test.expect(moduleSum == mapSum, "getModule and the hash maps found different modules");
+	}
+}
@@ -0,0 +1,276 @@
+#include "test.h"
+#include "testscene.h"
+
+#include <engine/scene.h>
+#include <engine/scene/sceneserializer.h>
+#include <engine/model.h>
+#include <engine/light.h>
+#include <engine/camera.h>
+#include <engine/core/logger.h>
+
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// Nodes in the order SceneSerializer writes them: breadth first, siblings in order.
+	static std::vector<SceneNodePtr> getNodesBreadthFirst(Scene& scene)
+	{
+		std::vector<SceneNodePtr> nodes;
+		for (SceneNodePtr child = scene.getRoot()->getFirstChild(); child != nullptr; child = child->getNextSibling())
+		{
+			nodes.push_back(child);
+		}
+
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			for (SceneNodePtr child = nodes[i]->getFirstChild(); child != nullptr; child = child->getNextSibling())
+			{
+				nodes.push_back(child);
+			}
+		}
+
+		return nodes;
+	}
+
+	// The first difference between two nodes at the same place of two scenes, empty if none.
+	static std::string compareNodes(SceneNodePtr a, SceneNodePtr b, size_t aParent, size_t bParent)
+	{
+		if (a->name != b->name) return fmt::format("node '{}' came back named '{}'", a->name, b->name);
+		if (aParent != bParent) return fmt::format("node '{}' came back under another parent", a->name);
+		if (a->getAcive() != b->getAcive()) return fmt::format("node '{}' came back with another active state", a->name);
+
+		Transform& at = a->getTransform();
+		Transform& bt = b->getTransform();
+		if (at.position() != bt.position() || at.euler() != bt.euler() || at.scale() != bt.scale())
+		{
+			return fmt::format("node '{}' came back with another transform", a->name);
+		}
+
+		Model* am = a->getModule<Model>();
+		Model* bm = b->getModule<Model>();
+		if ((am == nullptr) != (bm == nullptr)) return fmt::format("node '{}' lost or gained a model", a->name);
+		if (am != nullptr && (am->enabled != bm->enabled || am->isStatic != bm->isStatic
+			|| am->castShadows != bm->castShadows || am->receiveShadows != bm->receiveShadows))
+		{
+			return fmt::format("the model of node '{}' came back with other flags", a->name);
+		}
+
+		Light* al = a->getModule<Light>();
+		Light* bl = b->getModule<Light>();
+		if ((al == nullptr) != (bl == nullptr)) return fmt::format("node '{}' lost or gained a light", a->name);
+		if (al != nullptr && (al->type != bl->type || al->enabled != bl->enabled || al->isStatic != bl->isStatic
+			|| al->generateShadows != bl->generateShadows || al->color != bl->color || al->intensity != bl->intensity))
+		{
+			return fmt::format("the light of node '{}' came back different", a->name);
+		}
+
+		Camera* ac = a->getModule<Camera>();
+		Camera* bc = b->getModule<Camera>();
+		if ((ac == nullptr) != (bc == nullptr)) return fmt::format("node '{}' lost or gained a camera", a->name);
+		if (ac != nullptr && (ac->clearType != bc->clearType || ac->enabled != bc->enabled || ac->isStatic != bc->isStatic
+			|| ac->fieldOfView != bc->fieldOfView || ac->nearClip != bc->nearClip || ac->farClip != bc->farClip || ac->clearColor != bc->clearColor))
+		{
+			return fmt::format("the camera of node '{}' came back different", a->name);
+		}
+
+		return "";
+	}
+
+	// The first difference between two scenes, empty if none.
+	static std::string compareScenes(Scene& a, Scene& b)
+	{
+		std::vector<SceneNodePtr> aNodes = getNodesBreadthFirst(a);
+		std::vector<SceneNodePtr> bNodes = getNodesBreadthFirst(b);
+		if (aNodes.size() != bNodes.size()) return fmt::format("{} nodes came back as {}", aNodes.size(), bNodes.size());
+
+		std::unordered_map<SceneNodePtr, size_t> aIndices, bIndices;
+		aIndices[a.getRoot()] = SIZE_MAX;
+		bIndices[b.getRoot()] = SIZE_MAX;
+		for (size_t i = 0; i < aNodes.size(); ++i)
+		{
+			aIndices[aNodes[i]] = i;
+			bIndices[bNodes[i]] = i;
+		}
+
+		for (size_t i = 0; i < aNodes.size(); ++i)
+		{
+			std::string difference = compareNodes(aNodes[i], bNodes[i], aIndices[aNodes[i]->getParent()], bIndices[bNodes[i]->getParent()]);
+			if (!difference.empty()) return difference;
+		}
+
+		return "";
+	}
+
+	// Every property the format keeps, on a small hierarchy. Models have no mesh, so no asset
+	// or material has to resolve; those are looked up by name, as --load-scene does.
+	static void buildSmallScene(Scene& scene)
+	{
+		SceneNodePtr world = scene.createNode("World");
+		SceneNodePtr sun = scene.createNode("Sun");
+		Light* light = sun->addModule<Light>();
+		light->type = LightType::Directional;
+		light->color = glm::vec3(1.0f, 0.9f, 0.7f);
+		light->intensity = 0.8f;
+		light->generateShadows = false;
+		sun->getTransform().euler(glm::vec3(-40.0f, 10.0f, 0.0f));
+
+		SceneNodePtr eye = scene.createNode("");
+		Camera* camera = eye->addModule<Camera>();
+		camera->fieldOfView = 75.0f;
+		camera->nearClip = 0.5f;
+		camera->farClip = 900.0f;
+		camera->clearColor = glm::vec3(0.1f, 0.2f, 0.3f);
+		eye->setParent(world);
+
+		for (int i = 0; i < 5; ++i)
+		{
+			SceneNodePtr block = scene.createNode(fmt::format("A block with a name too long for the small string buffer {}", i));
+			block->setParent(world);
+			block->setAcive(i % 2 == 0);
+			block->getTransform().position(glm::vec3(i * 1.5f, -2.25f, 1e-3f * i));
+			block->getTransform().scale(glm::vec3(1.0f, 2.0f + i, 0.5f));
+
+			Model* model = block->addModule<Model>();
+			model->isStatic = i % 2 == 1;
+			model->enabled = i != 3;
+			model->castShadows = i != 1;
+			model->receiveShadows = i != 2;
+
+			SceneNodePtr child = scene.createNode("Child");
+			child->setParent(block);
+			child->getTransform().euler(glm::vec3(0.0f, 30.0f * i, 0.0f));
+		}
+	}
+
+	// Saves the small scene in the directory and returns the file written, empty if it couldn't.
+	static std::string saveSmallScene(TestContext& test, const TestDirectory& directory)
+	{
+		if (!test.expect(directory.isValid(), "the temporary directory could not be created")) return "";
+
+		Scene scene;
+		buildSmallScene(scene);
+
+		const std::string file = (directory.getPath() / "small.anscene").string();
+		return test.expect(SceneSerializer::save(&scene, file), "the scene could not be saved") ? file : "";
+	}
+
+	ANNILEEN_TEST(serializationRoundTrip, "scene/serialization/round-trip")
+	{
+		TestDirectory directory("annileen_scene_round_trip");
+		if (!test.expect(directory.isValid(), "the temporary directory could not be created")) return;
+
+		Scene scene;
+		buildSmallScene(scene);
+
+		const std::string file = (directory.getPath() / "small.anscene").string();
+		if (!test.expect(SceneSerializer::save(&scene, file), "the scene could not be saved")) return;
+
+		Scene loaded;
+		if (!test.expect(SceneSerializer::load(&loaded, file), "the saved scene could not be loaded")) return;
+
+		const std::string difference = compareScenes(scene, loaded);
+		test.expect(difference.empty(), difference);
+	}
+
+	// Saving what was loaded gives the same bytes.
+	ANNILEEN_TEST(serializationResave, "scene/serialization/resave-same-bytes")
+	{
+		TestDirectory directory("annileen_scene_resave");
+		const std::string file = saveSmallScene(test, directory);
+		if (file.empty()) return;
+
+		Scene loaded;
+		if (!test.expect(SceneSerializer::load(&loaded, file), "the saved scene could not be loaded")) return;
+
+		const std::string again = (directory.getPath() / "again.anscene").string();
+		test.expect(SceneSerializer::save(&loaded, again) && readWholeFile(file) == readWholeFile(again), "saving a loaded scene gives another file");
+	}
+
+	// Instantiating a few nodes per call, as the SceneManager does, gives the same scene.
+	ANNILEEN_TEST(serializationSteppedInstantiate, "scene/serialization/stepped-instantiate")
+	{
+		TestDirectory directory("annileen_scene_stepped");
+		const std::string file = saveSmallScene(test, directory);
+		if (file.empty()) return;
+
+		SceneData data;
+		if (!test.expect(SceneSerializer::read(file, data), "the saved scene could not be read")) return;
+
+		Scene stepped;
+		uint32_t calls = 1;
+		while (!SceneSerializer::instantiate(&stepped, data, 3) && calls < 1000) ++calls;
+		test.expect(calls > 1, "3 nodes per call instantiated the whole scene at once");
+
+		const std::string again = (directory.getPath() / "stepped.anscene").string();
+		test.expect(SceneSerializer::save(&stepped, again) && readWholeFile(file) == readWholeFile(again),
+			fmt::format("instantiating in {} steps gives another scene", calls));
+	}
+
+	// Broken files are refused with a reason, not half loaded.
+	ANNILEEN_TEST(serializationBrokenFiles, "scene/serialization/broken-files")
+	{
+		TestDirectory directory("annileen_scene_broken");
+		const std::string file = saveSmallScene(test, directory);
+		if (file.empty()) return;
+
+		const std::vector<char> bytes = readWholeFile(file);
+		auto refuses = [&directory](const std::vector<char>& contents)
+		{
+			const std::filesystem::path broken = directory.getPath() / "broken.anscene";
+			writeWholeFile(broken, contents);
+
+			SceneData data;
+			return !SceneSerializer::read(broken.string(), data) && !data.error.empty();
+		};
+
+		std::vector<char> badMagic = bytes;
+		badMagic[0] = 'X';
+		std::vector<char> newerVersion = bytes;
+		const uint32_t nextVersion = SceneSerializer::version + 1;
+		std::memcpy(newerVersion.data() + 4, &nextVersion, sizeof(nextVersion));
+
+		test.expect(refuses(std::vector<char>(bytes.begin(), bytes.begin() + bytes.size() / 2)), "a truncated file was read");
+		test.expect(refuses(badMagic), "a file without the scene magic was read");
+		test.expect(refuses(newerVersion), "a file of a newer version was read");
+	}
+
+	// 100000 nodes: 1000 parents of 99 children, every node with a model, every hundredth a light.
+	ANNILEEN_BENCHMARK(serializationLarge, "scene/serialization/large")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		TestDirectory directory("annileen_scene_large");
+		if (!test.expect(directory.isValid(), "the temporary directory could not be created")) return;
+
+		const std::string file = (directory.getPath() / "large.anscene").string();
+
+		Scene scene;
+		buildLargeScene(scene, 1000, 99);
+
+		auto saveStart = Clock::now();
+		if (!test.expect(SceneSerializer::save(&scene, file), "the large scene could not be saved")) return;
+		const double saveTime = std::chrono::duration<double, std::milli>(Clock::now() - saveStart).count();
+
+		Scene loaded;
+		SceneData data;
+		auto readStart = Clock::now();
+		const bool read = SceneSerializer::read(file, data);
+		auto instantiateStart = Clock::now();
+		if (read) SceneSerializer::instantiate(&loaded, data);
+		auto end = Clock::now();
+
+		test.expect(read && loaded.getNodeList().size() == scene.getNodeList().size(),
+			fmt::format("{} nodes were saved, {} loaded", scene.getNodeList().size(), loaded.getNodeList().size()));
+		test.expect(loaded.getModuleStorage<Model>().size() == scene.getModuleStorage<Model>().size()
+			&& loaded.getModuleStorage<Light>().size() == scene.getModuleStorage<Light>().size(), "the large scene lost modules");
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Scene serialization: {} nodes, {:.2f} MB, save {:.2f} ms, read {:.2f} ms, instantiate {:.2f} ms.",
+			scene.getNodeList().size(), data.bytes.size() / (1024.0 * 1024.0), saveTime,
+			std::chrono::duration<double, std::milli>(instantiateStart - readStart).count(),
+			std::chrono::duration<double, std::milli>(end - instantiateStart).count());
+	}
+}
@@ -0,0 +1,251 @@
+#include "test.h"
+#include "testscene.h"
+
+#include <engine/scene.h>
+#include <engine/model.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// A grid of gridSize by layers by gridSize cubes 2 units apart, every other one static.
+	// The dynamic nodes go to dynamicNodes.
+	static void buildQueryGrid(Scene& scene, MeshGroup* cube, int gridSize, int layers, std::vector<SceneNodePtr>& dynamicNodes)
+	{
+		for (int x = 0; x < gridSize; ++x)
+		{
+			for (int z = 0; z < gridSize; ++z)
+			{
+				for (int y = 0; y < layers; ++y)
+				{
+					SceneNodePtr node = scene.createNode("Query Model");
+					Model* model = node->addModule<Model>();
+					model->setMeshGroup(cube);
+					model->isStatic = (x + y + z) % 2 == 0;
+					node->getTransform().position(glm::vec3(x * 2.0f, y * 2.0f, z * 2.0f));
+
+					if (!model->isStatic) dynamicNodes.push_back(node);
+				}
+			}
+		}
+	}
+
+	static std::vector<Aabb> makeQueries(std::mt19937& random, const Aabb& bounds, uint32_t count)
+	{
+		std::uniform_real_distribution<float> x(bounds.min.x, bounds.max.x);
+		std::uniform_real_distribution<float> y(bounds.min.y, bounds.max.y);
+		std::uniform_real_distribution<float> z(bounds.min.z, bounds.max.z);
+
+		std::vector<Aabb> queries;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			glm::vec3 center(x(random), y(random), z(random));
+			queries.push_back({ center - glm::vec3(8.0f), center + glm::vec3(8.0f) });
+		}
+		return queries;
+	}
+
+	// Queries for which the scene BVH and a scan of every model find different models.
+	static size_t countMismatches(Scene& scene, const std::vector<Aabb>& queries)
+	{
+		std::vector<Model*> bvhResults;
+		std::vector<Model*> linearResults;
+		size_t mismatches = 0;
+
+		for (const Aabb& query : queries)
+		{
+			bvhResults.clear();
+			linearResults.clear();
+			scene.queryAabb(query, bvhResults);
+			scene.getModuleStorage<Model>().forEach([&query, &linearResults](Model* model)
+			{
+				if (model->getWorldBounds().overlaps(query)) linearResults.push_back(model);
+			});
+
+			std::sort(bvhResults.begin(), bvhResults.end());
+			std::sort(linearResults.begin(), linearResults.end());
+			if (bvhResults != linearResults) ++mismatches;
+		}
+
+		return mismatches;
+	}
+
+	// Static models built in one go, then moved, destroyed, added and made dynamic a few at a
+	// time, which changes the static tree a leaf at a time. Queries find what a scan finds
+	// after every update.
+	ANNILEEN_TEST(spatialStaticChanges, "scene/spatial/static-changes")
+	{
+		// 576 static models, enough for the first update to build the static tree in one go.
+		const int gridSize = 24;
+		const int layers = 2;
+		const uint32_t queryCount = 500;
+
+		std::unique_ptr<MeshGroup> cube = createCube();
+		Scene scene;
+		std::vector<SceneNodePtr> dynamicNodes;
+		buildQueryGrid(scene, cube.get(), gridSize, layers, dynamicNodes);
+
+		std::mt19937 random(99);
+		const Aabb bounds = { glm::vec3(-4.0f), glm::vec3(gridSize * 2.0f + 4.0f, layers * 2.0f + 4.0f, gridSize * 2.0f + 4.0f) };
+
+		auto check = [&](const char* when)
+		{
+			scene.updateTransforms();
+			const size_t mismatches = countMismatches(scene, makeQueries(random, bounds, queryCount));
+			test.expect(mismatches == 0, fmt::format("{}: the BVH and the linear scan found different models for {} of {} queries", when, mismatches, queryCount));
+		};
+
+		check("as built");
+
+		std::vector<SceneNodePtr> nodes;
+		scene.getNodesWith(ModuleType::mask<Model>(), nodes);
+		std::vector<SceneNodePtr> staticNodes;
+		for (SceneNodePtr node : nodes)
+		{
+			if (node->getModule<Model>()->isStatic) staticNodes.push_back(node);
+		}
+
+		for (size_t i = 0; i < staticNodes.size(); i += 16)
+		{
+			staticNodes[i]->getTransform().translate(glm::vec3(0.5f, 3.0f, -1.0f), false);
+		}
+		check("after moving static models");
+
+		for (size_t i = 1; i < staticNodes.size(); i += 16)
+		{
+			scene.destroyNode(staticNodes[i]);
+		}
+		check("after destroying static models");
+
+		for (int i = 0; i < 10; ++i)
+		{
+			SceneNodePtr node = scene.createNode("Late Static Model");
+			Model* model = node->addModule<Model>();
+			model->setMeshGroup(cube.get());
+			model->isStatic = true;
+			node->getTransform().position(glm::vec3(i * 3.0f, 1.0f, 5.0f));
+		}
+		check("after adding static models");
+
+		for (size_t i = 2; i < staticNodes.size(); i += 16)
+		{
+			staticNodes[i]->getModule<Model>()->isStatic = false;
+		}
+		for (size_t i = 0; i < dynamicNodes.size(); i += 16)
+		{
+			dynamicNodes[i]->getModule<Model>()->isStatic = true;
+		}
+		check("after switching models between static and dynamic");
+
+		// Without a mesh a model has no bounds and leaves the tree.
+		for (size_t i = 3; i < staticNodes.size(); i += 16)
+		{
+			staticNodes[i]->getModule<Model>()->setMeshGroup(static_cast<MeshGroup*>(nullptr));
+		}
+		check("after taking meshes away");
+	}
+
+	// Box queries through the scene BVH against a scan of every model, over 16384 models.
+	// Also times an update that moves a few static models, which must not cost a rebuild
+	// of the static tree.
+	ANNILEEN_BENCHMARK(spatialQueries, "scene/spatial/queries")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const int gridSize = 64;
+		const int layers = 4;
+		const uint32_t queryCount = 10000;
+		const size_t movedStatics = 100;
+
+		// Declared first, the scene's models point to it.
+		std::unique_ptr<MeshGroup> cube = createCube();
+		Scene scene;
+		std::vector<SceneNodePtr> dynamicNodes;
+		buildQueryGrid(scene, cube.get(), gridSize, layers, dynamicNodes);
+
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> offset(-4.0f, 4.0f);
+		const Aabb bounds = { glm::vec3(-4.0f), glm::vec3(gridSize * 2.0f + 4.0f, layers * 2.0f + 4.0f, gridSize * 2.0f + 4.0f) };
+
+		std::vector<Model*> results;
+
+		// Once as built, once after the dynamic models moved and some static ones were destroyed.
+		for (int round = 0; round < 2; ++round)
+		{
+			if (round == 1)
+			{
+				for (SceneNodePtr node : dynamicNodes)
+				{
+					node->getTransform().translate(glm::vec3(offset(random), offset(random), offset(random)), false);
+				}
+
+				std::vector<SceneNodePtr> staticNodes;
+				scene.getNodesWith(ModuleType::mask<Model>(), staticNodes);
+				for (size_t i = 0; i < staticNodes.size(); i += 8)
+				{
+					if (staticNodes[i]->getModule<Model>()->isStatic) scene.destroyNode(staticNodes[i]);
+				}
+			}
+
+			scene.updateTransforms();
+
+			const std::vector<Aabb> queries = makeQueries(random, bounds, queryCount);
+
+			size_t bvhHits = 0;
+			auto bvhStart = Clock::now();
+			for (const Aabb& query : queries)
+			{
+				results.clear();
+				scene.queryAabb(query, results);
+				bvhHits += results.size();
+			}
+			const double bvhTime = std::chrono::duration<double, std::milli>(Clock::now() - bvhStart).count();
+
+			size_t linearHits = 0;
+			auto linearStart = Clock::now();
+			for (const Aabb& query : queries)
+			{
+				results.clear();
+				scene.getModuleStorage<Model>().forEach([&query, &results](Model* model)
+				{
+					if (model->getWorldBounds().overlaps(query)) results.push_back(model);
+				});
+				linearHits += results.size();
+			}
+			const double linearTime = std::chrono::duration<double, std::milli>(Clock::now() - linearStart).count();
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Spatial queries: {} box queries over {} models {}, BVH {:.3f} ms, linear scan {:.3f} ms, {} hits.",
+				queries.size(), scene.getModuleStorage<Model>().size(), round == 0 ? "as built" : "after moves", bvhTime, linearTime, bvhHits);
+
+			// Untimed, the same models for every query, not only the same count.
+			const size_t mismatches = countMismatches(scene, queries);
+			test.expect(mismatches == 0 && bvhHits == linearHits,
+				fmt::format("the BVH and the linear scan found different models for {} of {} queries {}", mismatches, queries.size(), round == 0 ? "as built" : "after moves"));
+		}
+
+		std::vector<SceneNodePtr> nodes;
+		scene.getNodesWith(ModuleType::mask<Model>(), nodes);
+		size_t moved = 0;
+		for (size_t i = 0; i < nodes.size() && moved < movedStatics; i += 7)
+		{
+			if (!nodes[i]->getModule<Model>()->isStatic) continue;
+
+			nodes[i]->getTransform().translate(glm::vec3(0.0f, 1.0f, 0.0f), false);
+			++moved;
+		}
+
+		auto updateStart = Clock::now();
+		scene.updateTransforms();
+		const double updateTime = std::chrono::duration<double, std::milli>(Clock::now() - updateStart).count();
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Spatial queries: an update moving {} static models took {:.3f} ms.", moved, updateTime);
+
+		const size_t mismatches = countMismatches(scene, makeQueries(random, bounds, 1000));
+		test.expect(mismatches == 0, fmt::format("the BVH and the linear scan found different models for {} of 1000 queries after moving static models", mismatches));
+	}
+}
@@ -0,0 +1,188 @@
+#include "test.h"
+#include "testscene.h"
+
+#include <engine/engine.h>
+#include <engine/renderer.h>
+#include <engine/serviceprovider.h>
+#include <engine/scene/sceneserializer.h>
+#include <engine/scene/scenemanager.h>
+#include <engine/core/logger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// A sub-scene read in the background and created over several frames lands in the
+	// current scene, and unloading it takes all of it out again.
+	ANNILEEN_TEST(streamingSubScene, "scene/streaming/sub-scene")
+	{
+		const uint32_t maxFrames = 10000;
+
+		SceneManager* sceneManager = ServiceProvider::getSceneManager();
+		if (!test.expect(sceneManager != nullptr, "the scene manager is missing")) return;
+
+		TestDirectory directory("annileen_streaming_sub_scene");
+		if (!test.expect(directory.isValid(), "the temporary directory could not be created")) return;
+
+		// 10 parents of 99 children, more than one slice of nodes.
+		const std::string file = (directory.getPath() / "sub.anscene").string();
+		size_t fileNodes = 0;
+		{
+			Scene sub;
+			buildLargeScene(sub, 10, 99);
+			fileNodes = sub.getNodeList().size();
+			if (!test.expect(SceneSerializer::save(&sub, file), "the sub-scene could not be saved")) return;
+		}
+
+		Engine* engine = Engine::getInstance();
+		Scene* engineScene = engine->getScene();
+		Scene scene;
+		engine->setScene(&scene);
+		const size_t sceneNodes = scene.getNodeList().size();
+
+		const SceneLoadId load = sceneManager->loadSubScene(file);
+		uint32_t frames = 0;
+		while (load != SceneManager::invalidLoad && sceneManager->isLoading(load) && frames < maxFrames)
+		{
+			sceneManager->update();
+			++frames;
+		}
+
+		if (test.expect(load != SceneManager::invalidLoad && !sceneManager->isLoading(load), fmt::format("the sub-scene did not finish loading in {} frames", maxFrames)))
+		{
+			test.expect(scene.getNodeList().size() == sceneNodes + fileNodes,
+				fmt::format("the scene has {} nodes after the load, {} expected", scene.getNodeList().size(), sceneNodes + fileNodes));
+
+			sceneManager->unloadSubScene(load);
+			test.expect(scene.getNodeList().size() == sceneNodes,
+				fmt::format("{} nodes were left after unloading the sub-scene", scene.getNodeList().size() - sceneNodes));
+		}
+
+		engine->setScene(engineScene);
+	}
+
+	// Streams a 100000 node scene in through the SceneManager while a wall of cubes renders,
+	// and checks each frame keeps to its budget.
+	ANNILEEN_BENCHMARK(streamingHeavyScene, "scene/streaming/heavy")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const uint32_t baselineFrames = 30;
+		const uint32_t maxLoadFrames = 20000;
+		// Nodes the SceneManager creates between two checks of its budget.
+		const uint32_t slice = 64;
+
+		SceneManager* sceneManager = ServiceProvider::getSceneManager();
+		std::shared_ptr<Material> material = createFlatMaterial();
+		if (!test.expect(sceneManager != nullptr && material != nullptr, "the scene manager or the shadowmap shader permutation is missing")) return;
+
+		TestDirectory directory("annileen_streaming_heavy");
+		if (!test.expect(directory.isValid(), "the temporary directory could not be created")) return;
+
+		// The heavy scene: 100000 nodes, written here so the case needs no scene file of its own.
+		const std::string file = (directory.getPath() / "heavy.anscene").string();
+		size_t fileNodes = 0;
+		{
+			Scene heavy;
+			buildLargeScene(heavy, 1000, 99);
+			fileNodes = heavy.getNodeList().size();
+			if (!test.expect(SceneSerializer::save(&heavy, file), fmt::format("could not write '{}'", file))) return;
+		}
+
+		// The slowest slice of nodes the SceneManager creates at once. Its budget is checked
+		// between slices, so a frame may go over it by one slice.
+		double worstSlice = 0.0;
+		{
+			Scene scratch;
+			SceneData data;
+			bool finished = !SceneSerializer::read(file, data);
+			while (!finished)
+			{
+				auto start = Clock::now();
+				finished = SceneSerializer::instantiate(&scratch, data, slice);
+				worstSlice = std::max(worstSlice, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+			}
+		}
+
+		// The running scene: a wall of cubes rendered every frame while the file streams in.
+		std::unique_ptr<MeshGroup> cube = createCube();
+		Scene scene;
+		Camera* camera = buildCubeWall(scene, cube.get(), material, 100, 50);
+		const size_t sceneNodes = scene.getNodeList().size();
+
+		Engine* engine = Engine::getInstance();
+		Scene* engineScene = engine->getScene();
+		Renderer* renderer = engine->getRenderer();
+		engine->setScene(&scene);
+		renderer->setActiveCamera(camera);
+
+		// One frame as the application runs it, returning the time of SceneManager::update.
+		double frameTime = 0.0;
+		auto runFrame = [&]()
+		{
+			auto start = Clock::now();
+			sceneManager->update();
+			auto updated = Clock::now();
+			scene.updateTransforms();
+			renderer->render();
+			renderer->updateStats();
+			bgfx::frame();
+			frameTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			return std::chrono::duration<double, std::milli>(updated - start).count();
+		};
+
+		double baselineWorst = 0.0;
+		double baselineTotal = 0.0;
+		for (uint32_t frame = 0; frame < baselineFrames; ++frame)
+		{
+			runFrame();
+			baselineWorst = std::max(baselineWorst, frameTime);
+			baselineTotal += frameTime;
+		}
+
+		const SceneLoadId load = sceneManager->loadSubScene(file);
+		const double budget = sceneManager->getFrameBudget();
+
+		uint32_t loadFrames = 0;
+		double worstUpdate = 0.0;
+		double worstFrame = 0.0;
+		double loadTotal = 0.0;
+		float progress = 0.0f;
+		bool progressWentBack = false;
+		auto loadStart = Clock::now();
+		while (load != SceneManager::invalidLoad && sceneManager->isLoading(load) && loadFrames < maxLoadFrames)
+		{
+			worstUpdate = std::max(worstUpdate, runFrame());
+			worstFrame = std::max(worstFrame, frameTime);
+			loadTotal += frameTime;
+			++loadFrames;
+
+			const float nextProgress = sceneManager->getProgress(load);
+			progressWentBack |= nextProgress < progress;
+			progress = nextProgress;
+		}
+		const double loadTime = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+
+		test.expect(load != SceneManager::invalidLoad && !sceneManager->isLoading(load), fmt::format("the scene did not finish loading in {} frames", maxLoadFrames));
+		test.expect(scene.getNodeList().size() == sceneNodes + fileNodes,
+			fmt::format("the scene has {} nodes after the load, {} expected", scene.getNodeList().size(), sceneNodes + fileNodes));
+		test.expect(!progressWentBack, "the load progress went backwards");
+		// One slice over the budget is allowed, and as much again for the noise of timing single slices.
+		test.expect(worstUpdate <= budget + 2.0 * worstSlice, fmt::format("a frame spent {:.3f} ms creating nodes, over the {:.3f} ms budget and one {:.3f} ms slice",
+			worstUpdate, budget, worstSlice));
+
+		sceneManager->unloadSubScene(load);
+		test.expect(scene.getNodeList().size() == sceneNodes,
+			fmt::format("{} nodes were left after unloading the sub-scene", scene.getNodeList().size() - sceneNodes));
+
+		renderer->setActiveCamera(nullptr);
+		engine->setScene(engineScene);
+
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Scene streaming: {} nodes in {} frames ({:.1f} ms), worst node creation {:.3f} ms per frame (budget {:.3f} ms, slowest slice {:.3f} ms).",
+			fileNodes, loadFrames, loadTime, worstUpdate, budget, worstSlice);
+		ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Scene streaming: frames {:.3f} ms on average and {:.3f} ms at worst before the load, {:.3f} ms and {:.3f} ms during it.",
+			baselineTotal / baselineFrames, baselineWorst, loadFrames > 0 ? loadTotal / loadFrames : 0.0, worstFrame);
+	}
+}
@@ -0,0 +1,61 @@
+#include "test.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace annileen
+{
+	bool TestContext::expect(bool condition, const std::string& failure)
+	{
+		++m_Checks;
+		if (!condition)
+		{
+			m_Failures.push_back(failure);
+		}
+		return condition;
+	}
+
+	std::vector<TestCase>& getTestCases()
+	{
+		// A function local, so registrations from any translation unit find it constructed.
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	TestRegistration::TestRegistration(const char* name, TestKind kind, TestFunction function)
+	{
+		getTestCases().push_back({ name, kind, function });
+	}
+
+	TestDirectory::TestDirectory(const std::string& name)
+	{
+		std::error_code error;
+		std::filesystem::path path = std::filesystem::temp_directory_path(error) / name;
+		std::filesystem::remove_all(path, error);
+		if (std::filesystem::create_directories(path, error))
+		{
+			m_Path = path;
+		}
+	}
+
+	TestDirectory::~TestDirectory()
+	{
+		if (!m_Path.empty())
+		{
+			std::error_code error;
+			std::filesystem::remove_all(m_Path, error);
+		}
+	}
+
+	std::vector<char> readWholeFile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void writeWholeFile(const std::filesystem::path& path, const std::vector<char>& bytes)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), bytes.size());
+	}
+}
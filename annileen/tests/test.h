@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+namespace annileen
+{
+	// What a test case checked and which of its expectations failed.
+	class TestContext final
+	{
+	private:
+		uint32_t m_Checks = 0;
+		std::vector<std::string> m_Failures;
+
+	public:
+		// Records a failure when condition is false. Returns condition, so a case can stop
+		// where going on makes no sense.
+		bool expect(bool condition, const std::string& failure);
+
+		uint32_t getCheckCount() const { return m_Checks; }
+		const std::vector<std::string>& getFailures() const { return m_Failures; }
+		bool passed() const { return m_Failures.empty(); }
+	};
+
+	enum class TestKind
+	{
+		// Quick checks of behaviour, run by default.
+		Test,
+		// Timings logged for comparison, which check their results on the way. Only run when
+		// asked for, they take seconds each.
+		Benchmark
+	};
+
+	using TestFunction = void (*)(TestContext& test);
+
+	struct TestCase
+	{
+		const char* name;
+		TestKind kind;
+		TestFunction function;
+	};
+
+	// Every test case of the executable, in the order they registered.
+	std::vector<TestCase>& getTestCases();
+
+	struct TestRegistration
+	{
+		TestRegistration(const char* name, TestKind kind, TestFunction function);
+	};
+
+	// A directory of its own under the system temporary directory, removed with everything
+	// in it when destroyed. Empty path if it could not be created.
+	class TestDirectory final
+	{
+	private:
+		std::filesystem::path m_Path;
+
+	public:
+		const std::filesystem::path& getPath() const { return m_Path; }
+		bool isValid() const { return !m_Path.empty(); }
+
+		explicit TestDirectory(const std::string& name);
+		~TestDirectory();
+	};
+
+	// Every byte of the file, empty if it can't be read.
+	std::vector<char> readWholeFile(const std::filesystem::path& path);
+	void writeWholeFile(const std::filesystem::path& path, const std::vector<char>& bytes);
+}
+
+// Defines a test case, registered before main() runs:
+//
+//   ANNILEEN_TEST(checkSomething, "area/something")
+//   {
+//       test.expect(1 + 1 == 2, "1 + 1 is not 2");
+//   }
+#define ANNILEEN_TEST_CASE(__Function, __Name, __Kind) \
+	static void __Function(annileen::TestContext& test); \
+	static annileen::TestRegistration __Function##Registration(__Name, __Kind, &__Function); \
+	static void __Function(annileen::TestContext& test)
+
+#define ANNILEEN_TEST(__Function, __Name) ANNILEEN_TEST_CASE(__Function, __Name, annileen::TestKind::Test)
+#define ANNILEEN_BENCHMARK(__Function, __Name) ANNILEEN_TEST_CASE(__Function, __Name, annileen::TestKind::Benchmark)
@@ -0,0 +1,83 @@
+#include "testassets.h"
+
+#include <algorithm>
+#include <cctype>
+#include <initializer_list>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	AssetLoadingSet sortAssets(const AssetManager& assetManager)
+	{
+		auto isOneOf = [](const std::string& extension, std::initializer_list<const char*> extensions)
+		{
+			return std::find_if(extensions.begin(), extensions.end(), [&extension](const char* e) { return extension == e; }) != extensions.end();
+		};
+
+		AssetLoadingSet set;
+		for (const std::string& name : assetManager.getAssetNames())
+		{
+			const size_t dot = name.find_last_of('.');
+			if (dot == std::string::npos) continue;
+
+			std::string extension = name.substr(dot + 1);
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+			const std::string stem = name.substr(0, dot);
+
+			if (extension == "vs" && assetManager.hasAsset(stem + ".fs")) set.shaders.emplace_back(name, stem + ".fs");
+			else if (isOneOf(extension, { "bmp", "dds", "exr", "gif", "jpg", "hdr", "ktx", "png", "psd", "pvr", "tga" })) set.textures.push_back(name);
+			else if (extension == "toml") set.cubemaps.push_back(name);
+			else if (isOneOf(extension, { "obj", "gltf", "glb" })) set.meshes.push_back(name);
+			else if (isOneOf(extension, { "ttf", "otf" })) set.fonts.push_back(name);
+		}
+
+		return set;
+	}
+
+	std::vector<uint8_t> TestAssetManager::readBytes(const std::string& name)
+	{
+		const AssetTableEntry* entry = getEntry(name);
+		if (entry == nullptr) return {};
+
+		const AssetManager::AssetBytes bytes = entry->m_Type == AssetType::Cubemap ? m_AssetManager.readCubemap(*entry) : m_AssetManager.readAsset(*entry);
+		return std::vector<uint8_t>(bytes.data, bytes.data + bytes.size);
+	}
+
+	void TestAssetManager::prefetch(const std::string& name)
+	{
+		const AssetTableEntry* entry = getEntry(name);
+		if (entry == nullptr) return;
+
+		if (entry->m_Type == AssetType::Cubemap) m_AssetManager.readCubemap(*entry).prefetch();
+		else m_AssetManager.readAsset(*entry).prefetch();
+	}
+
+	bool TestAssetManager::isCookedMesh(const std::string& name)
+	{
+		const AssetTableEntry* entry = getEntry(name);
+		return entry != nullptr && m_AssetManager.isCookedMesh(*entry);
+	}
+
+	bool TestAssetManager::loadCookedMesh(const std::string& name, MeshFile::Header& header, MeshGroup* meshGroup, std::string& error)
+	{
+		const AssetTableEntry* entry = getEntry(name);
+		if (entry == nullptr)
+		{
+			error = fmt::format("'{}' is not in the asset table.", name);
+			return false;
+		}
+
+		// The file points into the bytes, which go with the mapping when this returns.
+		const AssetManager::AssetBytes bytes = m_AssetManager.readAsset(*entry);
+		MeshFile meshFile;
+		if (!AssetManager::readCookedMesh(bytes, name, meshFile, error)) return false;
+
+		header = meshFile.getHeader();
+		if (meshGroup != nullptr) AssetManager::createCookedMeshes(bytes, meshFile, meshGroup);
+		return true;
+	}
+
+	TestAssetManager::TestAssetManager(const std::string& assetFile, bool useArchive) : m_AssetManager(assetFile, useArchive)
+	{
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <engine/assetmanager.h>
+
+namespace annileen
+{
+	// Assets shared by the test cases.
+
+	// The asset table the test executable starts the engine with, and the sources it was built from.
+	constexpr const char* testAssetFile = "build_assets/assets.toml";
+	constexpr const char* testSourceDirectory = "assets";
+
+	// Assets of the asset table sorted by what loads them, from their file extensions (the
+	// same ones the asset tools build).
+	struct AssetLoadingSet
+	{
+		std::vector<std::pair<std::string, std::string>> shaders;
+		std::vector<std::string> textures;
+		std::vector<std::string> cubemaps;
+		std::vector<std::string> meshes;
+		std::vector<std::string> fonts;
+
+		size_t size() const { return shaders.size() + textures.size() + cubemaps.size() + meshes.size() + fonts.size(); }
+	};
+
+	AssetLoadingSet sortAssets(const AssetManager& assetManager);
+
+	// An AssetManager of a test case's own, so nothing the running engine loaded is reused,
+	// with the parts of it the tests check that AssetManager keeps to itself.
+	class TestAssetManager final
+	{
+	private:
+		AssetManager m_AssetManager;
+
+	public:
+		AssetManager* operator->() { return &m_AssetManager; }
+		AssetManager& get() { return m_AssetManager; }
+
+		// nullptr if the asset isn't in the table.
+		const AssetTableEntry* getEntry(const std::string& name) { return m_AssetManager.getAssetEntry(name); }
+		// The bytes of the asset as a load reads them, the strip texture of cubemaps. Empty
+		// if it isn't in the table.
+		std::vector<uint8_t> readBytes(const std::string& name);
+		// Reads the bytes into memory without copying them, as a load does before decoding.
+		void prefetch(const std::string& name);
+
+		// Meshes cooked by the asset tools, which load without Assimp.
+		bool isCookedMesh(const std::string& name);
+		// Reads the header of the cooked mesh and, unless meshGroup is nullptr, creates its
+		// meshes there, the way a load does. False with the reason in error if it can't be read.
+		bool loadCookedMesh(const std::string& name, MeshFile::Header& header, MeshGroup* meshGroup, std::string& error);
+
+		// How changed files are found while hot reloading. Notify falls back to polling where
+		// there are no file notifications.
+		FileWatcher::Mode getWatchMode() const { return m_AssetManager.m_FileWatcher->getMode(); }
+
+		// Off creates the stages of every program anew, as before they were shared.
+		void setShareShaderStages(bool share) { m_AssetManager.m_ShareShaderStages = share; }
+		// The permutation table of a manager, the running engine's to load the same ones.
+		static const std::vector<ShaderPermutation>& getShaderPermutations(const AssetManager& assetManager) { return assetManager.m_ShaderPermutations; }
+
+		TestAssetManager(const std::string& assetFile, bool useArchive = true);
+		TestAssetManager(const TestAssetManager&) = delete;
+		TestAssetManager& operator=(const TestAssetManager&) = delete;
+	};
+}
@@ -0,0 +1,115 @@
+#include "testscene.h"
+
+#include <engine/model.h>
+#include <engine/light.h>
+#include <engine/shaderpass.h>
+#include <engine/serviceprovider.h>
+
+namespace annileen
+{
+	bool nearlyEqual(const glm::mat4& a, const glm::mat4& b)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			if (glm::any(glm::greaterThan(glm::abs(a[column] - b[column]), glm::vec4(1e-4f)))) return false;
+		}
+		return true;
+	}
+
+	bool nearlyEqual(const glm::vec3& a, const glm::vec3& b)
+	{
+		return glm::all(glm::lessThan(glm::abs(a - b), glm::vec3(1e-4f)));
+	}
+
+	std::unique_ptr<MeshGroup> createCube()
+	{
+		struct Vertex
+		{
+			float x, y, z;
+			uint32_t normal;
+		};
+
+		const Vertex vertices[] =
+		{
+			{ -0.5f, -0.5f, -0.5f, 0 }, { 0.5f, -0.5f, -0.5f, 0 }, { 0.5f, 0.5f, -0.5f, 0 }, { -0.5f, 0.5f, -0.5f, 0 },
+			{ -0.5f, -0.5f, 0.5f, 0 }, { 0.5f, -0.5f, 0.5f, 0 }, { 0.5f, 0.5f, 0.5f, 0 }, { -0.5f, 0.5f, 0.5f, 0 }
+		};
+		const uint16_t indices[] =
+		{
+			0, 2, 1, 0, 3, 2,  4, 5, 6, 4, 6, 7,  0, 1, 5, 0, 5, 4,
+			3, 6, 2, 3, 7, 6,  0, 4, 7, 0, 7, 3,  1, 2, 6, 1, 6, 5
+		};
+
+		bgfx::VertexLayout layout;
+		layout.begin()
+			.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::Normal, 4, bgfx::AttribType::Uint8, true, true)
+			.end();
+
+		auto mesh = new Mesh();
+		mesh->init(bgfx::copy(vertices, sizeof(vertices)), layout, bgfx::copy(indices, sizeof(indices)), false,
+			{ glm::vec3(-0.5f), glm::vec3(0.5f) });
+
+		auto meshGroup = std::make_unique<MeshGroup>();
+		meshGroup->m_Meshes.push_back(mesh);
+		return meshGroup;
+	}
+
+	std::shared_ptr<Material> createFlatMaterial()
+	{
+		Shader* shader = ServiceProvider::getAssetManager()->getShaderPermutation("shadowmap", ShaderFeatures::None);
+		if (shader == nullptr) return nullptr;
+
+		auto shaderPass = std::make_shared<ShaderPass>();
+		shaderPass->init(shader);
+		shaderPass->setState(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_CULL_CW);
+
+		auto material = std::make_shared<Material>();
+		material->setName("Test Material");
+		material->addShaderPass(shaderPass);
+		return material;
+	}
+
+	Camera* buildCubeWall(Scene& scene, MeshGroup* cube, const std::shared_ptr<Material>& material, uint32_t columns, uint32_t rows)
+	{
+		for (uint32_t column = 0; column < columns; ++column)
+		{
+			for (uint32_t row = 0; row < rows; ++row)
+			{
+				SceneNodePtr node = scene.createNode("Cube");
+				node->addModule<Model>()->init(cube, material);
+				node->getTransform().position(glm::vec3(column - columns * 0.5f, row - rows * 0.5f, 150.0f));
+			}
+		}
+
+		Camera* camera = scene.createNode("Camera")->addModule<Camera>();
+		camera->setForward(glm::vec3(0.0f, 0.0f, 1.0f));
+		return camera;
+	}
+
+	void buildLargeScene(Scene& scene, uint32_t parents, uint32_t children)
+	{
+		scene.reserveNodes(parents * (children + 1));
+		for (uint32_t i = 0; i < parents; ++i)
+		{
+			SceneNodePtr parent = scene.createNode("Parent");
+			parent->addModule<Model>();
+			parent->getTransform().position(glm::vec3(static_cast<float>(i), 0.0f, 0.0f));
+
+			for (uint32_t j = 0; j < children; ++j)
+			{
+				SceneNodePtr child = scene.createNode("Child");
+				child->setParent(parent);
+				child->addModule<Model>();
+				child->getTransform().position(glm::vec3(0.0f, static_cast<float>(j), 0.0f));
+				if (j % 100 == 0)
+				{
+					Light* light = child->addModule<Light>();
+					light->type = LightType::Point;
+					light->color = glm::vec3(1.0f);
+					light->intensity = 1.0f;
+				}
+			}
+		}
+	}
+}
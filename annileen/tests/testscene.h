@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include <engine/scene.h>
+#include <engine/mesh.h>
+#include <engine/material.h>
+#include <engine/camera.h>
+
+namespace annileen
+{
+	// Scenes and resources shared by the test cases.
+
+	// Every element of a and b within 1e-4 of each other.
+	bool nearlyEqual(const glm::mat4& a, const glm::mat4& b);
+	bool nearlyEqual(const glm::vec3& a, const glm::vec3& b);
+
+	// Unit cube around the origin, with its bounds given so nothing is read back. The layout
+	// is the one the shadow map shader reads.
+	std::unique_ptr<MeshGroup> createCube();
+
+	// The shadow map permutation is the one program the engine always has. nullptr if it's missing.
+	std::shared_ptr<Material> createFlatMaterial();
+
+	// A wall of columns by rows cubes 150 units down +z, all inside the view of the camera
+	// returned, which stands at the origin. No lights, so nothing but the cubes is drawn.
+	Camera* buildCubeWall(Scene& scene, MeshGroup* cube, const std::shared_ptr<Material>& material, uint32_t columns, uint32_t rows);
+
+	// Parents of children, every node with a model without mesh and every hundredth child a light.
+	// Nothing to render, so saving and loading the scene costs only its nodes and modules.
+	void buildLargeScene(Scene& scene, uint32_t parents, uint32_t children);
+}
@@ -0,0 +1,238 @@
+#include "test.h"
+
+#include <engine/scene.h>
+#include <engine/model.h>
+#include <engine/core/logger.h>
+#include <engine/core/fixedtimestep.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// A frame longer than a step carries what is left over to the next frame.
+	ANNILEEN_TEST(timestepCarryOver, "timestep/carry-over")
+	{
+		FixedTimestep timestep(0.25, 8);
+
+		// Times that add up exactly in binary.
+		test.expect(timestep.advance(0.625) == 2, "0.625 s of 0.25 s steps did not run 2 steps");
+		test.expect(timestep.getInterpolation() == 0.5f, fmt::format("0.125 s left of a 0.25 s step interpolates by {}", timestep.getInterpolation()));
+		test.expect(timestep.advance(0.125) == 1, "the 0.125 s carried over and 0.125 s more did not make a step");
+		test.expect(timestep.getStepCount() == 3, fmt::format("{} steps counted, 3 expected", timestep.getStepCount()));
+		test.expect(timestep.getDroppedTime() == 0.0, "time was dropped below the step cap");
+	}
+
+	// A frame due more steps than the cap runs the cap and drops the rest, less than a step kept.
+	ANNILEEN_TEST(timestepStepCap, "timestep/step-cap")
+	{
+		FixedTimestep timestep(0.25, 4);
+
+		test.expect(timestep.advance(2.1) == 4, "a 2.1 s frame did not run the 4 steps of the cap");
+		test.expect(std::abs(timestep.getDroppedTime() - 1.0) < 1e-9, fmt::format("{} s dropped, 1 s expected", timestep.getDroppedTime()));
+		test.expect(timestep.getInterpolation() < 1.0f, "more than a step was kept past the cap");
+	}
+
+	// Bouncing balls tied to each other with springs, enough to make any difference in the
+	// steps taken show up in the state.
+	struct ReplayBody
+	{
+		float position[3];
+		float velocity[3];
+	};
+
+	static void stepReplayBodies(std::vector<ReplayBody>& bodies, float deltaTime)
+	{
+		const float gravity = -9.81f;
+		const float stiffness = 40.0f;
+		const float restLength = 1.0f;
+
+		for (size_t i = 0; i < bodies.size(); ++i)
+		{
+			ReplayBody& body = bodies[i];
+			body.velocity[1] += gravity * deltaTime;
+
+			if (i > 0)
+			{
+				const ReplayBody& other = bodies[i - 1];
+				float delta[3];
+				float length = 0.0f;
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					delta[axis] = other.position[axis] - body.position[axis];
+					length += delta[axis] * delta[axis];
+				}
+				length = std::sqrt(length);
+
+				if (length > 0.0f)
+				{
+					const float force = stiffness * (length - restLength) / length;
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						body.velocity[axis] += force * delta[axis] * deltaTime;
+					}
+				}
+			}
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				body.position[axis] += body.velocity[axis] * deltaTime;
+			}
+
+			if (body.position[1] < 0.0f)
+			{
+				body.position[1] = -body.position[1];
+				body.velocity[1] = -body.velocity[1] * 0.8f;
+			}
+		}
+	}
+
+	// A scene whose nodes are moved by the bodies in fixedUpdate(), drawn through interpolated
+	// models. It keeps where every node was before the last step, to check the interpolation.
+	class ReplayScene final : public Scene
+	{
+	public:
+		std::vector<ReplayBody> bodies;
+		std::vector<SceneNodePtr> nodes;
+		std::vector<glm::vec3> previous;
+		float stepTime;
+		uint64_t steps = 0;
+
+		void fixedUpdate() override
+		{
+			stepReplayBodies(bodies, stepTime);
+			++steps;
+
+			for (size_t i = 0; i < nodes.size(); ++i)
+			{
+				Transform& transform = nodes[i]->getTransform();
+				previous[i] = transform.position();
+				transform.position(glm::vec3(bodies[i].position[0], bodies[i].position[1], bodies[i].position[2]));
+				// Turning too, so the rotations get interpolated as well.
+				transform.euler(glm::vec3(0.0f, static_cast<float>(steps % 360) * (1.0f + i % 3), 0.0f));
+			}
+		}
+
+		ReplayScene(float stepTime) : stepTime(stepTime)
+		{
+			for (size_t i = 0; i < 32; ++i)
+			{
+				bodies.push_back({ { static_cast<float>(i), 5.0f + static_cast<float>(i % 7), 0.0f }, { 0.0f, 0.0f, static_cast<float>(i % 3) } });
+
+				SceneNodePtr node = createNode("Replay Body");
+				node->getTransform().position(glm::vec3(bodies[i].position[0], bodies[i].position[1], bodies[i].position[2]));
+				node->addModule<Model>()->interpolate = true;
+				nodes.push_back(node);
+				previous.push_back(node->getTransform().position());
+			}
+		}
+	};
+
+	// The same steps give the same state whatever the frame rate, and models are drawn
+	// interpolated between their last two steps.
+	ANNILEEN_TEST(timestepReplay, "timestep/replay")
+	{
+		const double stepTime = 1.0 / 60.0;
+		const uint64_t stepCount = 600;
+
+		struct Schedule
+		{
+			const char* name;
+			std::function<double(uint64_t frame)> frameTime;
+		};
+
+		std::mt19937 random(42);
+		std::uniform_real_distribution<double> jitter(0.5, 1.5);
+
+		const Schedule schedules[] =
+		{
+			{ "30 Hz", [](uint64_t) { return 1.0 / 30.0; } },
+			{ "60 Hz", [](uint64_t) { return 1.0 / 60.0; } },
+			{ "75 Hz", [](uint64_t) { return 1.0 / 75.0; } },
+			{ "144 Hz", [](uint64_t) { return 1.0 / 144.0; } },
+			{ "240 Hz", [](uint64_t) { return 1.0 / 240.0; } },
+			{ "jittered 90 Hz", [&random, &jitter](uint64_t) { return jitter(random) / 90.0; } },
+			// Half a second every 100 frames, more than the step cap lets through.
+			{ "120 Hz with hitches", [](uint64_t frame) { return frame % 100 == 99 ? 0.5 : 1.0 / 120.0; } }
+		};
+
+		std::vector<ReplayBody> referenceBodies;
+		std::vector<glm::mat4> referenceMatrices;
+
+		for (const Schedule& schedule : schedules)
+		{
+			// Frames run the way Application::run() runs them.
+			FixedTimestep timestep(stepTime, 8);
+			ReplayScene scene(static_cast<float>(stepTime));
+			uint64_t frames = 0;
+			uint32_t badInterpolations = 0;
+
+			while (timestep.getStepCount() < stepCount)
+			{
+				const uint64_t stepsBefore = timestep.getStepCount();
+				const uint32_t steps = timestep.advance(schedule.frameTime(frames++));
+
+				// Stop at exactly stepCount steps, the last frame may be due more.
+				const uint32_t stepsRun = static_cast<uint32_t>(std::min<uint64_t>(steps, stepCount - stepsBefore));
+				for (uint32_t step = 0; step < stepsRun; ++step)
+				{
+					scene.beginFixedStep();
+					scene.fixedUpdate();
+				}
+
+				const float interpolation = timestep.getInterpolation();
+				scene.updateTransforms(interpolation);
+
+				if (interpolation < 0.0f || interpolation > 1.0f)
+				{
+					++badInterpolations;
+					continue;
+				}
+
+				// Models are drawn that far from where the next to last step left them to where the
+				// last one did, or where they are if no step ran yet.
+				for (size_t i = 0; i < scene.nodes.size(); ++i)
+				{
+					Model* model = scene.nodes[i]->getModule<Model>();
+					const glm::vec3 drawn(model->getRenderMatrix()[3]);
+					const glm::vec3 current = scene.nodes[i]->getTransform().position();
+					const glm::vec3 expected = scene.steps > 0 ? glm::mix(scene.previous[i], current, interpolation) : current;
+
+					if (glm::length(drawn - expected) > 1e-3f)
+					{
+						++badInterpolations;
+						break;
+					}
+				}
+			}
+
+			std::vector<glm::mat4> matrices;
+			for (SceneNodePtr node : scene.nodes)
+			{
+				matrices.push_back(node->getTransform().getWorldMatrix());
+			}
+
+			if (referenceBodies.empty())
+			{
+				referenceBodies = scene.bodies;
+				referenceMatrices = matrices;
+			}
+
+			const bool matches = scene.steps == stepCount
+				&& std::memcmp(referenceBodies.data(), scene.bodies.data(), scene.bodies.size() * sizeof(ReplayBody)) == 0
+				&& matrices == referenceMatrices;
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Timestep replay: {}, {} frames for {} steps, {:.3f} s dropped, {}.",
+				schedule.name, frames, scene.steps, timestep.getDroppedTime(), matches ? "same state" : "state differs");
+
+			test.expect(matches, fmt::format("the {} run ended in a different state", schedule.name));
+			test.expect(badInterpolations == 0, fmt::format("{} of {} frames of the {} run drew models off their interpolated position",
+				badInterpolations, frames, schedule.name));
+		}
+	}
+}
@@ -0,0 +1,236 @@
+#include "test.h"
+#include "testscene.h"
+
+#include <engine/scene.h>
+#include <engine/core/logger.h>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <fmt/format.h>
+
+namespace annileen
+{
+	// A parent turned a quarter around y, scaled by 2 and moved to x = 10, its child one
+	// along x and its grandchild one up y. Worked out by hand: the quarter turn takes +x to -z.
+	struct TransformFamily
+	{
+		Scene scene;
+		SceneNodePtr parent;
+		SceneNodePtr child;
+		SceneNodePtr grandchild;
+		SceneNodePtr other;
+
+		TransformFamily()
+		{
+			parent = scene.createNode("Parent");
+			child = scene.createNode("Child");
+			grandchild = scene.createNode("Grandchild");
+			other = scene.createNode("Other");
+			child->setParent(parent);
+			grandchild->setParent(child);
+
+			parent->getTransform().position(glm::vec3(10.0f, 0.0f, 0.0f));
+			parent->getTransform().euler(glm::vec3(0.0f, 90.0f, 0.0f));
+			parent->getTransform().scale(glm::vec3(2.0f));
+			child->getTransform().position(glm::vec3(1.0f, 0.0f, 0.0f));
+			grandchild->getTransform().position(glm::vec3(0.0f, 1.0f, 0.0f));
+			other->getTransform().position(glm::vec3(0.0f, 0.0f, 5.0f));
+			scene.updateTransforms();
+		}
+	};
+
+	ANNILEEN_TEST(transformCompose, "transform/compose")
+	{
+		TransformFamily family;
+
+		test.expect(nearlyEqual(family.child->getTransform().getWorldPosition(), glm::vec3(10.0f, 0.0f, -2.0f)),
+			"a child is not placed by its rotated and scaled parent");
+		test.expect(nearlyEqual(family.grandchild->getTransform().getWorldPosition(), glm::vec3(10.0f, 2.0f, -2.0f)),
+			"a grandchild does not inherit both its ancestors");
+		test.expect(nearlyEqual(family.grandchild->getTransform().getWorldMatrix(),
+			family.parent->getTransform().getLocalMatrix() * family.child->getTransform().getLocalMatrix() * family.grandchild->getTransform().getLocalMatrix()),
+			"a world matrix is not the product of the local matrices above it");
+	}
+
+	// Moving a parent updates its subtree, and only its subtree.
+	ANNILEEN_TEST(transformParentMoved, "transform/parent-moved")
+	{
+		TransformFamily family;
+
+		const uint32_t grandchildVersion = family.grandchild->getTransform().getWorldVersion();
+		const uint32_t otherVersion = family.other->getTransform().getWorldVersion();
+		family.parent->getTransform().position(glm::vec3(20.0f, 0.0f, 0.0f));
+		family.scene.updateTransforms();
+
+		test.expect(family.grandchild->getTransform().getWorldVersion() != grandchildVersion, "moving a parent does not update its grandchildren");
+		test.expect(family.other->getTransform().getWorldVersion() == otherVersion, "moving a node updates nodes outside its subtree");
+	}
+
+	// Matrices read between updates are brought up to date on the way.
+	ANNILEEN_TEST(transformReadBetweenUpdates, "transform/read-between-updates")
+	{
+		TransformFamily family;
+
+		family.parent->getTransform().position(glm::vec3(30.0f, 0.0f, 0.0f));
+		test.expect(nearlyEqual(family.grandchild->getTransform().getWorldPosition(), glm::vec3(30.0f, 2.0f, -2.0f)),
+			"a world matrix read before the update is stale");
+	}
+
+	// Reparenting keeps the local transform, under the new parent.
+	ANNILEEN_TEST(transformReparent, "transform/reparent")
+	{
+		TransformFamily family;
+
+		family.child->setParent(family.other);
+		family.scene.updateTransforms();
+		test.expect(nearlyEqual(family.grandchild->getTransform().getWorldPosition(), glm::vec3(1.0f, 1.0f, 5.0f)),
+			"a reparented subtree does not follow its new parent");
+
+		family.child->setParent(nullptr);
+		family.scene.updateTransforms();
+		test.expect(nearlyEqual(family.child->getTransform().getWorldMatrix(), family.child->getTransform().getLocalMatrix()),
+			"a node moved to the root is not placed by its local matrix");
+	}
+
+	// Nodes keep their transform in the arrays of the scene, slots of destroyed nodes are
+	// taken again and the world matrices updated in the arrays are the ones nodes return.
+	ANNILEEN_TEST(transformStorage, "transform/storage")
+	{
+		Scene scene;
+		std::vector<SceneNodePtr> nodes;
+		for (uint32_t i = 0; i < 100; ++i)
+		{
+			SceneNodePtr node = scene.createNode("Stored");
+			node->getTransform().position(glm::vec3(static_cast<float>(i), 0.0f, 0.0f));
+			if (i % 2 == 1) node->setParent(nodes[i - 1]);
+			nodes.push_back(node);
+		}
+
+		const size_t slotCount = scene.getTransformStorage().size();
+		for (uint32_t i = 0; i < 100; i += 2)
+		{
+			scene.destroyNode(nodes[i]);
+		}
+		nodes.clear();
+		for (uint32_t i = 0; i < 100; ++i)
+		{
+			SceneNodePtr node = scene.createNode("Stored Again");
+			node->getTransform().position(glm::vec3(0.0f, static_cast<float>(i), 0.0f));
+			node->getTransform().euler(glm::vec3(0.0f, static_cast<float>(i), 0.0f));
+			nodes.push_back(node);
+		}
+		test.expect(scene.getTransformStorage().size() == slotCount, fmt::format("the transform storage grew from {} to {} slots refilling the freed ones",
+			slotCount, scene.getTransformStorage().size()));
+
+		scene.updateTransforms();
+
+		size_t wrongNodes = 0;
+		for (SceneNodePtr node : nodes)
+		{
+			Transform& transform = node->getTransform();
+			const glm::mat4 expected = glm::translate(glm::mat4(1.0f), transform.position()) * glm::mat4_cast(glm::quat(glm::radians(transform.euler())));
+			if (!nearlyEqual(scene.getTransformStorage().getWorldMatrices()[transform.getSlot()], expected)
+				|| !nearlyEqual(transform.getWorldMatrix(), expected)) ++wrongNodes;
+		}
+		test.expect(wrongNodes == 0, fmt::format("{} of {} nodes have the wrong world matrix in the transform storage", wrongNodes, nodes.size()));
+	}
+
+	// Deep, wide and flat hierarchies timed updating with every root moved, one leaf moved and
+	// nothing moved. Every leaf must still be the product of its ancestors.
+	ANNILEEN_BENCHMARK(transformHierarchy, "transform/hierarchy-update")
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// Deep: chains of nodes each a step along from its parent. Wide: parents with many
+		// children each, so the update is spread over the job system.
+		struct Shape
+		{
+			const char* name;
+			uint32_t roots;
+			uint32_t depth;
+			uint32_t children;
+		};
+
+		const Shape shapes[] =
+		{
+			{ "deep", 100, 100, 1 },
+			{ "wide", 100, 1, 100 },
+			{ "flat", 10000, 0, 0 }
+		};
+
+		const uint32_t updates = 20;
+
+		for (const Shape& shape : shapes)
+		{
+			Scene scene;
+			std::vector<SceneNodePtr> roots;
+			std::vector<SceneNodePtr> leaves;
+			for (uint32_t root = 0; root < shape.roots; ++root)
+			{
+				SceneNodePtr node = scene.createNode("Root");
+				node->getTransform().position(glm::vec3(static_cast<float>(root), 0.0f, 0.0f));
+				roots.push_back(node);
+
+				std::vector<SceneNodePtr> level = { node };
+				for (uint32_t depth = 0; depth < shape.depth; ++depth)
+				{
+					std::vector<SceneNodePtr> next;
+					for (SceneNodePtr parent : level)
+					{
+						for (uint32_t child = 0; child < shape.children; ++child)
+						{
+							SceneNodePtr childNode = scene.createNode("Node");
+							childNode->setParent(parent);
+							childNode->getTransform().position(glm::vec3(0.0f, 1.0f, 0.0f));
+							childNode->getTransform().euler(glm::vec3(0.0f, 1.0f, 0.0f));
+							next.push_back(childNode);
+						}
+					}
+					level = std::move(next);
+				}
+				leaves.insert(leaves.end(), level.begin(), level.end());
+			}
+			scene.updateTransforms();
+
+			auto time = [&scene, updates](const std::function<void(uint32_t)>& change)
+			{
+				double total = 0.0;
+				for (uint32_t update = 0; update < updates; ++update)
+				{
+					change(update);
+					auto start = Clock::now();
+					scene.updateTransforms();
+					total += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				}
+				return total / updates;
+			};
+
+			const double everything = time([&roots](uint32_t update)
+			{
+				for (SceneNodePtr root : roots) root->getTransform().euler(glm::vec3(0.0f, static_cast<float>(update), 0.0f));
+			});
+			const double oneLeaf = time([&leaves](uint32_t update)
+			{
+				leaves[update % leaves.size()]->getTransform().position(glm::vec3(0.0f, 1.0f, static_cast<float>(update)));
+			});
+			const double nothing = time([](uint32_t) {});
+
+			// The leaves are where the matrices were composed the most times.
+			size_t wrongLeaves = 0;
+			for (SceneNodePtr leaf : leaves)
+			{
+				glm::mat4 expected = leaf->getTransform().getLocalMatrix();
+				for (SceneNodePtr parent = leaf->getParent(); parent != scene.getRoot(); parent = parent->getParent())
+				{
+					expected = parent->getTransform().getLocalMatrix() * expected;
+				}
+				if (!nearlyEqual(leaf->getTransform().getWorldMatrix(), expected)) ++wrongLeaves;
+			}
+			test.expect(wrongLeaves == 0, fmt::format("{} of {} {} leaves have the wrong world matrix", wrongLeaves, leaves.size(), shape.name));
+
+			ANNILEEN_LOGF_INFO(LoggingChannel::Core, "Transform hierarchy: {}, {} nodes, update {:.3f} ms with every root moved, {:.3f} ms with one leaf moved, {:.3f} ms with nothing moved.",
+				shape.name, scene.getNodeList().size(), everything, oneLeaf, nothing);
+		}
+	}
+}
@@ -25,6 +25,42 @@ newoption {
 	}
  }
 
+newoption {
+	trigger     = "frames",
+	value       = "N",
+	description = "Number of frames the benchmark action runs (default 1000)"
+}
+
+newaction {
+	trigger     = "benchmark",
+	description = "Run the worldbuilding example headless and write frame timings to benchmark.json",
+	execute     = function()
+		-- Prefer a Release build, any generator
+		local candidates = os.matchfiles("build/**/Release/example-worldbuilding*")
+		if #candidates == 0 then
+			candidates = os.matchfiles("build/**/example-worldbuilding*")
+		end
+		local executable = nil
+		for _, candidate in ipairs(candidates) do
+			local ext = path.getextension(candidate)
+			if ext == "" or ext == ".exe" then
+				executable = candidate
+				break
+			end
+		end
+		if executable == nil then
+			error("example-worldbuilding was not found, build it before running the benchmark")
+		end
+
+		local frames = _OPTIONS["frames"] or "1000"
+		local command = string.format('"%s" --headless --frames %s --output benchmark.json', path.getabsolute(executable), frames)
+		print(command)
+		if not os.execute(command) then
+			error("benchmark failed")
+		end
+	end
+}
+
 solution "annileen-engine"
 	location(BUILD_DIR)
 	startproject "example-worldbuilding"
@@ -221,13 +257,55 @@ project "example-cube"
 	setBxCompat()
 
 
+project "annileen-tests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	exceptionhandling "On"
+	rtti "On"
+	files
+	{
+		path.join(ANNILEEN_DIR, "tests/*"),
+	}
+	includedirs
+	{
+		ANNILEEN_DIR,
+		path.join(BGFX_DIR, "include"),
+		path.join(BX_DIR, "include"),
+		path.join(BIMG_DIR, "include"),
+		path.join(GLFW_DIR, "include"),
+		path.join(GLM_DIR, "glm"),
+		path.join(BGFX_DIR, "3rdparty"),
+		path.join(ANNILEEN_DIR, "engine"),
+		path.join(ANNILEEN_DIR, "resources/imgui"),
+		path.join(FMT_DIR, "include"),
+		path.join(ASSIMP_DIR, "include"),
+		TOML11_DIR
+	}
+	debugdir "."
+	links { "annileen", "bgfx", "bimg", "bx", "glfw", "assimp", "imgui" }
+	filter "configurations:Release"
+		defines "NDEBUG"
+		optimize "Full"
+	filter "configurations:Debug*"
+		defines "_DEBUG"
+		optimize "Debug"
+		symbols "On"
+	filter "system:windows"
+		links { "gdi32", "kernel32", "psapi" }
+	filter "system:linux"
+		links { "dl", "GL", "pthread", "X11" }
+	filter "system:macosx"
+		links { "QuartzCore.framework", "Metal.framework", "Cocoa.framework", "IOKit.framework", "CoreVideo.framework" }
+	setBxCompat()
+
 project "bgfx"
 	kind "StaticLib"
 	language "C++"
 	cppdialect "C++14"
 	exceptionhandling "Off"
 	rtti "Off"
-	defines {"__STDC_FORMAT_MACROS", "BGFX_CONFIG_RENDERER_OPENGL=32"}
+	defines {"__STDC_FORMAT_MACROS", "BGFX_CONFIG_RENDERER_OPENGL=32", "BGFX_CONFIG_MAX_ENCODERS=16"}
 	files
 	{
 		path.join(BGFX_DIR, "include/bgfx/**.h"),
@@ -2,6 +2,8 @@ import os
 import shutil
 import sys
 import argparse
+import time
+from concurrent.futures import ProcessPoolExecutor
 
 import tools
 from tools import bcolors
@@ -10,51 +12,105 @@ import mesh
 import texture
 import cubemap
 import font
+import pack
+import manifest
 
 asset_descriptor = {
     'asset': {}
 }
 
-def build_assets(platform, shader_model, force=False):
-    build_shaders(platform, shader_model, force)
-    build_textures(platform, force)
-    build_meshes(platform, force)
-    build_cubemaps(platform, force)
-    build_fonts(platform, force)
+# Asset kinds in build order: the tool module of each, its descriptor type and how it builds one
+# file, always rebuilding since the manifest already decided it had to.
+asset_kinds = [
+    (shader, 'shader', lambda f, platform, model: shader.build_shader(f, shader.shader_build_path, "", platform, model, True)),
+    (texture, 'texture', lambda f, platform, model: texture.build_texture(f, texture.texture_build_path, "", True)),
+    (mesh, 'mesh', lambda f, platform, model: mesh.build_mesh(f, mesh.models_build_path, "", True)),
+    (cubemap, 'cubemap', lambda f, platform, model: cubemap.build_cubemap(f, cubemap.cubemap_build_path, "", True)),
+    (font, 'font', lambda f, platform, model: font.build_font(f, font.font_build_path, "", True))
+]
+
+def _init_worker():
+    # Workers print as they go, not when they exit.
+    sys.stdout.reconfigure(line_buffering=True)
+
+def _build_asset(kind, assetfile, platform, shader_model):
+    start = time.perf_counter()
+    try:
+        success, name, output = asset_kinds[kind][2](assetfile, platform, shader_model)
+    except Exception as e:
+        print(f"{bcolors.ERROR}[ERROR]{bcolors.ENDC} '{assetfile}' failed to build: {e}")
+        success, name, output = False, tools.path_leaf(assetfile), None
+    return success, name, output, time.perf_counter() - start
+
+def build_assets(platform, shader_model, force=False, jobs=None):
+    start = time.perf_counter()
+    built_manifest = manifest.Manifest(manifest.default_path())
+
+    # Every asset depends on its own files, the tool that builds it and the scripts driving the
+    # tool. Assets don't depend on each other, so whatever has to be built is built at once.
+    pending = []
+    skipped = []
+    for kind, (module, asset_type, _) in enumerate(asset_kinds):
+        scripts = [os.path.realpath(module.__file__), os.path.realpath(tools.__file__)]
+        options = f'{platform} {shader_model}' if module is shader else ''
+
+        for assetfile in module.find_all():
+            key = f'{asset_type}:{assetfile}'
+            digest = built_manifest.digest(module.get_dependencies(assetfile) + scripts, options)
+            current = None if force else built_manifest.get_current(key, digest)
+            if current != None:
+                skipped.append((kind, key, current))
+            else:
+                pending.append((kind, key, digest, assetfile))
+
+    print(f'{bcolors.OKBLUE}BUILDING {len(pending)} ASSETS, {len(skipped)} UP TO DATE{bcolors.ENDC}')
+
+    results = []
+    if len(pending) > 0:
+        jobs = min(jobs or os.cpu_count() or 1, len(pending))
+        if jobs > 1:
+            with ProcessPoolExecutor(max_workers=jobs, initializer=_init_worker) as executor:
+                futures = [executor.submit(_build_asset, kind, assetfile, platform, shader_model) for kind, _, _, assetfile in pending]
+                results = [f.result() for f in futures]
+        else:
+            results = [_build_asset(kind, assetfile, platform, shader_model) for kind, _, _, assetfile in pending]
+
+    failed = 0
+    built = {}
+    for (kind, key, digest, _), (success, name, output, seconds) in zip(pending, results):
+        if success:
+            built_manifest.record(key, digest, name, output, seconds)
+            built[key] = (kind, name, output)
+        else:
+            built_manifest.forget(key)
+            failed += 1
+
+    for kind, key, current in skipped:
+        built[key] = (kind, current['name'], current['output'])
+
+    # Same order as building everything one by one wrote it.
+    for key in sorted(built, key=lambda k: (built[k][0], k)):
+        kind, name, output = built[key]
+        asset_descriptor['asset'][name.lower()] = {'path': output.replace(os.getcwd(), "."), 'type': asset_kinds[kind][1]}
 
     descriptor_path = tools.save_descriptor(asset_descriptor)
     print(f'\n{tools.bcolors.OKBLUE}ASSET DESCRIPTOR WRITTEN AT: {tools.bcolors.ENDC}{tools.bcolors.BOLD}{descriptor_path}{tools.bcolors.ENDC}') 
 
-def build_shaders(platform, shader_model, force=False):
-    print(f'{tools.bcolors.OKBLUE}COMPILING SHADERS{tools.bcolors.ENDC}')
-    for s in shader.build_all(platform, shader_model, force):
-        if s[0]:
-            asset_descriptor['asset'][s[1].lower()] = {'path': s[2].replace(os.getcwd(), "."), 'type': 'shader'}
-
-def build_textures(platform, force=False):
-    print(f'{tools.bcolors.OKBLUE}COMPILING TEXTURES{tools.bcolors.ENDC}')
-    for t in texture.build_all(force):
-        if t[0]:
-            asset_descriptor['asset'][t[1].lower()] = {'path': t[2].replace(os.getcwd(), "."), 'type': 'texture'}
-
-def build_meshes(platform, force=False):
-    print(f'{tools.bcolors.OKBLUE}COMPILING MESHES{tools.bcolors.ENDC}')
-    for m in mesh.build_all(force):
-        if m[0]:
-            asset_descriptor['asset'][m[1].lower()] = {'path': m[2].replace(os.getcwd(), "."), 'type': 'mesh'}
-
-def build_cubemaps(platform, force=False):
-    print(f'{tools.bcolors.OKBLUE}COMPILING CUBEMAPS{tools.bcolors.ENDC}')
-    for m in cubemap.build_all(force):
-        if m[0]:
-            asset_descriptor['asset'][m[1].lower()] = {'path': m[2].replace(os.getcwd(), "."), 'type': 'mesh'}
-
-def build_fonts(platform, force=False):
-    print(f'{tools.bcolors.OKBLUE}COMPILING FONTS{tools.bcolors.ENDC}')
-    for f in font.build_all(force):
-        if f[0]:
-            asset_descriptor['asset'][f[1].lower()] = {'path': f[2].replace(os.getcwd(), "."), 'type': 'font'}
+    # The archive is made of the descriptor and the built assets, which the asset hashes stand for.
+    archive_path = os.path.join('.', tools.build_dir, tools.archive_file)
+    archive_digest = built_manifest.digest([descriptor_path], ' '.join(built_manifest.assets[k]['hash'] for k in sorted(built)))
+    if built_manifest.is_archive_current(archive_digest, archive_path):
+        print(f'{bcolors.OKBLUE}PACKING ASSETS{bcolors.ENDC} {bcolors.WARNING}- SKIPPED{bcolors.ENDC}')
+    elif pack.pack(descriptor_path, archive_path) != None:
+        built_manifest.record_archive(archive_digest, archive_path)
 
+    built_manifest.save()
+
+    elapsed = time.perf_counter() - start
+    cooking = sum(seconds for _, _, _, seconds in results)
+    saved = sum(current.get('seconds', 0.0) for _, _, current in skipped)
+    print(f'{bcolors.SUCCESS}ASSETS BUILT IN {elapsed:.2f}s:{bcolors.ENDC} {len(pending) - failed} built ({cooking:.2f}s of building, {jobs if results else 0} at once), '
+        f'{failed} failed, {len(skipped)} up to date ({saved:.2f}s of building saved)')
 
 def ensure_build_dir():
     build_assets = os.path.join(os.getcwd(), tools.build_dir)
@@ -83,6 +139,7 @@ def check_required_dir():
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description=f'{bcolors.SUCCESS}Annileen Asset Tools{bcolors.ENDC}')
     parser.add_argument('-f', '--force', help='force rebuild of all assets', action='store_true')
+    parser.add_argument('-j', '--jobs', help='assets built at once, defaults to the number of cores', type=int, default=None)
     parser.add_argument('-p', '--platform', help='compiles the mesh specified', choices=tools.available_platforms, default='auto')
     parser.add_argument('-s', '--shader', help='shader model', choices=tools.available_shader_models, default='auto')
     args = parser.parse_args()
@@ -90,4 +147,4 @@ if __name__ == '__main__':
 
     if check_required_dir():
         ensure_build_dir()
-        build_assets(args.platform, args.shader, args.force)
+        build_assets(args.platform, args.shader, args.force, args.jobs)
@@ -34,16 +34,17 @@ def build_cubemap(cubemapfile, dest, options, force=False):
     strip = False
     tmp = ""
     if cubemap['cubemap']['sides'] != None:
-        tmp = os.path.join(dest, 'skybox-tmp.png')
+        tmp = os.path.join(dest, tools.path_leaf(cubemapfile.split('.')[0]) + '-tmp.png')
         if _build_strip_texture(cubemap['cubemap']['sides'], tmp):
             strip = True
 
     strip_cmd = "--strip" if strip else ''
 
+    temp_file = tools.temp_path(output_texture_file)
     command = "%s -f %s -o %s -t ETC2 %s" % (
         bgfx_texturec,
         tmp,
-        output_texture_file,
+        temp_file,
         strip_cmd
     )
 
@@ -51,6 +52,7 @@ def build_cubemap(cubemapfile, dest, options, force=False):
     if not os.system(command):
         success = True
         os.remove(tmp)
+        os.replace(temp_file, output_texture_file)
         cubemap['cubemap']['sides'] = None
         cubemap['cubemap']['strip_file'] = output_texture_file
         print(f" {bcolors.SUCCESS}- Cubemap compiled: {output_file}{bcolors.ENDC}")
@@ -88,8 +90,20 @@ def _build_cubemap(cubemap, options):
     else:
         print(f"{bcolors.ERROR}[ERROR]{bcolors.ENDC} File '{cubemap}' not found.")
 
+def get_dependencies(cubemapfile):
+    dependencies = [cubemapfile, bgfx_texturec, bgfx_texturec + '.exe']
+    _, cubemap = tools.load_asset_descriptor(cubemapfile, None)
+    sides = cubemap.get('cubemap', {}).get('sides') if cubemap != None else None
+    if sides != None:
+        for side in sides.values():
+            dependencies += sorted(glob.glob(os.path.join(texture_path, "**", side), recursive=True))
+    return dependencies
+
+def find_all():
+    return reduce(lambda x, y : x + y, [glob.glob(os.path.join(cubemap_path, "**", "*." + filetype), recursive=True) for filetype in tools.cubemap_types])
+
 def build_all(force=False):
-    cubemaps = reduce(lambda x, y : x + y, [glob.glob(os.path.join(cubemap_path, "**", "*." + filetype), recursive=True) for filetype in tools.cubemap_types])
+    cubemaps = find_all()
     print(cubemaps)
     return [build_cubemap(cubemapfile, cubemap_build_path, "", force) for cubemapfile in cubemaps]
 
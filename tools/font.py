@@ -22,7 +22,9 @@ def build_font(fontfile, dest, options, force=False):
 
     success = False    
     try: 
-        shutil.copyfile(fontfile, output_file)
+        temp_file = tools.temp_path(output_file)
+        shutil.copyfile(fontfile, temp_file)
+        os.replace(temp_file, output_file)
         success = True
         print(f" {bcolors.SUCCESS}- Font compiled: {output_file}{bcolors.ENDC}")
  
@@ -52,9 +54,14 @@ def _build_font(fontname, options):
     else:
         print(f"{bcolors.ERROR}[ERROR]{bcolors.ENDC} File '{fontname}' not found.")
 
+def get_dependencies(fontfile):
+    return [fontfile]
+
+def find_all():
+    return reduce(lambda x, y : x + y, [glob.glob(os.path.join(font_path, "**", "*." + filetype), recursive=True) for filetype in tools.font_types])
+
 def build_all(force=False):
-    fonts = reduce(lambda x, y : x + y, [glob.glob(os.path.join(font_path, "**", "*." + filetype), recursive=True) for filetype in tools.font_types])
-    return [build_font(fontfile, font_build_path, "", force) for fontfile in fonts]
+    return [build_font(fontfile, font_build_path, "", force) for fontfile in find_all()]
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description=f'{bcolors.SUCCESS}Annileen Font Tools{bcolors.ENDC}')
@@ -0,0 +1,103 @@
+import os
+import json
+import hashlib
+
+import tools
+
+manifest_version = 1
+
+class Manifest:
+    # Content hashes of everything each built asset was made from: its source, descriptor,
+    # other files it reads, the tools and the options. An asset whose hash didn't change and
+    # whose output is still there is not built again.
+    #
+    # Files are hashed once per change of their size or modification time, the hashes are kept
+    # with the stats they were taken at, so a build with nothing to do reads no file contents.
+    def __init__(self, path):
+        self.path = path
+        self.files = {}
+        self.assets = {}
+        self.archive = None
+        self.seen = set()
+        self.used = set()
+
+        if not os.path.isfile(path): return
+
+        try:
+            with open(path, 'r') as f:
+                data = json.load(f)
+        except (OSError, ValueError):
+            return
+
+        if data.get('version') != manifest_version: return
+        self.files = data.get('files', {})
+        self.assets = data.get('assets', {})
+        self.archive = data.get('archive')
+
+    def hash_file(self, path):
+        self.used.add(path)
+        try:
+            stat = os.stat(path)
+        except OSError:
+            return 'missing'
+
+        cached = self.files.get(path)
+        if cached != None and cached['mtime'] == stat.st_mtime_ns and cached['size'] == stat.st_size:
+            return cached['hash']
+
+        h = hashlib.sha256()
+        with open(path, 'rb') as f:
+            for block in iter(lambda: f.read(1 << 20), b''):
+                h.update(block)
+
+        self.files[path] = {'mtime': stat.st_mtime_ns, 'size': stat.st_size, 'hash': h.hexdigest()}
+        return h.hexdigest()
+
+    def digest(self, files, options=''):
+        h = hashlib.sha256(str(manifest_version).encode('utf-8'))
+        for path in files:
+            h.update(path.encode('utf-8'))
+            h.update(self.hash_file(path).encode('utf-8'))
+        h.update(options.encode('utf-8'))
+        return h.hexdigest()
+
+    def get_current(self, key, digest):
+        # The previous build of the asset if it is still valid, None if it has to be built.
+        self.seen.add(key)
+        asset = self.assets.get(key)
+        if asset == None or asset['hash'] != digest or not os.path.isfile(asset['output']):
+            return None
+        return asset
+
+    def record(self, key, digest, name, output, seconds):
+        self.seen.add(key)
+        self.assets[key] = {'hash': digest, 'name': name, 'output': output, 'seconds': seconds}
+
+    def forget(self, key):
+        self.assets.pop(key, None)
+
+    def is_archive_current(self, digest, archive_path):
+        if self.archive == None or self.archive['hash'] != digest: return False
+        try:
+            stat = os.stat(archive_path)
+        except OSError:
+            return False
+        return self.archive['mtime'] == stat.st_mtime_ns and self.archive['size'] == stat.st_size
+
+    def record_archive(self, digest, archive_path):
+        stat = os.stat(archive_path)
+        self.archive = {'hash': digest, 'mtime': stat.st_mtime_ns, 'size': stat.st_size}
+
+    def save(self):
+        # Assets that are gone from the source folder, and the files only they used, are dropped.
+        assets = {k: v for k, v in self.assets.items() if k in self.seen}
+        files = {k: v for k, v in self.files.items() if k in self.used}
+        data = {'version': manifest_version, 'files': files, 'assets': assets, 'archive': self.archive}
+
+        tmp = self.path + '.tmp'
+        with open(tmp, 'w') as f:
+            json.dump(data, f, indent=1, sort_keys=True)
+        os.replace(tmp, self.path)
+
+def default_path():
+    return os.path.join('.', tools.build_dir, tools.manifest_file)
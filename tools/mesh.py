@@ -1,7 +1,11 @@
 import os
+import sys
+import math
+import struct
 import argparse
 import glob
 import ntpath
+from array import array
 from shutil import copyfile
 from functools import reduce
 
@@ -16,9 +20,268 @@ bgfx_tools_dir = os.path.join(tools_dir, 'bgfx-tools', tools.get_platform())
 bgfx_geometryc = os.path.join(bgfx_tools_dir, 'geometryc')
 bgfx_geometryv = os.path.join(bgfx_tools_dir, 'geometryv')
 
+# Cooked mesh layout shared with annileen/engine/meshfile.h.
+amesh_magic = b'AMSH'
+amesh_version = 1
+amesh_alignment = 16
+
+amesh_header_format = '<4sIIIIIII6fII'
+amesh_submesh_format = '<IIII6f'
+
+attribute_texcoord0 = 0x01
+attribute_normal = 0x02
+
+def _obj_index(text, count):
+    # OBJ indices start at 1, negative ones count back from the last element read.
+    i = int(text)
+    return i - 1 if i > 0 else count + i
+
+def _read_obj(meshfile):
+    positions, texcoords, normals = [], [], []
+    # Each group holds its triangles, each triangle three (position, texcoord, normal) corners.
+    groups = []
+    triangles = None
+
+    with open(meshfile, 'r', errors='replace') as f:
+        for line in f:
+            parts = line.split()
+            if not parts: continue
+
+            tag = parts[0]
+            if tag == 'v':
+                positions.append((float(parts[1]), float(parts[2]), float(parts[3])))
+            elif tag == 'vt':
+                # Flipped like aiProcess_FlipUVs does for imported meshes.
+                v = float(parts[2]) if len(parts) > 2 else 0.0
+                texcoords.append((float(parts[1]), 1.0 - v))
+            elif tag == 'vn':
+                normals.append((float(parts[1]), float(parts[2]), float(parts[3])))
+            elif tag in ('o', 'g', 'usemtl'):
+                # Assimp gives objects, groups and materials meshes of their own, so do we.
+                triangles = None
+            elif tag == 'f':
+                corners = []
+                for corner in parts[1:]:
+                    refs = corner.split('/')
+                    corners.append((
+                        _obj_index(refs[0], len(positions)),
+                        _obj_index(refs[1], len(texcoords)) if len(refs) > 1 and refs[1] else None,
+                        _obj_index(refs[2], len(normals)) if len(refs) > 2 and refs[2] else None))
+
+                if triangles is None:
+                    triangles = []
+                    groups.append(triangles)
+
+                for i in range(1, len(corners) - 1):
+                    triangles.append((corners[0], corners[i], corners[i + 1]))
+
+    return positions, texcoords, normals, [g for g in groups if g]
+
+def _sub(a, b):
+    return (a[0] - b[0], a[1] - b[1], a[2] - b[2])
+
+def _cross(a, b):
+    return (a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0])
+
+def _normalize(v):
+    length = math.sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2])
+    return (v[0] / length, v[1] / length, v[2] / length) if length > 0.0 else (0.0, 0.0, 0.0)
+
+def _face_normal(positions, triangle):
+    p1, p2, p3 = (positions[c[0]] for c in triangle)
+    return _cross(_sub(p2, p1), _sub(p3, p1))
+
+# The same passes as annileen/engine/meshoptimizer.cpp, see there.
+cache_size = 16
+
+def get_acmr(indices, vertex_count):
+    if len(indices) < 3: return 0.0
+    entered = [0] * vertex_count
+    time = cache_size + 1
+    misses = 0
+    for i in indices:
+        if time - entered[i] > cache_size:
+            entered[i] = time
+            time += 1
+            misses += 1
+    return misses / (len(indices) // 3)
+
+def optimize_vertex_cache(indices, vertex_count):
+    # Tipsify, Sander et al. 2007.
+    triangle_count = len(indices) // 3
+    live = [0] * vertex_count
+    for i in indices: live[i] += 1
+
+    adjacency = [[] for _ in range(vertex_count)]
+    for i, v in enumerate(indices): adjacency[v].append(i // 3)
+
+    cache_time = [0] * vertex_count
+    emitted = [False] * triangle_count
+    dead_ends = []
+    output = []
+    time = cache_size + 1
+    cursor = 0
+    fanning = 0 if vertex_count > 0 else -1
+
+    while fanning >= 0:
+        candidates = []
+        for t in adjacency[fanning]:
+            if emitted[t]: continue
+            for v in indices[t * 3:t * 3 + 3]:
+                output.append(v)
+                dead_ends.append(v)
+                candidates.append(v)
+                live[v] -= 1
+                if time - cache_time[v] > cache_size:
+                    cache_time[v] = time
+                    time += 1
+            emitted[t] = True
+
+        fanning = -1
+        best = -1
+        for v in candidates:
+            if live[v] == 0: continue
+            priority = time - cache_time[v] if time - cache_time[v] + 2 * live[v] <= cache_size else 0
+            if priority > best:
+                best = priority
+                fanning = v
+
+        while fanning < 0 and dead_ends:
+            v = dead_ends.pop()
+            if live[v] > 0: fanning = v
+
+        while fanning < 0 and cursor < vertex_count:
+            if live[cursor] > 0: fanning = cursor
+            cursor += 1
+
+    return output
+
+def optimize_vertex_fetch(vertices, indices):
+    # Vertices by first use, unused ones dropped.
+    remap = {}
+    reordered = []
+    for i in indices:
+        if i not in remap:
+            remap[i] = len(reordered)
+            reordered.append(vertices[i])
+    return reordered, [remap[i] for i in indices]
+
+def cook_obj(meshfile, output_file, descriptor):
+    positions, texcoords, normals, groups = _read_obj(meshfile)
+    if not groups:
+        print(f" {bcolors.ERROR}- '{meshfile}' has no faces.{bcolors.ENDC}")
+        return False
+
+    corners = [c for g in groups for t in g for c in t]
+    has_texcoord = all(c[1] is not None for c in corners)
+    has_normal = all(c[2] is not None for c in corners)
+
+    # 'generate' gives each face its own normal; 'generate_smooth' averages the faces around
+    # each position, and like Assimp only when the file has no normals.
+    normals_mode = descriptor.get('normals', tools.mesh_descriptor_schema['normals'])
+    flat = normals_mode == 'generate'
+    smooth = normals_mode == 'generate_smooth' and not has_normal
+
+    smooth_normals = None
+    if smooth:
+        summed = [(0.0, 0.0, 0.0)] * len(positions)
+        for g in groups:
+            for t in g:
+                n = _face_normal(positions, t)
+                for c in t:
+                    s = summed[c[0]]
+                    summed[c[0]] = (s[0] + n[0], s[1] + n[1], s[2] + n[2])
+        smooth_normals = [_normalize(n) for n in summed]
+
+    has_normal = has_normal or flat or smooth
+
+    attributes = (attribute_texcoord0 if has_texcoord else 0) | (attribute_normal if has_normal else 0)
+    stride = 4 * (3 + (2 if has_texcoord else 0) + (3 if has_normal else 0))
+
+    vertices = array('f')
+    indices = []
+    submeshes = []
+    bounds_min = [math.inf] * 3
+    bounds_max = [-math.inf] * 3
+    misses_before, misses_after = 0.0, 0.0
+
+    for g in groups:
+        remap = {}
+        sub_vertices = []
+        sub_indices = []
+
+        for t in g:
+            face_normal = _normalize(_face_normal(positions, t)) if flat else None
+            for c in t:
+                vertex = positions[c[0]]
+                if has_texcoord: vertex += texcoords[c[1]]
+                if flat: vertex += face_normal
+                elif smooth: vertex += smooth_normals[c[0]]
+                elif has_normal: vertex += normals[c[2]]
+
+                # Corners with the same values share a vertex.
+                index = remap.get(vertex)
+                if index is None:
+                    index = len(sub_vertices)
+                    remap[vertex] = index
+                    sub_vertices.append(vertex)
+                sub_indices.append(index)
+
+        misses_before += get_acmr(sub_indices, len(sub_vertices)) * len(g)
+        sub_indices = optimize_vertex_cache(sub_indices, len(sub_vertices))
+        sub_vertices, sub_indices = optimize_vertex_fetch(sub_vertices, sub_indices)
+        misses_after += get_acmr(sub_indices, len(sub_vertices)) * len(g)
+
+        sub_min = [min(v[a] for v in sub_vertices) for a in range(3)]
+        sub_max = [max(v[a] for v in sub_vertices) for a in range(3)]
+        for a in range(3):
+            bounds_min[a] = min(bounds_min[a], sub_min[a])
+            bounds_max[a] = max(bounds_max[a], sub_max[a])
+
+        submeshes.append((len(vertices) * 4 // stride, len(sub_vertices), len(indices), len(sub_indices), *sub_min, *sub_max))
+        for v in sub_vertices: vertices.extend(v)
+        indices.extend(sub_indices)
+
+    triangle_count = len(indices) // 3
+    print(f"   {triangle_count} triangles, {len(vertices) * 4 // stride} vertices, ACMR {misses_before / triangle_count:.3f} -> {misses_after / triangle_count:.3f}")
+
+    # Indices are relative to the submesh, so 16 bits are enough while every submesh fits.
+    index_size = 2 if all(s[1] <= 65536 for s in submeshes) else 4
+    index_data = array('H' if index_size == 2 else 'I', indices)
+
+    if sys.byteorder != 'little':
+        vertices.byteswap()
+        index_data.byteswap()
+
+    header_size = struct.calcsize(amesh_header_format)
+    submesh_size = struct.calcsize(amesh_submesh_format)
+    vertex_offset = _align(header_size + submesh_size * len(submeshes))
+    index_offset = _align(vertex_offset + len(vertices) * 4)
+
+    temp_file = tools.temp_path(output_file)
+    with open(temp_file, 'wb') as f:
+        f.write(struct.pack(amesh_header_format, amesh_magic, amesh_version, attributes, stride,
+            len(vertices) * 4 // stride, len(indices), index_size, len(submeshes), *bounds_min, *bounds_max,
+            vertex_offset, index_offset))
+        for s in submeshes:
+            f.write(struct.pack(amesh_submesh_format, *s))
+        f.write(b'\0' * (vertex_offset - f.tell()))
+        vertices.tofile(f)
+        f.write(b'\0' * (index_offset - f.tell()))
+        index_data.tofile(f)
+    os.replace(temp_file, output_file)
+
+    return True
+
+def _align(offset):
+    return (offset + amesh_alignment - 1) & ~(amesh_alignment - 1)
+
 def build_mesh(meshfile, dest, options, force=False):
     print(f" - Compiling {bcolors.UNDERLINE}'{meshfile}'{bcolors.ENDC}")
-    output_file = os.path.join(dest, tools.path_leaf(meshfile.split('.')[0]) + '.obj')
+    # OBJ files are cooked, so the engine doesn't import them at runtime. The other formats are
+    # copied and go through Assimp.
+    cook = meshfile.lower().endswith('.obj')
+    output_file = os.path.join(dest, tools.path_leaf(meshfile.split('.')[0]) + ('.amesh' if cook else '.' + meshfile.split('.')[-1]))
 
     descriptor_filename, descriptor = tools.load_asset_descriptor(meshfile, tools.mesh_descriptor_schema)
 
@@ -37,9 +300,19 @@ def build_mesh(meshfile, dest, options, force=False):
     #     success = True
     #     print(f" {bcolors.SUCCESS}- Mesh compiled: {output_file}{bcolors.ENDC}")
 
-    success = copyfile(meshfile, output_file)
+    if cook:
+        success = cook_obj(meshfile, output_file, descriptor)
+        if success:
+            print(f" {bcolors.SUCCESS}- Mesh cooked: {output_file}{bcolors.ENDC}")
+    else:
+        temp_file = tools.temp_path(output_file)
+        copyfile(meshfile, temp_file)
+        os.replace(temp_file, output_file)
+        success = True
+        if success:
+            print(f" {bcolors.SUCCESS}- Mesh copied: {output_file}{bcolors.ENDC}")
+
     if success:
-        print(f" {bcolors.SUCCESS}- Mesh copied: {output_file}{bcolors.ENDC}")
         tools.save_built_asset_descriptor(output_file, descriptor)
 
     return success, tools.path_leaf(meshfile), output_file
@@ -52,9 +325,15 @@ def _build_mesh(meshname, options):
     else:
         print(f"{bcolors.ERROR}[ERROR]{bcolors.ENDC} File '{meshname}' not found.")
 
+def get_dependencies(meshfile):
+    descriptor_filename, _ = tools.load_asset_descriptor(meshfile, tools.mesh_descriptor_schema)
+    return [meshfile, descriptor_filename]
+
+def find_all():
+    return reduce(lambda x, y : x + y, [glob.glob(os.path.join(models_path, "**", "*." + filetype), recursive=True) for filetype in tools.mesh_types])
+
 def build_all(force=False):
-    meshes = reduce(lambda x, y : x + y, [glob.glob(os.path.join(models_path, "**", "*." + filetype), recursive=True) for filetype in tools.mesh_types])
-    return [build_mesh(meshfile, models_build_path, "", force) for meshfile in meshes]
+    return [build_mesh(meshfile, models_build_path, "", force) for meshfile in find_all()]
 
 def view_mesh(meshname):
     filepath = glob.glob(os.path.join(models_build_path, meshname.split('.')[0] + '.*'), recursive=True)
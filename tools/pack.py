@@ -0,0 +1,134 @@
+import os
+import struct
+import argparse
+
+import toml
+
+import tools
+from tools import bcolors
+
+# Layout shared with annileen/engine/assetarchive.h.
+archive_magic = b'ANPK'
+archive_version = 1
+archive_alignment = 16
+
+header_format = '<4sIIIQQ'
+entry_format = '<QQQIIBBBB8sI'
+
+kinds = {
+    'shader': 0,
+    'texture': 1,
+    'mesh': 2,
+    'cubemap': 3,
+    'font': 4
+}
+
+normals = {
+    'generate': 1,
+    'generate_smooth': 2
+}
+
+def hash_name(name):
+    # 64 bit FNV-1a, the same as AssetArchive::hashName.
+    h = 14695981039346656037
+    for b in name.encode('utf-8'):
+        h ^= b
+        h = (h * 1099511628211) & 0xffffffffffffffff
+    return h
+
+def _align(offset):
+    return (offset + archive_alignment - 1) & ~(archive_alignment - 1)
+
+def _sidecar(path):
+    descriptor_file = os.path.splitext(path)[0] + '.toml'
+    if not os.path.isfile(descriptor_file): return {}
+    return toml.load(descriptor_file)
+
+def _pack_entry(name, asset):
+    kind = asset['type']
+    path = asset['path']
+
+    mipmap, filtering, normal_mode = 0, 0, 0
+
+    if kind == 'texture':
+        descriptor = {**tools.texture_descriptor_schema, **_sidecar(path)}
+        mipmap = 1 if descriptor['mipmap'] else 0
+        filtering = 1 if descriptor['filter'] == 'point' else 0
+    elif kind == 'mesh':
+        descriptor = {**tools.mesh_descriptor_schema, **_sidecar(path)}
+        normal_mode = normals.get(descriptor['normals'], 0)
+    elif kind == 'cubemap':
+        # The cubemap descriptor only points at the strip texture, which is packed instead.
+        path = toml.load(path)['cubemap']['strip_file']
+
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    extension = os.path.splitext(path)[1][1:].lower().encode('utf-8')[:8]
+    return {
+        'name': name.encode('utf-8'),
+        'hash': hash_name(name),
+        'kind': kinds[kind],
+        'mipmap': mipmap,
+        'filtering': filtering,
+        'normals': normal_mode,
+        'extension': extension,
+        'data': data
+    }
+
+def write_archive(descriptor, archive_path):
+    entries = []
+    for name, asset in descriptor['asset'].items():
+        if asset['type'] not in kinds:
+            print(f"{bcolors.WARNING}[WARNING]{bcolors.ENDC} '{name}' has unknown type '{asset['type']}', not packed.")
+            continue
+        try:
+            entries.append(_pack_entry(name, asset))
+        except (OSError, KeyError, toml.TomlDecodeError) as e:
+            print(f"{bcolors.ERROR}[ERROR]{bcolors.ENDC} '{name}' could not be packed: {e}")
+            return None
+
+    entries.sort(key=lambda e: e['hash'])
+
+    header_size = struct.calcsize(header_format)
+    entry_size = struct.calcsize(entry_format)
+
+    names = b''
+    for e in entries:
+        e['name_offset'] = len(names)
+        names += e['name']
+
+    names_offset = header_size + entry_size * len(entries)
+    offset = _align(names_offset + len(names))
+    for e in entries:
+        e['offset'] = offset
+        offset = _align(offset + len(e['data']))
+
+    temp_file = tools.temp_path(archive_path)
+    with open(temp_file, 'wb') as f:
+        f.write(struct.pack(header_format, archive_magic, archive_version, len(entries), archive_alignment, names_offset, len(names)))
+        for e in entries:
+            f.write(struct.pack(entry_format, e['hash'], e['offset'], len(e['data']), e['name_offset'], len(e['name']),
+                e['kind'], e['mipmap'], e['filtering'], e['normals'], e['extension'], 0))
+        f.write(names)
+        for e in entries:
+            f.write(b'\0' * (e['offset'] - f.tell()))
+            f.write(e['data'])
+    os.replace(temp_file, archive_path)
+
+    return archive_path
+
+def pack(descriptor_path, archive_path):
+    print(f'{bcolors.OKBLUE}PACKING ASSETS{bcolors.ENDC}')
+    written = write_archive(toml.load(descriptor_path), archive_path)
+    if written != None:
+        print(f" {bcolors.SUCCESS}- Archive written: {written} ({os.path.getsize(written)} bytes){bcolors.ENDC}")
+    return written
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=f'{bcolors.SUCCESS}Annileen Asset Packer{bcolors.ENDC}')
+    parser.add_argument('-d', '--descriptor', help='asset descriptor to pack', default=os.path.join('.', tools.build_dir, tools.descriptor_file))
+    parser.add_argument('-o', '--output', help='archive to write', default=os.path.join('.', tools.build_dir, tools.archive_file))
+    args = parser.parse_args()
+
+    pack(args.descriptor, args.output)
@@ -2,6 +2,7 @@ import os
 import argparse
 import glob
 import ntpath
+import re
 from functools import reduce
 
 import tools
@@ -18,6 +19,8 @@ bgfx_tools_dir = os.path.join(tools_dir, 'bgfx-tools', tools.get_platform())
 bgfx_shaderc = os.path.join(bgfx_tools_dir, 'shaderc')
 bgfx_source_folder = os.path.join(os. getcwd(), 'bgfx', 'src')
 
+include_pattern = re.compile(r'\s*#\s*include\s*([<"])([^>"]+)[>"]')
+
 def build_shader(shaderfile, dest, options, platform, model, force=False):
     print(f" - Compiling {bcolors.UNDERLINE}'{shaderfile}'{bcolors.ENDC}")
     output_file = os.path.join(dest, tools.path_leaf(shaderfile))
@@ -36,10 +39,11 @@ def build_shader(shaderfile, dest, options, platform, model, force=False):
         model = ('p' if shadertype == 'fragment' else 'v') + model
     model = '--profile 120' if model == 'auto' else f'--profile {model}'
 
+    temp_file = tools.temp_path(output_file)
     command = "%s -f %s -o %s -i %s --varyingdef %s --platform %s %s --type %s" % (
         bgfx_shaderc,
         shaderfile,
-        output_file,
+        temp_file,
         bgfx_source_folder,
         varying_def_path,
         platform,
@@ -49,12 +53,32 @@ def build_shader(shaderfile, dest, options, platform, model, force=False):
 
     success = False
     if not os.system(command):
+        os.replace(temp_file, output_file)
         success = True
         print(f" {bcolors.SUCCESS}- Shader compiled: {output_file}{bcolors.ENDC}")
 
     return success, tools.path_leaf(shaderfile), output_file
 
 
+def _find_includes(sourcefile, found):
+    # Quoted includes are resolved from the including file, the angle bracket ones from bgfx.
+    with open(sourcefile, 'r', errors='replace') as f:
+        for line in f:
+            match = include_pattern.match(line)
+            if match == None: continue
+
+            base = ntpath.split(sourcefile)[0] if match.group(1) == '"' else bgfx_source_folder
+            include = os.path.normpath(os.path.join(base, match.group(2)))
+            if include not in found and os.path.isfile(include):
+                found.append(include)
+                _find_includes(include, found)
+    return found
+
+def get_dependencies(shaderfile):
+    current_path_varying = os.path.join(ntpath.split(shaderfile)[0], varying_def)
+    varying_def_path = current_path_varying if os.path.isfile(current_path_varying) else default_varying_def
+    return [shaderfile, varying_def_path, bgfx_shaderc, bgfx_shaderc + '.exe'] + _find_includes(shaderfile, [])
+
 def _build_shader(shadername, options, platform, model, force):
     filepath = glob.glob(os.path.join(shader_path, shadername), recursive=True)
     if filepath != None and len(filepath) == 1:
@@ -63,9 +87,11 @@ def _build_shader(shadername, options, platform, model, force):
         print(f"{bcolors.ERROR}[ERROR]{bcolors.ENDC} File '{shadername}' not found.")
 
 
+def find_all():
+    return reduce(lambda x, y : x + y, [glob.glob(os.path.join(shader_path, "**", "*." + filetype), recursive=True) for filetype in tools.shader_types])
+
 def build_all(platform, model, force=False):
-    shaders = reduce(lambda x, y : x + y, [glob.glob(os.path.join(shader_path, "**", "*." + filetype), recursive=True) for filetype in tools.shader_types])
-    return [build_shader(shaderfile, shader_build_path, "", platform, model, force) for shaderfile in shaders]
+    return [build_shader(shaderfile, shader_build_path, "", platform, model, force) for shaderfile in find_all()]
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description=f'{bcolors.SUCCESS}Annileen Shader Tools{bcolors.ENDC}')
@@ -1,5 +1,6 @@
 import os
 import argparse
+import shutil
 import glob
 import ntpath
 from functools import reduce
@@ -17,25 +18,47 @@ bgfx_texturev = os.path.join(bgfx_tools_dir, 'texturev')
 
 def build_texture(texturefile, dest, options, force=False):
     print(f" - Compiling {bcolors.UNDERLINE}'{texturefile}'{bcolors.ENDC}")
-    output_file = os.path.join(dest, tools.path_leaf(texturefile.split('.')[0]) + '.dds')
 
     descriptor_filename, descriptor = tools.load_asset_descriptor(texturefile, tools.texture_descriptor_schema)
+    descriptor = {**tools.texture_descriptor_schema, **descriptor}
+
+    # Without texturec the source image is copied, the engine decodes it and builds its mips
+    # at load time.
+    compile = os.path.isfile(bgfx_texturec) or os.path.isfile(bgfx_texturec + '.exe')
+    extension = '.dds' if compile else os.path.splitext(texturefile)[1].lower()
+    output_file = os.path.join(dest, tools.path_leaf(texturefile.split('.')[0]) + extension)
 
     if not force and not tools.check_should_build(output_file, texturefile, descriptor_filename): 
         print(f" {bcolors.WARNING}- SKIPPED{bcolors.ENDC}")
         return True, tools.path_leaf(texturefile), output_file
 
-    mipmap = '-m 1' if descriptor['mipmap'] else ''
+    temp_file = tools.temp_path(output_file)
+    if not compile:
+        shutil.copyfile(texturefile, temp_file)
+        os.replace(temp_file, output_file)
+        print(f" {bcolors.WARNING}- texturec not found, texture copied uncompressed: {output_file}{bcolors.ENDC}")
+        tools.save_built_asset_descriptor(output_file, descriptor)
+        return True, tools.path_leaf(texturefile), output_file
+
+    if descriptor['format'] not in tools.texture_formats:
+        print(f" {bcolors.ERROR}- Unknown format '{descriptor['format']}', expected one of {', '.join(tools.texture_formats)}.{bcolors.ENDC}")
+        return False, tools.path_leaf(texturefile), output_file
 
-    command = "%s -f %s -o %s %s -t ETC2" % (
+    mipmap = '-m' if descriptor['mipmap'] else ''
+
+    # Block compressed formats the GPU can't sample are decoded when loaded, see
+    # AssetManager::prepareImage.
+    command = "%s -f %s -o %s %s -t %s" % (
         bgfx_texturec,
         texturefile,
-        output_file,
+        temp_file,
         mipmap,
+        tools.texture_formats[descriptor['format']],
     )
 
     success = False
     if not os.system(command):
+        os.replace(temp_file, output_file)
         success = True
         print(f" {bcolors.SUCCESS}- Texture compiled: {output_file}{bcolors.ENDC}")
         tools.save_built_asset_descriptor(output_file, descriptor)
@@ -50,9 +73,15 @@ def _build_texture(meshname, options):
     else:
         print(f"{bcolors.ERROR}[ERROR]{bcolors.ENDC} File '{meshname}' not found.")
 
+def get_dependencies(texturefile):
+    descriptor_filename, _ = tools.load_asset_descriptor(texturefile, tools.texture_descriptor_schema)
+    return [texturefile, descriptor_filename, bgfx_texturec, bgfx_texturec + '.exe']
+
+def find_all():
+    return reduce(lambda x, y : x + y, [glob.glob(os.path.join(texture_path, "**", "*." + filetype), recursive=True) for filetype in tools.texture_types])
+
 def build_all(force=False):
-    textures = reduce(lambda x, y : x + y, [glob.glob(os.path.join(texture_path, "**", "*." + filetype), recursive=True) for filetype in tools.texture_types])
-    return [build_texture(texturefile, texture_build_path, "", force) for texturefile in textures]
+    return [build_texture(texturefile, texture_build_path, "", force) for texturefile in find_all()]
 
 def view_texture(meshname):
     filepath = glob.glob(os.path.join(texture_build_path, meshname.split('.')[0] + '.*'), recursive=True)
@@ -48,6 +48,8 @@ available_shader_models = [
 root_dir = "assets"
 build_dir = "build_assets"
 descriptor_file = "assets.toml"
+archive_file = "assets.pak"
+manifest_file = "manifest.json"
 
 shader_types = ["vs", "fs"]
 mesh_types = ["obj", "gltf", "glb"]
@@ -57,7 +59,15 @@ font_types = ["ttf", "otf"]
 
 texture_descriptor_schema = {
     'mipmap': False,
-    'filter': 'linear'
+    'filter': 'linear',
+    'format': 'bc3' # 'bc1', 'bc3', 'bc7', 'rgba8'
+}
+
+texture_formats = {
+    'bc1': 'BC1',
+    'bc3': 'BC3',
+    'bc7': 'BC7',
+    'rgba8': 'RGBA8'
 }
 
 mesh_descriptor_schema = {
@@ -113,6 +123,13 @@ def get_platform():
     elif sys.platform.startswith('darwin'):
         return "osx"
 
+def temp_path(path):
+    # Built files are written here first and moved over the output once complete, with
+    # os.replace. The engine maps asset files, truncating one it has mapped crashes it.
+    # The extension is kept, the bgfx tools pick the output container from it.
+    root, extension = os.path.splitext(path)
+    return root + '.tmp' + extension
+
 def path_leaf(path):
     head, tail = ntpath.split(path)
     return tail or ntpath.basename(head)